@@ -0,0 +1,389 @@
+#include "GameEngine/game_engine.h"
+#include "World/world.h"
+#include "Actors/actor.h"
+#include "Components/mesh_component.h"
+#include "Components/camera_component.h"
+#include "Model/material_factory.h"
+#include "Model/primitive_factory.h"
+#include "Model/mesh.h"
+#include "Model/model_helper.h"
+#include "Model/model_cache.h"
+#include "Assets/asset_registry.h"
+#include "Assets/asset_manager.h"
+#include "Time/frame_timings.h"
+#include "render_device_null.h"
+#include "Debug/debug.h"
+#include "Debug/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Ming3D;
+
+namespace
+{
+    struct BenchmarkParams
+    {
+        size_t mNumActors = 1000;
+        size_t mNumMaterials = 10;
+        size_t mHierarchyDepth = 1;
+        size_t mNumFrames = 300;
+        size_t mNumWarmupFrames = 10;
+        float mDeltaTime = 1.0f / 60.0f;
+        unsigned int mSeed = 1;
+        bool mJson = false;
+        std::string mOutputPath; // benchmark_results.csv/json if empty
+        std::string mTracePath; // Chrome trace of the profiler zones (needs MING3D_PROFILER)
+        std::string mModelPath; // model to measure the load time of (assimp import vs cooked model cache), if not empty
+    };
+
+    /** Load times of a model, in milliseconds. */
+    struct ModelLoadResult
+    {
+        double mImportTime = 0.0; // assimp import and cooking
+        double mCookedTime = 0.0; // from the model cache
+    };
+
+    /** Values measured in one frame. Times are in milliseconds. */
+    struct FrameResult
+    {
+        double mTotalTime = 0.0;
+        double mMoveActorsTime = 0.0; // rotating the root actors, which updates the transforms of their children and render objects (transforms are updated eagerly)
+        double mPhaseTimes[(size_t)EFramePhase::NumPhases] = {};
+        size_t mNumDrawCalls = 0;
+        size_t mNumIndices = 0;
+        size_t mNumStateChanges = 0; // shader programs, texture binds and render states
+    };
+
+    /** A column of the results: a frame value, with its name in the output. */
+    struct ResultColumn
+    {
+        std::string mName;
+        std::vector<double> mValues;
+    };
+
+    struct ColumnSummary
+    {
+        double mMean = 0.0;
+        double mMedian = 0.0;
+        double mP95 = 0.0;
+        double mMin = 0.0;
+        double mMax = 0.0;
+    };
+
+    ColumnSummary SummariseColumn(const ResultColumn& inColumn)
+    {
+        ColumnSummary summary;
+        if (inColumn.mValues.empty())
+            return summary;
+
+        std::vector<double> sortedValues = inColumn.mValues;
+        std::sort(sortedValues.begin(), sortedValues.end());
+        for (double value : sortedValues)
+            summary.mMean += value;
+        summary.mMean /= sortedValues.size();
+        summary.mMedian = sortedValues[sortedValues.size() / 2];
+        summary.mP95 = sortedValues[std::min(sortedValues.size() - 1, sortedValues.size() * 95 / 100)];
+        summary.mMin = sortedValues.front();
+        summary.mMax = sortedValues.back();
+        return summary;
+    }
+
+    std::vector<ResultColumn> GetResultColumns(const std::vector<FrameResult>& inFrames)
+    {
+        std::vector<ResultColumn> columns;
+        auto addColumn = [&](const std::string& inName, auto inGetValue)
+        {
+            ResultColumn column;
+            column.mName = inName;
+            for (const FrameResult& frame : inFrames)
+                column.mValues.push_back((double)inGetValue(frame));
+            columns.push_back(std::move(column));
+        };
+
+        addColumn("total_ms", [](const FrameResult& frame) { return frame.mTotalTime; });
+        addColumn("move_actors_ms", [](const FrameResult& frame) { return frame.mMoveActorsTime; });
+        for (size_t iPhase = 0; iPhase < (size_t)EFramePhase::NumPhases; iPhase++)
+            addColumn(std::string(GetFramePhaseName((EFramePhase)iPhase)) + "_ms", [iPhase](const FrameResult& frame) { return frame.mPhaseTimes[iPhase]; });
+        addColumn("draw_calls", [](const FrameResult& frame) { return frame.mNumDrawCalls; });
+        addColumn("indices", [](const FrameResult& frame) { return frame.mNumIndices; });
+        addColumn("state_changes", [](const FrameResult& frame) { return frame.mNumStateChanges; });
+        return columns;
+    }
+
+    void WriteCSV(std::ostream& outStream, const std::vector<ResultColumn>& inColumns)
+    {
+        outStream << "frame";
+        for (const ResultColumn& column : inColumns)
+            outStream << "," << column.mName;
+        outStream << "\n";
+
+        const size_t numFrames = inColumns.empty() ? 0 : inColumns[0].mValues.size();
+        for (size_t iFrame = 0; iFrame < numFrames; iFrame++)
+        {
+            outStream << iFrame;
+            for (const ResultColumn& column : inColumns)
+                outStream << "," << column.mValues[iFrame];
+            outStream << "\n";
+        }
+    }
+
+    void WriteJSON(std::ostream& outStream, const BenchmarkParams& inParams, const std::vector<ResultColumn>& inColumns, const ModelLoadResult* inModelLoad)
+    {
+        outStream << "{\n";
+        outStream << "  \"config\": { \"actors\": " << inParams.mNumActors << ", \"materials\": " << inParams.mNumMaterials
+            << ", \"depth\": " << inParams.mHierarchyDepth << ", \"frames\": " << inParams.mNumFrames << ", \"warmup\": " << inParams.mNumWarmupFrames
+            << ", \"delta\": " << inParams.mDeltaTime << ", \"seed\": " << inParams.mSeed << " },\n";
+
+        if (inModelLoad != nullptr)
+        {
+            outStream << "  \"model_load\": { \"model\": \"" << inParams.mModelPath << "\", \"assimp_ms\": " << inModelLoad->mImportTime
+                << ", \"cooked_ms\": " << inModelLoad->mCookedTime << " },\n";
+        }
+
+        outStream << "  \"summary\": {\n";
+        for (size_t iColumn = 0; iColumn < inColumns.size(); iColumn++)
+        {
+            const ColumnSummary summary = SummariseColumn(inColumns[iColumn]);
+            outStream << "    \"" << inColumns[iColumn].mName << "\": { \"mean\": " << summary.mMean << ", \"median\": " << summary.mMedian
+                << ", \"p95\": " << summary.mP95 << ", \"min\": " << summary.mMin << ", \"max\": " << summary.mMax << " }"
+                << (iColumn + 1 < inColumns.size() ? ",\n" : "\n");
+        }
+        outStream << "  },\n";
+
+        outStream << "  \"frames\": {\n";
+        for (size_t iColumn = 0; iColumn < inColumns.size(); iColumn++)
+        {
+            outStream << "    \"" << inColumns[iColumn].mName << "\": [";
+            const std::vector<double>& values = inColumns[iColumn].mValues;
+            for (size_t iValue = 0; iValue < values.size(); iValue++)
+                outStream << (iValue > 0 ? ", " : "") << values[iValue];
+            outStream << "]" << (iColumn + 1 < inColumns.size() ? ",\n" : "\n");
+        }
+        outStream << "  }\n";
+        outStream << "}\n";
+    }
+
+    /**
+    * Creates a synthetic scene: inNumActors box actors using inNumMaterials materials, in chains of inHierarchyDepth actors.
+    * Root actors are spread randomly (from inSeed) in a cube in front of a camera that sees part of it. Returns the root actors.
+    */
+    std::vector<Actor*> CreateScene(GameEngine* inGameEngine, const BenchmarkParams& inParams)
+    {
+        std::mt19937 randomEngine(inParams.mSeed);
+        const float sceneExtent = 2.0f * std::cbrt((float)inParams.mNumActors);
+        std::uniform_real_distribution<float> positionDistribution(-sceneExtent * 0.5f, sceneExtent * 0.5f);
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+
+        Actor* camActor = new Actor();
+        camActor->AddComponent<CameraComponent>();
+        camActor->GetTransform().SetWorldPosition(glm::vec3(0.0f, 0.0f, sceneExtent * 0.25f));
+        inGameEngine->GetWorld()->AddActor(camActor);
+
+        std::vector<Material*> materials;
+        for (size_t iMaterial = 0; iMaterial < std::max(inParams.mNumMaterials, (size_t)1); iMaterial++)
+        {
+            MaterialParams matParams;
+            matParams.mShaderProgramPath = "Resources/Shaders/defaultshader.cgp";
+            matParams.mPreprocessorDefinitions.emplace("use_mat_colour", "");
+            Material* material = MaterialFactory::CreateMaterial(matParams);
+            material->SetShaderUniformVec4("_colourDiffuse", glm::vec4(unitDistribution(randomEngine), unitDistribution(randomEngine), unitDistribution(randomEngine), 1.0f));
+            materials.push_back(material);
+        }
+
+        // All actors share one box mesh
+        Mesh* boxMesh = PrimitiveFactory::CreateBox(glm::vec3(0.5f));
+        AssetHandle<Mesh> meshHandle(boxMesh, [](Mesh* mesh) { delete mesh; });
+        AssetHandle<MeshBuffer> meshBuffer = inGameEngine->GetAssetRegistry()->GetMeshBuffer("Benchmark/Box", boxMesh);
+
+        const size_t hierarchyDepth = std::max(inParams.mHierarchyDepth, (size_t)1);
+        std::vector<Actor*> rootActors;
+        Actor* parentActor = nullptr;
+        for (size_t iActor = 0; iActor < inParams.mNumActors; iActor++)
+        {
+            Actor* actor = new Actor();
+            if (iActor % hierarchyDepth == 0)
+            {
+                actor->GetTransform().SetLocalPosition(glm::vec3(positionDistribution(randomEngine), positionDistribution(randomEngine), positionDistribution(randomEngine)));
+                inGameEngine->GetWorld()->AddActor(actor);
+                rootActors.push_back(actor);
+            }
+            else
+            {
+                actor->GetTransform().SetParent(&parentActor->GetTransform());
+                actor->GetTransform().SetLocalPosition(glm::vec3(0.0f, 0.6f, 0.0f));
+            }
+
+            MeshComponent* meshComp = actor->AddComponent<MeshComponent>();
+            meshComp->SetMesh(meshHandle, meshBuffer);
+            meshComp->SetMaterial(materials[iActor % materials.size()]);
+            parentActor = actor;
+        }
+
+        return rootActors;
+    }
+
+    double GetMilliseconds(std::chrono::steady_clock::duration inDuration)
+    {
+        return std::chrono::duration<double, std::milli>(inDuration).count();
+    }
+
+    /**
+    * Measures how long it takes to load a model with assimp (MODELLOADERFLAGS_NO_CACHE), and from the cooked model cache.
+    * The cache file is written first if it doesn't exist or is out of date, so the cooked load is always a cache hit.
+    */
+    bool MeasureModelLoad(const std::string& inModelPath, ModelLoadResult& outResult)
+    {
+        auto timeLoad = [&](int inFlags, double& outTime)
+        {
+            const auto startTime = std::chrono::steady_clock::now();
+            CookedModel* cookedModel = ModelLoader::LoadCookedModel(inModelPath.c_str(), inFlags);
+            outTime = GetMilliseconds(std::chrono::steady_clock::now() - startTime);
+            delete cookedModel;
+            return cookedModel != nullptr;
+        };
+
+        double cookTime = 0.0;
+        if (!timeLoad(MODELLOADERFLAGS_NO_CACHE, outResult.mImportTime) || !timeLoad(0, cookTime) || !timeLoad(0, outResult.mCookedTime))
+        {
+            LOG_ERROR() << "Failed to load model: " << inModelPath;
+            return false;
+        }
+        return true;
+    }
+}
+
+// Runs a fixed number of frames of a synthetic scene on a headless engine (RenderDeviceNull), with a fixed delta time,
+// and writes the time spent in each phase of every frame, as CSV or JSON (summary and per-frame values).
+// Must be run from the directory that contains the Resources folder.
+// With --model, the load time of a model with assimp and from the model cache is measured first (and added to the JSON output).
+// Usage: Benchmark [--actors N] [--materials M] [--depth D] [--frames F] [--warmup W] [--delta S] [--seed X] [--json] [--output path] [--trace path] [--model path]
+int main(int argc, char** argv)
+{
+    BenchmarkParams params;
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        const bool hasValue = iArg + 1 < argc;
+        if (strcmp(argv[iArg], "--actors") == 0 && hasValue)
+            params.mNumActors = (size_t)atol(argv[++iArg]);
+        else if (strcmp(argv[iArg], "--materials") == 0 && hasValue)
+            params.mNumMaterials = (size_t)atol(argv[++iArg]);
+        else if (strcmp(argv[iArg], "--depth") == 0 && hasValue)
+            params.mHierarchyDepth = (size_t)atol(argv[++iArg]);
+        else if (strcmp(argv[iArg], "--frames") == 0 && hasValue)
+            params.mNumFrames = (size_t)atol(argv[++iArg]);
+        else if (strcmp(argv[iArg], "--warmup") == 0 && hasValue)
+            params.mNumWarmupFrames = (size_t)atol(argv[++iArg]);
+        else if (strcmp(argv[iArg], "--delta") == 0 && hasValue)
+            params.mDeltaTime = (float)atof(argv[++iArg]);
+        else if (strcmp(argv[iArg], "--seed") == 0 && hasValue)
+            params.mSeed = (unsigned int)atol(argv[++iArg]);
+        else if (strcmp(argv[iArg], "--json") == 0)
+            params.mJson = true;
+        else if (strcmp(argv[iArg], "--output") == 0 && hasValue)
+            params.mOutputPath = argv[++iArg];
+        else if (strcmp(argv[iArg], "--trace") == 0 && hasValue)
+            params.mTracePath = argv[++iArg];
+        else if (strcmp(argv[iArg], "--model") == 0 && hasValue)
+            params.mModelPath = argv[++iArg];
+        else
+        {
+            LOG_ERROR() << "Usage: Benchmark [--actors N] [--materials M] [--depth D] [--frames F] [--warmup W] [--delta S] [--seed X] [--json] [--output path] [--trace path] [--model path]";
+            return 1;
+        }
+    }
+
+    GameEngine* gameEngine = new GameEngine();
+    gameEngine->Initialise(true);
+    gameEngine->SetFixedDeltaTime(params.mDeltaTime);
+    // Initialise starts precompiling the default shader on the worker threads. Wait for it, so it isn't part of the measured frames.
+    gameEngine->GetAssetManager()->FlushAll();
+    RenderDeviceNull* renderDevice = static_cast<RenderDeviceNull*>(gameEngine->GetRenderDevice());
+
+    ModelLoadResult modelLoadResult;
+    if (!params.mModelPath.empty())
+    {
+        if (!MeasureModelLoad(params.mModelPath, modelLoadResult))
+            return 1;
+        LOG_INFO() << "Model load time of " << params.mModelPath << ": assimp " << modelLoadResult.mImportTime << " ms, cooked " << modelLoadResult.mCookedTime << " ms";
+    }
+
+    const std::vector<Actor*> rootActors = CreateScene(gameEngine, params);
+
+    std::vector<FrameResult> frameResults;
+    frameResults.reserve(params.mNumFrames);
+    for (size_t iFrame = 0; iFrame < params.mNumWarmupFrames + params.mNumFrames; iFrame++)
+    {
+        renderDevice->ResetCallStats();
+        FrameResult frameResult;
+
+        const auto frameStartTime = std::chrono::steady_clock::now();
+
+        // Move all actors (children follow their root)
+        {
+            PROFILE_ZONE("MoveActors");
+            for (Actor* actor : rootActors)
+                actor->GetTransform().Rotate(params.mDeltaTime, glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        const auto moveActorsEndTime = std::chrono::steady_clock::now();
+
+        gameEngine->Update();
+        const auto frameEndTime = std::chrono::steady_clock::now();
+
+        if (iFrame < params.mNumWarmupFrames)
+            continue;
+
+        frameResult.mTotalTime = GetMilliseconds(frameEndTime - frameStartTime);
+        frameResult.mMoveActorsTime = GetMilliseconds(moveActorsEndTime - frameStartTime);
+        for (size_t iPhase = 0; iPhase < (size_t)EFramePhase::NumPhases; iPhase++)
+            frameResult.mPhaseTimes[iPhase] = gameEngine->GetFrameTimings().GetTime((EFramePhase)iPhase) * 1000.0;
+
+        const RenderDeviceNullStats& stats = renderDevice->GetStats();
+        frameResult.mNumDrawCalls = stats.mNumDrawCalls;
+        frameResult.mNumIndices = stats.mNumIndices;
+        frameResult.mNumStateChanges = stats.mNumShaderProgramChanges + stats.mNumTextureBinds + stats.mNumStateChanges;
+        frameResults.push_back(frameResult);
+    }
+
+    const std::vector<ResultColumn> columns = GetResultColumns(frameResults);
+    for (const ResultColumn& column : columns)
+    {
+        const ColumnSummary summary = SummariseColumn(column);
+        LOG_INFO() << column.mName << ": mean " << summary.mMean << ", median " << summary.mMedian << ", p95 " << summary.mP95;
+    }
+
+    if (params.mOutputPath.empty())
+        params.mOutputPath = params.mJson ? "benchmark_results.json" : "benchmark_results.csv";
+
+    std::ofstream outFile(params.mOutputPath);
+    if (!outFile.is_open())
+    {
+        LOG_ERROR() << "Failed to open benchmark output file: " << params.mOutputPath;
+        return 1;
+    }
+    if (params.mJson)
+        WriteJSON(outFile, params, columns, params.mModelPath.empty() ? nullptr : &modelLoadResult);
+    else
+        WriteCSV(outFile, columns);
+
+    LOG_INFO() << "Wrote results of " << frameResults.size() << " frames to " << params.mOutputPath;
+
+    if (!params.mTracePath.empty())
+    {
+#ifdef MING3D_PROFILER_ENABLED
+        if (!Profiler::ExportChromeTrace(params.mTracePath))
+            return 1;
+#else
+        LOG_ERROR() << "Can't write a trace: the profiler is disabled (build with MING3D_PROFILER)";
+        return 1;
+#endif
+    }
+    return 0;
+}
@@ -5,6 +5,7 @@
 #include <sstream>
 #include <string>
 #include <fstream>
+#include <mutex>
 
 #define DEBUG_MODE_NONE				0x0000
 #define DEBUG_MODE_INFO				0x0001
@@ -74,6 +75,9 @@ namespace Ming3D
 		{
 			_buffer << _buffersuffix.str();
 			_buffer << std::endl;
+
+			// Log messages may come from asset loading threads
+			std::lock_guard<std::mutex> lock(outputMutex);
 			std::cout << _buffer.str();
 
 
@@ -105,8 +109,9 @@ namespace Ming3D
 		std::ostringstream _buffersuffix;
 		static DEBUG_MODE terminalLogMode;
 		static DEBUG_MODE fileLogMode;
-		static DEBUG_MODE outputMode;
+		DEBUG_MODE outputMode;
 		static bool firstTime;
+		static std::mutex outputMutex;
 	};
 }
 
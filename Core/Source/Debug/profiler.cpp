@@ -0,0 +1,125 @@
+#include "profiler.h"
+
+#ifdef MING3D_PROFILER_ENABLED
+
+#include "Debug/debug.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace Ming3D
+{
+    namespace
+    {
+        // All thread buffers, kept alive after their threads exit so their events can still be exported
+        struct ProfilerThreadRegistry
+        {
+            std::mutex mMutex;
+            std::vector<std::unique_ptr<ProfilerThreadBuffer>> mThreadBuffers;
+        };
+
+        ProfilerThreadRegistry& GetThreadRegistry()
+        {
+            static ProfilerThreadRegistry registry;
+            return registry;
+        }
+
+        void WriteJSONString(std::ostream& outStream, const char* inString)
+        {
+            outStream << '"';
+            for (const char* c = inString; *c != '\0'; c++)
+            {
+                if (*c == '"' || *c == '\\')
+                    outStream << '\\';
+                outStream << *c;
+            }
+            outStream << '"';
+        }
+    }
+
+    uint64_t Profiler::GetTimestamp()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    ProfilerThreadBuffer* Profiler::GetThreadBuffer()
+    {
+        thread_local ProfilerThreadBuffer* threadBuffer = nullptr;
+        if (threadBuffer == nullptr)
+        {
+            ProfilerThreadRegistry& registry = GetThreadRegistry();
+            std::lock_guard<std::mutex> lock(registry.mMutex);
+            registry.mThreadBuffers.emplace_back(new ProfilerThreadBuffer());
+            threadBuffer = registry.mThreadBuffers.back().get();
+            threadBuffer->mThreadIndex = (unsigned int)registry.mThreadBuffers.size();
+        }
+        return threadBuffer;
+    }
+
+    void Profiler::SetThreadName(const char* inName)
+    {
+        GetThreadBuffer()->mThreadName = inName;
+    }
+
+    bool Profiler::ExportChromeTrace(const std::string& inPath)
+    {
+        std::ofstream file(inPath);
+        if (!file.is_open())
+        {
+            LOG_ERROR() << "Failed to open profiler trace file: " << inPath;
+            return false;
+        }
+
+        ProfilerThreadRegistry& registry = GetThreadRegistry();
+        std::lock_guard<std::mutex> lock(registry.mMutex);
+
+        // Timestamps are relative to the oldest recorded event
+        uint64_t baseTime = std::numeric_limits<uint64_t>::max();
+        for (const std::unique_ptr<ProfilerThreadBuffer>& threadBuffer : registry.mThreadBuffers)
+        {
+            const uint64_t numEvents = threadBuffer->mNumEvents.load(std::memory_order_acquire);
+            for (uint64_t iEvent = numEvents - std::min(numEvents, (uint64_t)ProfilerThreadBuffer::Capacity); iEvent < numEvents; iEvent++)
+                baseTime = std::min(baseTime, threadBuffer->mEvents[iEvent % ProfilerThreadBuffer::Capacity].mStartTime);
+        }
+
+        file.setf(std::ios::fixed);
+        file.precision(3);
+        file << "{\"traceEvents\":[\n";
+        bool firstEvent = true;
+        size_t numExportedEvents = 0;
+        for (const std::unique_ptr<ProfilerThreadBuffer>& threadBuffer : registry.mThreadBuffers)
+        {
+            if (threadBuffer->mThreadName != nullptr)
+            {
+                file << (firstEvent ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << threadBuffer->mThreadIndex << ",\"args\":{\"name\":";
+                WriteJSONString(file, threadBuffer->mThreadName);
+                file << "}}";
+                firstEvent = false;
+            }
+
+            const uint64_t numEvents = threadBuffer->mNumEvents.load(std::memory_order_acquire);
+            for (uint64_t iEvent = numEvents - std::min(numEvents, (uint64_t)ProfilerThreadBuffer::Capacity); iEvent < numEvents; iEvent++)
+            {
+                const ProfilerZoneEvent& zoneEvent = threadBuffer->mEvents[iEvent % ProfilerThreadBuffer::Capacity];
+                // Complete events, in microseconds
+                file << (firstEvent ? "" : ",\n") << "{\"ph\":\"X\",\"name\":";
+                WriteJSONString(file, zoneEvent.mName);
+                file << ",\"pid\":1,\"tid\":" << threadBuffer->mThreadIndex
+                    << ",\"ts\":" << (zoneEvent.mStartTime - baseTime) / 1000.0
+                    << ",\"dur\":" << (zoneEvent.mEndTime - zoneEvent.mStartTime) / 1000.0 << "}";
+                firstEvent = false;
+                numExportedEvents++;
+            }
+        }
+        file << "\n]}\n";
+
+        LOG_INFO() << "Exported " << numExportedEvents << " profiler zones to " << inPath;
+        return file.good();
+    }
+}
+
+#endif
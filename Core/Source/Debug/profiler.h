@@ -0,0 +1,96 @@
+#ifndef MING3D_PROFILER_H
+#define MING3D_PROFILER_H
+
+// CPU profiler: PROFILE_ZONE("Name") records the time spent in the enclosing scope (zones nest).
+// Enabled by MING3D_PROFILER_ENABLED (CMake: MING3D_PROFILER). When disabled, the macros expand to nothing.
+
+#ifdef MING3D_PROFILER_ENABLED
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Ming3D
+{
+    struct ProfilerZoneEvent
+    {
+        const char* mName; // must be a string literal (or outlive the profiler)
+        uint64_t mStartTime; // nanoseconds
+        uint64_t mEndTime;
+    };
+
+    /**
+    * Zone events of one thread. Only written by its own thread, so adding an event needs no lock.
+    * It's a ring buffer: the oldest events are overwritten when it's full.
+    */
+    class ProfilerThreadBuffer
+    {
+    public:
+        static constexpr size_t Capacity = 65536;
+
+        std::unique_ptr<ProfilerZoneEvent[]> mEvents;
+        std::atomic<uint64_t> mNumEvents; // total number of events written (including overwritten ones)
+        unsigned int mThreadIndex = 0;
+        const char* mThreadName = nullptr;
+
+        ProfilerThreadBuffer() : mEvents(new ProfilerZoneEvent[Capacity]), mNumEvents(0) {}
+
+        void AddEvent(const char* inName, uint64_t inStartTime, uint64_t inEndTime)
+        {
+            const uint64_t numEvents = mNumEvents.load(std::memory_order_relaxed);
+            mEvents[numEvents % Capacity] = { inName, inStartTime, inEndTime };
+            mNumEvents.store(numEvents + 1, std::memory_order_release);
+        }
+    };
+
+    class Profiler
+    {
+    public:
+        /** Current time, in nanoseconds (steady clock). */
+        static uint64_t GetTimestamp();
+
+        /** Gets the event buffer of the calling thread (created the first time). */
+        static ProfilerThreadBuffer* GetThreadBuffer();
+
+        /** Names the calling thread in the exported traces. inName must be a string literal. */
+        static void SetThreadName(const char* inName);
+
+        /**
+        * Writes the recorded zones of all threads as Chrome trace_event JSON (open in chrome://tracing or Perfetto).
+        * Call while the other threads are idle, or events they record during the export may be torn.
+        */
+        static bool ExportChromeTrace(const std::string& inPath);
+    };
+
+    /** Records a zone from construction to destruction. Use PROFILE_ZONE. */
+    class ProfilerScopedZone
+    {
+    private:
+        const char* mName;
+        uint64_t mStartTime;
+
+    public:
+        explicit ProfilerScopedZone(const char* inName) : mName(inName), mStartTime(Profiler::GetTimestamp()) {}
+
+        ~ProfilerScopedZone()
+        {
+            Profiler::GetThreadBuffer()->AddEvent(mName, mStartTime, Profiler::GetTimestamp());
+        }
+    };
+}
+
+#define MING3D_PROFILER_CONCAT_INNER(A, B) A##B
+#define MING3D_PROFILER_CONCAT(A, B) MING3D_PROFILER_CONCAT_INNER(A, B)
+
+#define PROFILE_ZONE(ZoneName) \
+Ming3D::ProfilerScopedZone MING3D_PROFILER_CONCAT(profilerZone, __LINE__)(ZoneName)
+#define PROFILE_THREAD_NAME(ThreadName) \
+Ming3D::Profiler::SetThreadName(ThreadName)
+
+#else
+#define PROFILE_ZONE(ZoneName)
+#define PROFILE_THREAD_NAME(ThreadName)
+#endif
+
+#endif
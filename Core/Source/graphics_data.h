@@ -15,6 +15,18 @@ namespace Ming3D
         Colour
     };
 
+    /**
+    * Storage format of a vertex component.
+    * Normalised and half float formats are padded to 2 or 4 elements (a vec3 is stored in 4 elements).
+    */
+    enum class EVertexComponentFormat
+    {
+        Float,   // 32 bit float
+        Half,    // 16 bit float
+        SNorm16, // 16 bit signed integer, normalised to [-1, 1]
+        SNorm8   // 8 bit signed integer, normalised to [-1, 1]
+    };
+
     /**
     * Vertex Layout.
     * Contains information about vertices (type, size).
@@ -22,6 +34,18 @@ namespace Ming3D
     struct VertexLayout
     {
         std::vector<EVertexComponent> VertexComponents;
+        // Format of each component in VertexComponents (Float if not set)
+        std::vector<EVertexComponentFormat> ComponentFormats;
+        // SNorm16 positions are dequantised as: position * PositionScale + PositionOffset
+        glm::vec3 PositionOffset = glm::vec3(0.0f);
+        float PositionScale = 1.0f;
+
+        EVertexComponentFormat GetComponentFormat(size_t inIndex) const { return inIndex < ComponentFormats.size() ? ComponentFormats[inIndex] : EVertexComponentFormat::Float; }
+        size_t GetVertexSize() const;
+        /** Returns the offset of the component (in bytes), or -1 if the layout doesn't contain it. */
+        size_t GetComponentOffset(EVertexComponent inComponent) const;
+        /** Matrix that transforms (quantised) vertex positions to mesh space. */
+        glm::mat4 GetPositionDequantisationMatrix() const;
     };
 
     namespace VertexDataType
@@ -74,12 +98,20 @@ namespace Ming3D
         
         const VertexLayout& GetVertexLayout() { return mVertexLayout; }
 
-        static size_t GetVertexComponentSize(EVertexComponent inComp);
+        /** Reads (and decodes) a vertex component. Positions are dequantised. */
+        glm::vec4 GetComponentValue(size_t inVertex, EVertexComponent inComp);
+        /** Writes (and encodes) a vertex component. Positions are quantised. */
+        void SetComponentValue(size_t inVertex, EVertexComponent inComp, const glm::vec4& inValue);
+
+        static size_t GetVertexComponentSize(EVertexComponent inComp, EVertexComponentFormat inFormat = EVertexComponentFormat::Float);
+        /** Number of elements stored for a vertex component, including padding. */
+        static size_t GetVertexComponentElementCount(EVertexComponent inComp, EVertexComponentFormat inFormat = EVertexComponentFormat::Float);
     };
 
     /**
     * Index Data.
     * Contains a set of indices.
+    * Indices are always 32 bit here, but are converted to 16 bit when uploaded to the GPU, if all of them fit (see UseShortIndices).
     */
     class IndexData
     {
@@ -90,8 +122,16 @@ namespace Ming3D
         IndexData(size_t inNumIndices);
         size_t GetNumIndices();
         unsigned int* GetData() { return mData.data(); }
+
+        /** True if all indices fit in 16 bits (the mesh has no more than 65536 vertices). */
+        bool UseShortIndices();
+        void GetShortIndices(std::vector<unsigned short>& outIndices);
     };
 
+    /**
+    * Iterates over a vertex component, without decoding it.
+    * Only for Float components (see VertexData::GetComponentValue for other formats).
+    */
     template <typename T>
     class VertexDataIterator
     {
@@ -118,7 +158,7 @@ namespace Ming3D
         }
 
         size_t GetCount() { return mNumVertices; }
-        T GetElement(const size_t index) { return *reinterpret_cast<T*>(mVertData + (index * mVertexSize)); }
+        T GetElement(const size_t index) { return *reinterpret_cast<T*>(mVertData + (index * mVertexSize) + mComponentOffset); }
     };
 }
 
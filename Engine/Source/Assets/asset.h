@@ -0,0 +1,69 @@
+#ifndef MING3D_ASSET_H
+#define MING3D_ASSET_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+
+namespace Ming3D
+{
+    enum class EAssetState
+    {
+        Queued,   // waiting for the I/O thread
+        Decoding, // file read, waiting for (or running on) a worker thread
+        Uploading,// decoded, waiting for the main thread to create GPU resources
+        Ready,
+        Failed
+    };
+
+    /**
+    * Base class of asynchronously loaded assets (see AssetManager).
+    * Loading happens in three steps: the file is read on the I/O thread, decoded on a worker thread,
+    *  and finalised (GPU resources created) on the main thread.
+    */
+    class Asset
+    {
+        friend class AssetManager;
+
+    private:
+        std::atomic<EAssetState> mState;
+        std::vector<std::function<void(Asset*)>> mCallbacks; // main thread only
+
+        // Guarded by the AssetManager's mutex
+        glm::vec3 mLocation;
+        bool mHasLocation = false;
+
+    protected:
+        std::string mPath;
+        std::vector<char> mFileData; // read by the I/O thread, unless ReadsOwnFile
+
+        /** True if the decoder reads the file(s) itself (e.g. assimp, and shaders with includes). */
+        virtual bool ReadsOwnFile() const { return false; }
+        /** Worker thread. Must not touch the render device or the world. */
+        virtual bool Decode() = 0;
+        /** Main thread. Creates GPU resources. */
+        virtual bool Finalise() = 0;
+
+    public:
+        Asset(const std::string& inPath) : mState(EAssetState::Queued), mPath(inPath) {}
+        virtual ~Asset() = default;
+
+        EAssetState GetState() const { return mState.load(); }
+        bool IsReady() const { return GetState() == EAssetState::Ready; }
+        bool IsFailed() const { return GetState() == EAssetState::Failed; }
+        const std::string& GetPath() const { return mPath; }
+    };
+
+    /**
+    * Reference to an asset. The asset manager keeps its own reference while the asset is loading.
+    */
+    template <typename T>
+    using AssetHandle = std::shared_ptr<T>;
+
+    typedef std::function<void(Asset*)> AssetCallback;
+}
+
+#endif
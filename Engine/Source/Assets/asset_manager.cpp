@@ -0,0 +1,271 @@
+#include "asset_manager.h"
+
+#include "texture_asset.h"
+#include "model_asset.h"
+#include "material_asset.h"
+#include "shader_asset.h"
+#include "asset_registry.h"
+#include "Model/model_helper.h"
+#include "Model/model_cache.h"
+#include "shader_cache.h"
+#include "Actors/actor.h"
+#include "GameEngine/game_engine.h"
+#include "SceneRenderer/scene_renderer.h"
+#include "SceneRenderer/camera.h"
+#include "Debug/debug.h"
+#include "Debug/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+
+namespace Ming3D
+{
+    AssetManager::AssetManager()
+    {
+        mIOThread = std::thread(&AssetManager::IOThreadLoop, this);
+
+        // The main thread and the I/O thread are busy too
+        const unsigned int numCores = std::thread::hardware_concurrency();
+        const unsigned int numWorkers = numCores > 3 ? numCores - 2 : 1;
+        for (unsigned int iWorker = 0; iWorker < numWorkers; iWorker++)
+            mWorkerThreads.push_back(std::thread(&AssetManager::WorkerThreadLoop, this));
+    }
+
+    AssetManager::~AssetManager()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mShutdown = true;
+        }
+        mReadCondition.notify_all();
+        mDecodeCondition.notify_all();
+
+        mIOThread.join();
+        for (std::thread& worker : mWorkerThreads)
+            worker.join();
+    }
+
+    AssetHandle<Asset> AssetManager::PopClosestAsset(AssetQueue& ioQueue)
+    {
+        auto closestIter = ioQueue.end();
+        float closestDistSqr = 0.0f;
+        for (auto assetIter = ioQueue.begin(); assetIter != ioQueue.end(); assetIter++)
+        {
+            const Asset* asset = assetIter->get();
+            float distSqr = 0.0f;
+            if (asset->mHasLocation && !mViewPositions.empty())
+            {
+                distSqr = std::numeric_limits<float>::max();
+                for (const glm::vec3& viewPos : mViewPositions)
+                {
+                    const glm::vec3 offset = asset->mLocation - viewPos;
+                    distSqr = std::min(distSqr, glm::dot(offset, offset));
+                }
+            }
+            if (closestIter == ioQueue.end() || distSqr < closestDistSqr)
+            {
+                closestIter = assetIter;
+                closestDistSqr = distSqr;
+            }
+        }
+
+        AssetHandle<Asset> asset = *closestIter;
+        ioQueue.erase(closestIter);
+        return asset;
+    }
+
+    void AssetManager::IOThreadLoop()
+    {
+        PROFILE_THREAD_NAME("Asset I/O");
+        while (true)
+        {
+            AssetHandle<Asset> asset;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mReadCondition.wait(lock, [this] { return mShutdown || !mReadQueue.empty(); });
+                if (mShutdown)
+                    return;
+                asset = PopClosestAsset(mReadQueue);
+            }
+
+            if (!asset->ReadsOwnFile())
+            {
+                PROFILE_ZONE("ReadAssetFile");
+                std::ifstream file(asset->mPath, std::ios::binary | std::ios::ate);
+                if (file.is_open())
+                {
+                    asset->mFileData.resize((size_t)file.tellg());
+                    file.seekg(0);
+                    file.read(asset->mFileData.data(), asset->mFileData.size());
+                }
+                if (!file.is_open() || !file.good())
+                {
+                    LOG_ERROR() << "Failed to read asset file: " << asset->mPath;
+                    asset->mState = EAssetState::Failed;
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mFinaliseQueue.push_back(asset); // for the callbacks
+                    continue;
+                }
+            }
+
+            asset->mState = EAssetState::Decoding;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mDecodeQueue.push_back(asset);
+            }
+            mDecodeCondition.notify_one();
+        }
+    }
+
+    void AssetManager::WorkerThreadLoop()
+    {
+        PROFILE_THREAD_NAME("Asset Worker");
+        while (true)
+        {
+            AssetHandle<Asset> asset;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mDecodeCondition.wait(lock, [this] { return mShutdown || !mDecodeQueue.empty(); });
+                if (mShutdown)
+                    return;
+                asset = PopClosestAsset(mDecodeQueue);
+            }
+
+            bool decoded;
+            {
+                PROFILE_ZONE("DecodeAsset");
+                decoded = asset->Decode();
+            }
+            asset->mFileData.clear();
+            asset->mFileData.shrink_to_fit();
+            if (!decoded)
+                LOG_ERROR() << "Failed to decode asset: " << asset->mPath;
+            asset->mState = decoded ? EAssetState::Uploading : EAssetState::Failed;
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            mFinaliseQueue.push_back(asset);
+        }
+    }
+
+    void AssetManager::QueueAsset(AssetHandle<Asset> inAsset, AssetCallback inCallback, const glm::vec3* inLocation)
+    {
+        if (inCallback != nullptr)
+            inAsset->mCallbacks.push_back(inCallback);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (inLocation != nullptr)
+            {
+                inAsset->mLocation = *inLocation;
+                inAsset->mHasLocation = true;
+            }
+            mReadQueue.push_back(inAsset);
+            mNumPendingAssets++;
+        }
+        mReadCondition.notify_one();
+    }
+
+    void AssetManager::CompleteAsset(Asset* inAsset, EAssetState inState)
+    {
+        inAsset->mState = inState;
+        for (AssetCallback& callback : inAsset->mCallbacks)
+            callback(inAsset);
+        inAsset->mCallbacks.clear();
+    }
+
+    void AssetManager::Update()
+    {
+        const auto startTime = std::chrono::high_resolution_clock::now();
+
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        mViewPositions.clear();
+        for (const Camera* camera : GGameEngine->GetSceneRenderer()->GetCameras())
+            mViewPositions.push_back(glm::vec3(glm::inverse(camera->mCameraMatrix)[3]));
+
+        while (!mFinaliseQueue.empty())
+        {
+            AssetHandle<Asset> asset = PopClosestAsset(mFinaliseQueue);
+            lock.unlock();
+
+            {
+                PROFILE_ZONE("FinaliseAsset");
+                if (asset->GetState() == EAssetState::Failed)
+                    CompleteAsset(asset.get(), EAssetState::Failed);
+                else
+                    CompleteAsset(asset.get(), asset->Finalise() ? EAssetState::Ready : EAssetState::Failed);
+                asset = nullptr;
+            }
+
+            const std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+            lock.lock();
+            mNumPendingAssets--;
+            if (elapsed.count() >= mFinaliseBudgetMs)
+                break;
+        }
+    }
+
+    void AssetManager::SetAssetLocation(AssetHandle<Asset> inAsset, const glm::vec3& inLocation)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        inAsset->mLocation = inLocation;
+        inAsset->mHasLocation = true;
+    }
+
+    void AssetManager::FlushAll()
+    {
+        const float oldBudget = mFinaliseBudgetMs;
+        mFinaliseBudgetMs = std::numeric_limits<float>::max();
+        while (GetNumPendingAssets() > 0)
+        {
+            Update();
+            std::this_thread::yield();
+        }
+        mFinaliseBudgetMs = oldBudget;
+    }
+
+    size_t AssetManager::GetNumPendingAssets()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mNumPendingAssets;
+    }
+
+    AssetHandle<TextureAsset> AssetManager::LoadTextureAsync(const std::string& inPath, int inFlags, AssetCallback inCallback)
+    {
+        AssetHandle<TextureAsset> asset = std::make_shared<TextureAsset>(inPath, inFlags);
+        QueueAsset(asset, inCallback, nullptr);
+        return asset;
+    }
+
+    AssetHandle<ModelAsset> AssetManager::LoadModelAsync(const std::string& inPath, Actor* inActor, int inFlags, AssetCallback inCallback)
+    {
+        AssetHandle<CookedModel> cookedModel = GGameEngine->GetAssetRegistry()->FindModel(ModelLoader::GetModelKey(inPath.c_str(), inFlags));
+        AssetHandle<ModelAsset> asset = std::make_shared<ModelAsset>(inPath, inActor, inFlags, cookedModel);
+        const glm::vec3 location = inActor->GetTransform().GetWorldPosition();
+        QueueAsset(asset, inCallback, &location);
+        return asset;
+    }
+
+    AssetHandle<MaterialAsset> AssetManager::LoadMaterialAsync(const MaterialParams& inParams, AssetCallback inCallback)
+    {
+        AssetHandle<MaterialAsset> asset = std::make_shared<MaterialAsset>(inParams);
+        QueueAsset(asset, inCallback, nullptr);
+        return asset;
+    }
+
+    std::vector<AssetHandle<ShaderAsset>> AssetManager::PrecompileShaderAsync(const std::string& inProgramPath, AssetCallback inCallback)
+    {
+        std::vector<AssetHandle<ShaderAsset>> assets;
+        for (const ShaderParserParams& permutation : ShaderCache::GetPermutations(inProgramPath))
+        {
+            MaterialParams params;
+            params.mShaderProgramPath = permutation.mShaderProgramPath;
+            params.mPreprocessorDefinitions = permutation.mPreprocessorDefinitions;
+            AssetHandle<ShaderAsset> asset = std::make_shared<ShaderAsset>(params);
+            QueueAsset(asset, inCallback, nullptr);
+            assets.push_back(asset);
+        }
+        return assets;
+    }
+}
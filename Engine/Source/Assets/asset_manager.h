@@ -0,0 +1,84 @@
+#ifndef MING3D_ASSETMANAGER_H
+#define MING3D_ASSETMANAGER_H
+
+#include "asset.h"
+#include "Model/material_factory.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Ming3D
+{
+    class Actor;
+    class TextureAsset;
+    class ModelAsset;
+    class MaterialAsset;
+    class ShaderAsset;
+
+    /**
+    * Loads assets asynchronously, without blocking the frame loop.
+    * Files are read on an I/O thread and decoded on worker threads. GPU resources are created on the main thread (in Update),
+    *  within a time budget per frame.
+    * Assets with a location are prioritised by their distance to the closest camera. Assets without a location go first.
+    */
+    class AssetManager
+    {
+    private:
+        typedef std::vector<AssetHandle<Asset>> AssetQueue;
+
+        std::mutex mMutex;
+        std::condition_variable mReadCondition;
+        std::condition_variable mDecodeCondition;
+        AssetQueue mReadQueue;
+        AssetQueue mDecodeQueue;
+        AssetQueue mFinaliseQueue;
+        std::vector<glm::vec3> mViewPositions;
+        size_t mNumPendingAssets = 0; // queued, and not yet completed (or cancelled)
+        bool mShutdown = false;
+
+        std::thread mIOThread;
+        std::vector<std::thread> mWorkerThreads;
+
+        float mFinaliseBudgetMs = 2.0f;
+
+        void IOThreadLoop();
+        void WorkerThreadLoop();
+
+        /** Removes and returns the asset closest to a camera. Must be called with mMutex locked. */
+        AssetHandle<Asset> PopClosestAsset(AssetQueue& ioQueue);
+        void QueueAsset(AssetHandle<Asset> inAsset, AssetCallback inCallback, const glm::vec3* inLocation);
+        void CompleteAsset(Asset* inAsset, EAssetState inState);
+
+    public:
+        AssetManager();
+        ~AssetManager();
+
+        /** Main thread. Finalises decoded assets, and calls the completion callbacks. */
+        void Update();
+
+        /** Time (per frame) spent creating GPU resources for loaded assets. At least one asset is finalised per frame. */
+        void SetFinaliseBudget(float inMilliseconds) { mFinaliseBudgetMs = inMilliseconds; }
+
+        /** Sets the location used to prioritise a loading asset. */
+        void SetAssetLocation(AssetHandle<Asset> inAsset, const glm::vec3& inLocation);
+
+        /** Blocks until all queued assets are ready (or failed). For loading screens. */
+        void FlushAll();
+
+        /** Number of assets that are queued, being loaded or waiting to be finalised. */
+        size_t GetNumPendingAssets();
+
+        AssetHandle<TextureAsset> LoadTextureAsync(const std::string& inPath, int inFlags = 0, AssetCallback inCallback = nullptr);
+        /** Loads a model, and adds it to inActor (like ModelLoader::LoadModel) when ready. The actor must outlive the load. */
+        AssetHandle<ModelAsset> LoadModelAsync(const std::string& inPath, Actor* inActor, int inFlags = 0, AssetCallback inCallback = nullptr);
+        AssetHandle<MaterialAsset> LoadMaterialAsync(const MaterialParams& inParams, AssetCallback inCallback = nullptr);
+        /**
+        * Parses all permutations of a shader program (see ShaderCache::GetPermutations) in parallel on the worker threads,
+        *  and creates their GPU programs (which also fills the ShaderDiskCache). Keep the returned assets to keep the programs loaded.
+        */
+        std::vector<AssetHandle<ShaderAsset>> PrecompileShaderAsync(const std::string& inProgramPath, AssetCallback inCallback = nullptr);
+    };
+}
+
+#endif
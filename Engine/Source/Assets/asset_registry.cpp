@@ -0,0 +1,129 @@
+#include "asset_registry.h"
+
+#include "GameEngine/game_engine.h"
+#include "render_device.h"
+#include "shader_program.h"
+#include "texture_buffer.h"
+#include "vertex_buffer.h"
+#include "index_buffer.h"
+#include "texture.h"
+#include "texture_cache.h"
+#include "texture_streamer.h"
+#include "Model/mesh.h"
+#include "Model/mesh_buffer.h"
+#include "Debug/debug.h"
+
+namespace Ming3D
+{
+    namespace
+    {
+        void DeleteMeshBuffer(MeshBuffer* inMeshBuffer)
+        {
+            delete inMeshBuffer->mVertexBuffer;
+            delete inMeshBuffer->mIndexBuffer;
+            for (MeshLODBuffer& lod : inMeshBuffer->mLODs)
+                delete lod.mIndexBuffer;
+            delete inMeshBuffer;
+        }
+    }
+
+    AssetRegistry::~AssetRegistry()
+    {
+        mPersistentAssets.clear();
+    }
+
+    AssetHandle<ShaderProgram> AssetRegistry::GetShaderProgram(ParsedShaderProgram* inParsedProgram)
+    {
+        AssetHandle<ShaderProgram> shaderProgram = mShaderPrograms.Find(inParsedProgram);
+        if (shaderProgram == nullptr)
+        {
+            shaderProgram = AssetHandle<ShaderProgram>(GGameEngine->GetRenderDevice()->CreateShaderProgram(inParsedProgram));
+            mShaderPrograms.Add(inParsedProgram, shaderProgram);
+        }
+        return shaderProgram;
+    }
+
+    AssetHandle<ShaderProgram> AssetRegistry::GetDepthOnlyShaderProgram(ParsedShaderProgram* inParsedProgram)
+    {
+        AssetHandle<ShaderProgram> shaderProgram = mDepthOnlyShaderPrograms.Find(inParsedProgram);
+        if (shaderProgram == nullptr)
+        {
+            shaderProgram = AssetHandle<ShaderProgram>(GGameEngine->GetRenderDevice()->CreateDepthOnlyShaderProgram(inParsedProgram));
+            mDepthOnlyShaderPrograms.Add(inParsedProgram, shaderProgram);
+        }
+        return shaderProgram;
+    }
+
+    AssetHandle<TextureBuffer> AssetRegistry::GetTextureBuffer(const std::string& inPath, Texture* inTexture)
+    {
+        AssetHandle<TextureBuffer> textureBuffer = mTextureBuffers.Find(inPath);
+        if (textureBuffer == nullptr)
+        {
+            Texture* loadedTexture = inTexture == nullptr ? TextureCache::LoadTexture(inPath) : nullptr;
+            if (inTexture == nullptr && loadedTexture == nullptr)
+            {
+                LOG_ERROR() << "Failed to load texture: " << inPath;
+                return nullptr;
+            }
+            // The streamer keeps its own copy of the mips
+            textureBuffer = GGameEngine->GetTextureStreamer()->CreateStreamedTexture(inTexture != nullptr ? new Texture(*inTexture) : loadedTexture);
+            mTextureBuffers.Add(inPath, textureBuffer);
+        }
+        return textureBuffer;
+    }
+
+    AssetHandle<TextureBuffer> AssetRegistry::CreateTextureBuffer(Texture* inTexture)
+    {
+        return AssetHandle<TextureBuffer>(GGameEngine->GetRenderDevice()->CreateTextureBuffer(inTexture->GetTextureInfo(), inTexture->GetTextureData()));
+    }
+
+    AssetHandle<TextureArrayLayer> AssetRegistry::GetTextureArrayLayer(const std::string& inPath, Texture* inTexture)
+    {
+        AssetHandle<TextureArrayLayer> textureLayer = mTextureArrayLayers.Find(inPath);
+        if (textureLayer == nullptr)
+        {
+            Texture* loadedTexture = inTexture == nullptr ? TextureCache::LoadTexture(inPath) : nullptr;
+            if (inTexture == nullptr && loadedTexture == nullptr)
+            {
+                LOG_ERROR() << "Failed to load texture: " << inPath;
+                return nullptr;
+            }
+            // All mips are uploaded, so the texture isn't kept
+            textureLayer = mTextureArrayPool.AddTexture(inTexture != nullptr ? inTexture : loadedTexture);
+            delete loadedTexture;
+            mTextureArrayLayers.Add(inPath, textureLayer);
+        }
+        return textureLayer;
+    }
+
+    AssetHandle<MeshBuffer> AssetRegistry::GetMeshBuffer(const std::string& inKey, Mesh* inMesh)
+    {
+        AssetHandle<MeshBuffer> meshBuffer = mMeshBuffers.Find(inKey);
+        if (meshBuffer == nullptr)
+        {
+            meshBuffer = CreateMeshBuffer(inMesh);
+            mMeshBuffers.Add(inKey, meshBuffer);
+        }
+        return meshBuffer;
+    }
+
+    AssetHandle<MeshBuffer> AssetRegistry::CreateMeshBuffer(Mesh* inMesh)
+    {
+        RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
+        MeshBuffer* meshBuffer = new MeshBuffer();
+
+        meshBuffer->mVertexBuffer = renderDevice->CreateVertexBuffer(inMesh->mVertexData);
+        meshBuffer->mPositionDequantisation = inMesh->mVertexData->GetVertexLayout().GetPositionDequantisationMatrix();
+        meshBuffer->mIndexBuffer = renderDevice->CreateIndexBuffer(inMesh->mIndexData);
+        for (MeshLOD& lod : inMesh->mLODs)
+        {
+            MeshLODBuffer lodBuffer;
+            lodBuffer.mIndexBuffer = renderDevice->CreateIndexBuffer(lod.mIndexData);
+            lodBuffer.mScreenSize = lod.mScreenSize;
+            meshBuffer->mLODs.push_back(lodBuffer);
+        }
+        inMesh->CalculateBoundingSphere(meshBuffer->mBoundsCentre, meshBuffer->mBoundsRadius);
+
+        return AssetHandle<MeshBuffer>(meshBuffer, DeleteMeshBuffer);
+    }
+}
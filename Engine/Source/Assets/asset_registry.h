@@ -0,0 +1,94 @@
+#ifndef MING3D_ASSETREGISTRY_H
+#define MING3D_ASSETREGISTRY_H
+
+#include "asset.h"
+#include "texture_array_pool.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace Ming3D
+{
+    class ShaderProgram;
+    class ParsedShaderProgram;
+    class TextureBuffer;
+    class Texture;
+    class MeshBuffer;
+    class Mesh;
+    class CookedModel;
+
+    /**
+    * Registry of shared (GPU) resources, so identical assets are only loaded and uploaded once.
+    * Resources are keyed by their source (path and import parameters), and released when the last handle to them is released.
+    * Main thread only (resources are created on the render device).
+    */
+    class AssetRegistry
+    {
+    private:
+        template <typename TKey, typename T>
+        class AssetCache
+        {
+        private:
+            std::unordered_map<TKey, std::weak_ptr<T>> mAssets;
+
+        public:
+            AssetHandle<T> Find(const TKey& inKey)
+            {
+                auto assetIter = mAssets.find(inKey);
+                if (assetIter == mAssets.end())
+                    return nullptr;
+                AssetHandle<T> asset = assetIter->second.lock();
+                if (asset == nullptr)
+                    mAssets.erase(assetIter); // released
+                return asset;
+            }
+
+            void Add(const TKey& inKey, AssetHandle<T> inAsset)
+            {
+                mAssets[inKey] = inAsset;
+            }
+
+            size_t GetNumAssets() const { return mAssets.size(); }
+        };
+
+        AssetCache<const ParsedShaderProgram*, ShaderProgram> mShaderPrograms;
+        AssetCache<const ParsedShaderProgram*, ShaderProgram> mDepthOnlyShaderPrograms;
+        AssetCache<std::string, TextureBuffer> mTextureBuffers;
+        AssetCache<std::string, TextureArrayLayer> mTextureArrayLayers;
+        AssetCache<std::string, MeshBuffer> mMeshBuffers;
+        AssetCache<std::string, CookedModel> mModels;
+
+        std::vector<std::shared_ptr<void>> mPersistentAssets;
+
+        TextureArrayPool mTextureArrayPool;
+
+    public:
+        ~AssetRegistry();
+
+        /** Shader program for a parsed program. Parsed programs are shared by the ShaderCache, so they identify the shader source and defines. */
+        AssetHandle<ShaderProgram> GetShaderProgram(ParsedShaderProgram* inParsedProgram);
+        AssetHandle<ShaderProgram> GetDepthOnlyShaderProgram(ParsedShaderProgram* inParsedProgram);
+
+        /** Texture buffer for an image file, streamed by the TextureStreamer. inTexture is used if the texture isn't loaded yet (or the file is loaded, if null). */
+        AssetHandle<TextureBuffer> GetTextureBuffer(const std::string& inPath, Texture* inTexture = nullptr);
+        /** Creates a texture buffer that isn't shared. */
+        static AssetHandle<TextureBuffer> CreateTextureBuffer(Texture* inTexture);
+        /** Layer of a shared texture array (see TextureArrayPool) for an image file. inTexture is used if the texture isn't loaded yet (or the file is loaded, if null). */
+        AssetHandle<TextureArrayLayer> GetTextureArrayLayer(const std::string& inPath, Texture* inTexture = nullptr);
+        TextureArrayPool* GetTextureArrayPool() { return &mTextureArrayPool; }
+
+        /** Mesh buffer with the given key. inMesh is uploaded if the key isn't registered yet. */
+        AssetHandle<MeshBuffer> GetMeshBuffer(const std::string& inKey, Mesh* inMesh);
+        AssetHandle<MeshBuffer> FindMeshBuffer(const std::string& inKey) { return mMeshBuffers.Find(inKey); }
+        /** Creates a mesh buffer that isn't shared. */
+        static AssetHandle<MeshBuffer> CreateMeshBuffer(Mesh* inMesh);
+
+        AssetHandle<CookedModel> FindModel(const std::string& inKey) { return mModels.Find(inKey); }
+        void AddModel(const std::string& inKey, AssetHandle<CookedModel> inModel) { mModels.Add(inKey, inModel); }
+
+        /** Keeps an asset loaded until the registry is destroyed (e.g. for assets that are used by objects without a lifetime). */
+        void KeepAlive(std::shared_ptr<void> inAsset) { mPersistentAssets.push_back(inAsset); }
+    };
+}
+
+#endif
@@ -0,0 +1,16 @@
+#include "material_asset.h"
+
+namespace Ming3D
+{
+    bool MaterialAsset::Decode()
+    {
+        mParsedProgram = MaterialFactory::GetShaderProgram(mParams);
+        return mParsedProgram != nullptr;
+    }
+
+    bool MaterialAsset::Finalise()
+    {
+        mMaterial = new Material(mParsedProgram);
+        return true;
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef MING3D_MATERIALASSET_H
+#define MING3D_MATERIALASSET_H
+
+#include "asset.h"
+#include "Model/material_factory.h"
+
+namespace Ming3D
+{
+    /**
+    * Material, with its shader program parsed on a worker thread.
+    */
+    class MaterialAsset : public Asset
+    {
+    private:
+        MaterialParams mParams;
+        ParsedShaderProgram* mParsedProgram = nullptr;
+        Material* mMaterial = nullptr;
+
+    protected:
+        virtual bool ReadsOwnFile() const override { return true; } // the preprocessor reads included files
+        virtual bool Decode() override;
+        virtual bool Finalise() override;
+
+    public:
+        MaterialAsset(const MaterialParams& inParams) : Asset(inParams.mShaderProgramPath), mParams(inParams) {}
+
+        Material* GetMaterial() { return mMaterial; }
+    };
+}
+
+#endif
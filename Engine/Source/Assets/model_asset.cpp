@@ -0,0 +1,42 @@
+#include "model_asset.h"
+
+#include "Model/model_helper.h"
+#include "Model/model_cache.h"
+#include "Model/mesh.h"
+#include "Model/material_factory.h"
+#include "GameEngine/game_engine.h"
+#include "asset_registry.h"
+
+namespace Ming3D
+{
+    bool ModelAsset::Decode()
+    {
+        // Already loaded models are shared (and not modified), so they are safe to read here
+        if (mCookedModel == nullptr)
+            mCookedModel = AssetHandle<CookedModel>(ModelLoader::LoadCookedModel(mPath.c_str(), mFlags));
+        if (mCookedModel == nullptr)
+            return false;
+
+        // Parse the shaders here, so only the GPU programs are created on the main thread
+        for (MaterialData* matData : mCookedModel->mMaterials)
+            MaterialFactory::GetShaderProgram(ModelLoader::GetMaterialParams(matData, mFlags));
+        return true;
+    }
+
+    bool ModelAsset::Finalise()
+    {
+        AssetRegistry* assetRegistry = GGameEngine->GetAssetRegistry();
+        const std::string modelKey = ModelLoader::GetModelKey(mPath.c_str(), mFlags);
+
+        // The same model may have been loaded while this one was decoding
+        AssetHandle<CookedModel> registeredModel = assetRegistry->FindModel(modelKey);
+        if (registeredModel != nullptr)
+            mCookedModel = registeredModel;
+        else
+            assetRegistry->AddModel(modelKey, mCookedModel);
+
+        ModelLoader::CreateModelActors(mCookedModel, modelKey, mActor, mFlags);
+        mCookedModel = nullptr;
+        return true;
+    }
+}
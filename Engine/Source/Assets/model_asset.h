@@ -0,0 +1,34 @@
+#ifndef MING3D_MODELASSET_H
+#define MING3D_MODELASSET_H
+
+#include "asset.h"
+
+namespace Ming3D
+{
+    class Actor;
+    class CookedModel;
+
+    /**
+    * Model loaded with ModelLoader, in the background.
+    * The model (and its shaders) are loaded and parsed on a worker thread. Actors and GPU resources are created when finalised.
+    */
+    class ModelAsset : public Asset
+    {
+    private:
+        Actor* mActor;
+        int mFlags;
+        AssetHandle<CookedModel> mCookedModel;
+
+    protected:
+        virtual bool ReadsOwnFile() const override { return true; }
+        virtual bool Decode() override;
+        virtual bool Finalise() override;
+
+    public:
+        /** inCookedModel is the model, if it's already loaded (see AssetRegistry). */
+        ModelAsset(const std::string& inPath, Actor* inActor, int inFlags, AssetHandle<CookedModel> inCookedModel)
+            : Asset(inPath), mActor(inActor), mFlags(inFlags), mCookedModel(inCookedModel) {}
+    };
+}
+
+#endif
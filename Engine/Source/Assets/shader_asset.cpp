@@ -0,0 +1,21 @@
+#include "shader_asset.h"
+
+#include "asset_registry.h"
+#include "GameEngine/game_engine.h"
+
+namespace Ming3D
+{
+    bool ShaderAsset::Decode()
+    {
+        mParsedProgram = MaterialFactory::GetShaderProgram(mParams);
+        return mParsedProgram != nullptr;
+    }
+
+    bool ShaderAsset::Finalise()
+    {
+        AssetRegistry* assetRegistry = GGameEngine->GetAssetRegistry();
+        mShaderProgram = assetRegistry->GetShaderProgram(mParsedProgram);
+        mDepthOnlyShaderProgram = assetRegistry->GetDepthOnlyShaderProgram(mParsedProgram);
+        return mShaderProgram != nullptr;
+    }
+}
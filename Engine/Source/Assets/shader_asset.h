@@ -0,0 +1,35 @@
+#ifndef MING3D_SHADERASSET_H
+#define MING3D_SHADERASSET_H
+
+#include "asset.h"
+#include "Model/material_factory.h"
+#include "shader_program.h"
+
+namespace Ming3D
+{
+    /**
+    * Shader program permutation, parsed on a worker thread.
+    * Holds the GPU programs (regular and depth-only), so they stay loaded for as long as the asset is kept.
+    */
+    class ShaderAsset : public Asset
+    {
+    private:
+        MaterialParams mParams;
+        ParsedShaderProgram* mParsedProgram = nullptr;
+        AssetHandle<ShaderProgram> mShaderProgram;
+        AssetHandle<ShaderProgram> mDepthOnlyShaderProgram;
+
+    protected:
+        virtual bool ReadsOwnFile() const override { return true; } // the preprocessor reads included files
+        virtual bool Decode() override;
+        virtual bool Finalise() override;
+
+    public:
+        ShaderAsset(const MaterialParams& inParams) : Asset(inParams.mShaderProgramPath), mParams(inParams) {}
+
+        ParsedShaderProgram* GetParsedProgram() { return mParsedProgram; }
+        AssetHandle<ShaderProgram> GetShaderProgram() { return mShaderProgram; }
+    };
+}
+
+#endif
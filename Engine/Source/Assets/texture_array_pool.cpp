@@ -0,0 +1,67 @@
+#include "texture_array_pool.h"
+
+#include "GameEngine/game_engine.h"
+#include "render_device.h"
+#include "texture_buffer.h"
+
+#include <algorithm>
+
+namespace Ming3D
+{
+    namespace
+    {
+        bool IsSameLayerFormat(const TextureInfo& inInfoA, const TextureInfo& inInfoB)
+        {
+            return inInfoA.mWidth == inInfoB.mWidth && inInfoA.mHeight == inInfoB.mHeight && inInfoA.mPixelFormat == inInfoB.mPixelFormat
+                && inInfoA.mBytesPerPixel == inInfoB.mBytesPerPixel && inInfoA.mMipLevels == inInfoB.mMipLevels;
+        }
+    }
+
+    TextureArrayLayer::~TextureArrayLayer()
+    {
+        mTextureArray->mFreeLayers.push_back(mLayer);
+    }
+
+    AssetHandle<TextureArrayLayer> TextureArrayPool::AddTexture(Texture* inTexture)
+    {
+        const TextureInfo textureInfo = inTexture->GetTextureInfo();
+
+        // Find an array with a free layer (and forget the released ones)
+        std::shared_ptr<TextureArray> textureArray;
+        for (auto arrayIter = mTextureArrays.begin(); arrayIter != mTextureArrays.end();)
+        {
+            std::shared_ptr<TextureArray> existingArray = arrayIter->lock();
+            if (existingArray == nullptr)
+            {
+                arrayIter = mTextureArrays.erase(arrayIter);
+                continue;
+            }
+            if (textureArray == nullptr && !existingArray->mFreeLayers.empty() && IsSameLayerFormat(existingArray->mLayerInfo, textureInfo))
+                textureArray = existingArray;
+            arrayIter++;
+        }
+
+        RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
+        if (textureArray == nullptr)
+        {
+            const size_t layerSize = std::max(textureInfo.GetDataSize(), (size_t)1);
+            const unsigned int numLayers = (unsigned int)std::max((size_t)1, std::min((size_t)mMaxLayersPerArray, mMaxArraySize / layerSize));
+
+            textureArray = std::make_shared<TextureArray>();
+            textureArray->mTextureBuffer = AssetHandle<TextureBuffer>(renderDevice->CreateTextureArrayBuffer(textureInfo, numLayers));
+            textureArray->mLayerInfo = textureInfo;
+            textureArray->mNumLayers = numLayers;
+            for (unsigned int iLayer = numLayers; iLayer > 0; iLayer--)
+                textureArray->mFreeLayers.push_back(iLayer - 1); // lowest layer is used first
+            mTextureArrays.push_back(textureArray);
+        }
+
+        AssetHandle<TextureArrayLayer> layer = std::make_shared<TextureArrayLayer>();
+        layer->mTextureArray = textureArray;
+        layer->mLayer = textureArray->mFreeLayers.back();
+        textureArray->mFreeLayers.pop_back();
+
+        renderDevice->UpdateTextureArrayLayer(textureArray->mTextureBuffer.get(), layer->mLayer, textureInfo, inTexture->GetTextureData());
+        return layer;
+    }
+}
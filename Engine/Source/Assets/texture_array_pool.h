@@ -0,0 +1,56 @@
+#ifndef MING3D_TEXTUREARRAYPOOL_H
+#define MING3D_TEXTUREARRAYPOOL_H
+
+#include "asset.h"
+#include "texture.h"
+
+#include <vector>
+
+namespace Ming3D
+{
+    class TextureBuffer;
+
+    /** A 2D texture array, shared by textures with the same size, format and number of mip levels. */
+    class TextureArray
+    {
+    public:
+        AssetHandle<TextureBuffer> mTextureBuffer;
+        TextureInfo mLayerInfo;
+        unsigned int mNumLayers = 0;
+        std::vector<unsigned int> mFreeLayers;
+    };
+
+    /** A texture uploaded to one layer of a TextureArray. The layer is freed when this is destroyed. */
+    class TextureArrayLayer
+    {
+    public:
+        std::shared_ptr<TextureArray> mTextureArray; // keeps the array alive
+        unsigned int mLayer = 0;
+
+        ~TextureArrayLayer();
+    };
+
+    /**
+    * Packs textures with the same size, format and number of mip levels into 2D texture arrays.
+    * Materials that use layers of the same array (see Material::SetTexture) only differ by their layer uniform,
+    *  so they can be drawn one after the other without rebinding textures.
+    * Array textures aren't streamed (all their mips are resident). Main thread only.
+    */
+    class TextureArrayPool
+    {
+    private:
+        std::vector<std::weak_ptr<TextureArray>> mTextureArrays; // released when their last layer is destroyed
+        size_t mMaxArraySize = 32 * 1024 * 1024;
+        unsigned int mMaxLayersPerArray = 64;
+
+    public:
+        /** Uploads a texture to a free layer of an array with the same format. A new array is created if they are all full. */
+        AssetHandle<TextureArrayLayer> AddTexture(Texture* inTexture);
+
+        /** New arrays get as many layers as fit in this size (in bytes), and at least one. */
+        void SetMaxArraySize(size_t inBytes) { mMaxArraySize = inBytes; }
+        void SetMaxLayersPerArray(unsigned int inLayers) { mMaxLayersPerArray = inLayers; }
+    };
+}
+
+#endif
@@ -0,0 +1,31 @@
+#include "texture_asset.h"
+
+#include "texture_cache.h"
+#include "texture.h"
+
+namespace Ming3D
+{
+    TextureAsset::~TextureAsset()
+    {
+        delete mTexture;
+    }
+
+    bool TextureAsset::Decode()
+    {
+        mTexture = TextureCache::LoadTexture(mPath, mFileData.data(), mFileData.size(), mFlags);
+        return mTexture != nullptr;
+    }
+
+    bool TextureAsset::Finalise()
+    {
+        // Texture buffers are created by the material (see Material::SetTexture)
+        return true;
+    }
+
+    Texture* TextureAsset::ReleaseTexture()
+    {
+        Texture* texture = mTexture;
+        mTexture = nullptr;
+        return texture;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef MING3D_TEXTUREASSET_H
+#define MING3D_TEXTUREASSET_H
+
+#include "asset.h"
+
+namespace Ming3D
+{
+    class Texture;
+
+    class TextureAsset : public Asset
+    {
+    private:
+        Texture* mTexture = nullptr;
+        int mFlags;
+
+    protected:
+        virtual bool Decode() override;
+        virtual bool Finalise() override;
+
+    public:
+        /** inFlags: TEXTUREFLAGS_ (see TextureCache) */
+        TextureAsset(const std::string& inPath, int inFlags = 0) : Asset(inPath), mFlags(inFlags) {}
+        virtual ~TextureAsset();
+
+        /** Transfers ownership of the loaded texture to the caller (e.g. to pass it to Material::SetTexture). */
+        Texture* ReleaseTexture();
+    };
+}
+
+#endif
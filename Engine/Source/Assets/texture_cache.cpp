@@ -0,0 +1,151 @@
+#include "texture_cache.h"
+
+#include "texture.h"
+#include "texture_loader.h"
+#include "texture_processor.h"
+#include "Model/model_cache.h"
+#include "GameEngine/game_engine.h"
+#include "Platform/platform.h"
+#include "Debug/debug.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Ming3D
+{
+    namespace
+    {
+        const uint32_t CookedTextureMagic = 0x5444334D; // "M3DT"
+        const uint32_t CookedTextureVersion = 2;
+
+        struct CookedTextureHeader
+        {
+            uint32_t mMagic;
+            uint32_t mVersion;
+            uint64_t mSourceHash;
+            int32_t mFlags;
+            uint32_t mWidth;
+            uint32_t mHeight;
+            uint32_t mBytesPerPixel;
+            uint32_t mPixelFormat;
+            uint32_t mMipLevels;
+            uint64_t mDataSize;
+        };
+
+        std::string GetCachePath(const std::string& inSourcePath)
+        {
+            return inSourcePath + ".ctex";
+        }
+
+        Texture* LoadCookedTexture(const std::string& inSourcePath, uint64_t inSourceHash, int inFlags)
+        {
+            PlatformFile* platformFile = GGameEngine->GetPlatform()->mPlatformFile;
+            MappedFile* file = platformFile->MapFile(GetCachePath(inSourcePath));
+            if (file == nullptr)
+                return nullptr;
+
+            CookedTextureHeader header;
+            bool valid = file->mSize >= sizeof(header);
+            if (valid)
+            {
+                memcpy(&header, file->mData, sizeof(header));
+                valid = header.mMagic == CookedTextureMagic && header.mVersion == CookedTextureVersion
+                    && header.mSourceHash == inSourceHash && header.mFlags == (inFlags & TEXTUREFLAGS_COOKED_MASK);
+            }
+
+            Texture* texture = nullptr;
+            if (valid)
+            {
+                TextureInfo textureInfo;
+                textureInfo.mWidth = header.mWidth;
+                textureInfo.mHeight = header.mHeight;
+                textureInfo.mBytesPerPixel = header.mBytesPerPixel;
+                textureInfo.mPixelFormat = (PixelFormat)header.mPixelFormat;
+                textureInfo.mMipLevels = header.mMipLevels;
+
+                if (header.mDataSize == textureInfo.GetDataSize() && header.mDataSize <= file->mSize - sizeof(header))
+                {
+                    texture = new Texture();
+                    texture->SetTextureData(file->mData + sizeof(header), textureInfo);
+                }
+                else
+                {
+                    LOG_ERROR() << "Corrupt texture cache file: " << GetCachePath(inSourcePath);
+                }
+            }
+
+            platformFile->UnmapFile(file);
+            return texture;
+        }
+
+        bool SaveCookedTexture(const std::string& inSourcePath, uint64_t inSourceHash, int inFlags, const Texture* inTexture)
+        {
+            const TextureInfo& textureInfo = inTexture->mTextureInfo;
+
+            CookedTextureHeader header;
+            header.mMagic = CookedTextureMagic;
+            header.mVersion = CookedTextureVersion;
+            header.mSourceHash = inSourceHash;
+            header.mFlags = inFlags & TEXTUREFLAGS_COOKED_MASK;
+            header.mWidth = textureInfo.mWidth;
+            header.mHeight = textureInfo.mHeight;
+            header.mBytesPerPixel = textureInfo.mBytesPerPixel;
+            header.mPixelFormat = (uint32_t)textureInfo.mPixelFormat;
+            header.mMipLevels = textureInfo.mMipLevels;
+            header.mDataSize = inTexture->mTextureData.size();
+
+            // Written in one go, since other threads may have the old cache file mapped (see ModelCache::WriteCacheFile)
+            std::vector<char> fileData(sizeof(header) + inTexture->mTextureData.size());
+            memcpy(fileData.data(), &header, sizeof(header));
+            memcpy(fileData.data() + sizeof(header), inTexture->mTextureData.data(), inTexture->mTextureData.size());
+            return ModelCache::WriteCacheFile(GetCachePath(inSourcePath), fileData.data(), fileData.size());
+        }
+
+        void ProcessTexture(Texture* ioTexture, int inFlags)
+        {
+            if ((inFlags & TEXTUREFLAGS_NO_MIPS) == 0)
+                TextureProcessor::GenerateMipmaps(ioTexture);
+            if ((inFlags & TEXTUREFLAGS_NO_COMPRESSION) == 0 && TextureProcessor::CanCompress(ioTexture->mTextureInfo))
+                TextureProcessor::Compress(ioTexture, TextureProcessor::HasAlpha(ioTexture) ? PixelFormat::BC3 : PixelFormat::BC1);
+        }
+    }
+
+    Texture* TextureCache::LoadTexture(const std::string& inPath, int inFlags)
+    {
+        PlatformFile* platformFile = GGameEngine->GetPlatform()->mPlatformFile;
+        MappedFile* file = platformFile->MapFile(inPath);
+        if (file == nullptr)
+            return nullptr;
+
+        Texture* texture = LoadTexture(inPath, file->mData, file->mSize, inFlags);
+        platformFile->UnmapFile(file);
+        return texture;
+    }
+
+    Texture* TextureCache::LoadTexture(const std::string& inPath, const char* inData, size_t inSize, int inFlags)
+    {
+        const bool useCache = (inFlags & TEXTUREFLAGS_NO_CACHE) == 0;
+        const uint64_t sourceHash = useCache ? ModelCache::HashData(inData, inSize) : 0;
+
+        if (useCache)
+        {
+            Texture* cookedTexture = LoadCookedTexture(inPath, sourceHash, inFlags);
+            if (cookedTexture != nullptr)
+                return cookedTexture;
+        }
+
+        const size_t extensionPos = inPath.find_last_of('.');
+        const std::string extension = extensionPos != std::string::npos ? inPath.substr(extensionPos + 1) : "";
+        Texture* texture = TextureLoader::LoadTextureData(inData, inSize, extension.empty() ? nullptr : extension.c_str(), (inFlags & TEXTUREFLAGS_PREMULTIPLY_ALPHA) != 0);
+        if (texture == nullptr)
+            return nullptr;
+
+        ProcessTexture(texture, inFlags);
+
+        if (useCache)
+            SaveCookedTexture(inPath, sourceHash, inFlags, texture);
+
+        return texture;
+    }
+}
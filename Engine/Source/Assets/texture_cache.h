@@ -0,0 +1,35 @@
+#ifndef MING3D_TEXTURECACHE_H
+#define MING3D_TEXTURECACHE_H
+
+#include <string>
+
+#define TEXTUREFLAGS_NO_MIPS 1
+#define TEXTUREFLAGS_NO_COMPRESSION 2 // keep 32 bit RGBA (e.g. for textures that are read by the CPU, or where BC artifacts are visible)
+#define TEXTUREFLAGS_NO_CACHE 4 // always decode the source image, and don't write the cooked texture cache
+#define TEXTUREFLAGS_PREMULTIPLY_ALPHA 8 // multiply the colour by alpha at load time (for premultiplied blending, and to avoid colour bleeding from transparent texels into mips)
+
+#define TEXTUREFLAGS_COOKED_MASK (TEXTUREFLAGS_NO_MIPS | TEXTUREFLAGS_NO_COMPRESSION | TEXTUREFLAGS_PREMULTIPLY_ALPHA)
+
+namespace Ming3D
+{
+    class Texture;
+
+    /**
+    * Loads textures as the GPU wants them: with a full mip chain, and block compressed (BC1, or BC3 if the texture has alpha).
+    * Processed textures are cached next to the source image ("<image>.ctex"), keyed by a hash of the source file and the flags,
+    *  so the (slow) processing only happens the first time a texture is loaded.
+    * Textures that can't be compressed (non power of two) are still mip mapped.
+    * Thread safe (no render device access), so it can be used by asset decoders.
+    */
+    class TextureCache
+    {
+    public:
+        /** Loads a texture through the cache. Returns nullptr if neither the cache nor the source image can be read. */
+        static Texture* LoadTexture(const std::string& inPath, int inFlags = 0);
+
+        /** Same as LoadTexture, for a source image that has already been read into memory. */
+        static Texture* LoadTexture(const std::string& inPath, const char* inData, size_t inSize, int inFlags = 0);
+    };
+}
+
+#endif
@@ -0,0 +1,227 @@
+#include "texture_streamer.h"
+
+#include "asset_registry.h"
+#include "GameEngine/game_engine.h"
+#include "Model/material_buffer.h"
+#include "render_device.h"
+#include "texture.h"
+#include "texture_buffer.h"
+#include "Debug/debug_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <vector>
+
+namespace Ming3D
+{
+    namespace
+    {
+        /** The mip chain starting at inMip, as a texture of its own. */
+        TextureInfo GetMipChainInfo(const TextureInfo& inTextureInfo, unsigned int inMip)
+        {
+            TextureInfo textureInfo = inTextureInfo;
+            textureInfo.mWidth = inTextureInfo.GetMipWidth(inMip);
+            textureInfo.mHeight = inTextureInfo.GetMipHeight(inMip);
+            textureInfo.mMipLevels = inTextureInfo.mMipLevels - inMip;
+            return textureInfo;
+        }
+
+        void DeleteStreamedTextureBuffer(TextureBuffer* inTextureBuffer)
+        {
+            TextureStreamer* textureStreamer = GGameEngine->GetTextureStreamer();
+            if (textureStreamer != nullptr)
+                textureStreamer->RemoveTexture(inTextureBuffer);
+            delete inTextureBuffer;
+        }
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        for (auto& texture : mTextures)
+        {
+            delete texture.second->mTexture;
+            delete texture.second;
+        }
+    }
+
+    size_t TextureStreamer::GetResidentSize(const StreamedTexture* inTexture, unsigned int inMip)
+    {
+        const TextureInfo& textureInfo = inTexture->mTexture->mTextureInfo;
+        return textureInfo.GetDataSize() - textureInfo.GetMipLevelOffset(inMip);
+    }
+
+    AssetHandle<TextureBuffer> TextureStreamer::CreateStreamedTexture(Texture* inTexture)
+    {
+        const TextureInfo& textureInfo = inTexture->mTextureInfo;
+
+        // Block compressed textures need a base level of whole blocks
+        unsigned int tailMip = 0;
+        while (tailMip + 1 < textureInfo.mMipLevels && std::max(textureInfo.GetMipWidth(tailMip + 1), textureInfo.GetMipHeight(tailMip + 1)) >= mTailSize
+            && (!textureInfo.IsCompressed() || (textureInfo.GetMipWidth(tailMip + 1) % 4 == 0 && textureInfo.GetMipHeight(tailMip + 1) % 4 == 0)))
+            tailMip++;
+
+        if (tailMip == 0)
+        {
+            AssetHandle<TextureBuffer> textureBuffer = AssetRegistry::CreateTextureBuffer(inTexture);
+            delete inTexture;
+            return textureBuffer;
+        }
+
+        // Only the tail is loaded up front
+        StreamedTexture* texture = new StreamedTexture();
+        texture->mTexture = inTexture;
+        texture->mTailMip = tailMip;
+        texture->mResidentMip = tailMip;
+        texture->mRequestedMip = tailMip;
+        texture->mTextureBuffer = GGameEngine->GetRenderDevice()->CreateTextureBuffer(GetMipChainInfo(textureInfo, tailMip), inTexture->mTextureData.data() + textureInfo.GetMipLevelOffset(tailMip));
+        mTextures[texture->mTextureBuffer] = texture;
+        mResidentSize += GetResidentSize(texture, tailMip);
+
+        return AssetHandle<TextureBuffer>(texture->mTextureBuffer, DeleteStreamedTextureBuffer);
+    }
+
+    void TextureStreamer::RemoveTexture(const TextureBuffer* inTextureBuffer)
+    {
+        auto textureIter = mTextures.find(inTextureBuffer);
+        if (textureIter == mTextures.end())
+            return;
+
+        StreamedTexture* texture = textureIter->second;
+        mResidentSize -= GetResidentSize(texture, texture->mResidentMip);
+        delete texture->mTexture;
+        delete texture;
+        mTextures.erase(textureIter);
+    }
+
+    void TextureStreamer::RequestMaterialMips(const MaterialBuffer* inMaterial, float inScreenPixels)
+    {
+        for (const AssetHandle<TextureBuffer>& textureBuffer : inMaterial->mTextureBuffers)
+        {
+            if (textureBuffer == nullptr)
+                continue;
+            auto textureIter = mTextures.find(textureBuffer.get());
+            if (textureIter == mTextures.end())
+                continue;
+
+            // Assumes the texture is mapped once over the object: one texel per pixel at the requested mip
+            StreamedTexture* texture = textureIter->second;
+            const TextureInfo& textureInfo = texture->mTexture->mTextureInfo;
+            const float textureSize = (float)std::max(textureInfo.mWidth, textureInfo.mHeight);
+            const float mip = std::log2(textureSize / std::max(inScreenPixels, 1.0f)) + mMipBias;
+            const unsigned int requestedMip = mip > 0.0f ? std::min((unsigned int)mip, texture->mTailMip) : 0;
+
+            texture->mRequestedMip = std::min(texture->mRequestedMip, requestedMip);
+            texture->mLastUsedFrame = mFrame;
+        }
+    }
+
+    void TextureStreamer::SetResidentMip(StreamedTexture* inTexture, unsigned int inMip)
+    {
+        const TextureInfo& textureInfo = inTexture->mTexture->mTextureInfo;
+        GGameEngine->GetRenderDevice()->UpdateTextureBuffer(inTexture->mTextureBuffer, GetMipChainInfo(textureInfo, inMip), inTexture->mTexture->mTextureData.data() + textureInfo.GetMipLevelOffset(inMip));
+
+        mResidentSize -= GetResidentSize(inTexture, inTexture->mResidentMip);
+        mResidentSize += GetResidentSize(inTexture, inMip);
+        inTexture->mResidentMip = inMip;
+    }
+
+    void TextureStreamer::Update()
+    {
+        struct StreamingTarget
+        {
+            StreamedTexture* mTexture;
+            unsigned int mRequiredMip; // what the scene needs (the tail, if the texture wasn't drawn)
+            unsigned int mTargetMip;
+        };
+
+        // Stream in what was requested. Keep resident mips that are no longer needed, unless they don't fit the budget.
+        std::vector<StreamingTarget> targets;
+        targets.reserve(mTextures.size());
+        size_t targetSize = 0;
+        for (auto& textureEntry : mTextures)
+        {
+            StreamedTexture* texture = textureEntry.second;
+            StreamingTarget target;
+            target.mTexture = texture;
+            target.mRequiredMip = texture->mLastUsedFrame == mFrame ? texture->mRequestedMip : texture->mTailMip;
+            target.mTargetMip = std::min(target.mRequiredMip, texture->mResidentMip);
+            targets.push_back(target);
+            targetSize += GetResidentSize(texture, target.mTargetMip);
+            texture->mRequestedMip = texture->mTailMip;
+        }
+
+        // Fit the budget: drop mips that aren't required first, then the largest mips
+        if (targetSize > mBudget)
+        {
+            auto compareDropPriority = [](const StreamingTarget* inLeft, const StreamingTarget* inRight)
+            {
+                const bool leftRequired = inLeft->mTargetMip >= inLeft->mRequiredMip;
+                const bool rightRequired = inRight->mTargetMip >= inRight->mRequiredMip;
+                if (leftRequired != rightRequired)
+                    return leftRequired;
+                return inLeft->mTexture->mTexture->mTextureInfo.GetMipLevelSize(inLeft->mTargetMip) < inRight->mTexture->mTexture->mTextureInfo.GetMipLevelSize(inRight->mTargetMip);
+            };
+            std::priority_queue<StreamingTarget*, std::vector<StreamingTarget*>, decltype(compareDropPriority)> dropQueue(compareDropPriority);
+            for (StreamingTarget& target : targets)
+            {
+                if (target.mTargetMip < target.mTexture->mTailMip)
+                    dropQueue.push(&target);
+            }
+
+            while (targetSize > mBudget && !dropQueue.empty())
+            {
+                StreamingTarget* target = dropQueue.top();
+                dropQueue.pop();
+                targetSize -= target->mTexture->mTexture->mTextureInfo.GetMipLevelSize(target->mTargetMip);
+                target->mTargetMip++;
+                if (target->mTargetMip < target->mTexture->mTailMip)
+                    dropQueue.push(target);
+            }
+        }
+
+        // Evict first (frees memory), then stream in within the upload budget
+        int numEvicted = 0;
+        for (StreamingTarget& target : targets)
+        {
+            if (target.mTargetMip > target.mTexture->mResidentMip)
+            {
+                SetResidentMip(target.mTexture, target.mTargetMip);
+                numEvicted++;
+            }
+        }
+        size_t uploadedSize = 0;
+        for (StreamingTarget& target : targets)
+        {
+            if (target.mTargetMip >= target.mTexture->mResidentMip)
+                continue;
+            const size_t uploadSize = GetResidentSize(target.mTexture, target.mTargetMip);
+            if (uploadedSize > 0 && uploadedSize + uploadSize > mUploadBudget)
+                continue; // next frame
+            SetResidentMip(target.mTexture, target.mTargetMip);
+            uploadedSize += uploadSize;
+        }
+
+        mFrame++;
+
+        ADD_FRAME_STAT_INT("TextureStreaming.UploadedKB", (int)(uploadedSize / 1024));
+        ADD_FRAME_STAT_INT("TextureStreaming.Evictions", numEvicted);
+        UpdateStats();
+    }
+
+    void TextureStreamer::UpdateStats()
+    {
+#ifdef MING3D_DEBUG_STATS_ENABLED
+        int numFullyResident = 0;
+        for (auto& textureEntry : mTextures)
+        {
+            if (textureEntry.second->mResidentMip == 0)
+                numFullyResident++;
+        }
+        SET_DEBUG_STAT_INT("TextureStreaming.BudgetKB", (int)(mBudget / 1024));
+        SET_DEBUG_STAT_INT("TextureStreaming.ResidentKB", (int)(mResidentSize / 1024));
+        SET_DEBUG_STAT_INT("TextureStreaming.Textures", (int)mTextures.size());
+        SET_DEBUG_STAT_INT("TextureStreaming.FullyResidentTextures", numFullyResident);
+#endif
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef MING3D_TEXTURESTREAMER_H
+#define MING3D_TEXTURESTREAMER_H
+
+#include "asset.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace Ming3D
+{
+    class Texture;
+    class TextureBuffer;
+    class MaterialBuffer;
+
+    /**
+    * Streams the mip levels of textures in and out of video memory.
+    * Streamed textures start with only their small mips resident (the "tail"). Each frame, the scene renderer reports
+    *  the on-screen size of the materials it draws (RequestMaterialMips), and Update streams in the mips needed for that size.
+    * When the resident mips don't fit the budget, detail is dropped from the textures that weren't drawn recently first,
+    *  then from the textures with the largest resident mips.
+    * Textures keep all mip levels in system memory. Main thread only.
+    */
+    class TextureStreamer
+    {
+    private:
+        class StreamedTexture
+        {
+        public:
+            Texture* mTexture = nullptr; // all mip levels
+            TextureBuffer* mTextureBuffer = nullptr;
+            unsigned int mTailMip = 0; // mips from here on are always resident
+            unsigned int mResidentMip = 0; // largest resident mip level
+            unsigned int mRequestedMip = 0; // largest mip requested since the last update
+            uint64_t mLastUsedFrame = 0;
+        };
+
+        std::unordered_map<const TextureBuffer*, StreamedTexture*> mTextures;
+        uint64_t mFrame = 1;
+        size_t mResidentSize = 0;
+
+        size_t mBudget = 256 * 1024 * 1024;
+        size_t mUploadBudget = 16 * 1024 * 1024;
+        unsigned int mTailSize = 64;
+        float mMipBias = 0.0f;
+
+        /** Size of a texture in video memory, when mips from inMip on are resident. */
+        static size_t GetResidentSize(const StreamedTexture* inTexture, unsigned int inMip);
+        void SetResidentMip(StreamedTexture* inTexture, unsigned int inMip);
+        void UpdateStats();
+
+    public:
+        ~TextureStreamer();
+
+        /**
+        * Creates a streamed texture buffer. Takes ownership of the texture.
+        * Textures without mips (or too small to stream) get a regular texture buffer.
+        */
+        AssetHandle<TextureBuffer> CreateStreamedTexture(Texture* inTexture);
+        /** Called when a streamed texture buffer is destroyed. */
+        void RemoveTexture(const TextureBuffer* inTextureBuffer);
+
+        /** Mip feedback: the material is drawn at inScreenPixels (projected diameter of the object, in pixels). */
+        void RequestMaterialMips(const MaterialBuffer* inMaterial, float inScreenPixels);
+
+        /** Streams mips in and out, based on the requests since the last update. Call once per frame, after rendering. */
+        void Update();
+
+        /** Video memory available to streamed textures (in bytes). Tail mips are always resident, even if they exceed the budget. */
+        void SetBudget(size_t inBytes) { mBudget = inBytes; }
+        size_t GetBudget() const { return mBudget; }
+        /** Maximum amount of texture data uploaded per frame (in bytes). At least one texture is updated per frame. */
+        void SetUploadBudget(size_t inBytes) { mUploadBudget = inBytes; }
+        /** Mips of this size (and smaller) are always resident. */
+        void SetTailSize(unsigned int inSize) { mTailSize = inSize; }
+        /** Added to the requested mip level. Positive values trade detail for memory. */
+        void SetMipBias(float inBias) { mMipBias = inBias; }
+
+        size_t GetResidentSize() const { return mResidentSize; }
+        size_t GetNumTextures() const { return mTextures.size(); }
+    };
+}
+
+#endif
@@ -0,0 +1,38 @@
+#include "light_component.h"
+#include "GameEngine/game_engine.h"
+#include "SceneRenderer/scene_renderer.h"
+#include "Actors/actor.h"
+
+IMPLEMENT_CLASS(Ming3D::LightComponent)
+
+namespace Ming3D
+{
+    void LightComponent::InitialiseClass()
+    {
+
+    }
+
+    LightComponent::LightComponent()
+    {
+        mRenderSceneLight = new RenderSceneLight();
+    }
+
+    LightComponent::~LightComponent()
+    {
+        GGameEngine->GetSceneRenderer()->RemoveSceneLight(mRenderSceneLight);
+        delete mRenderSceneLight;
+    }
+
+    void LightComponent::InitialTick()
+    {
+        GGameEngine->GetSceneRenderer()->AddSceneLight(mRenderSceneLight);
+    }
+
+    void LightComponent::Tick(float inDeltaTime)
+    {
+        Component::Tick(inDeltaTime);
+
+        mRenderSceneLight->mPosition = mParent->GetTransform().GetWorldPosition();
+        mRenderSceneLight->mDirection = mParent->GetTransform().GetForward();
+    }
+}
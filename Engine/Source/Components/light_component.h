@@ -0,0 +1,37 @@
+#ifndef MING3D_LIGHTCOMPONENT_H
+#define MING3D_LIGHTCOMPONENT_H
+
+#include "component.h"
+#include "SceneRenderer/render_scene_light.h"
+
+namespace Ming3D
+{
+    /**
+    * A dynamic point or spot light, rendered through the clustered forward lighting path.
+    * Spot lights point along the actor's forward direction.
+    */
+    class LightComponent : public Component
+    {
+        DEFINE_CLASS(Ming3D::LightComponent, Ming3D::Component)
+
+    private:
+        static void InitialiseClass();
+
+        RenderSceneLight* mRenderSceneLight = nullptr;
+
+    protected:
+        virtual void InitialTick() override;
+        virtual void Tick(float inDeltaTime) override;
+
+    public:
+        LightComponent();
+        virtual ~LightComponent();
+
+        void SetLightType(ELightType inType) { mRenderSceneLight->mLightType = inType; }
+        void SetColour(const glm::vec3& inColour) { mRenderSceneLight->mColour = inColour; }
+        void SetRange(float inRange) { mRenderSceneLight->mRange = inRange; }
+        void SetSpotAngle(float inDegrees) { mRenderSceneLight->mSpotAngle = inDegrees; }
+    };
+}
+
+#endif
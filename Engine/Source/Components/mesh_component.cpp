@@ -7,6 +7,7 @@
 #include "SceneRenderer/scene_renderer.h"
 #include "Actors/actor.h"
 #include "Model/material_factory.h"
+#include "Assets/asset_registry.h"
 
 IMPLEMENT_CLASS(Ming3D::MeshComponent)
 
@@ -29,22 +30,21 @@ namespace Ming3D
 
     void MeshComponent::SetMesh(Mesh* inMesh)
     {
-        mMesh = inMesh;
-
-        RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
-        MeshBuffer* meshBuffer = new MeshBuffer();
+        SetMesh(AssetHandle<Mesh>(inMesh, [](Mesh*) {}), AssetRegistry::CreateMeshBuffer(inMesh));
+    }
 
-        // TODO: Store vertex layout in mesh
-        VertexData* vertexData = inMesh->mVertexData;
-        IndexData* indexData(inMesh->mIndexData);
+    void MeshComponent::SetMesh(AssetHandle<Mesh> inMesh, AssetHandle<MeshBuffer> inMeshBuffer)
+    {
+        const bool addToScene = mMeshBuffer == nullptr;
 
-        meshBuffer->mVertexBuffer = renderDevice->CreateVertexBuffer(vertexData);
-        meshBuffer->mIndexBuffer = renderDevice->CreateIndexBuffer(indexData);
+        mMesh = inMesh;
+        mMeshBuffer = inMeshBuffer;
 
         mRenderSceneObject->mModelMatrix = mParent->GetTransform().GetWorldTransformMatrix();
-        mRenderSceneObject->mMesh = meshBuffer;
+        mRenderSceneObject->mMesh = mMeshBuffer.get();
 
-        GGameEngine->GetSceneRenderer()->AddSceneObject(mRenderSceneObject);
+        if (addToScene)
+            GGameEngine->GetSceneRenderer()->AddSceneObject(mRenderSceneObject);
     }
 
     void MeshComponent::SetMaterial(Material* inMat)
@@ -15,19 +15,23 @@ namespace Ming3D
     private:
         static void InitialiseClass();
 
-        Mesh* mMesh = nullptr;
+        AssetHandle<Mesh> mMesh;
+        AssetHandle<MeshBuffer> mMeshBuffer;
         Material* mMaterial = nullptr;
         RenderSceneObject* mRenderSceneObject = nullptr;
 
     public:
         MeshComponent();
         virtual void InitialiseComponent();
+        /** Sets a mesh that isn't shared with other components. The mesh is not owned by the component. */
         void SetMesh(Mesh* inMesh);
+        /** Sets a (shared) mesh, with its (shared) GPU buffers. See AssetRegistry. */
+        void SetMesh(AssetHandle<Mesh> inMesh, AssetHandle<MeshBuffer> inMeshBuffer);
         void SetMaterial(Material* inMat);
     
         virtual void Tick(float inDeltaTime) override;
 
-        Mesh* GetMesh() { return mMesh; };
+        Mesh* GetMesh() { return mMesh.get(); };
         Material* GetMaterial() { return mMaterial; }
     };
 }
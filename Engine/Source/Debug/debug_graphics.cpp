@@ -10,23 +10,28 @@
 #include "Model/primitive_factory.h"
 #include "Model/material_factory.h"
 #include "Model/mesh.h"
+#include "Assets/asset_registry.h"
 
 namespace Ming3D
 {
     // TODO: add rotation parameter
     void DebugGraphics::DrawBox(const glm::vec3& boxPos, const glm::vec3& boxSize, const glm::vec4& boxColour)
     {
-        RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
-        MeshBuffer* meshBuffer = new MeshBuffer();
-
-        Mesh* mesh = PrimitiveFactory::CreateBox(boxSize);
-
-        meshBuffer->mVertexBuffer = renderDevice->CreateVertexBuffer(mesh->mVertexData);
-        meshBuffer->mIndexBuffer = renderDevice->CreateIndexBuffer(mesh->mIndexData);
+        // All boxes share a unit box mesh, scaled by the model matrix
+        const char* boxMeshKey = "DebugGraphics/Box";
+        AssetRegistry* assetRegistry = GGameEngine->GetAssetRegistry();
+        AssetHandle<MeshBuffer> meshBuffer = assetRegistry->FindMeshBuffer(boxMeshKey);
+        if (meshBuffer == nullptr)
+        {
+            Mesh* mesh = PrimitiveFactory::CreateBox(glm::vec3(1.0f));
+            meshBuffer = assetRegistry->GetMeshBuffer(boxMeshKey, mesh);
+            assetRegistry->KeepAlive(meshBuffer); // debug boxes have no lifetime yet
+            delete mesh;
+        }
 
         RenderSceneObject* renderSceneObject = new RenderSceneObject();
         renderSceneObject->mModelMatrix = glm::translate(glm::mat4(1.0f), boxPos) * glm::mat4(1.0f) * glm::scale(glm::mat4(1.0f), boxSize);
-        renderSceneObject->mMesh = meshBuffer;
+        renderSceneObject->mMesh = meshBuffer.get();
         Material* mat = MaterialFactory::CreateMaterial("Resources/Shaders/debuggraphics.shader");
         renderSceneObject->mMaterial = mat->mMaterialBuffer;
 
@@ -11,12 +11,20 @@
 #include "render_device.h"
 #include "window_base.h"
 #include "render_window.h"
+#include "render_device_null.h"
+#include "window_null.h"
 #include "SceneRenderer/scene_renderer.h"
 #include "Networking/network_manager.h"
 #include "Components/camera_component.h"
 #include "Input/input_handler.h"
+#include "Input/input_handler_null.h"
 #include "Input/input_manager.h"
 #include "Debug/debug_stats.h"
+#include "Debug/profiler.h"
+#include "Assets/asset_manager.h"
+#include "Assets/asset_registry.h"
+#include "Assets/shader_asset.h"
+#include "Assets/texture_streamer.h"
 
 #ifdef MING3D_PHYSX
 #include "Physics/API/PhysX/physics_manager_physx.h"
@@ -53,12 +61,20 @@ namespace Ming3D
         mPhysicsManager = new PhysicsManagerNull();
 #endif
         mNetworkManager = new NetworkManager();
+        mAssetManager = new AssetManager();
+        mAssetRegistry = new AssetRegistry();
+        mTextureStreamer = new TextureStreamer();
     }
 
 	GameEngine::~GameEngine()
 	{
+        delete mAssetManager; // stops the loading threads
+        mPrecompiledShaders.clear();
+        delete mAssetRegistry;
 		delete mClassManager;
         delete mWorld;
+        delete mTextureStreamer; // after the world, which owns the materials that use streamed textures
+        mTextureStreamer = nullptr;
         delete mTimeManager;
         delete mRenderWindow;
         delete mWindow;
@@ -68,26 +84,44 @@ namespace Ming3D
         delete mPlatform;
     }
 
-	void GameEngine::Initialise()
+	void GameEngine::Initialise(bool inHeadless)
 	{
+        PROFILE_THREAD_NAME("Main");
         mClassManager->InitialiseClasses();
-        mPlatform->Initialise();
-        mWindow = mPlatform->CreateOSWindow();
-        mInputHandler = mPlatform->CreateInputHandler();
+        if (inHeadless)
+        {
+            LOG_INFO() << "Running headless, using null render device";
+            mWindow = new WindowNull();
+            mInputHandler = new InputHandlerNull();
+            mRenderDevice = new RenderDeviceNull();
+            mRenderWindow = mRenderDevice->CreateRenderWindow(mWindow);
+        }
+        else
+        {
+            mPlatform->Initialise();
+            mWindow = mPlatform->CreateOSWindow();
+            mInputHandler = mPlatform->CreateInputHandler();
+            mRenderDevice = mPlatform->CreateRenderDevice();
+            mRenderWindow = mPlatform->CreateRenderWindow(mWindow, mRenderDevice);
+        }
         mInputManager = new InputManager();
-        mRenderDevice = mPlatform->CreateRenderDevice();
-        mRenderWindow = mPlatform->CreateRenderWindow(mWindow, mRenderDevice);
         mRenderTarget = mRenderDevice->CreateRenderTarget(mRenderWindow);
         mTimeManager->Initialise();
         mSceneRenderer->Initialise();
 
+        // Parse and compile all permutations of the default shader in the background, so materials don't wait for them
+        mPrecompiledShaders = mAssetManager->PrecompileShaderAsync("Resources/Shaders/defaultshader.cgp");
+
         mPhysicsManager->CreatePhysicsScene();
 	}
 
     void GameEngine::Update()
     {
+        PROFILE_ZONE("GameEngine::Update");
+        mFrameTimings.Reset();
+
         mTimeManager->UpdateTime();
-        float deltaTime = mTimeManager->GetDeltaTimeSeconds();
+        float deltaTime = mFixedDeltaTime > 0.0f ? mFixedDeltaTime : mTimeManager->GetDeltaTimeSeconds();
         mDeltaTime = deltaTime;
         mTime += mDeltaTime;
 
@@ -95,19 +129,44 @@ namespace Ming3D
         mInputHandler->Update();
         mInputManager->Update();
 
-        mPhysicsManager->SimulateScenes(deltaTime);
+        {
+            PROFILE_ZONE("Physics");
+            ScopedFramePhaseTimer timer(mFrameTimings, EFramePhase::Physics);
+            mPhysicsManager->SimulateScenes(deltaTime);
+        }
+
+        {
+            PROFILE_ZONE("TickActors");
+            ScopedFramePhaseTimer timer(mFrameTimings, EFramePhase::Tick);
+            for (Actor* actor : mWorld->GetActors())
+            {
+                actor->Tick(deltaTime);
+            }
+        }
 
-        for (Actor* actor : mWorld->GetActors())
         {
-            actor->Tick(deltaTime);
+            PROFILE_ZONE("UpdateNetworks");
+            ScopedFramePhaseTimer timer(mFrameTimings, EFramePhase::Network);
+            mNetworkManager->UpdateNetworks();
         }
 
-        mNetworkManager->UpdateNetworks();
+        {
+            PROFILE_ZONE("AssetManager::Update");
+            ScopedFramePhaseTimer timer(mFrameTimings, EFramePhase::Assets);
+            mAssetManager->Update();
+        }
 
+        // Cull, Sort and Submit are timed by the SceneRenderer
         mRenderDevice->BeginRenderWindow(mRenderWindow);
         mSceneRenderer->Render();
         mRenderDevice->EndRenderWindow(mRenderWindow);
 
+        {
+            PROFILE_ZONE("TextureStreamer::Update");
+            ScopedFramePhaseTimer timer(mFrameTimings, EFramePhase::Assets);
+            mTextureStreamer->Update();
+        }
+
         HandleDebugStats();
     }
 
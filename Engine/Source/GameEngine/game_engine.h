@@ -1,6 +1,11 @@
 #ifndef MING3D_GAMEENGINE_H
 #define MING3D_GAMEENGINE_H
 
+#include <memory>
+#include <vector>
+
+#include "Time/frame_timings.h"
+
 namespace Ming3D
 {
 	class ClassManager;
@@ -17,6 +22,10 @@ namespace Ming3D
     class CameraComponent;
     class InputHandler;
     class InputManager;
+    class AssetManager;
+    class AssetRegistry;
+    class TextureStreamer;
+    class ShaderAsset;
 
 	class GameEngine
 	{
@@ -34,9 +43,15 @@ namespace Ming3D
         PhysicsManager* mPhysicsManager = nullptr;
         InputHandler* mInputHandler = nullptr;
         InputManager* mInputManager = nullptr;
+        AssetManager* mAssetManager = nullptr;
+        AssetRegistry* mAssetRegistry = nullptr;
+        TextureStreamer* mTextureStreamer = nullptr;
+        std::vector<std::shared_ptr<ShaderAsset>> mPrecompiledShaders; // keeps the default shader permutations loaded
 
         float mTime = 0.0f;
         float mDeltaTime = 0.0f;
+        float mFixedDeltaTime = 0.0f;
+        FrameTimings mFrameTimings;
 
         void HandleDebugStats();
 
@@ -44,7 +59,11 @@ namespace Ming3D
 		GameEngine();
 		~GameEngine();
 
-		void Initialise();
+		/**
+		* Initialises the engine.
+		* @param inHeadless If true, no OS window or GPU device is created, and a RenderDeviceNull is used (for servers and benchmarks).
+		*/
+		void Initialise(bool inHeadless = false);
         void Start();
         void Update();
 
@@ -62,9 +81,17 @@ namespace Ming3D
         inline RenderTarget* GetMainRenderTarget() { return mRenderTarget; }
         inline InputHandler* GetInputHandler() { return mInputHandler; }
         inline InputManager* GetInputManager() { return mInputManager; }
+        inline AssetManager* GetAssetManager() { return mAssetManager; }
+        inline AssetRegistry* GetAssetRegistry() { return mAssetRegistry; }
+        inline TextureStreamer* GetTextureStreamer() { return mTextureStreamer; }
         
         float GetDeltaTime() const { return mDeltaTime; }
         float GetTime() const { return mTime; }
+
+        /** Makes every frame advance the time by inDeltaTime seconds, regardless of the real time (0 to use the real time). For deterministic benchmarks and tests. */
+        void SetFixedDeltaTime(float inDeltaTime) { mFixedDeltaTime = inDeltaTime; }
+        /** Time spent in each phase of the last Update. */
+        FrameTimings& GetFrameTimings() { return mFrameTimings; }
     };
 }
 
@@ -0,0 +1,16 @@
+#ifndef MING3D_INPUTHANDLER_NULL_H
+#define MING3D_INPUTHANDLER_NULL_H
+
+#include "input_handler.h"
+
+namespace Ming3D
+{
+    /** Input handler of headless engines, which have no OS window to receive input from. */
+    class InputHandlerNull : public InputHandler
+    {
+    public:
+        virtual void Update() override {}
+    };
+}
+
+#endif
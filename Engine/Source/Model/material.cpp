@@ -4,8 +4,10 @@
 #include "shader_parser.h"
 #include "texture.h"
 #include "shader_info.h"
-#include "shader_uniform_data.h"
 #include "SceneRenderer/scene_renderer.h" // TODO
+#include "Assets/asset_registry.h"
+#include "Assets/texture_array_pool.h"
+#include "Debug/st_assert.h"
 
 namespace Ming3D
 {
@@ -17,39 +19,21 @@ namespace Ming3D
         mMaterialBuffer->mTextureBuffers.resize(numTextures);
 
         for (size_t iTexture = 0; iTexture < numTextures; iTexture++)
-        {
             mTextures[iTexture] = nullptr;
-            mMaterialBuffer->mTextureBuffers[iTexture] = nullptr;
-        }
-
-        int zeroValues[128] = { }; // zero-initialised
-
-        for (size_t iCB = 0; iCB < shaderProgram->mConstantBufferInfos.size(); iCB++)
-        {
-            const ConstantBufferInfo& constantBuffer = shaderProgram->mConstantBufferInfos[iCB];
-            mMaterialBuffer->mConstantBuffers.insert(constantBuffer.mName);
-        }
 
-        for (size_t iUniform = 0; iUniform < shaderProgram->mUniforms.size(); iUniform++)
+        // Uniforms are zero-initialised, except matrices (identity)
+        const ShaderUniformBlockLayout& uniformBlockLayout = shaderProgram->mUniformBlockLayout;
+        mMaterialBuffer->mUniformData.resize(uniformBlockLayout.mSize);
+        const glm::mat4 identMat(1.0f);
+        for (const ShaderUniformBlockMember& blockMember : uniformBlockLayout.mMembers)
         {
-            const ShaderVariableInfo& uniform = shaderProgram->mUniforms[iUniform];
-            ShaderUniformData* uniformData = new ShaderUniformData(uniform.mDatatypeInfo, uniform.mDatatypeInfo.GetDataSize());
-            switch (uniform.mDatatypeInfo.mDatatype)
-            {
-            case EShaderDatatype::Mat4x4:
-            {
-                glm::mat4 identMat(1.0f);
-                uniformData->SetData(&identMat);
-                break;
-            }
-            default:
-                uniformData->SetData(&zeroValues);
-            }
-            mMaterialBuffer->mShaderUniformMap.emplace(uniform.mName, uniformData);
+            if (blockMember.mDatatype == EShaderDatatype::Mat4x4)
+                memcpy(&mMaterialBuffer->mUniformData[blockMember.mOffset], &identMat, sizeof(identMat));
         }
 
         // TODO: Queue render thread command
-        mMaterialBuffer->mShaderProgram = GGameEngine->GetRenderDevice()->CreateShaderProgram(shaderProgram);
+        mMaterialBuffer->mParsedShaderProgram = shaderProgram;
+        mMaterialBuffer->mShaderProgram = GGameEngine->GetAssetRegistry()->GetShaderProgram(shaderProgram);
         GGameEngine->GetSceneRenderer()->RegisterMaterial(mMaterialBuffer); // TODO
     }
 
@@ -65,9 +49,33 @@ namespace Ming3D
         mTextures[textureIndex] = texture;
 
         // TODO: Queue render thread command
-        if (mMaterialBuffer->mTextureBuffers[textureIndex] != nullptr)
-            delete mMaterialBuffer->mTextureBuffers[textureIndex];
-        mMaterialBuffer->mTextureBuffers[textureIndex] = GGameEngine->GetRenderDevice()->CreateTextureBuffer(texture->GetTextureInfo(), texture->GetTextureData());
+        mMaterialBuffer->mTextureBuffers[textureIndex] = AssetRegistry::CreateTextureBuffer(texture);
+    }
+
+    void Material::SetTexture(size_t textureIndex, AssetHandle<TextureBuffer> textureBuffer)
+    {
+        if (mTextures[textureIndex] != nullptr)
+        {
+            delete mTextures[textureIndex];
+            mTextures[textureIndex] = nullptr;
+        }
+
+        mMaterialBuffer->mTextureBuffers[textureIndex] = textureBuffer;
+    }
+
+    void Material::SetTexture(size_t textureIndex, AssetHandle<TextureArrayLayer> textureLayer)
+    {
+        const ShaderTextureInfo& textureInfo = mMaterialBuffer->mParsedShaderProgram->mShaderTextures[textureIndex];
+        __AssertComment(textureInfo.mTextureType == "Texture2DArray", "Texture array layers can only be used by Texture2DArray textures");
+        if (textureLayer == nullptr)
+        {
+            SetTexture(textureIndex, AssetHandle<TextureBuffer>());
+            return;
+        }
+
+        // The texture buffer handle keeps the layer (and its array) alive
+        SetTexture(textureIndex, AssetHandle<TextureBuffer>(textureLayer, textureLayer->mTextureArray->mTextureBuffer.get()));
+        mMaterialBuffer->SetShaderUniformFloat(textureInfo.mTextureName + "Layer", (float)textureLayer->mLayer);
     }
 
     void Material::SetShaderUniformFloat(const std::string& inName, float inVal)
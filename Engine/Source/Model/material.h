@@ -9,6 +9,8 @@ namespace Ming3D
 {
     class ParsedShaderProgram;
     class Texture;
+    class TextureBuffer;
+    class TextureArrayLayer;
 
     class Material
     {
@@ -19,7 +21,12 @@ namespace Ming3D
         Material(ParsedShaderProgram* shaderProgram);
         ~Material();
 
+        /** Uploads the texture, and takes ownership of it. */
         void SetTexture(size_t textureIndex, Texture* texture);
+        /** Uses a (shared) texture buffer, e.g. from the AssetRegistry. */
+        void SetTexture(size_t textureIndex, AssetHandle<TextureBuffer> textureBuffer);
+        /** Uses a layer of a shared texture array, for Texture2DArray textures. Also sets the layer uniform ("<texture name>Layer"). */
+        void SetTexture(size_t textureIndex, AssetHandle<TextureArrayLayer> textureLayer);
 
         void SetShaderUniformFloat(const std::string& inName, float inVal);
         void SetShaderUniformInt(const std::string& inName, int inVal);
@@ -1,48 +1,98 @@
 #include "material_buffer.h"
-#include "shader_uniform_data.h"
+#include "shader_info.h"
 #include "Debug/debug.h"
+#include "Debug/st_assert.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace Ming3D
 {
-    void MaterialBuffer::UpdateUniformData(const std::string& inName, const void* inData)
+    constexpr size_t MaterialBuffer::InvalidUniformIndex;
+
+    size_t MaterialBuffer::GetUniformIndex(const std::string& inName) const
     {
-        auto it = mShaderUniformMap.find(inName);
-        if (it != mShaderUniformMap.end())
+        const std::vector<ShaderVariableInfo>& uniforms = mParsedShaderProgram->mUniforms;
+        for (size_t iUniform = 0; iUniform < uniforms.size(); iUniform++)
+        {
+            if (uniforms[iUniform].mName == inName)
+                return iUniform;
+        }
+        return InvalidUniformIndex;
+    }
+
+    void MaterialBuffer::UpdateUniformData(size_t inUniformIndex, const void* inData, size_t inSize)
+    {
+        if (inUniformIndex == InvalidUniformIndex)
+            return;
+
+        const ShaderUniformBlockMember& blockMember = mParsedShaderProgram->mUniformBlockLayout.mMembers[inUniformIndex];
+        if (blockMember.mSize != inSize)
+        {
+            __AssertComment(false, "Uniform type mismatch");
+            return;
+        }
+        memcpy(&mUniformData[blockMember.mOffset], inData, blockMember.mSize);
+        mUniformVersion++;
+
+        if (mDirtyUniformsBegin == mDirtyUniformsEnd)
         {
-            it->second->SetData(inData);
-            mModifiedUniforms.insert(inName);
+            mDirtyUniformsBegin = blockMember.mOffset;
+            mDirtyUniformsEnd = blockMember.mOffset + blockMember.mSize;
         }
         else
-            LOG_ERROR() << "Failed to find uniform with name: " << inName;
+        {
+            mDirtyUniformsBegin = std::min(mDirtyUniformsBegin, blockMember.mOffset);
+            mDirtyUniformsEnd = std::max(mDirtyUniformsEnd, blockMember.mOffset + blockMember.mSize);
+        }
+    }
+
+    void MaterialBuffer::ClearDirtyUniforms()
+    {
+        mDirtyUniformsBegin = mDirtyUniformsEnd = 0;
+        mDirtyUniformsVersion = mUniformVersion;
+    }
+
+    void MaterialBuffer::UpdateUniformData(const std::string& inName, const void* inData, size_t inSize)
+    {
+        const size_t uniformIndex = GetUniformIndex(inName);
+        if (uniformIndex != InvalidUniformIndex)
+            UpdateUniformData(uniformIndex, inData, inSize);
+        else
+        {
+            const std::vector<std::string>& strippedUniforms = mParsedShaderProgram->mStrippedUniforms;
+            if (std::find(strippedUniforms.begin(), strippedUniforms.end(), inName) == strippedUniforms.end())
+                LOG_ERROR() << "Failed to find uniform with name: " << inName;
+        }
     }
 
     void MaterialBuffer::SetShaderUniformFloat(const std::string& inName, float inVal)
     {
-        UpdateUniformData(inName, &inVal);
+        UpdateUniformData(inName, &inVal, sizeof(inVal));
     }
 
     void MaterialBuffer::SetShaderUniformInt(const std::string& inName, int inVal)
     {
-        UpdateUniformData(inName, &inVal);
+        UpdateUniformData(inName, &inVal, sizeof(inVal));
     }
 
     void MaterialBuffer::SetShaderUniformVec2(const std::string& inName, const glm::vec2& inVal)
     {
-        UpdateUniformData(inName, &inVal);
+        UpdateUniformData(inName, &inVal, sizeof(inVal));
     }
 
     void MaterialBuffer::SetShaderUniformVec3(const std::string& inName, const glm::vec3& inVal)
     {
-        UpdateUniformData(inName, &inVal);
+        UpdateUniformData(inName, &inVal, sizeof(inVal));
     }
 
     void MaterialBuffer::SetShaderUniformVec4(const std::string& inName, const glm::vec4& inVal)
     {
-        UpdateUniformData(inName, &inVal);
+        UpdateUniformData(inName, &inVal, sizeof(inVal));
     }
 
     void MaterialBuffer::SetShaderUniformMat4x4(const std::string& inName, const glm::mat4& inVal)
     {
-        UpdateUniformData(inName, &inVal);
+        UpdateUniformData(inName, &inVal, sizeof(inVal));
     }
 }
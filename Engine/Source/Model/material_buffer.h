@@ -1,30 +1,49 @@
 #ifndef MING3D_MATERIALBUFFER_H
 #define MING3D_MATERIALBUFFER_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
-#include <unordered_map>
 #include "glm/glm.hpp"
-#include <set>
+#include "Assets/asset.h"
 
 namespace Ming3D
 {
     // forward declarations
     class ShaderProgram;
     class TextureBuffer;
-    class ShaderUniformData;
+    class ParsedShaderProgram;
 
     class MaterialBuffer
     {
     private:
-        void UpdateUniformData(const std::string& inName, const void* inData);
+        void UpdateUniformData(const std::string& inName, const void* inData, size_t inSize);
+        void UpdateUniformData(size_t inUniformIndex, const void* inData, size_t inSize);
 
     public:
-        ShaderProgram* mShaderProgram = nullptr;
-        std::vector<TextureBuffer*> mTextureBuffers;
-        std::unordered_map<std::string, ShaderUniformData*> mShaderUniformMap;
-        std::set<std::string> mConstantBuffers;
-        std::set<std::string> mModifiedUniforms;
+        static constexpr size_t InvalidUniformIndex = ~(size_t)0;
+
+        // Shader programs and textures may be shared with other materials (see AssetRegistry)
+        AssetHandle<ShaderProgram> mShaderProgram;
+        AssetHandle<ShaderProgram> mDepthOnlyShaderProgram; // created on demand by the depth pre-pass
+        ParsedShaderProgram* mParsedShaderProgram = nullptr;
+        std::vector<AssetHandle<TextureBuffer>> mTextureBuffers;
+        std::vector<char> mUniformData; // uniform values, laid out by the parsed program's ShaderUniformBlockLayout
+        uint64_t mUniformVersion = 0; // incremented when a uniform is modified
+        // Byte range of mUniformData modified since mUniformVersion was mDirtyUniformsVersion (empty if mDirtyUniformsBegin == mDirtyUniformsEnd)
+        size_t mDirtyUniformsBegin = 0;
+        size_t mDirtyUniformsEnd = 0;
+        uint64_t mDirtyUniformsVersion = 0;
+
+        /** Index of a uniform, for SetShaderUniform. Returns InvalidUniformIndex if the program doesn't have it. */
+        size_t GetUniformIndex(const std::string& inName) const;
+
+        /** Sets a uniform by index (see GetUniformIndex), without looking up its name. */
+        template <typename T>
+        void SetShaderUniform(size_t inUniformIndex, const T& inVal)
+        {
+            UpdateUniformData(inUniformIndex, &inVal, sizeof(T));
+        }
 
         void SetShaderUniformFloat(const std::string& inName, float inVal);
         void SetShaderUniformInt(const std::string& inName, int inVal);
@@ -32,6 +51,9 @@ namespace Ming3D
         void SetShaderUniformVec3(const std::string& inName, const glm::vec3& inVal);
         void SetShaderUniformVec4(const std::string& inName, const glm::vec4& inVal);
         void SetShaderUniformMat4x4(const std::string& inName, const glm::mat4& inVal);
+
+        /** Empties the dirty range. Programs that were updated before this need a full upload (see mDirtyUniformsVersion). */
+        void ClearDirtyUniforms();
     };
 }
 
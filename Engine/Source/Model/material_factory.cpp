@@ -2,6 +2,7 @@
 
 #include "shader_parser.h"
 #include "shader_cache.h"
+#include "shader_disk_cache.h"
 
 namespace Ming3D
 {
@@ -12,7 +13,7 @@ namespace Ming3D
         return CreateMaterial(params);
     }
 
-    Material* MaterialFactory::CreateMaterial(const MaterialParams& inParams)
+    ParsedShaderProgram* MaterialFactory::GetShaderProgram(const MaterialParams& inParams)
     {
         ShaderParserParams params;
         params.mShaderProgramPath = inParams.mShaderProgramPath;
@@ -20,10 +21,28 @@ namespace Ming3D
         ParsedShaderProgram* parsedProgram = nullptr;
         if (!ShaderCache::GetCachedProgramInfo(params, parsedProgram))
         {
-            ShaderParser parser;
-            parsedProgram = parser.ParseShaderProgram(params);
+            parsedProgram = ShaderDiskCache::LoadProgram(params);
+            if (parsedProgram == nullptr)
+            {
+                ShaderParser parser;
+                parsedProgram = parser.ParseShaderProgram(params);
+            }
             ShaderCache::CacheProgramInfo(params, parsedProgram);
+            // Another thread may have parsed (and cached) the same program in the meantime. Use that one, and delete ours.
+            ParsedShaderProgram* cachedProgram = parsedProgram;
+            ShaderCache::GetCachedProgramInfo(params, cachedProgram);
+            if (cachedProgram != parsedProgram)
+            {
+                delete parsedProgram;
+                parsedProgram = cachedProgram;
+            }
         }
+        return parsedProgram;
+    }
+
+    Material* MaterialFactory::CreateMaterial(const MaterialParams& inParams)
+    {
+        ParsedShaderProgram* parsedProgram = GetShaderProgram(inParams);
         if (parsedProgram != nullptr)
         {
             Material* mat = new Material(parsedProgram);
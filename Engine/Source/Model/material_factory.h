@@ -18,6 +18,9 @@ namespace Ming3D
     public:
         static Material* CreateMaterial(const std::string& inShaderProgram);
         static Material* CreateMaterial(const MaterialParams& inParams);
+
+        /** Parses (or gets the cached) shader program of a material. Doesn't touch the render device, so it's safe to call from worker threads. */
+        static ParsedShaderProgram* GetShaderProgram(const MaterialParams& inParams);
     };
 }
 
@@ -1,4 +1,10 @@
 #include "mesh.h"
+#include "mesh_simplifier.h"
+#include "mesh_optimiser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace Ming3D
 {
@@ -9,5 +15,81 @@ namespace Ming3D
 
         if (mIndexData != nullptr)
             delete mIndexData;
+
+        for (MeshLOD& lod : mLODs)
+            delete lod.mIndexData;
+    }
+
+    void Mesh::CalculateBoundingSphere(glm::vec3& outCentre, float& outRadius)
+    {
+        const size_t vertCount = mVertexData->GetVertexLayout().GetComponentOffset(EVertexComponent::Position) != (size_t)-1 ? mVertexData->GetNumVertices() : 0;
+        if (vertCount == 0)
+        {
+            outCentre = glm::vec3(0.0f);
+            outRadius = 0.0f;
+            return;
+        }
+
+        // Centre of the AABB, and the distance to the furthest vertex
+        glm::vec3 minPos = glm::vec3(mVertexData->GetComponentValue(0, EVertexComponent::Position));
+        glm::vec3 maxPos = minPos;
+        for (size_t iVert = 1; iVert < vertCount; iVert++)
+        {
+            const glm::vec3 pos = glm::vec3(mVertexData->GetComponentValue(iVert, EVertexComponent::Position));
+            minPos = glm::min(minPos, pos);
+            maxPos = glm::max(maxPos, pos);
+        }
+        outCentre = (minPos + maxPos) * 0.5f;
+
+        float radiusSqr = 0.0f;
+        for (size_t iVert = 0; iVert < vertCount; iVert++)
+        {
+            const glm::vec3 offset = glm::vec3(mVertexData->GetComponentValue(iVert, EVertexComponent::Position)) - outCentre;
+            radiusSqr = std::max(radiusSqr, glm::dot(offset, offset));
+        }
+        outRadius = std::sqrt(radiusSqr);
+    }
+
+    void Mesh::GenerateLODs(int inMaxLevels)
+    {
+        // Screen error allowed for a LOD, as a fraction of the screen height (about 2 pixels at 1080p)
+        const float maxScreenError = 0.002f;
+        // Simplification error limit, relative to the mesh size
+        const float maxMeshError = 0.05f;
+
+        for (MeshLOD& lod : mLODs)
+            delete lod.mIndexData;
+        mLODs.clear();
+
+        std::vector<glm::vec3> positions(mVertexData->GetNumVertices());
+        for (size_t iVert = 0; iVert < positions.size(); iVert++)
+            positions[iVert] = glm::vec3(mVertexData->GetComponentValue(iVert, EVertexComponent::Position));
+
+        std::vector<unsigned int> indices(mIndexData->GetData(), mIndexData->GetData() + mIndexData->GetNumIndices());
+        std::vector<unsigned int> lodIndices;
+        size_t prevIndexCount = indices.size();
+        float prevScreenSize = 1.0f;
+
+        for (int iLevel = 1; iLevel <= inMaxLevels; iLevel++)
+        {
+            const size_t targetIndexCount = (indices.size() / 3 >> iLevel) * 3;
+            const float error = MeshSimplifier::Simplify(positions, indices, targetIndexCount, maxMeshError, lodIndices);
+
+            // Not worth an extra LOD
+            if (lodIndices.empty() || lodIndices.size() > prevIndexCount * 4 / 5)
+                break;
+
+            MeshOptimiser::OptimiseVertexCache(lodIndices, positions.size());
+
+            // The mesh fits in its bounding sphere, so its error on screen is at most error * screen size
+            MeshLOD lod;
+            lod.mScreenSize = error > 0.0f ? std::min(maxScreenError / error, prevScreenSize) : prevScreenSize;
+            lod.mIndexData = new IndexData(lodIndices.size());
+            memcpy(lod.mIndexData->GetData(), lodIndices.data(), lodIndices.size() * sizeof(unsigned int));
+            mLODs.push_back(lod);
+
+            prevIndexCount = lodIndices.size();
+            prevScreenSize = lod.mScreenSize;
+        }
     }
 }
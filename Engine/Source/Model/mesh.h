@@ -6,13 +6,34 @@
 
 namespace Ming3D
 {
+    /**
+    * Reduced level of detail of a mesh.
+    * Uses the mesh's vertex data, with a simplified index list.
+    */
+    class MeshLOD
+    {
+    public:
+        IndexData* mIndexData = nullptr;
+        float mScreenSize = 0.0f; // used when the mesh's bounding sphere covers less than this fraction of the screen height
+    };
+
     class Mesh
     {
     public:
         VertexData* mVertexData = nullptr;
         IndexData* mIndexData = nullptr;
+        std::vector<MeshLOD> mLODs; // from highest to lowest detail (mIndexData is LOD 0)
 
         ~Mesh();
+
+        /** Calculates a bounding sphere of the vertex positions (in mesh space). */
+        void CalculateBoundingSphere(glm::vec3& outCentre, float& outRadius);
+
+        /**
+        * Generates up to inMaxLevels simplified LODs, each with about half the triangles of the previous one.
+        * Stops early when the mesh can't be simplified further without visible error.
+        */
+        void GenerateLODs(int inMaxLevels);
     };
 }
 
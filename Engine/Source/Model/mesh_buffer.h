@@ -1,17 +1,34 @@
 #ifndef MING3D_MESHBUFFER_H
 #define MING3D_MESHBUFFER_H
 
+#include "glm/glm.hpp"
+#include <vector>
+
 namespace Ming3D
 {
     class VertexBuffer;
     class IndexBuffer;
     class TextureBuffer;
 
+    class MeshLODBuffer
+    {
+    public:
+        IndexBuffer* mIndexBuffer = nullptr;
+        float mScreenSize = 0.0f; // see MeshLOD
+    };
+
     class MeshBuffer
     {
     public:
         VertexBuffer* mVertexBuffer = nullptr;
         IndexBuffer* mIndexBuffer = nullptr;
+        // Mesh space bounding sphere, used for culling. Meshes with a negative radius are never culled.
+        glm::vec3 mBoundsCentre = glm::vec3(0.0f);
+        float mBoundsRadius = -1.0f;
+        std::vector<MeshLODBuffer> mLODs; // LOD 1 and up (mIndexBuffer is LOD 0)
+        glm::mat4 mPositionDequantisation = glm::mat4(1.0f); // applied to the model matrix when rendering (see VertexLayout::PositionScale)
+
+        IndexBuffer* GetIndexBuffer(int inLOD) const { return inLOD == 0 ? mIndexBuffer : mLODs[inLOD - 1].mIndexBuffer; }
     };
 }
 
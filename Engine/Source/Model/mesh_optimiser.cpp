@@ -0,0 +1,380 @@
+#include "mesh_optimiser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Ming3D
+{
+    namespace
+    {
+        // Vertex scoring, from Tom Forsyth's article
+        const int ForsythCacheSize = 32;
+        const float ForsythCacheDecayPower = 1.5f;
+        const float ForsythLastTriScore = 0.75f;
+        const float ForsythValenceBoostScale = 2.0f;
+        const float ForsythValenceBoostPower = 0.5f;
+
+        float GetVertexScore(int inCachePosition, unsigned int inRemainingTriangles)
+        {
+            if (inRemainingTriangles == 0)
+                return -1.0f; // no triangles left to add
+
+            float score = 0.0f;
+            if (inCachePosition >= 0)
+            {
+                if (inCachePosition < 3)
+                {
+                    // Used by the last triangle. Fixed score, so there's no strong preference for which edge the next triangle shares.
+                    score = ForsythLastTriScore;
+                }
+                else
+                {
+                    const float scaler = 1.0f / (ForsythCacheSize - 3);
+                    score = std::pow(1.0f - (inCachePosition - 3) * scaler, ForsythCacheDecayPower);
+                }
+            }
+
+            // Boost vertices with few triangles left, to get rid of lone triangles
+            score += ForsythValenceBoostScale * std::pow((float)inRemainingTriangles, -ForsythValenceBoostPower);
+            return score;
+        }
+
+        /** Simulates a FIFO post-transform cache, and returns the number of misses for each triangle. */
+        void SimulateVertexCache(const unsigned int* inIndices, size_t inNumIndices, size_t inNumVertices, size_t inCacheSize, std::vector<unsigned char>& outTriangleMisses)
+        {
+            std::vector<unsigned int> cacheTimestamps(inNumVertices, 0);
+            unsigned int timestamp = (unsigned int)inCacheSize + 1;
+
+            outTriangleMisses.resize(inNumIndices / 3);
+            for (size_t iIndex = 0; iIndex < inNumIndices; iIndex += 3)
+            {
+                unsigned char misses = 0;
+                for (int iCorner = 0; iCorner < 3; iCorner++)
+                {
+                    const unsigned int index = inIndices[iIndex + iCorner];
+                    if (timestamp - cacheTimestamps[index] > inCacheSize)
+                    {
+                        cacheTimestamps[index] = timestamp++;
+                        misses++;
+                    }
+                }
+                outTriangleMisses[iIndex / 3] = misses;
+            }
+        }
+    }
+
+    void MeshOptimiser::OptimiseVertexCache(std::vector<unsigned int>& ioIndices, size_t inNumVertices)
+    {
+        const size_t numTriangles = ioIndices.size() / 3;
+        if (numTriangles == 0)
+            return;
+
+        // Vertex to triangle adjacency
+        std::vector<unsigned int> triangleOffsets(inNumVertices + 1, 0);
+        for (unsigned int index : ioIndices)
+            triangleOffsets[index + 1]++;
+        for (size_t iVert = 0; iVert < inNumVertices; iVert++)
+            triangleOffsets[iVert + 1] += triangleOffsets[iVert];
+
+        std::vector<unsigned int> remainingTriangles(inNumVertices);
+        for (size_t iVert = 0; iVert < inNumVertices; iVert++)
+            remainingTriangles[iVert] = triangleOffsets[iVert + 1] - triangleOffsets[iVert];
+
+        std::vector<unsigned int> vertexTriangles(ioIndices.size());
+        {
+            std::vector<unsigned int> cursors(triangleOffsets.begin(), triangleOffsets.end() - 1);
+            for (size_t iIndex = 0; iIndex < ioIndices.size(); iIndex++)
+                vertexTriangles[cursors[ioIndices[iIndex]]++] = (unsigned int)(iIndex / 3);
+        }
+
+        std::vector<int> cachePositions(inNumVertices, -1);
+        std::vector<float> vertexScores(inNumVertices);
+        for (size_t iVert = 0; iVert < inNumVertices; iVert++)
+            vertexScores[iVert] = GetVertexScore(-1, remainingTriangles[iVert]);
+
+        std::vector<float> triangleScores(numTriangles);
+        std::vector<bool> triangleAdded(numTriangles, false);
+        for (size_t iTri = 0; iTri < numTriangles; iTri++)
+            triangleScores[iTri] = vertexScores[ioIndices[iTri * 3]] + vertexScores[ioIndices[iTri * 3 + 1]] + vertexScores[ioIndices[iTri * 3 + 2]];
+
+        std::vector<unsigned int> newIndices;
+        newIndices.reserve(ioIndices.size());
+
+        // The cache holds 3 extra entries, for the vertices of the new triangle
+        std::vector<unsigned int> cache;
+        std::vector<unsigned int> newCache;
+        cache.reserve(ForsythCacheSize + 3);
+        newCache.reserve(ForsythCacheSize + 3);
+
+        size_t nextTriangleCursor = 0;
+        size_t bestTriangle = 0;
+        float bestScore = -1.0f;
+        for (size_t iTri = 0; iTri < numTriangles; iTri++)
+        {
+            if (triangleScores[iTri] > bestScore)
+            {
+                bestScore = triangleScores[iTri];
+                bestTriangle = iTri;
+            }
+        }
+
+        for (size_t numAdded = 0; numAdded < numTriangles; numAdded++)
+        {
+            // No candidates in the cache: continue with the next triangle in the original order
+            if (bestScore < 0.0f)
+            {
+                while (triangleAdded[nextTriangleCursor])
+                    nextTriangleCursor++;
+                bestTriangle = nextTriangleCursor;
+            }
+
+            const unsigned int* tri = &ioIndices[bestTriangle * 3];
+            triangleAdded[bestTriangle] = true;
+            newIndices.insert(newIndices.end(), tri, tri + 3);
+
+            // Remove the triangle from the adjacency of its vertices, and put them at the front of the cache
+            newCache.clear();
+            for (int iCorner = 0; iCorner < 3; iCorner++)
+            {
+                const unsigned int vert = tri[iCorner];
+                unsigned int* adjBegin = &vertexTriangles[triangleOffsets[vert]];
+                unsigned int* adjEnd = adjBegin + remainingTriangles[vert];
+                *std::find(adjBegin, adjEnd, (unsigned int)bestTriangle) = *(adjEnd - 1);
+                remainingTriangles[vert]--;
+                newCache.push_back(vert);
+            }
+            for (unsigned int vert : cache)
+            {
+                if (vert != tri[0] && vert != tri[1] && vert != tri[2])
+                    newCache.push_back(vert);
+            }
+            cache.swap(newCache);
+
+            // Update scores of the vertices in the cache (and the ones pushed out of it)
+            for (size_t iCache = 0; iCache < cache.size(); iCache++)
+            {
+                const unsigned int vert = cache[iCache];
+                cachePositions[vert] = iCache < (size_t)ForsythCacheSize ? (int)iCache : -1;
+                vertexScores[vert] = GetVertexScore(cachePositions[vert], remainingTriangles[vert]);
+            }
+
+            // Update the scores of their triangles, and find the best one
+            bestScore = -1.0f;
+            for (unsigned int vert : cache)
+            {
+                for (unsigned int iAdj = 0; iAdj < remainingTriangles[vert]; iAdj++)
+                {
+                    const unsigned int adjTri = vertexTriangles[triangleOffsets[vert] + iAdj];
+                    const float score = vertexScores[ioIndices[adjTri * 3]] + vertexScores[ioIndices[adjTri * 3 + 1]] + vertexScores[ioIndices[adjTri * 3 + 2]];
+                    triangleScores[adjTri] = score;
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        bestTriangle = adjTri;
+                    }
+                }
+            }
+
+            if (cache.size() > (size_t)ForsythCacheSize)
+                cache.resize(ForsythCacheSize);
+        }
+
+        ioIndices.swap(newIndices);
+    }
+
+    void MeshOptimiser::OptimiseOverdraw(const std::vector<glm::vec3>& inPositions, std::vector<unsigned int>& ioIndices, float inThreshold)
+    {
+        const size_t numTriangles = ioIndices.size() / 3;
+        if (numTriangles == 0)
+            return;
+
+        const size_t numVertices = inPositions.size();
+        const float targetACMR = CalculateACMR(ioIndices, numVertices) * inThreshold;
+
+        // Split into clusters, each starting with an empty cache. A cluster ends as soon as its own ACMR is within the target,
+        //  so the clusters can be drawn in any order without exceeding it.
+        std::vector<size_t> clusterStarts;
+        {
+            std::vector<unsigned int> cacheTimestamps(numVertices, 0);
+            unsigned int timestamp = DefaultCacheSize + 1;
+            size_t clusterMisses = 0;
+            size_t clusterTriangles = 0;
+            for (size_t iTri = 0; iTri < numTriangles; iTri++)
+            {
+                if (clusterTriangles == 0)
+                {
+                    clusterStarts.push_back(iTri);
+                    timestamp += DefaultCacheSize + 1; // reset cache
+                }
+
+                for (int iCorner = 0; iCorner < 3; iCorner++)
+                {
+                    const unsigned int index = ioIndices[iTri * 3 + iCorner];
+                    if (timestamp - cacheTimestamps[index] > DefaultCacheSize)
+                    {
+                        cacheTimestamps[index] = timestamp++;
+                        clusterMisses++;
+                    }
+                }
+                clusterTriangles++;
+
+                if ((float)clusterMisses <= targetACMR * (float)clusterTriangles)
+                {
+                    clusterMisses = 0;
+                    clusterTriangles = 0;
+                }
+            }
+        }
+        const size_t numClusters = clusterStarts.size();
+        clusterStarts.push_back(numTriangles);
+
+        // Mesh centroid (area weighted)
+        glm::vec3 meshCentroid(0.0f);
+        float meshArea = 0.0f;
+        for (size_t iIndex = 0; iIndex < ioIndices.size(); iIndex += 3)
+        {
+            const glm::vec3& p0 = inPositions[ioIndices[iIndex]];
+            const glm::vec3& p1 = inPositions[ioIndices[iIndex + 1]];
+            const glm::vec3& p2 = inPositions[ioIndices[iIndex + 2]];
+            const float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+            meshCentroid += (p0 + p1 + p2) * (area / 3.0f);
+            meshArea += area;
+        }
+        if (meshArea > 0.0f)
+            meshCentroid /= meshArea;
+
+        // Clusters facing away from the mesh centre are more likely to occlude other clusters, so draw them first
+        std::vector<float> clusterSortKeys(numClusters);
+        for (size_t iCluster = 0; iCluster < numClusters; iCluster++)
+        {
+            glm::vec3 centroid(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+            for (size_t iTri = clusterStarts[iCluster]; iTri < clusterStarts[iCluster + 1]; iTri++)
+            {
+                const glm::vec3& p0 = inPositions[ioIndices[iTri * 3]];
+                const glm::vec3& p1 = inPositions[ioIndices[iTri * 3 + 1]];
+                const glm::vec3& p2 = inPositions[ioIndices[iTri * 3 + 2]];
+                const glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+                const float triArea = glm::length(cross);
+                centroid += (p0 + p1 + p2) * (triArea / 3.0f);
+                normal += cross;
+                area += triArea;
+            }
+            if (area > 0.0f)
+                centroid /= area;
+            const float normalLength = glm::length(normal);
+            clusterSortKeys[iCluster] = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+        }
+
+        std::vector<size_t> clusterOrder(numClusters);
+        for (size_t iCluster = 0; iCluster < numClusters; iCluster++)
+            clusterOrder[iCluster] = iCluster;
+        std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](size_t inLeft, size_t inRight) { return clusterSortKeys[inLeft] > clusterSortKeys[inRight]; });
+
+        std::vector<unsigned int> newIndices;
+        newIndices.reserve(ioIndices.size());
+        for (size_t iCluster : clusterOrder)
+            newIndices.insert(newIndices.end(), ioIndices.begin() + clusterStarts[iCluster] * 3, ioIndices.begin() + clusterStarts[iCluster + 1] * 3);
+        ioIndices.swap(newIndices);
+    }
+
+    void MeshOptimiser::OptimiseVertexFetch(VertexData* ioVertexData, std::vector<unsigned int>& ioIndices)
+    {
+        const size_t numVertices = ioVertexData->GetNumVertices();
+        const size_t vertexSize = ioVertexData->GetVertexSize();
+        const unsigned int unassigned = (unsigned int)-1;
+
+        // New vertex indices, in order of first use
+        std::vector<unsigned int> vertexRemap(numVertices, unassigned);
+        unsigned int nextVertex = 0;
+        for (unsigned int& index : ioIndices)
+        {
+            if (vertexRemap[index] == unassigned)
+                vertexRemap[index] = nextVertex++;
+            index = vertexRemap[index];
+        }
+        for (size_t iVert = 0; iVert < numVertices; iVert++)
+        {
+            if (vertexRemap[iVert] == unassigned)
+                vertexRemap[iVert] = nextVertex++;
+        }
+
+        char* vertexDataPtr = static_cast<char*>(ioVertexData->GetDataPtr());
+        std::vector<char> oldVertexData(vertexDataPtr, vertexDataPtr + numVertices * vertexSize);
+        for (size_t iVert = 0; iVert < numVertices; iVert++)
+            memcpy(vertexDataPtr + vertexRemap[iVert] * vertexSize, &oldVertexData[iVert * vertexSize], vertexSize);
+    }
+
+    VertexData* MeshOptimiser::CompressVertexData(VertexData* inVertexData)
+    {
+        const size_t numVertices = inVertexData->GetNumVertices();
+        const VertexLayout& sourceLayout = inVertexData->GetVertexLayout();
+
+        VertexLayout layout;
+        layout.VertexComponents = sourceLayout.VertexComponents;
+        for (EVertexComponent vertexComponent : layout.VertexComponents)
+        {
+            switch (vertexComponent)
+            {
+            case EVertexComponent::Position:
+                layout.ComponentFormats.push_back(EVertexComponentFormat::SNorm16);
+                break;
+            case EVertexComponent::Normal:
+                layout.ComponentFormats.push_back(EVertexComponentFormat::SNorm8);
+                break;
+            case EVertexComponent::TexCoord:
+                layout.ComponentFormats.push_back(EVertexComponentFormat::Half);
+                break;
+            default:
+                layout.ComponentFormats.push_back(EVertexComponentFormat::Float);
+                break;
+            }
+        }
+
+        // Quantise positions relative to the bounding box. The scale is uniform, so it doesn't skew normals.
+        if (numVertices > 0)
+        {
+            glm::vec3 minPos = glm::vec3(inVertexData->GetComponentValue(0, EVertexComponent::Position));
+            glm::vec3 maxPos = minPos;
+            for (size_t iVert = 1; iVert < numVertices; iVert++)
+            {
+                const glm::vec3 pos = glm::vec3(inVertexData->GetComponentValue(iVert, EVertexComponent::Position));
+                minPos = glm::min(minPos, pos);
+                maxPos = glm::max(maxPos, pos);
+            }
+            const glm::vec3 halfExtents = (maxPos - minPos) * 0.5f;
+            layout.PositionOffset = (minPos + maxPos) * 0.5f;
+            layout.PositionScale = std::max(std::max(halfExtents.x, halfExtents.y), std::max(halfExtents.z, 1e-6f));
+        }
+
+        VertexData* compressedData = new VertexData(layout, numVertices);
+        for (size_t iVert = 0; iVert < numVertices; iVert++)
+        {
+            for (EVertexComponent vertexComponent : layout.VertexComponents)
+            {
+                glm::vec4 value = inVertexData->GetComponentValue(iVert, vertexComponent);
+                if (vertexComponent == EVertexComponent::Normal && glm::length(glm::vec3(value)) > 0.0f)
+                    value = glm::vec4(glm::normalize(glm::vec3(value)), 0.0f);
+                compressedData->SetComponentValue(iVert, vertexComponent, value);
+            }
+        }
+        return compressedData;
+    }
+
+    float MeshOptimiser::CalculateACMR(const std::vector<unsigned int>& inIndices, size_t inNumVertices, size_t inCacheSize)
+    {
+        const size_t numTriangles = inIndices.size() / 3;
+        if (numTriangles == 0)
+            return 0.0f;
+
+        std::vector<unsigned char> triangleMisses;
+        SimulateVertexCache(inIndices.data(), inIndices.size(), inNumVertices, inCacheSize, triangleMisses);
+
+        size_t misses = 0;
+        for (unsigned char triMisses : triangleMisses)
+            misses += triMisses;
+        return (float)misses / (float)numTriangles;
+    }
+}
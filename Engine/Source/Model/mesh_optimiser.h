@@ -0,0 +1,50 @@
+#ifndef MING3D_MESHOPTIMISER_H
+#define MING3D_MESHOPTIMISER_H
+
+#include <vector>
+#include "glm/glm.hpp"
+#include "graphics_data.h"
+
+namespace Ming3D
+{
+    /**
+    * Reorders triangle lists and vertices for faster GPU rendering.
+    * Recommended order: OptimiseVertexCache, OptimiseOverdraw, OptimiseVertexFetch.
+    */
+    class MeshOptimiser
+    {
+    public:
+        static constexpr size_t DefaultCacheSize = 16;
+
+        /**
+        * Reorders triangles to improve post-transform vertex cache hits (Tom Forsyth's "Linear-Speed Vertex Cache Optimisation").
+        */
+        static void OptimiseVertexCache(std::vector<unsigned int>& ioIndices, size_t inNumVertices);
+
+        /**
+        * Reorders clusters of triangles, so that outward facing triangles are drawn first (Sander et al. "Fast Triangle Reordering").
+        * Clusters are sized so the ACMR stays (roughly) within inThreshold times the original, whatever order they are drawn in.
+        */
+        static void OptimiseOverdraw(const std::vector<glm::vec3>& inPositions, std::vector<unsigned int>& ioIndices, float inThreshold = 1.05f);
+
+        /**
+        * Reorders vertices in the order they are first used by the triangle list, for better memory locality when fetching vertices.
+        * Unused vertices are moved to the end.
+        */
+        static void OptimiseVertexFetch(VertexData* ioVertexData, std::vector<unsigned int>& ioIndices);
+
+        /**
+        * Average Cache Miss Ratio: vertex shader invocations per triangle, for a FIFO cache of the given size.
+        * 3.0 is the worst case, and 0.5 is the best case for large regular meshes.
+        */
+        static float CalculateACMR(const std::vector<unsigned int>& inIndices, size_t inNumVertices, size_t inCacheSize = DefaultCacheSize);
+
+        /**
+        * Creates a copy of the vertex data with compact component formats:
+        * 16 bit normalised positions (relative to the bounding box, see VertexLayout::PositionScale), 8 bit normalised normals and 16 bit float texture coordinates.
+        */
+        static VertexData* CompressVertexData(VertexData* inVertexData);
+    };
+}
+
+#endif
@@ -0,0 +1,276 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+
+namespace Ming3D
+{
+    namespace
+    {
+        /** Symmetric quadric, for the (weighted) sum of squared distances to a set of planes: p^T A p + 2 b.p + c */
+        struct Quadric
+        {
+            float a00 = 0.0f, a11 = 0.0f, a22 = 0.0f;
+            float a01 = 0.0f, a02 = 0.0f, a12 = 0.0f;
+            float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+            float c = 0.0f;
+            float w = 0.0f;
+
+            void AddPlane(const glm::vec3& inNormal, float inDistance, float inWeight)
+            {
+                a00 += inWeight * inNormal.x * inNormal.x;
+                a11 += inWeight * inNormal.y * inNormal.y;
+                a22 += inWeight * inNormal.z * inNormal.z;
+                a01 += inWeight * inNormal.x * inNormal.y;
+                a02 += inWeight * inNormal.x * inNormal.z;
+                a12 += inWeight * inNormal.y * inNormal.z;
+                b0 += inWeight * inNormal.x * inDistance;
+                b1 += inWeight * inNormal.y * inDistance;
+                b2 += inWeight * inNormal.z * inDistance;
+                c += inWeight * inDistance * inDistance;
+                w += inWeight;
+            }
+
+            void Add(const Quadric& inOther)
+            {
+                a00 += inOther.a00; a11 += inOther.a11; a22 += inOther.a22;
+                a01 += inOther.a01; a02 += inOther.a02; a12 += inOther.a12;
+                b0 += inOther.b0; b1 += inOther.b1; b2 += inOther.b2;
+                c += inOther.c;
+                w += inOther.w;
+            }
+
+            /** Weighted mean squared distance to the planes. */
+            float GetError(const glm::vec3& p) const
+            {
+                const float rx = a00 * p.x + a01 * p.y + a02 * p.z + 2.0f * b0;
+                const float ry = a01 * p.x + a11 * p.y + a12 * p.z + 2.0f * b1;
+                const float rz = a02 * p.x + a12 * p.y + a22 * p.z + 2.0f * b2;
+                return w > 0.0f ? std::abs(rx * p.x + ry * p.y + rz * p.z + c) / w : 0.0f;
+            }
+        };
+
+        struct EdgeCollapse
+        {
+            unsigned int mFrom;
+            unsigned int mTo;
+            float mError;
+
+            bool operator<(const EdgeCollapse& inOther) const { return mError < inOther.mError; }
+        };
+
+        struct PositionHasher
+        {
+            size_t operator()(const glm::vec3& inPos) const
+            {
+                uint32_t bits[3];
+                memcpy(bits, &inPos, sizeof(bits));
+                return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+            }
+        };
+
+        inline uint64_t GetEdgeKey(unsigned int inA, unsigned int inB)
+        {
+            return inA < inB ? ((uint64_t)inA << 32) | inB : ((uint64_t)inB << 32) | inA;
+        }
+    }
+
+    float MeshSimplifier::Simplify(const std::vector<glm::vec3>& inPositions, const std::vector<unsigned int>& inIndices, size_t inTargetIndexCount, float inTargetError, std::vector<unsigned int>& outIndices)
+    {
+        outIndices = inIndices;
+
+        const size_t numVertices = inPositions.size();
+        if (outIndices.size() <= inTargetIndexCount || numVertices == 0)
+            return 0.0f;
+
+        // Normalise positions, so errors are relative to the mesh size
+        glm::vec3 minPos = inPositions[0];
+        glm::vec3 maxPos = inPositions[0];
+        for (const glm::vec3& pos : inPositions)
+        {
+            minPos = glm::min(minPos, pos);
+            maxPos = glm::max(maxPos, pos);
+        }
+        const glm::vec3 extents = maxPos - minPos;
+        const float scale = std::max(extents.x, std::max(extents.y, extents.z));
+        const float invScale = scale > 0.0f ? 1.0f / scale : 0.0f;
+
+        std::vector<glm::vec3> positions(numVertices);
+        for (size_t iVert = 0; iVert < numVertices; iVert++)
+            positions[iVert] = (inPositions[iVert] - minPos) * invScale;
+
+        // Vertices that share a position (attribute seams) are treated as one when looking for borders, and are locked
+        std::vector<unsigned int> positionRemap(numVertices);
+        std::vector<bool> locked(numVertices, false);
+        {
+            std::unordered_map<glm::vec3, unsigned int, PositionHasher> positionMap;
+            positionMap.reserve(numVertices);
+            for (unsigned int iVert = 0; iVert < (unsigned int)numVertices; iVert++)
+            {
+                auto inserted = positionMap.emplace(inPositions[iVert], iVert);
+                positionRemap[iVert] = inserted.first->second;
+                if (!inserted.second)
+                    locked[inserted.first->second] = true;
+            }
+        }
+
+        // Lock vertices on open borders (and non-manifold edges)
+        {
+            std::unordered_map<uint64_t, int> edgeCounts;
+            edgeCounts.reserve(outIndices.size());
+            for (size_t iIndex = 0; iIndex < outIndices.size(); iIndex += 3)
+            {
+                for (int iEdge = 0; iEdge < 3; iEdge++)
+                {
+                    const unsigned int a = positionRemap[outIndices[iIndex + iEdge]];
+                    const unsigned int b = positionRemap[outIndices[iIndex + (iEdge + 1) % 3]];
+                    edgeCounts[GetEdgeKey(a, b)]++;
+                }
+            }
+            for (const auto& edge : edgeCounts)
+            {
+                if (edge.second != 2)
+                {
+                    locked[(unsigned int)(edge.first >> 32)] = true;
+                    locked[(unsigned int)(edge.first & 0xFFFFFFFF)] = true;
+                }
+            }
+        }
+
+        // Area-weighted triangle plane quadrics, per position
+        std::vector<Quadric> quadrics(numVertices);
+        for (size_t iIndex = 0; iIndex < outIndices.size(); iIndex += 3)
+        {
+            const glm::vec3& p0 = positions[outIndices[iIndex]];
+            const glm::vec3& p1 = positions[outIndices[iIndex + 1]];
+            const glm::vec3& p2 = positions[outIndices[iIndex + 2]];
+            const glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+            const float doubleArea = glm::length(cross);
+            if (doubleArea <= 0.0f)
+                continue;
+            const glm::vec3 normal = cross / doubleArea;
+            const float distance = -glm::dot(normal, p0);
+            for (int iCorner = 0; iCorner < 3; iCorner++)
+                quadrics[positionRemap[outIndices[iIndex + iCorner]]].AddPlane(normal, distance, doubleArea * 0.5f);
+        }
+
+        const float maxError = inTargetError * inTargetError;
+        float resultError = 0.0f;
+
+        std::vector<EdgeCollapse> collapses;
+        std::vector<unsigned int> collapseTargets(numVertices);
+        std::vector<bool> touched(numVertices);
+        std::vector<unsigned int> triangleOffsets(numVertices + 1);
+        std::vector<unsigned int> vertexTriangles;
+
+        // Each pass collapses a set of independent edges, then rebuilds the triangle list
+        while (outIndices.size() > inTargetIndexCount)
+        {
+            const size_t numTriangles = outIndices.size() / 3;
+
+            // Vertex to triangle adjacency
+            std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+            for (unsigned int index : outIndices)
+                triangleOffsets[index + 1]++;
+            for (size_t iVert = 0; iVert < numVertices; iVert++)
+                triangleOffsets[iVert + 1] += triangleOffsets[iVert];
+            vertexTriangles.resize(outIndices.size());
+            {
+                std::vector<unsigned int> cursors(triangleOffsets.begin(), triangleOffsets.end() - 1);
+                for (size_t iIndex = 0; iIndex < outIndices.size(); iIndex++)
+                    vertexTriangles[cursors[outIndices[iIndex]]++] = (unsigned int)(iIndex / 3);
+            }
+
+            // Candidate collapses, in both directions of each edge
+            collapses.clear();
+            for (size_t iIndex = 0; iIndex < outIndices.size(); iIndex += 3)
+            {
+                for (int iEdge = 0; iEdge < 3; iEdge++)
+                {
+                    const unsigned int a = outIndices[iIndex + iEdge];
+                    const unsigned int b = outIndices[iIndex + (iEdge + 1) % 3];
+                    Quadric edgeQuadric = quadrics[positionRemap[a]];
+                    edgeQuadric.Add(quadrics[positionRemap[b]]);
+                    if (!locked[positionRemap[a]])
+                        collapses.push_back({ a, b, edgeQuadric.GetError(positions[b]) });
+                    if (!locked[positionRemap[b]])
+                        collapses.push_back({ b, a, edgeQuadric.GetError(positions[a]) });
+                }
+            }
+            std::sort(collapses.begin(), collapses.end());
+
+            for (unsigned int iVert = 0; iVert < (unsigned int)numVertices; iVert++)
+                collapseTargets[iVert] = iVert;
+            std::fill(touched.begin(), touched.end(), false);
+
+            // Each collapse removes (about) two triangles
+            const size_t maxCollapses = (numTriangles - inTargetIndexCount / 3 + 1) / 2;
+            size_t numCollapses = 0;
+
+            for (const EdgeCollapse& collapse : collapses)
+            {
+                if (collapse.mError > maxError || numCollapses >= maxCollapses)
+                    break;
+                if (touched[collapse.mFrom] || touched[collapse.mTo])
+                    continue;
+
+                // Reject collapses that would flip a triangle
+                bool flipped = false;
+                for (unsigned int iAdj = triangleOffsets[collapse.mFrom]; iAdj < triangleOffsets[collapse.mFrom + 1] && !flipped; iAdj++)
+                {
+                    const unsigned int* tri = &outIndices[vertexTriangles[iAdj] * 3];
+                    if (tri[0] == collapse.mTo || tri[1] == collapse.mTo || tri[2] == collapse.mTo)
+                        continue; // removed by the collapse
+
+                    glm::vec3 oldPos[3];
+                    glm::vec3 newPos[3];
+                    for (int iCorner = 0; iCorner < 3; iCorner++)
+                    {
+                        oldPos[iCorner] = positions[tri[iCorner]];
+                        newPos[iCorner] = positions[tri[iCorner] == collapse.mFrom ? collapse.mTo : tri[iCorner]];
+                    }
+                    const glm::vec3 oldNormal = glm::cross(oldPos[1] - oldPos[0], oldPos[2] - oldPos[0]);
+                    const glm::vec3 newNormal = glm::cross(newPos[1] - newPos[0], newPos[2] - newPos[0]);
+                    flipped = glm::dot(oldNormal, newNormal) <= 0.0f;
+                }
+                if (flipped)
+                    continue;
+
+                // The one-ring has changed, so keep it out of the rest of this pass
+                for (unsigned int iAdj = triangleOffsets[collapse.mFrom]; iAdj < triangleOffsets[collapse.mFrom + 1]; iAdj++)
+                {
+                    const unsigned int* tri = &outIndices[vertexTriangles[iAdj] * 3];
+                    touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+                }
+
+                collapseTargets[collapse.mFrom] = collapse.mTo;
+                quadrics[positionRemap[collapse.mTo]].Add(quadrics[positionRemap[collapse.mFrom]]);
+                resultError = std::max(resultError, collapse.mError);
+                numCollapses++;
+            }
+
+            if (numCollapses == 0)
+                break;
+
+            // Apply collapses, and remove degenerate triangles
+            size_t writeIndex = 0;
+            for (size_t iIndex = 0; iIndex < outIndices.size(); iIndex += 3)
+            {
+                const unsigned int i0 = collapseTargets[outIndices[iIndex]];
+                const unsigned int i1 = collapseTargets[outIndices[iIndex + 1]];
+                const unsigned int i2 = collapseTargets[outIndices[iIndex + 2]];
+                if (i0 == i1 || i1 == i2 || i2 == i0)
+                    continue;
+                outIndices[writeIndex++] = i0;
+                outIndices[writeIndex++] = i1;
+                outIndices[writeIndex++] = i2;
+            }
+            outIndices.resize(writeIndex);
+        }
+
+        return std::sqrt(resultError);
+    }
+}
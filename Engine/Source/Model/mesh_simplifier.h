@@ -0,0 +1,27 @@
+#ifndef MING3D_MESHSIMPLIFIER_H
+#define MING3D_MESHSIMPLIFIER_H
+
+#include <vector>
+#include "glm/glm.hpp"
+
+namespace Ming3D
+{
+    /**
+    * Triangle list simplification, using quadric error metrics (Garland & Heckbert).
+    * Edges are collapsed onto one of their existing vertices, so the output indexes the same vertex data as the input.
+    * Open borders and attribute seams (vertices sharing a position) are never collapsed.
+    */
+    class MeshSimplifier
+    {
+    public:
+        /**
+        * Collapses edges (cheapest first) until the triangle list has no more than inTargetIndexCount indices,
+        *  or no collapse is possible without exceeding inTargetError.
+        * Errors are distances, relative to the largest extent of the mesh's bounding box.
+        * @return The error of the simplified mesh.
+        */
+        static float Simplify(const std::vector<glm::vec3>& inPositions, const std::vector<unsigned int>& inIndices, size_t inTargetIndexCount, float inTargetError, std::vector<unsigned int>& outIndices);
+    };
+}
+
+#endif
@@ -0,0 +1,322 @@
+#include "model_cache.h"
+
+#include "model_helper.h"
+#include "mesh.h"
+#include "Assets/texture_cache.h"
+#include "texture.h"
+#include "Serialisation/data_writer.h"
+#include "GameEngine/game_engine.h"
+#include "Platform/platform.h"
+#include "Debug/debug.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace Ming3D
+{
+    namespace
+    {
+        const uint32_t CookedModelMagic = 0x4D44334D; // "M3DM"
+        const uint32_t CookedModelVersion = 1;
+
+        struct CookedModelHeader
+        {
+            uint32_t mMagic;
+            uint32_t mVersion;
+            uint64_t mSourceHash;
+            int32_t mFlags;
+            uint32_t mNumMaterials;
+            uint32_t mNumMeshes;
+        };
+
+        /** Reads from a memory mapped cache file. Fails (instead of reading past the end) if the file is truncated. */
+        class CookedDataReader
+        {
+        private:
+            const char* mData;
+            size_t mSize;
+            size_t mReadPos = 0;
+
+        public:
+            CookedDataReader(const char* inData, size_t inSize) : mData(inData), mSize(inSize) {}
+
+            bool Read(void* outData, size_t inBytes)
+            {
+                if (inBytes > mSize - mReadPos)
+                    return false;
+                memcpy(outData, mData + mReadPos, inBytes);
+                mReadPos += inBytes;
+                return true;
+            }
+
+            template <typename T>
+            bool Read(T& outVal)
+            {
+                return Read(&outVal, sizeof(T));
+            }
+
+            /** Returns true if inCount elements of inStride bytes can still be read (checked before allocating for them). */
+            bool CanRead(uint64_t inCount, uint64_t inStride) const
+            {
+                return inStride == 0 || inCount <= (mSize - mReadPos) / inStride;
+            }
+        };
+
+        std::string GetCachePath(const std::string& inSourcePath)
+        {
+            return inSourcePath + ".cooked";
+        }
+
+        void WriteIndexData(DataWriter& inWriter, IndexData* inIndexData)
+        {
+            inWriter.Write((uint32_t)inIndexData->GetNumIndices());
+            inWriter.Write(inIndexData->GetData(), inIndexData->GetNumIndices() * sizeof(unsigned int));
+        }
+
+        IndexData* ReadIndexData(CookedDataReader& inReader)
+        {
+            uint32_t numIndices;
+            if (!inReader.Read(numIndices) || !inReader.CanRead(numIndices, sizeof(unsigned int)))
+                return nullptr;
+            IndexData* indexData = new IndexData(numIndices);
+            if (!inReader.Read(indexData->GetData(), numIndices * sizeof(unsigned int)))
+            {
+                delete indexData;
+                return nullptr;
+            }
+            return indexData;
+        }
+
+        Mesh* ReadMesh(CookedDataReader& inReader)
+        {
+            VertexLayout layout;
+            uint32_t numComponents;
+            if (!inReader.Read(numComponents) || numComponents > (uint32_t)EVertexComponent::Colour + 1)
+                return nullptr;
+            for (uint32_t iComp = 0; iComp < numComponents; iComp++)
+            {
+                uint32_t component;
+                uint32_t format;
+                if (!inReader.Read(component) || !inReader.Read(format)
+                    || component > (uint32_t)EVertexComponent::Colour || format > (uint32_t)EVertexComponentFormat::SNorm8)
+                    return nullptr;
+                layout.VertexComponents.push_back((EVertexComponent)component);
+                layout.ComponentFormats.push_back((EVertexComponentFormat)format);
+            }
+            uint32_t numVertices;
+            if (!inReader.Read(layout.PositionOffset) || !inReader.Read(layout.PositionScale) || !inReader.Read(numVertices)
+                || !inReader.CanRead(numVertices, layout.GetVertexSize()))
+                return nullptr;
+
+            Mesh* mesh = new Mesh();
+            mesh->mVertexData = new VertexData(layout, numVertices);
+            bool valid = inReader.Read(mesh->mVertexData->GetDataPtr(), numVertices * mesh->mVertexData->GetVertexSize());
+            if (valid)
+            {
+                mesh->mIndexData = ReadIndexData(inReader);
+                valid = mesh->mIndexData != nullptr;
+            }
+            uint32_t numLODs = 0;
+            valid = valid && inReader.Read(numLODs);
+            for (uint32_t iLOD = 0; iLOD < numLODs && valid; iLOD++)
+            {
+                MeshLOD lod;
+                valid = inReader.Read(lod.mScreenSize) && (lod.mIndexData = ReadIndexData(inReader)) != nullptr;
+                if (valid)
+                    mesh->mLODs.push_back(lod);
+            }
+
+            if (!valid)
+            {
+                delete mesh;
+                return nullptr;
+            }
+            return mesh;
+        }
+
+        void WriteMesh(DataWriter& inWriter, Mesh* inMesh)
+        {
+            const VertexLayout& layout = inMesh->mVertexData->GetVertexLayout();
+            inWriter.Write((uint32_t)layout.VertexComponents.size());
+            for (size_t iComp = 0; iComp < layout.VertexComponents.size(); iComp++)
+            {
+                inWriter.Write((uint32_t)layout.VertexComponents[iComp]);
+                inWriter.Write((uint32_t)layout.GetComponentFormat(iComp));
+            }
+            inWriter.Write(layout.PositionOffset);
+            inWriter.Write(layout.PositionScale);
+            inWriter.Write((uint32_t)inMesh->mVertexData->GetNumVertices());
+            inWriter.Write(inMesh->mVertexData->GetDataPtr(), inMesh->mVertexData->GetNumVertices() * inMesh->mVertexData->GetVertexSize());
+            WriteIndexData(inWriter, inMesh->mIndexData);
+            inWriter.Write((uint32_t)inMesh->mLODs.size());
+            for (const MeshLOD& lod : inMesh->mLODs)
+            {
+                inWriter.Write(lod.mScreenSize);
+                WriteIndexData(inWriter, lod.mIndexData);
+            }
+        }
+    }
+
+    CookedModel::~CookedModel()
+    {
+        for (CookedMesh& cookedMesh : mMeshes)
+            delete cookedMesh.mMesh;
+        for (MaterialData* matData : mMaterials)
+        {
+            delete matData->mTexture;
+            delete matData;
+        }
+    }
+
+    uint64_t ModelCache::HashData(const char* inData, size_t inSize)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < inSize; i++)
+        {
+            hash ^= (uint64_t)(unsigned char)inData[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    bool ModelCache::WriteCacheFile(const std::string& inPath, const char* inData, size_t inSize)
+    {
+        // Other threads may have the old cache file mapped, so it's replaced instead of being overwritten
+        const std::string tempPath = inPath + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        {
+            std::ofstream tempFile(tempPath, std::ios::binary | std::ios::trunc);
+            if (!tempFile.is_open())
+            {
+                LOG_ERROR() << "Failed to write cache file: " << tempPath;
+                return false;
+            }
+            tempFile.write(inData, inSize);
+            if (!tempFile.good())
+            {
+                tempFile.close();
+                std::remove(tempPath.c_str());
+                LOG_ERROR() << "Failed to write cache file: " << tempPath;
+                return false;
+            }
+        }
+
+        PlatformFile* platformFile = GGameEngine->GetPlatform()->mPlatformFile;
+        if (!platformFile->RenameFile(tempPath, inPath))
+        {
+            std::remove(tempPath.c_str()); // the old cache file is kept
+            LOG_ERROR() << "Failed to replace cache file: " << inPath;
+            return false;
+        }
+        return true;
+    }
+
+    bool ModelCache::GetSourceHash(const std::string& inSourcePath, uint64_t& outHash)
+    {
+        PlatformFile* platformFile = GGameEngine->GetPlatform()->mPlatformFile;
+        MappedFile* file = platformFile->MapFile(inSourcePath);
+        if (file == nullptr)
+            return false;
+
+        outHash = HashData(file->mData, file->mSize);
+
+        platformFile->UnmapFile(file);
+        return true;
+    }
+
+    CookedModel* ModelCache::LoadCookedModel(const std::string& inSourcePath, uint64_t inSourceHash, int inFlags)
+    {
+        PlatformFile* platformFile = GGameEngine->GetPlatform()->mPlatformFile;
+        MappedFile* file = platformFile->MapFile(GetCachePath(inSourcePath));
+        if (file == nullptr)
+            return nullptr;
+
+        CookedDataReader reader(file->mData, file->mSize);
+
+        CookedModelHeader header;
+        if (!reader.Read(header) || header.mMagic != CookedModelMagic || header.mVersion != CookedModelVersion
+            || header.mSourceHash != inSourceHash || header.mFlags != (inFlags & MODELLOADERFLAGS_COOKED_MASK))
+        {
+            platformFile->UnmapFile(file);
+            return nullptr; // out of date
+        }
+
+        CookedModel* model = new CookedModel();
+        bool valid = true;
+
+        for (uint32_t iMat = 0; iMat < header.mNumMaterials && valid; iMat++)
+        {
+            MaterialData* matData = new MaterialData();
+            model->mMaterials.push_back(matData);
+            uint32_t pathLength = 0;
+            valid = reader.Read(matData->mDiffuseColour) && reader.Read(matData->mSpecularColour) && reader.Read(matData->mAmbientColour)
+                && reader.Read(matData->mShininess) && reader.Read(pathLength) && reader.CanRead(pathLength, 1);
+            if (valid)
+            {
+                matData->mTexturePath.resize(pathLength);
+                valid = reader.Read(&matData->mTexturePath[0], pathLength);
+            }
+        }
+
+        for (uint32_t iMesh = 0; iMesh < header.mNumMeshes && valid; iMesh++)
+        {
+            CookedMesh cookedMesh;
+            int32_t materialIndex;
+            valid = reader.Read(materialIndex) && (cookedMesh.mMesh = ReadMesh(reader)) != nullptr;
+            cookedMesh.mMaterialIndex = materialIndex;
+            if (valid)
+                model->mMeshes.push_back(cookedMesh);
+        }
+
+        platformFile->UnmapFile(file);
+
+        if (!valid)
+        {
+            LOG_ERROR() << "Corrupt model cache file: " << GetCachePath(inSourcePath);
+            delete model;
+            return nullptr;
+        }
+
+        for (MaterialData* matData : model->mMaterials)
+        {
+            if (!matData->mTexturePath.empty())
+                matData->mTexture = TextureCache::LoadTexture(matData->mTexturePath);
+        }
+
+        return model;
+    }
+
+    bool ModelCache::SaveCookedModel(const std::string& inSourcePath, uint64_t inSourceHash, int inFlags, const CookedModel* inModel)
+    {
+        DataWriter writer(1024);
+
+        CookedModelHeader header;
+        header.mMagic = CookedModelMagic;
+        header.mVersion = CookedModelVersion;
+        header.mSourceHash = inSourceHash;
+        header.mFlags = inFlags & MODELLOADERFLAGS_COOKED_MASK;
+        header.mNumMaterials = (uint32_t)inModel->mMaterials.size();
+        header.mNumMeshes = (uint32_t)inModel->mMeshes.size();
+        writer.Write(header);
+
+        for (MaterialData* matData : inModel->mMaterials)
+        {
+            writer.Write(matData->mDiffuseColour);
+            writer.Write(matData->mSpecularColour);
+            writer.Write(matData->mAmbientColour);
+            writer.Write(matData->mShininess);
+            writer.Write((uint32_t)matData->mTexturePath.size());
+            writer.Write(matData->mTexturePath.data(), matData->mTexturePath.size());
+        }
+
+        for (const CookedMesh& cookedMesh : inModel->mMeshes)
+        {
+            writer.Write((int32_t)cookedMesh.mMaterialIndex);
+            WriteMesh(writer, cookedMesh.mMesh);
+        }
+
+        return WriteCacheFile(GetCachePath(inSourcePath), writer.GetData(), writer.GetSize());
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef MING3D_MODELCACHE_H
+#define MING3D_MODELCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Ming3D
+{
+    class Mesh;
+    class MaterialData;
+
+    class CookedMesh
+    {
+    public:
+        Mesh* mMesh = nullptr;
+        int mMaterialIndex = -1;
+    };
+
+    /**
+    * A model, as the engine wants it: optimised, simplified (LODs) and compressed.
+    * The node hierarchy is flattened at import (aiProcess_OptimizeGraph), so each mesh becomes a child of the model's actor.
+    */
+    class CookedModel
+    {
+    public:
+        std::vector<CookedMesh> mMeshes;
+        std::vector<MaterialData*> mMaterials;
+
+        ~CookedModel(); // deletes the meshes, materials and textures
+    };
+
+    /**
+    * Binary cache of cooked models, stored next to the source model ("<model>.cooked").
+    * Cache files are keyed by a hash of the source file and the import flags, and are rebuilt when either changes.
+    * Referenced files (textures, .mtl files) are not part of the key.
+    * The cache file is memory mapped, and vertex/index data is copied straight into the engine's buffers.
+    */
+    class ModelCache
+    {
+    public:
+        /** 64 bit FNV-1a hash, used to detect changes in source files. */
+        static uint64_t HashData(const char* inData, size_t inSize);
+
+        /** Writes a cache file to a temporary file and renames it, so readers that have the old file mapped aren't affected. */
+        static bool WriteCacheFile(const std::string& inPath, const char* inData, size_t inSize);
+
+        /** Hashes the content of the source model. Returns false if the file can't be read. */
+        static bool GetSourceHash(const std::string& inSourcePath, uint64_t& outHash);
+
+        /** Loads a cooked model, or returns nullptr if there is no valid cache file for the given hash and flags. */
+        static CookedModel* LoadCookedModel(const std::string& inSourcePath, uint64_t inSourceHash, int inFlags);
+
+        static bool SaveCookedModel(const std::string& inSourcePath, uint64_t inSourceHash, int inFlags, const CookedModel* inModel);
+    };
+}
+
+#endif
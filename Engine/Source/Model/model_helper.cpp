@@ -3,15 +3,21 @@
 #include "assimp/scene.h"
 #include "assimp/postprocess.h"
 #include "assimp/Importer.hpp"
-#include "texture_loader.h"
+#include "Assets/texture_cache.h"
 #include "Debug/debug.h"
 #include "Debug/st_assert.h"
 #include "Components/mesh_component.h"
 #include "mesh.h"
+#include "mesh_optimiser.h"
+#include "model_cache.h"
+#include "GameEngine/game_engine.h"
+#include "Assets/asset_registry.h"
 #include "material_factory.h"
 #include "shader_program.h"
 #include "texture.h"
 
+#include <chrono>
+
 namespace Ming3D
 {
     ModelData* ModelDataImporter::ImportModelData(const char* inModel)
@@ -43,11 +49,8 @@ namespace Ming3D
                     texturePath = texturePath.substr(0, iLastSlash + 1) + std::string(path.C_Str());
                 else
                     texturePath = std::string(path.C_Str());
-                matData->mTexture = TextureLoader::LoadTextureData(texturePath.c_str());
-            }
-            else
-            {
-                matData->mTexture = nullptr;
+                matData->mTexturePath = texturePath;
+                matData->mTexture = TextureCache::LoadTexture(texturePath);
             }
             aiColor4D diffCol;
             if (aiGetMaterialColor(scene->mMaterials[m], AI_MATKEY_COLOR_DIFFUSE, &diffCol) == AI_SUCCESS)
@@ -119,35 +122,118 @@ namespace Ming3D
                 }
             }
 
+            // Reorder triangles for the post-transform vertex cache and overdraw, and vertices for fetch locality
+            const float acmrBefore = MeshOptimiser::CalculateACMR(meshData->mIndices, vertData->GetNumVertices());
+            std::vector<glm::vec3> positions(scene->mMeshes[m]->mNumVertices);
+            for (unsigned int i = 0; i < scene->mMeshes[m]->mNumVertices; ++i)
+                positions[i] = glm::vec3(scene->mMeshes[m]->mVertices[i].x, scene->mMeshes[m]->mVertices[i].y, scene->mMeshes[m]->mVertices[i].z);
+            MeshOptimiser::OptimiseVertexCache(meshData->mIndices, vertData->GetNumVertices());
+            MeshOptimiser::OptimiseOverdraw(positions, meshData->mIndices);
+            MeshOptimiser::OptimiseVertexFetch(vertData, meshData->mIndices);
+            const float acmrAfter = MeshOptimiser::CalculateACMR(meshData->mIndices, vertData->GetNumVertices());
+            LOG_INFO() << "Optimised mesh " << m << " of " << modelPath << ": ACMR " << acmrBefore << " -> " << acmrAfter;
+
             int matIndex = scene->mMeshes[m]->mMaterialIndex;
             meshData->mMaterialIndex = matIndex;
         }
         return modelData;
     }
 
-    bool ModelLoader::LoadModel(const char* inModel, Actor* inActor, int inFlags)
+    CookedModel* ModelLoader::CookModel(const char* inModel, int inFlags)
     {
         ModelData* modelData = ModelDataImporter::ImportModelData(inModel);
 
         if (modelData == nullptr)
-            return false;
+            return nullptr;
 
-        std::vector<Material*> materials;
-        materials.reserve(modelData->mMaterials.size());
-        for (MaterialData* matData : modelData->mMaterials)
+        CookedModel* cookedModel = new CookedModel();
+        cookedModel->mMaterials = modelData->mMaterials;
+
+        for (MeshData* meshData : modelData->mMeshes)
         {
-            MaterialParams matParams;
-            matParams.mShaderProgramPath = "Resources/Shaders/defaultshader.cgp";
-            if (matData->mTexture == nullptr)
-                matParams.mPreprocessorDefinitions.emplace("use_mat_colour", "");
-            
-            if(inFlags & MODELLOADERFLAGS_UNLIT)
-                matParams.mPreprocessorDefinitions.emplace("unlit_mode", "");
+            Mesh* mesh = new Mesh();
+            mesh->mVertexData = meshData->mVertexData;
+            mesh->mIndexData = new IndexData(meshData->mIndices.size());
+            if (meshData->mIndices.size() > 0)
+                memcpy(mesh->mIndexData->GetData(), &meshData->mIndices[0], meshData->mIndices.size() * sizeof(meshData->mIndices[0]));
+            if (!(inFlags & MODELLOADERFLAGS_NO_LODS))
+                mesh->GenerateLODs(MODELLOADER_MAX_LODS);
+            if (!(inFlags & MODELLOADERFLAGS_FULL_PRECISION))
+            {
+                VertexData* compressedData = MeshOptimiser::CompressVertexData(mesh->mVertexData);
+                delete mesh->mVertexData;
+                mesh->mVertexData = compressedData;
+            }
+
+            CookedMesh cookedMesh;
+            cookedMesh.mMesh = mesh;
+            cookedMesh.mMaterialIndex = meshData->mMaterialIndex;
+            cookedModel->mMeshes.push_back(cookedMesh);
+            delete meshData;
+        }
+
+        delete modelData;
+        return cookedModel;
+    }
 
-            Material* material = MaterialFactory::CreateMaterial(matParams); // TODO: Generate shader based on vertex layout
+    CookedModel* ModelLoader::LoadCookedModel(const char* inModel, int inFlags)
+    {
+        const auto startTime = std::chrono::high_resolution_clock::now();
+
+        uint64_t sourceHash = 0;
+        const bool useCache = !(inFlags & MODELLOADERFLAGS_NO_CACHE) && ModelCache::GetSourceHash(inModel, sourceHash);
+
+        CookedModel* cookedModel = useCache ? ModelCache::LoadCookedModel(inModel, sourceHash, inFlags) : nullptr;
+        const bool cached = cookedModel != nullptr;
+        if (!cached)
+        {
+            cookedModel = CookModel(inModel, inFlags);
+            if (cookedModel == nullptr)
+                return nullptr;
+            if (useCache)
+                ModelCache::SaveCookedModel(inModel, sourceHash, inFlags, cookedModel);
+        }
+
+        const std::chrono::duration<double, std::milli> loadTime = std::chrono::high_resolution_clock::now() - startTime;
+        LOG_INFO() << "Loaded " << inModel << (cached ? " from model cache" : " with assimp") << " in " << loadTime.count() << " ms";
+
+        return cookedModel;
+    }
+
+    MaterialParams ModelLoader::GetMaterialParams(const MaterialData* inMaterialData, int inFlags)
+    {
+        MaterialParams matParams;
+        matParams.mShaderProgramPath = "Resources/Shaders/defaultshader.cgp";
+        if (inMaterialData->mTexture == nullptr)
+            matParams.mPreprocessorDefinitions.emplace("use_mat_colour", "");
+        else if (inFlags & MODELLOADERFLAGS_TEXTURE_ARRAYS)
+            matParams.mPreprocessorDefinitions.emplace("texture_array", "");
+
+        if (inFlags & MODELLOADERFLAGS_UNLIT)
+            matParams.mPreprocessorDefinitions.emplace("unlit_mode", "");
+
+        return matParams;
+    }
+
+    std::string ModelLoader::GetModelKey(const char* inModel, int inFlags)
+    {
+        return std::string(inModel) + "|" + std::to_string(inFlags & MODELLOADERFLAGS_COOKED_MASK);
+    }
+
+    void ModelLoader::CreateModelActors(AssetHandle<CookedModel> inModel, const std::string& inModelKey, Actor* inActor, int inFlags)
+    {
+        AssetRegistry* assetRegistry = GGameEngine->GetAssetRegistry();
+
+        std::vector<Material*> materials;
+        materials.reserve(inModel->mMaterials.size());
+        for (MaterialData* matData : inModel->mMaterials)
+        {
+            Material* material = MaterialFactory::CreateMaterial(GetMaterialParams(matData, inFlags)); // TODO: Generate shader based on vertex layout
             
-            if (matData->mTexture != nullptr)
-                material->SetTexture(0, matData->mTexture);
+            if (matData->mTexture != nullptr && (inFlags & MODELLOADERFLAGS_TEXTURE_ARRAYS))
+                material->SetTexture(0, assetRegistry->GetTextureArrayLayer(matData->mTexturePath, matData->mTexture));
+            else if (matData->mTexture != nullptr)
+                material->SetTexture(0, assetRegistry->GetTextureBuffer(matData->mTexturePath, matData->mTexture));
             else
                 material->SetShaderUniformVec4("_colourDiffuse", matData->mDiffuseColour);
             material->SetShaderUniformVec4("_colourSpecular", matData->mSpecularColour);
@@ -155,21 +241,38 @@ namespace Ming3D
             materials.push_back(material);
         }
 
-        for (MeshData* meshData : modelData->mMeshes)
+        for (size_t iMesh = 0; iMesh < inModel->mMeshes.size(); iMesh++)
         {
+            const CookedMesh& cookedMesh = inModel->mMeshes[iMesh];
+
             Actor* childActor = new Actor();
             childActor->GetTransform().SetParent(&inActor->GetTransform());
 
-            Mesh* mesh = new Mesh();
-            mesh->mVertexData = meshData->mVertexData;
-            mesh->mIndexData = new IndexData(meshData->mIndices.size());
-            if (meshData->mIndices.size() > 0)
-                memcpy(mesh->mIndexData->GetData(), &meshData->mIndices[0], meshData->mIndices.size() * sizeof(meshData->mIndices[0]));
-
             MeshComponent* meshComp = childActor->AddComponent<MeshComponent>();
-            meshComp->SetMesh(mesh);
-            Material* material = meshData->mMaterialIndex >= 0 ? materials[meshData->mMaterialIndex] : nullptr;
+            // The mesh keeps the model alive
+            AssetHandle<Mesh> mesh(inModel, cookedMesh.mMesh);
+            meshComp->SetMesh(mesh, assetRegistry->GetMeshBuffer(inModelKey + "#" + std::to_string(iMesh), cookedMesh.mMesh));
+            Material* material = cookedMesh.mMaterialIndex >= 0 ? materials[cookedMesh.mMaterialIndex] : nullptr;
             meshComp->SetMaterial(material);
         }
     }
+
+    bool ModelLoader::LoadModel(const char* inModel, Actor* inActor, int inFlags)
+    {
+        AssetRegistry* assetRegistry = GGameEngine->GetAssetRegistry();
+        const std::string modelKey = GetModelKey(inModel, inFlags);
+
+        // Models are only loaded once, while in use
+        AssetHandle<CookedModel> cookedModel = assetRegistry->FindModel(modelKey);
+        if (cookedModel == nullptr)
+        {
+            cookedModel = AssetHandle<CookedModel>(LoadCookedModel(inModel, inFlags));
+            if (cookedModel == nullptr)
+                return false;
+            assetRegistry->AddModel(modelKey, cookedModel);
+        }
+
+        CreateModelActors(cookedModel, modelKey, inActor, inFlags);
+        return true;
+    }
 }
@@ -4,14 +4,18 @@
 #ifndef MING3D_MODELLOADER_H
 #define MING3D_MODELLOADER_H
 
+#include <string>
 #include <vector>
 #include "glm/glm.hpp"
 #include "Actors/actor.h"
 #include "graphics_data.h"
+#include "material_factory.h"
+#include "Assets/asset.h"
 
 namespace Ming3D
 {
     class Texture;
+    class CookedModel;
 
     class MeshData
     {
@@ -27,7 +31,8 @@ namespace Ming3D
     class MaterialData
     {
     public:
-        Texture * mTexture;
+        Texture * mTexture = nullptr;
+        std::string mTexturePath;
         glm::vec4 mDiffuseColour = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
         glm::vec4 mSpecularColour = glm::vec4(0.3f, 0.3f, 0.3f, 1.0f);
         glm::vec4 mAmbientColour = glm::vec4(0.2f, 0.2f, 0.2f, 1.0f);
@@ -49,11 +54,41 @@ namespace Ming3D
     };
 
 #define MODELLOADERFLAGS_UNLIT 1
+#define MODELLOADERFLAGS_NO_LODS 2
+#define MODELLOADERFLAGS_FULL_PRECISION 4 // keep 32 bit float vertex components
+#define MODELLOADERFLAGS_NO_CACHE 8 // always import with assimp, and don't write the cooked model cache
+#define MODELLOADERFLAGS_TEXTURE_ARRAYS 16 // put textures in shared texture arrays (see TextureArrayPool), so materials don't need to rebind them
+
+// Flags that change the cooked model (the rest are applied when creating materials and actors)
+#define MODELLOADERFLAGS_COOKED_MASK (MODELLOADERFLAGS_NO_LODS | MODELLOADERFLAGS_FULL_PRECISION)
+
+#define MODELLOADER_MAX_LODS 3
 
     class ModelLoader
     {
     public:
         static bool LoadModel(const char* inModel, Actor* inActor, int inFlags = 0);
+
+        /** Imports a model with assimp, and creates optimised (and compressed) meshes with LODs. */
+        static CookedModel* CookModel(const char* inModel, int inFlags);
+
+        /**
+        * Loads a model from the model cache, or cooks it (and updates the cache).
+        * Doesn't touch the render device or the world, so it's safe to call from worker threads.
+        */
+        static CookedModel* LoadCookedModel(const char* inModel, int inFlags);
+
+        /** Parameters of the material created for the given material data. */
+        static MaterialParams GetMaterialParams(const MaterialData* inMaterialData, int inFlags);
+
+        /** Key of a model in the AssetRegistry. */
+        static std::string GetModelKey(const char* inModel, int inFlags);
+
+        /**
+        * Creates materials and child actors with mesh components.
+        * GPU resources (mesh buffers, textures and shader programs) are shared with other instances of the model.
+        */
+        static void CreateModelActors(AssetHandle<CookedModel> inModel, const std::string& inModelKey, Actor* inActor, int inFlags);
     };
 }
 #endif
@@ -1,6 +1,7 @@
 #include "game_network.h"
 
 #include "Debug/debug.h"
+#include "Debug/profiler.h"
 #include "GameEngine/game_engine.h"
 #include "Platform/platform.h"
 #include <cstring>
@@ -45,6 +46,7 @@ namespace Ming3D
         if (!mIsActive)
             return;
 
+        PROFILE_ZONE("GameNetwork::Update");
         NetSocket* inConnSock = mListenSocket->Accept();
         NetConnection* inConnection = new NetConnection(inConnSock);
         if (inConnSock != nullptr)
@@ -65,6 +67,7 @@ namespace Ming3D
 
     void GameNetwork::HandleIncomingMessages()
     {
+        PROFILE_ZONE("HandleIncomingMessages");
         for (IncomingMessage& msg : mIncomingMessages)
         {
             delete msg.mMessage;
@@ -178,6 +181,7 @@ namespace Ming3D
 
     void GameNetwork::SendQueuedMessages()
     {
+        PROFILE_ZONE("SendQueuedMessages");
         for (OutgoingMessage& currMessage : mOutgoingMessages)
         {
             std::vector<int> targets;
@@ -5,12 +5,31 @@
 
 namespace Ming3D
 {
+    /**
+    * A read-only view of a file's content, mapped into memory.
+    */
+    class MappedFile
+    {
+    public:
+        const char* mData = nullptr;
+        size_t mSize = 0;
+        void* mHandle = nullptr; // platform specific
+    };
+
     class PlatformFile
     {
     public:
         virtual bool MakeDirectory(const std::string inPath) = 0;
         virtual bool DirectoryExists(const std::string inPath) = 0;
         virtual bool OpenFileDialog(const std::string inTitile, std::string& outFilePath) = 0;
+        /** Maps a file into memory (read-only). Returns nullptr if the file can't be opened. Close with UnmapFile. */
+        virtual MappedFile* MapFile(const std::string inPath) = 0;
+        virtual void UnmapFile(MappedFile* inFile) = 0;
+        /**
+        * Moves a file to inDestPath, replacing the existing file in one step (readers see either the old or the new file).
+        * Mapped views of the old file stay valid. Fails on Windows while the old file is mapped.
+        */
+        virtual bool RenameFile(const std::string inSourcePath, const std::string inDestPath) = 0;
     };
 }
 
@@ -1,6 +1,11 @@
 #ifdef __linux__
 #include "platform_file_linux.h"
 
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace Ming3D
 {
@@ -18,5 +23,40 @@ namespace Ming3D
     {
         return false;
     }
+
+    MappedFile* PlatformFileLinux::MapFile(const std::string inPath)
+    {
+        int fd = open(inPath.c_str(), O_RDONLY);
+        if (fd == -1)
+            return nullptr;
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping keeps the file open
+        if (data == MAP_FAILED)
+            return nullptr;
+
+        MappedFile* file = new MappedFile();
+        file->mData = static_cast<const char*>(data);
+        file->mSize = (size_t)fileStat.st_size;
+        return file;
+    }
+
+    void PlatformFileLinux::UnmapFile(MappedFile* inFile)
+    {
+        munmap(const_cast<char*>(inFile->mData), inFile->mSize);
+        delete inFile;
+    }
+
+    bool PlatformFileLinux::RenameFile(const std::string inSourcePath, const std::string inDestPath)
+    {
+        return rename(inSourcePath.c_str(), inDestPath.c_str()) == 0; // existing mappings keep the old inode
+    }
 }
 #endif
@@ -52,5 +52,49 @@ namespace Ming3D
         else
             return false;
     }
+
+    MappedFile* PlatformFileWin32::MapFile(const std::string inPath)
+    {
+        HANDLE fileHandle = CreateFileA(inPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+            return nullptr;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+        {
+            CloseHandle(fileHandle);
+            return nullptr;
+        }
+
+        HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(fileHandle); // the mapping keeps the file open
+        if (mappingHandle == NULL)
+            return nullptr;
+
+        void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        if (data == nullptr)
+        {
+            CloseHandle(mappingHandle);
+            return nullptr;
+        }
+
+        MappedFile* file = new MappedFile();
+        file->mData = static_cast<const char*>(data);
+        file->mSize = (size_t)fileSize.QuadPart;
+        file->mHandle = mappingHandle;
+        return file;
+    }
+
+    void PlatformFileWin32::UnmapFile(MappedFile* inFile)
+    {
+        UnmapViewOfFile(inFile->mData);
+        CloseHandle(inFile->mHandle);
+        delete inFile;
+    }
+
+    bool PlatformFileWin32::RenameFile(const std::string inSourcePath, const std::string inDestPath)
+    {
+        return MoveFileExA(inSourcePath.c_str(), inDestPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+    }
 }
 #endif
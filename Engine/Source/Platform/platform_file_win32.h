@@ -11,6 +11,9 @@ namespace Ming3D
         virtual bool MakeDirectory(const std::string inPath) override;
         virtual bool DirectoryExists(const std::string inPath) override;
         virtual bool OpenFileDialog(const std::string inTitile, std::string& outFilePath) override;
+        virtual MappedFile* MapFile(const std::string inPath) override;
+        virtual void UnmapFile(MappedFile* inFile) override;
+        virtual bool RenameFile(const std::string inSourcePath, const std::string inDestPath) override;
     };
 }
 
@@ -16,4 +16,9 @@ namespace Ming3D
     {
         delete mRenderPipelineParams;
     }
+
+    glm::mat4 Camera::GetProjectionMatrix(float inAspectRatio) const
+    {
+        return glm::perspective<float>(glm::radians(mFieldOfView), inAspectRatio, mNearPlane, mFarPlane);
+    }
 }
@@ -15,8 +15,13 @@ namespace Ming3D
         ~Camera();
 
         glm::mat4 mCameraMatrix;
+        float mFieldOfView = 45.0f; // vertical, in degrees
+        float mNearPlane = 0.1f;
+        float mFarPlane = 100.0f;
         RenderTarget* mRenderTarget = nullptr;
         RenderPipelineParams* mRenderPipelineParams = nullptr;
+
+        glm::mat4 GetProjectionMatrix(float inAspectRatio) const;
     };
 }
 
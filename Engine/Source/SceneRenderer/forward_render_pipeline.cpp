@@ -2,77 +2,118 @@
 #include "GameEngine/game_engine.h"
 #include "render_device.h"
 #include "Model/material_buffer.h"
-#include "Model/shader_uniform_data.h"
+#include "scene_renderer.h"
+#include "Assets/asset_registry.h"
+#include "Debug/profiler.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
 namespace Ming3D
 {
-    void ForwardRenderPipeline::UpdateUniforms(MaterialBuffer* inMat)
+    ForwardRenderPipeline::~ForwardRenderPipeline()
+    {
+        if (mDepthPrepassState != nullptr)
+            delete mDepthPrepassState;
+        if (mDepthEqualState != nullptr)
+            delete mDepthEqualState;
+    }
+
+    void ForwardRenderPipeline::UpdateUniforms(MaterialBuffer* inMat, const ShaderProgram* inProgram)
     {
         RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
 
-        for (const std::string& uniformName : inMat->mModifiedUniforms)
+        UniformOwner& owner = mUniformOwners[inProgram];
+        if (owner.mMaterial != inMat || owner.mUniformVersion < inMat->mDirtyUniformsVersion)
         {
-            auto it = inMat->mShaderUniformMap.find(uniformName);
-            assert(it != inMat->mShaderUniformMap.end());
-            const ShaderUniformData* uniformData = it->second;
-            switch (uniformData->mTypeInfo.mDatatype)
-            {
-            case EShaderDatatype::Float:
-            {
-                float val;
-                uniformData->GetData(&val);
-                renderDevice->SetShaderUniformFloat(uniformName.c_str(), val); // TODO: pass pointer instead of uniform name string?
-                break;
-            }
-            case EShaderDatatype::Int:
-            {
-                int val;
-                uniformData->GetData(&val);
-                renderDevice->SetShaderUniformInt(uniformName.c_str(), val); // TODO: pass pointer instead of uniform name string?
-                break;
-            }
-            case EShaderDatatype::Mat4x4:
-            {
-                glm::mat4 val;
-                uniformData->GetData(&val);
-                renderDevice->SetShaderUniformMat4x4(uniformName.c_str(), val); // TODO: pass pointer instead of uniform name string?
-                break;
-            }
-            case EShaderDatatype::Vec2:
-            {
-                glm::vec2 val;
-                uniformData->GetData(&val);
-                renderDevice->SetShaderUniformVec2(uniformName.c_str(), val); // TODO: pass pointer instead of uniform name string?
-                break;
-            }
-            case EShaderDatatype::Vec3:
-            {
-                glm::vec3 val;
-                uniformData->GetData(&val);
-                renderDevice->SetShaderUniformVec3(uniformName.c_str(), val); // TODO: pass pointer instead of uniform name string?
-                break;
-            }
-            case EShaderDatatype::Vec4:
+            renderDevice->SetShaderUniformBlock(inMat->mUniformData.data(), 0, inMat->mUniformData.size());
+        }
+        else if (owner.mUniformVersion != inMat->mUniformVersion && inMat->mDirtyUniformsEnd > inMat->mDirtyUniformsBegin)
+        {
+            renderDevice->SetShaderUniformBlock(inMat->mUniformData.data(), inMat->mDirtyUniformsBegin, inMat->mDirtyUniformsEnd - inMat->mDirtyUniformsBegin);
+        }
+        owner.mMaterial = inMat;
+        owner.mUniformVersion = inMat->mUniformVersion;
+    }
+
+    glm::mat4 ForwardRenderPipeline::GetProjectionMatrix(const Camera* inCamera)
+    {
+        WindowBase* window = GGameEngine->GetMainWindow();
+        return inCamera->GetProjectionMatrix((float)window->GetWidth() / (float)window->GetHeight());
+    }
+
+    void ForwardRenderPipeline::RenderDepthOnly(RenderPipelineNodeCollection& inNodes, const glm::mat4& inViewProjection, const glm::mat4& inView)
+    {
+        RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
+
+        MaterialBuffer* currMaterial = nullptr;
+
+        auto nodeIter = inNodes.begin();
+        while (nodeIter != inNodes.end())
+        {
+            RenderPipelineNode* node = *nodeIter;
+
+            if (node->mMaterial != currMaterial)
             {
-                glm::vec4 val;
-                uniformData->GetData(&val);
-                renderDevice->SetShaderUniformVec4(uniformName.c_str(), val); // TODO: pass pointer instead of uniform name string?
-                break;
-            }
-            default:
-                assert(0); // TODO: add support for other types
+                currMaterial = node->mMaterial;
+
+                // Depth-only programs are created the first time a material is used in a depth-only pass
+                if (currMaterial->mDepthOnlyShaderProgram == nullptr)
+                {
+                    currMaterial->mDepthOnlyShaderProgram = GGameEngine->GetAssetRegistry()->GetDepthOnlyShaderProgram(currMaterial->mParsedShaderProgram);
+                    GGameEngine->GetSceneRenderer()->RegisterMaterial(currMaterial);
+                }
+
+                renderDevice->SetActiveShaderProgram(currMaterial->mDepthOnlyShaderProgram.get());
+
+                // Vertex shaders may read material uniforms, so keep the depth-only program in sync.
+                // The dirty range is cleared by the colour pass. Modifications this program misses because of that are caught up with a full upload.
+                UpdateUniforms(currMaterial, currMaterial->mDepthOnlyShaderProgram.get());
             }
+
+            // Must match the colour pass exactly, to pass the Equal depth test
+            glm::mat4 model = node->mModelMatrix;
+            glm::mat4 mvp = inViewProjection * model;
+            glm::mat4 mv = inView * model;
+
+            renderDevice->SetShaderUniformMat4x4("MVP", mvp);
+            renderDevice->SetShaderUniformMat4x4("modelViewMat", mv);
+
+            renderDevice->RenderPrimitive(node->mMesh->mVertexBuffer, node->mIndexBuffer);
+
+            nodeIter++;
+        }
+    }
+
+    void ForwardRenderPipeline::RenderShadowCascades(RenderPipelineParams& params)
+    {
+        PROFILE_ZONE("RenderShadowCascades");
+        RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
+        RenderTarget* shadowMapTarget = GGameEngine->GetSceneRenderer()->GetShadowMapTarget();
+
+#ifdef MING3D_D3D11
+        // D3D clip space depth is [0, 1]
+        const glm::mat4 clipDepthRemap = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.5f)) * glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 1.0f, 0.5f));
+#else
+        const glm::mat4 clipDepthRemap(1.0f);
+#endif
+
+        for (int iCascade = 0; iCascade < params.mNumShadowCascades; iCascade++)
+        {
+            ShadowCascade& cascade = params.mShadowCascades[iCascade];
+            renderDevice->BeginDepthRenderTarget(shadowMapTarget, iCascade);
+            RenderDepthOnly(cascade.mCasters, clipDepthRemap * cascade.mLightViewProjection, cascade.mLightViewProjection);
+            renderDevice->EndRenderTarget(shadowMapTarget);
         }
-        inMat->mModifiedUniforms.clear();
     }
 
     void ForwardRenderPipeline::RenderObjects(RenderPipelineParams& params)
     {
-        WindowBase* window = GGameEngine->GetMainWindow();
+        PROFILE_ZONE("RenderObjects");
         RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
 
+        const glm::mat4 Projection = GetProjectionMatrix(params.mCamera);
+        const glm::mat4 view = params.mCamera->mCameraMatrix;
+
         MaterialBuffer* currMaterial = nullptr;
 
         auto nodeIter = params.mNodes.begin();
@@ -86,24 +127,23 @@ namespace Ming3D
                 currMaterial = node->mMaterial;
                 
                 // set shader program
-                renderDevice->SetActiveShaderProgram(currMaterial->mShaderProgram);
+                renderDevice->SetActiveShaderProgram(currMaterial->mShaderProgram.get());
 
                 // set textures
                 for (size_t iTexture = 0; iTexture < currMaterial->mTextureBuffers.size(); iTexture++)
                 {
-                    const TextureBuffer* texture = currMaterial->mTextureBuffers[iTexture];
+                    const TextureBuffer* texture = currMaterial->mTextureBuffers[iTexture].get();
                     if (texture != nullptr)
                         renderDevice->SetTexture(texture, iTexture); // temp
                 }
+                GGameEngine->GetSceneRenderer()->BindSceneTextures(currMaterial);
 
                 // update uniforms
-                UpdateUniforms(currMaterial);
+                UpdateUniforms(currMaterial, currMaterial->mShaderProgram.get());
+                currMaterial->ClearDirtyUniforms();
             }
 
-            glm::mat4 Projection = glm::perspective<float>(glm::radians(45.0f), (float)window->GetWidth() / (float)window->GetHeight(), 0.1f, 100.0f);
-
             // matrices
-            glm::mat4 view = params.mCamera->mCameraMatrix;
             glm::mat4 model = node->mModelMatrix;
 
             glm::mat4 mvp = Projection * view * model;
@@ -114,7 +154,7 @@ namespace Ming3D
 
             // TODO: Don't bind vertex/index buffer if same mesh as last frame
 
-            renderDevice->RenderPrimitive(node->mMesh->mVertexBuffer, node->mMesh->mIndexBuffer);
+            renderDevice->RenderPrimitive(node->mMesh->mVertexBuffer, node->mIndexBuffer);
 
             nodeIter++;
         }
@@ -124,8 +164,46 @@ namespace Ming3D
     {
         if (params.mCamera->mRenderTarget == nullptr)
             return;
-        GGameEngine->GetRenderDevice()->BeginRenderTarget(params.mCamera->mRenderTarget);
-        RenderObjects(params);
-        GGameEngine->GetRenderDevice()->EndRenderTarget(params.mCamera->mRenderTarget);
+
+        RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
+
+        if (params.mNumShadowCascades > 0)
+            RenderShadowCascades(params);
+
+        renderDevice->BeginRenderTarget(params.mCamera->mRenderTarget);
+
+        if (params.mDepthPrepass)
+        {
+            if (mDepthPrepassState == nullptr)
+            {
+                DepthStencilStateDesc dssDesc;
+                dssDesc.mDepthFunc = DepthStencilDepthFunc::Less;
+                mDepthPrepassState = renderDevice->CreateDepthStencilState(dssDesc);
+
+                dssDesc.mDepthFunc = DepthStencilDepthFunc::Equal;
+                dssDesc.mDepthWriteEnabled = false;
+                mDepthEqualState = renderDevice->CreateDepthStencilState(dssDesc);
+            }
+
+            // Depth only
+            PROFILE_ZONE("DepthPrepass");
+            renderDevice->SetColourWriteEnabled(false);
+            renderDevice->SetDepthStencilState(mDepthPrepassState);
+            const glm::mat4 view = params.mCamera->mCameraMatrix;
+            RenderDepthOnly(params.mNodes, GetProjectionMatrix(params.mCamera) * view, view);
+
+            // Shade only the visible surfaces
+            renderDevice->SetColourWriteEnabled(true);
+            renderDevice->SetDepthStencilState(mDepthEqualState);
+            RenderObjects(params);
+
+            renderDevice->SetDepthStencilState(nullptr);
+        }
+        else
+        {
+            RenderObjects(params);
+        }
+
+        renderDevice->EndRenderTarget(params.mCamera->mRenderTarget);
     }
 }
@@ -2,18 +2,45 @@
 #define MING3D_FORWARDRENDERPIPELINE_H
 
 #include "render_pipeline.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
 
 namespace Ming3D
 {
     class MaterialBuffer;
+    class DepthStencilState;
+    class ShaderProgram;
 
     class ForwardRenderPipeline : public RenderPipeline
     {
     private:
-        void UpdateUniforms(MaterialBuffer* inMat);
+        DepthStencilState* mDepthPrepassState = nullptr;
+        DepthStencilState* mDepthEqualState = nullptr;
+        /** The material whose uniforms a shader program has, and the material's mUniformVersion when they were uploaded. */
+        class UniformOwner
+        {
+        public:
+            const MaterialBuffer* mMaterial = nullptr;
+            uint64_t mUniformVersion = 0;
+        };
+
+        // Shader programs are shared by materials, so track which material's uniforms each program has
+        std::unordered_map<const ShaderProgram*, UniformOwner> mUniformOwners;
+
+        /**
+        * Uploads the material's modified uniforms, or all of them if the program was last used by another material,
+        *  or if the program missed modifications that are no longer in the dirty range (e.g. a depth-only program that wasn't used for a while).
+        */
+        void UpdateUniforms(MaterialBuffer* inMat, const ShaderProgram* inProgram);
+        void RenderDepthOnly(RenderPipelineNodeCollection& inNodes, const glm::mat4& inViewProjection, const glm::mat4& inView);
+        void RenderShadowCascades(RenderPipelineParams& params);
         void RenderObjects(RenderPipelineParams& params);
+        glm::mat4 GetProjectionMatrix(const Camera* inCamera);
 
     public:
+        virtual ~ForwardRenderPipeline();
+
         virtual void Render(RenderPipelineParams& params) override;
     };
 }
@@ -0,0 +1,34 @@
+#include "frustum.h"
+
+namespace Ming3D
+{
+    void Frustum::SetFromViewProjection(const glm::mat4& inViewProjection)
+    {
+        // Gribb/Hartmann: each plane is the sum/difference of the 4th row and one of the other rows
+        const glm::mat4 m = glm::transpose(inViewProjection);
+        mPlanes[Left] = m[3] + m[0];
+        mPlanes[Right] = m[3] - m[0];
+        mPlanes[Bottom] = m[3] + m[1];
+        mPlanes[Top] = m[3] - m[1];
+        mPlanes[Near] = m[3] + m[2];
+        mPlanes[Far] = m[3] - m[2];
+
+        for (int iPlane = 0; iPlane < NumPlanes; iPlane++)
+            mPlanes[iPlane] /= glm::length(glm::vec3(mPlanes[iPlane]));
+    }
+
+    void Frustum::DisablePlane(EPlane inPlane)
+    {
+        mPlanes[inPlane] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    bool Frustum::IntersectsSphere(const glm::vec3& inCentre, float inRadius) const
+    {
+        for (int iPlane = 0; iPlane < NumPlanes; iPlane++)
+        {
+            if (glm::dot(glm::vec3(mPlanes[iPlane]), inCentre) + mPlanes[iPlane].w < -inRadius)
+                return false;
+        }
+        return true;
+    }
+}
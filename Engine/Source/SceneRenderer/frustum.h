@@ -0,0 +1,32 @@
+#ifndef MING3D_FRUSTUM_H
+#define MING3D_FRUSTUM_H
+
+#include "glm/glm.hpp"
+
+namespace Ming3D
+{
+    /**
+    * View frustum, as six planes facing inwards (xyz = normal, w = distance).
+    * Used for culling bounding spheres.
+    */
+    class Frustum
+    {
+    public:
+        enum EPlane
+        {
+            Left, Right, Bottom, Top, Near, Far, NumPlanes
+        };
+
+        glm::vec4 mPlanes[NumPlanes];
+
+        /** Extracts the planes from a (world to clip space) view-projection matrix. */
+        void SetFromViewProjection(const glm::mat4& inViewProjection);
+
+        /** Makes the plane accept everything. */
+        void DisablePlane(EPlane inPlane);
+
+        bool IntersectsSphere(const glm::vec3& inCentre, float inRadius) const;
+    };
+}
+
+#endif
@@ -0,0 +1,197 @@
+#include "light_cluster_grid.h"
+#include "camera.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MING3D_LIGHTCLUSTERS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Ming3D
+{
+    void LightClusterGrid::Build(const std::vector<RenderSceneLight*>& inLights, const Camera* inCamera, float inAspectRatio)
+    {
+        const float nearPlane = inCamera->mNearPlane;
+        const float farPlane = inCamera->mFarPlane;
+
+        // Must match the projection matrix used for rendering (glm::perspective)
+        const float projScaleY = 1.0f / std::tan(glm::radians(inCamera->mFieldOfView) * 0.5f);
+        const float projScaleX = projScaleY / inAspectRatio;
+
+        // slice = log(depth) * scale + bias
+        const float logDepthRange = std::log(farPlane / nearPlane);
+        const float sliceScale = GridSizeZ / logDepthRange;
+        const float sliceBias = -GridSizeZ * std::log(nearPlane) / logDepthRange;
+
+        const size_t numLights = inLights.size();
+
+        mClusterParams = glm::vec4(projScaleX, projScaleY, sliceScale, sliceBias);
+        mGridSize = glm::vec4((float)GridSizeX, (float)GridSizeY, (float)GridSizeZ, (float)numLights);
+
+        mLightData.resize(numLights * TexelsPerLight);
+        mCentreX.resize(numLights);
+        mCentreY.resize(numLights);
+        mDepth.resize(numLights);
+        mRadius.resize(numLights);
+        mTileMinX.resize(numLights);
+        mTileMaxX.resize(numLights);
+        mTileMinY.resize(numLights);
+        mTileMaxY.resize(numLights);
+        mSliceMin.resize(numLights);
+        mSliceMax.resize(numLights);
+
+        // Transform lights to view space
+        const glm::mat4& viewMatrix = inCamera->mCameraMatrix;
+        for (size_t iLight = 0; iLight < numLights; iLight++)
+        {
+            const RenderSceneLight* light = inLights[iLight];
+            const glm::vec4 viewPos = viewMatrix * glm::vec4(light->mPosition, 1.0f);
+            const glm::vec3 viewDir = glm::normalize(glm::vec3(viewMatrix * glm::vec4(light->mDirection, 0.0f)));
+            const float lightType = light->mLightType == ELightType::Spot ? 1.0f : 0.0f;
+
+            mLightData[iLight * TexelsPerLight] = glm::vec4(viewPos.x, viewPos.y, viewPos.z, light->mRange);
+            mLightData[iLight * TexelsPerLight + 1] = glm::vec4(light->mColour, lightType);
+            mLightData[iLight * TexelsPerLight + 2] = glm::vec4(viewDir, std::cos(glm::radians(light->mSpotAngle)));
+
+            // Camera looks down negative Z
+            mCentreX[iLight] = viewPos.x;
+            mCentreY[iLight] = viewPos.y;
+            mDepth[iLight] = -viewPos.z;
+            mRadius[iLight] = light->mRange;
+        }
+
+        CalculateClusterBounds(numLights, nearPlane, farPlane);
+
+        // Count lights per cluster
+        mClusterCursors.assign(NumClusters, 0);
+        for (size_t iLight = 0; iLight < numLights; iLight++)
+        {
+            for (int z = mSliceMin[iLight]; z <= mSliceMax[iLight]; z++)
+                for (int y = mTileMinY[iLight]; y <= mTileMaxY[iLight]; y++)
+                    for (int x = mTileMinX[iLight]; x <= mTileMaxX[iLight]; x++)
+                        mClusterCursors[x + y * GridSizeX + z * GridSizeX * GridSizeY]++;
+        }
+
+        // Assign each cluster a range in the light index list
+        mClusterData.resize(NumClusters);
+        int numIndices = 0;
+        for (int iCluster = 0; iCluster < NumClusters; iCluster++)
+        {
+            const int count = mClusterCursors[iCluster];
+            mClusterData[iCluster] = glm::vec4((float)numIndices, (float)count, 0.0f, 0.0f);
+            mClusterCursors[iCluster] = numIndices;
+            numIndices += count;
+        }
+
+        // Fill light index lists
+        mLightIndices.resize(numIndices);
+        for (size_t iLight = 0; iLight < numLights; iLight++)
+        {
+            const glm::vec4 lightIndex((float)iLight, 0.0f, 0.0f, 0.0f);
+            for (int z = mSliceMin[iLight]; z <= mSliceMax[iLight]; z++)
+                for (int y = mTileMinY[iLight]; y <= mTileMaxY[iLight]; y++)
+                    for (int x = mTileMinX[iLight]; x <= mTileMaxX[iLight]; x++)
+                        mLightIndices[mClusterCursors[x + y * GridSizeX + z * GridSizeX * GridSizeY]++] = lightIndex;
+        }
+    }
+
+    void LightClusterGrid::CalculateClusterBounds(size_t inNumLights, float inNearPlane, float inFarPlane)
+    {
+        // Screen-space bounds of each light's view-space AABB.
+        // x / depth is monotonic in both, so the extremes are found at the corners of the (x, depth) range.
+        // tile = (ndc * 0.5 + 0.5) * gridSize
+        const float tileScaleX = mClusterParams.x * 0.5f * GridSizeX;
+        const float tileScaleY = mClusterParams.y * 0.5f * GridSizeY;
+        const float tileBiasX = 0.5f * GridSizeX;
+        const float tileBiasY = 0.5f * GridSizeY;
+
+        size_t iLight = 0;
+
+#ifdef MING3D_LIGHTCLUSTERS_SSE
+        const __m128 nearPlane = _mm_set1_ps(inNearPlane);
+        const __m128 farPlane = _mm_set1_ps(inFarPlane);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 scaleX = _mm_set1_ps(tileScaleX);
+        const __m128 scaleY = _mm_set1_ps(tileScaleY);
+        const __m128 biasX = _mm_set1_ps(tileBiasX);
+        const __m128 biasY = _mm_set1_ps(tileBiasY);
+        const __m128 maxTileX = _mm_set1_ps((float)(GridSizeX - 1));
+        const __m128 maxTileY = _mm_set1_ps((float)(GridSizeY - 1));
+
+        for (; iLight + 4 <= inNumLights; iLight += 4)
+        {
+            const __m128 centreX = _mm_loadu_ps(&mCentreX[iLight]);
+            const __m128 centreY = _mm_loadu_ps(&mCentreY[iLight]);
+            const __m128 depth = _mm_loadu_ps(&mDepth[iLight]);
+            const __m128 radius = _mm_loadu_ps(&mRadius[iLight]);
+
+            const __m128 invDepthMin = _mm_div_ps(one, _mm_max_ps(_mm_sub_ps(depth, radius), nearPlane));
+            const __m128 invDepthMax = _mm_div_ps(one, _mm_min_ps(_mm_add_ps(depth, radius), farPlane));
+
+            const __m128 x0 = _mm_sub_ps(centreX, radius);
+            const __m128 x1 = _mm_add_ps(centreX, radius);
+            const __m128 y0 = _mm_sub_ps(centreY, radius);
+            const __m128 y1 = _mm_add_ps(centreY, radius);
+
+            __m128 minX = _mm_min_ps(_mm_mul_ps(x0, invDepthMin), _mm_mul_ps(x0, invDepthMax));
+            __m128 maxX = _mm_max_ps(_mm_mul_ps(x1, invDepthMin), _mm_mul_ps(x1, invDepthMax));
+            __m128 minY = _mm_min_ps(_mm_mul_ps(y0, invDepthMin), _mm_mul_ps(y0, invDepthMax));
+            __m128 maxY = _mm_max_ps(_mm_mul_ps(y1, invDepthMin), _mm_mul_ps(y1, invDepthMax));
+
+            // Clamped to [0, gridSize - 1], so truncation is equivalent to floor
+            minX = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(minX, scaleX), biasX), zero), maxTileX);
+            maxX = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(maxX, scaleX), biasX), zero), maxTileX);
+            minY = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(minY, scaleY), biasY), zero), maxTileY);
+            maxY = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(maxY, scaleY), biasY), zero), maxTileY);
+
+            _mm_storeu_si128((__m128i*)&mTileMinX[iLight], _mm_cvttps_epi32(minX));
+            _mm_storeu_si128((__m128i*)&mTileMaxX[iLight], _mm_cvttps_epi32(maxX));
+            _mm_storeu_si128((__m128i*)&mTileMinY[iLight], _mm_cvttps_epi32(minY));
+            _mm_storeu_si128((__m128i*)&mTileMaxY[iLight], _mm_cvttps_epi32(maxY));
+        }
+#endif
+
+        for (; iLight < inNumLights; iLight++)
+        {
+            const float invDepthMin = 1.0f / std::max(mDepth[iLight] - mRadius[iLight], inNearPlane);
+            const float invDepthMax = 1.0f / std::min(mDepth[iLight] + mRadius[iLight], inFarPlane);
+
+            const float x0 = mCentreX[iLight] - mRadius[iLight];
+            const float x1 = mCentreX[iLight] + mRadius[iLight];
+            const float y0 = mCentreY[iLight] - mRadius[iLight];
+            const float y1 = mCentreY[iLight] + mRadius[iLight];
+
+            const float minX = std::min(x0 * invDepthMin, x0 * invDepthMax) * tileScaleX + tileBiasX;
+            const float maxX = std::max(x1 * invDepthMin, x1 * invDepthMax) * tileScaleX + tileBiasX;
+            const float minY = std::min(y0 * invDepthMin, y0 * invDepthMax) * tileScaleY + tileBiasY;
+            const float maxY = std::max(y1 * invDepthMin, y1 * invDepthMax) * tileScaleY + tileBiasY;
+
+            mTileMinX[iLight] = (int)std::min(std::max(minX, 0.0f), (float)(GridSizeX - 1));
+            mTileMaxX[iLight] = (int)std::min(std::max(maxX, 0.0f), (float)(GridSizeX - 1));
+            mTileMinY[iLight] = (int)std::min(std::max(minY, 0.0f), (float)(GridSizeY - 1));
+            mTileMaxY[iLight] = (int)std::min(std::max(maxY, 0.0f), (float)(GridSizeY - 1));
+        }
+
+        // Depth slices
+        for (iLight = 0; iLight < inNumLights; iLight++)
+        {
+            const float depthMin = mDepth[iLight] - mRadius[iLight];
+            const float depthMax = mDepth[iLight] + mRadius[iLight];
+            if (depthMax < inNearPlane || depthMin > inFarPlane)
+            {
+                // Outside the view depth range - not added to any cluster
+                mSliceMin[iLight] = 1;
+                mSliceMax[iLight] = 0;
+                continue;
+            }
+
+            const float sliceMin = std::log(std::max(depthMin, inNearPlane)) * mClusterParams.z + mClusterParams.w;
+            const float sliceMax = std::log(std::min(depthMax, inFarPlane)) * mClusterParams.z + mClusterParams.w;
+            mSliceMin[iLight] = (int)std::min(std::max(sliceMin, 0.0f), (float)(GridSizeZ - 1));
+            mSliceMax[iLight] = (int)std::min(std::max(sliceMax, 0.0f), (float)(GridSizeZ - 1));
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef MING3D_LIGHTCLUSTERGRID_H
+#define MING3D_LIGHTCLUSTERGRID_H
+
+#include "render_scene_light.h"
+#include "glm/glm.hpp"
+#include <vector>
+
+namespace Ming3D
+{
+    class Camera;
+
+    /**
+    * Bins point and spot lights into a view-space cluster grid, for clustered forward shading.
+    * XY tiles split the screen evenly, and Z slices are distributed exponentially between the near and far plane.
+    * The output is laid out for upload to texel buffers (one vec4 per texel):
+    *   mLightData:    3 texels per light: (view position, range), (colour, type), (view direction, cos of outer cone angle)
+    *   mClusterData:  1 texel per cluster: (light list offset, light count, 0, 0)
+    *   mLightIndices: 1 texel per light list entry: (light index, 0, 0, 0)
+    */
+    class LightClusterGrid
+    {
+    public:
+        static constexpr int GridSizeX = 16;
+        static constexpr int GridSizeY = 8;
+        static constexpr int GridSizeZ = 24;
+        static constexpr int NumClusters = GridSizeX * GridSizeY * GridSizeZ;
+        static constexpr int TexelsPerLight = 3;
+
+        std::vector<glm::vec4> mLightData;
+        std::vector<glm::vec4> mClusterData;
+        std::vector<glm::vec4> mLightIndices;
+
+        /** Parameters for the shader-side cluster lookup: (proj[0][0], proj[1][1], depth slice scale, depth slice bias) */
+        glm::vec4 mClusterParams;
+        /** (GridSizeX, GridSizeY, GridSizeZ, number of lights) */
+        glm::vec4 mGridSize;
+
+        void Build(const std::vector<RenderSceneLight*>& inLights, const Camera* inCamera, float inAspectRatio);
+
+    private:
+        // Per-light view-space bounding spheres and resulting cluster ranges, in structure-of-arrays layout (processed 4 at a time)
+        std::vector<float> mCentreX;
+        std::vector<float> mCentreY;
+        std::vector<float> mDepth;
+        std::vector<float> mRadius;
+        std::vector<int> mTileMinX;
+        std::vector<int> mTileMaxX;
+        std::vector<int> mTileMinY;
+        std::vector<int> mTileMaxY;
+        std::vector<int> mSliceMin;
+        std::vector<int> mSliceMax;
+        std::vector<int> mClusterCursors;
+
+        void CalculateClusterBounds(size_t inNumLights, float inNearPlane, float inFarPlane);
+    };
+}
+
+#endif
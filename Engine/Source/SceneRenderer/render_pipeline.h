@@ -11,8 +11,11 @@ namespace Ming3D
     {
     public:
         MeshBuffer* mMesh = nullptr;
+        IndexBuffer* mIndexBuffer = nullptr; // index buffer of the selected LOD
         MaterialBuffer* mMaterial = nullptr;
         glm::mat4 mModelMatrix;
+        float mViewDepth = 0.0f;
+        float mBoundsRadius = -1.0f; // world space bounding sphere radius (negative if unknown)
     };
 
     class RenderPipelineNodeCollection
@@ -33,10 +36,58 @@ namespace Ming3D
         size_t mSize = 0;
     };
 
+    enum class ERenderNodeSortMode
+    {
+        Material,   // minimise state changes
+        FrontToBack // minimise overdraw (nearest objects first)
+    };
+
+    /**
+    * Cascaded shadow map settings, for the main (directional) light.
+    * The camera frustum (up to mMaxDistance) is split into mNumCascades slices, each rendered to one layer of the shadow map.
+    */
+    struct ShadowSettings
+    {
+        static constexpr int MaxCascades = 4;
+
+        bool mEnabled = false;
+        int mNumCascades = 3;
+        size_t mTexelBudget = 3 * 1024 * 1024; // total shadow map texels, shared by all cascades
+        float mMaxDistance = 50.0f;
+        float mSplitLambda = 0.75f; // cascade split distribution: 0 = uniform, 1 = logarithmic
+        float mDepthBias = 0.0005f;
+        float mNormalOffset = 1.5f; // in shadow map texels
+
+        /** Resolution of each cascade: the largest power of two that fits the texel budget. */
+        unsigned int GetCascadeResolution() const
+        {
+            unsigned int resolution = 4096;
+            while (resolution > 256 && (size_t)resolution * resolution * mNumCascades > mTexelBudget)
+                resolution /= 2;
+            return resolution;
+        }
+    };
+
+    class ShadowCascade
+    {
+    public:
+        glm::mat4 mLightViewProjection; // world space to light clip space
+        glm::mat4 mShadowMatrix; // camera view space to shadow map texture space
+        float mSplitDepth = 0.0f; // far end of the cascade (view depth)
+        float mTexelSize = 0.0f; // size of a shadow map texel, in world units
+        RenderPipelineNodeCollection mCasters;
+    };
+
     struct RenderPipelineParams
     {
         Camera* mCamera = nullptr;
         RenderPipelineNodeCollection mNodes;
+        ERenderNodeSortMode mSortMode = ERenderNodeSortMode::Material;
+        bool mDepthPrepass = false; // lay down depth first, then shade each pixel once with an Equal depth test
+        float mLODHysteresis = 0.1f; // relative screen size margin around LOD switch points, to avoid switching back and forth
+        ShadowSettings mShadowSettings;
+        ShadowCascade mShadowCascades[ShadowSettings::MaxCascades];
+        int mNumShadowCascades = 0; // cascades to render this frame (set by the SceneRenderer)
     };
 
     class RenderPipeline
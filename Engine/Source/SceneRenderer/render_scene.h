@@ -2,6 +2,7 @@
 #define MING3D_RENDERSCENE_H
 
 #include "render_scene_object.h"
+#include "render_scene_light.h"
 #include <vector>
 
 namespace Ming3D
@@ -10,6 +11,7 @@ namespace Ming3D
     {
     public:
         std::vector<RenderSceneObject*> mSceneObjects;
+        std::vector<RenderSceneLight*> mSceneLights;
 
     };
 }
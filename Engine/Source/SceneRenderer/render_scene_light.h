@@ -0,0 +1,29 @@
+#ifndef MING3D_RENDERSCENELIGHT_H
+#define MING3D_RENDERSCENELIGHT_H
+
+#include "glm/glm.hpp"
+
+namespace Ming3D
+{
+    enum class ELightType
+    {
+        Point, Spot
+    };
+
+    /**
+    * A dynamic light, as seen by the scene renderer.
+    * Position and direction are in world space.
+    */
+    class RenderSceneLight
+    {
+    public:
+        ELightType mLightType = ELightType::Point;
+        glm::vec3 mPosition = glm::vec3(0.0f);
+        glm::vec3 mDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+        glm::vec3 mColour = glm::vec3(1.0f);
+        float mRange = 10.0f;
+        float mSpotAngle = 45.0f; // outer cone half-angle, in degrees
+    };
+}
+
+#endif
@@ -16,6 +16,7 @@ namespace Ming3D
         MeshBuffer* mMesh;
         glm::mat4 mModelMatrix;
         MaterialBuffer* mMaterial = nullptr;
+        int mLOD = 0; // current level of detail (see SceneRenderer::SelectLODs)
     };
 }
 
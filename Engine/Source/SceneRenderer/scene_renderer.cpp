@@ -1,28 +1,61 @@
 #include "scene_renderer.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/matrix_access.hpp"
 #include "window_base.h"
 #include "GameEngine/game_engine.h"
 #include "render_device.h"
 #include "Components/component.h"
 #include "Actors/actor.h"
-#include "Model/shader_uniform_data.h"
 #include "forward_render_pipeline.h"
 #include <algorithm>
 #include "constant_buffer_data.h"
+#include "shader_info.h"
+#include "texture_buffer.h"
+#include "render_target.h"
+#include "Assets/texture_streamer.h"
+#include "Debug/profiler.h"
+#include <cmath>
 
 namespace Ming3D
 {
     ConstantBufferData<glm::vec3, glm::vec4, glm::vec3, float> cbDataGlobal; // TODO
+    ConstantBufferData<glm::vec4, glm::vec4> cbDataLightClusters;
+    ConstantBufferData<glm::vec4, glm::vec4> cbDataShadows;
+
+    // Shadow matrix rows (x, y, z) and (normal offset, 0, 0, 0), per cascade
+    static constexpr int ShadowTexelsPerCascade = 4;
 
     struct RenderNodeSorter
     {
         inline bool operator() (const RenderPipelineNode* left, const RenderPipelineNode* right)
         {
             if (left->mMaterial != right->mMaterial)
+            {
+                // Group materials by shader and first texture, so the render device can skip rebinding them
+                const MaterialBuffer* leftMat = left->mMaterial;
+                const MaterialBuffer* rightMat = right->mMaterial;
+                if (leftMat->mShaderProgram != rightMat->mShaderProgram)
+                    return (leftMat->mShaderProgram < rightMat->mShaderProgram);
+                const TextureBuffer* leftTexture = leftMat->mTextureBuffers.empty() ? nullptr : leftMat->mTextureBuffers[0].get();
+                const TextureBuffer* rightTexture = rightMat->mTextureBuffers.empty() ? nullptr : rightMat->mTextureBuffers[0].get();
+                if (leftTexture != rightTexture)
+                    return (leftTexture < rightTexture);
                 return (left->mMaterial < right->mMaterial); // TODO: use material ID?
+            }
             else if (left->mMesh != right->mMesh)
                 return (left->mMesh < right->mMesh); // TODO: use mesh ID?
+            return false;
+        }
+    };
+
+    struct RenderNodeFrontToBackSorter
+    {
+        inline bool operator() (const RenderPipelineNode* left, const RenderPipelineNode* right)
+        {
+            if (left->mViewDepth != right->mViewDepth)
+                return (left->mViewDepth < right->mViewDepth);
+            return (left->mMaterial < right->mMaterial);
         }
     };
 
@@ -34,14 +67,26 @@ namespace Ming3D
 
     SceneRenderer::~SceneRenderer()
     {
+        if (mShadowMapTarget != nullptr)
+            delete mShadowMapTarget;
         delete mRenderPipeline;
         delete mRenderScene;
     }
 
     void SceneRenderer::Initialise()
     {
-        cbDataGlobal.SetData(glm::vec3(), glm::vec4(), glm::vec3(), 0.0f);
         mGlobalCBuffer = GGameEngine->GetRenderDevice()->CreateConstantBuffer(cbDataGlobal.mSize);
+        mLightClusterCBuffer = GGameEngine->GetRenderDevice()->CreateConstantBuffer(cbDataLightClusters.mSize);
+
+        mLightGridBuffer = GGameEngine->GetRenderDevice()->CreateTexelBuffer(LightClusterGrid::NumClusters);
+        mLightDataBuffer = GGameEngine->GetRenderDevice()->CreateTexelBuffer(64 * LightClusterGrid::TexelsPerLight);
+        mLightIndexBuffer = GGameEngine->GetRenderDevice()->CreateTexelBuffer(1024);
+        mLightDataCapacity = 64 * LightClusterGrid::TexelsPerLight;
+        mLightIndexCapacity = 1024;
+
+        mShadowCBuffer = GGameEngine->GetRenderDevice()->CreateConstantBuffer(cbDataShadows.mSize);
+        mShadowMatrixData.resize(ShadowSettings::MaxCascades * ShadowTexelsPerCascade);
+        mShadowMatrixBuffer = GGameEngine->GetRenderDevice()->CreateTexelBuffer(mShadowMatrixData.size());
     }
 
     void SceneRenderer::AddCamera(Camera* inCamera)
@@ -59,45 +104,341 @@ namespace Ming3D
         mRenderScene->mSceneObjects.push_back(inObject);
     }
 
+    void SceneRenderer::AddSceneLight(RenderSceneLight* inLight)
+    {
+        mRenderScene->mSceneLights.push_back(inLight);
+    }
+
+    void SceneRenderer::RemoveSceneLight(RenderSceneLight* inLight)
+    {
+        auto it = std::find(mRenderScene->mSceneLights.begin(), mRenderScene->mSceneLights.end(), inLight);
+        if (it != mRenderScene->mSceneLights.end())
+            mRenderScene->mSceneLights.erase(it);
+    }
+
     void SceneRenderer::RegisterMaterial(MaterialBuffer* inMat)
     {
-        // Set _Globals, if present (shaders need not use this)
-        if(inMat->mConstantBuffers.find("_Globals") != inMat->mConstantBuffers.end())
-            GGameEngine->GetRenderDevice()->BindConstantBuffer(mGlobalCBuffer, "_Globals", inMat->mShaderProgram);
+        for (const ConstantBufferInfo& constantBuffer : inMat->mParsedShaderProgram->mConstantBufferInfos)
+        {
+            // Set _Globals, if present (shaders need not use this)
+            if (constantBuffer.mName == "_Globals")
+            {
+                GGameEngine->GetRenderDevice()->BindConstantBuffer(mGlobalCBuffer, "_Globals", inMat->mShaderProgram.get());
+                if (inMat->mDepthOnlyShaderProgram != nullptr)
+                    GGameEngine->GetRenderDevice()->BindConstantBuffer(mGlobalCBuffer, "_Globals", inMat->mDepthOnlyShaderProgram.get());
+            }
+            else if (constantBuffer.mName == "_LightClusters")
+                GGameEngine->GetRenderDevice()->BindConstantBuffer(mLightClusterCBuffer, "_LightClusters", inMat->mShaderProgram.get());
+            else if (constantBuffer.mName == "_Shadows")
+                GGameEngine->GetRenderDevice()->BindConstantBuffer(mShadowCBuffer, "_Shadows", inMat->mShaderProgram.get());
+        }
+    }
+
+    void SceneRenderer::BindSceneTextures(MaterialBuffer* inMat)
+    {
+        RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
+        const std::vector<ShaderTextureInfo>& shaderTextures = inMat->mParsedShaderProgram->mShaderTextures;
+        for (size_t iTexture = 0; iTexture < shaderTextures.size(); iTexture++)
+        {
+            const std::string& textureName = shaderTextures[iTexture].mTextureName;
+            if (textureName == "_lightData")
+                renderDevice->SetTexture(mLightDataBuffer, iTexture);
+            else if (textureName == "_lightGrid")
+                renderDevice->SetTexture(mLightGridBuffer, iTexture);
+            else if (textureName == "_lightIndices")
+                renderDevice->SetTexture(mLightIndexBuffer, iTexture);
+            else if (textureName == "_shadowMatrices")
+                renderDevice->SetTexture(mShadowMatrixBuffer, iTexture);
+            else if (textureName == "_shadowMap" && mShadowMapTarget != nullptr)
+                renderDevice->SetTexture(mShadowMapTarget->GetDepthTextureBuffer(), iTexture);
+        }
+    }
+
+    void SceneRenderer::UploadTexelBuffer(TextureBuffer*& ioBuffer, size_t& ioCapacity, const std::vector<glm::vec4>& inData)
+    {
+        RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
+        if (inData.size() > ioCapacity)
+        {
+            delete ioBuffer;
+            ioCapacity = std::max(inData.size(), ioCapacity * 2);
+            ioBuffer = renderDevice->CreateTexelBuffer(ioCapacity);
+        }
+        if (inData.size() > 0)
+            renderDevice->UpdateTexelBuffer(ioBuffer, inData.data(), inData.size());
+    }
+
+    void SceneRenderer::SetMainLightDirection(const glm::vec3& inDirection)
+    {
+        mMainLightDirection = glm::normalize(inDirection);
+    }
+
+    float SceneRenderer::GetAspectRatio()
+    {
+        WindowBase* window = GGameEngine->GetMainWindow();
+        return (float)window->GetWidth() / (float)window->GetHeight();
+    }
+
+    void SceneRenderer::UpdateLightClusters(Camera* inCamera)
+    {
+        PROFILE_ZONE("UpdateLightClusters");
+        mLightClusterGrid.Build(mRenderScene->mSceneLights, inCamera, GetAspectRatio());
+
+        size_t gridCapacity = LightClusterGrid::NumClusters;
+        UploadTexelBuffer(mLightGridBuffer, gridCapacity, mLightClusterGrid.mClusterData);
+        UploadTexelBuffer(mLightDataBuffer, mLightDataCapacity, mLightClusterGrid.mLightData);
+        UploadTexelBuffer(mLightIndexBuffer, mLightIndexCapacity, mLightClusterGrid.mLightIndices);
+
+        cbDataLightClusters.SetData(mLightClusterGrid.mClusterParams, mLightClusterGrid.mGridSize);
+        GGameEngine->GetRenderDevice()->SetConstantBufferData(mLightClusterCBuffer, cbDataLightClusters.mDataPtr, cbDataLightClusters.mSize);
+    }
+
+    void SceneRenderer::UpdateShadowCascades(RenderPipelineParams& params)
+    {
+        PROFILE_ZONE("UpdateShadowCascades");
+        RenderDevice* renderDevice = GGameEngine->GetRenderDevice();
+        const ShadowSettings& settings = params.mShadowSettings;
+        const Camera* camera = params.mCamera;
+
+        const int numCascades = settings.mEnabled ? std::min(std::max(settings.mNumCascades, 1), (int)ShadowSettings::MaxCascades) : 0;
+        const unsigned int resolution = settings.GetCascadeResolution();
+        params.mNumShadowCascades = numCascades;
+
+        if (numCascades > 0 && (mShadowMapTarget == nullptr || mShadowMapResolution != resolution || mShadowMapLayers != numCascades))
+        {
+            if (mShadowMapTarget != nullptr)
+                delete mShadowMapTarget;
+
+            TextureInfo textureInfo;
+            textureInfo.mWidth = resolution;
+            textureInfo.mHeight = resolution;
+            mShadowMapTarget = renderDevice->CreateDepthRenderTarget(textureInfo, numCascades);
+            mShadowMapResolution = resolution;
+            mShadowMapLayers = numCascades;
+        }
+
+        const float nearPlane = camera->mNearPlane;
+        const float farPlane = std::min(camera->mFarPlane, settings.mMaxDistance);
+        const glm::mat4 invView = glm::inverse(camera->mCameraMatrix);
+        const float tanHalfFovY = std::tan(glm::radians(camera->mFieldOfView) * 0.5f);
+        const float tanHalfFovX = tanHalfFovY * GetAspectRatio();
+        const float cornerSlopeSqr = tanHalfFovX * tanHalfFovX + tanHalfFovY * tanHalfFovY;
+
+        // Light space rotation, used for snapping the cascades to whole texels
+        const glm::vec3 lightDir = mMainLightDirection;
+        const glm::vec3 lightUp = std::abs(lightDir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        const glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), lightDir, lightUp);
+        const glm::mat4 invLightRotation = glm::transpose(lightRotation);
+
+        // Light clip space to shadow map texture space ([-1, 1] to [0, 1])
+        const glm::mat4 textureBias = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+
+        glm::vec4 splitDepths(0.0f);
+        float splitNear = nearPlane;
+        for (int iCascade = 0; iCascade < numCascades; iCascade++)
+        {
+            ShadowCascade& cascade = params.mShadowCascades[iCascade];
+
+            // Blend between logarithmic and uniform split distribution
+            const float t = (float)(iCascade + 1) / (float)numCascades;
+            const float splitLog = nearPlane * std::pow(farPlane / nearPlane, t);
+            const float splitUniform = nearPlane + (farPlane - nearPlane) * t;
+            const float splitFar = settings.mSplitLambda * splitLog + (1.0f - settings.mSplitLambda) * splitUniform;
+
+            // Bounding sphere of the frustum slice. Unlike a tight box, its size doesn't change when the camera rotates.
+            const float centreDepth = std::min(0.5f * (splitNear + splitFar) * (1.0f + cornerSlopeSqr), splitFar);
+            const float farDist = splitFar - centreDepth;
+            const float nearDist = centreDepth - splitNear;
+            float radius = std::sqrt(std::max(cornerSlopeSqr * splitFar * splitFar + farDist * farDist, cornerSlopeSqr * splitNear * splitNear + nearDist * nearDist));
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+            const float texelSize = 2.0f * radius / (float)resolution;
+
+            // Move the cascade in whole texels only, to avoid shimmering edges when the camera moves
+            glm::vec4 lightSpaceCentre = lightRotation * (invView * glm::vec4(0.0f, 0.0f, -centreDepth, 1.0f));
+            lightSpaceCentre.x = std::floor(lightSpaceCentre.x / texelSize) * texelSize;
+            lightSpaceCentre.y = std::floor(lightSpaceCentre.y / texelSize) * texelSize;
+            const glm::vec3 centre = glm::vec3(invLightRotation * lightSpaceCentre);
+            const glm::mat4 lightView = glm::lookAt(centre, centre + lightDir, lightUp);
+
+            // Casters: objects inside the cascade, or between it and the light
+            Frustum casterFrustum;
+            casterFrustum.SetFromViewProjection(glm::ortho(-radius, radius, -radius, radius, -radius, radius) * lightView);
+            casterFrustum.DisablePlane(Frustum::Near);
+            cascade.mCasters.clear();
+            CullObjects(casterFrustum, lightView, cascade.mCasters);
+
+            // Pull the near plane in to the nearest caster
+            float nearDepth = -radius;
+            for (auto nodeIter = cascade.mCasters.begin(); nodeIter != cascade.mCasters.end(); nodeIter++)
+                nearDepth = std::min(nearDepth, (*nodeIter)->mViewDepth - std::max((*nodeIter)->mBoundsRadius, 0.0f));
+
+            RenderNodeSorter sorter;
+            std::sort(cascade.mCasters.begin(), cascade.mCasters.end(), sorter);
+
+            cascade.mLightViewProjection = glm::ortho(-radius, radius, -radius, radius, nearDepth, radius) * lightView;
+            cascade.mShadowMatrix = textureBias * cascade.mLightViewProjection * invView;
+            cascade.mSplitDepth = splitFar;
+            cascade.mTexelSize = texelSize;
+
+            // The shader only needs the first three rows (the projection is orthographic)
+            for (int iRow = 0; iRow < 3; iRow++)
+                mShadowMatrixData[iCascade * ShadowTexelsPerCascade + iRow] = glm::row(cascade.mShadowMatrix, iRow);
+            mShadowMatrixData[iCascade * ShadowTexelsPerCascade + 3] = glm::vec4(settings.mNormalOffset * texelSize, 0.0f, 0.0f, 0.0f);
+
+            splitDepths[iCascade] = splitFar;
+            splitNear = splitFar;
+        }
+
+        // Unused splits are set to the shadow distance, so the shader never selects their cascades.
+        // The last component is the shadow distance (0 if shadows are disabled).
+        for (int iSplit = std::max(numCascades, 1); iSplit < ShadowSettings::MaxCascades; iSplit++)
+            splitDepths[iSplit] = splitDepths[numCascades > 0 ? numCascades - 1 : 0];
+
+        renderDevice->UpdateTexelBuffer(mShadowMatrixBuffer, mShadowMatrixData.data(), mShadowMatrixData.size());
+
+        cbDataShadows.SetData(splitDepths, glm::vec4(settings.mDepthBias, 0.0f, 0.5f / (float)resolution, (float)numCascades));
+        renderDevice->SetConstantBufferData(mShadowCBuffer, cbDataShadows.mDataPtr, cbDataShadows.mSize);
     }
 
     void SceneRenderer::Render()
     {
+        PROFILE_ZONE("SceneRenderer::Render");
+        FrameTimings& frameTimings = GGameEngine->GetFrameTimings();
         for (Camera* camera : mCameras)
         {
             RenderPipelineParams* params = camera->mRenderPipelineParams;
             params->mCamera = camera;
             params->mNodes.clear();
 
-            CollectObjects(*params);
-            SortObjects(*params);
+            {
+                PROFILE_ZONE("CollectObjects");
+                ScopedFramePhaseTimer timer(frameTimings, EFramePhase::Cull);
+                CollectObjects(*params);
+            }
+            {
+                PROFILE_ZONE("SortObjects");
+                ScopedFramePhaseTimer timer(frameTimings, EFramePhase::Sort);
+                SortObjects(*params);
+            }
+
+            PROFILE_ZONE("SubmitCamera");
+            ScopedFramePhaseTimer timer(frameTimings, EFramePhase::Submit);
 
-            cbDataGlobal.SetData(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec4(0.8f, 0.8f, 0.8f, 1.0f), camera->mCameraMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 0.0f), GGameEngine->GetTime());
+            // Lighting is done in view space
+            const glm::vec3 lightDir = glm::vec3(camera->mCameraMatrix * glm::vec4(mMainLightDirection, 0.0f));
+            cbDataGlobal.SetData(lightDir, glm::vec4(0.8f, 0.8f, 0.8f, 1.0f), camera->mCameraMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 0.0f), GGameEngine->GetTime());
             GGameEngine->GetRenderDevice()->SetConstantBufferData(mGlobalCBuffer, cbDataGlobal.mDataPtr, cbDataGlobal.mSize);
 
+            UpdateLightClusters(camera);
+            UpdateShadowCascades(*params);
+
             mRenderPipeline->Render(*params);
         }
     }
 
-    void SceneRenderer::CollectObjects(RenderPipelineParams& params)
+    void SceneRenderer::CullObjects(const Frustum& inFrustum, const glm::mat4& inViewMatrix, RenderPipelineNodeCollection& outNodes)
     {
         for (RenderSceneObject* obj : mRenderScene->mSceneObjects)
         {
-            RenderPipelineNode* node = params.mNodes.push_back();
+            const MeshBuffer* mesh = obj->mMesh;
+            const glm::mat4& model = obj->mModelMatrix;
+            const glm::vec3 centre = glm::vec3(model * glm::vec4(mesh->mBoundsCentre, 1.0f));
+
+            float radius = -1.0f;
+            if (mesh->mBoundsRadius >= 0.0f)
+            {
+                const float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+                radius = mesh->mBoundsRadius * scale;
+                if (!inFrustum.IntersectsSphere(centre, radius))
+                    continue;
+            }
+
+            RenderPipelineNode* node = outNodes.push_back();
             node->mMaterial = obj->mMaterial;
             node->mMesh = obj->mMesh;
-            node->mModelMatrix = obj->mModelMatrix;
+            node->mIndexBuffer = mesh->GetIndexBuffer(obj->mLOD);
+            node->mModelMatrix = obj->mModelMatrix * mesh->mPositionDequantisation;
+            // Camera looks down negative Z, so distance along the view direction is -z
+            node->mViewDepth = -(inViewMatrix * glm::vec4(centre, 1.0f)).z;
+            node->mBoundsRadius = radius;
+        }
+    }
+
+    void SceneRenderer::SelectLODs(RenderPipelineParams& params)
+    {
+        const Camera* camera = params.mCamera;
+        const glm::mat4& viewMatrix = camera->mCameraMatrix;
+        const float tanHalfFovY = std::tan(glm::radians(camera->mFieldOfView) * 0.5f);
+        const float hysteresis = params.mLODHysteresis;
+
+        for (RenderSceneObject* obj : mRenderScene->mSceneObjects)
+        {
+            const MeshBuffer* mesh = obj->mMesh;
+            const int numLODs = (int)mesh->mLODs.size();
+            if (numLODs == 0 || mesh->mBoundsRadius < 0.0f)
+            {
+                obj->mLOD = 0;
+                continue;
+            }
+
+            // Projected bounding sphere diameter, relative to the screen height
+            const glm::mat4& model = obj->mModelMatrix;
+            const float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+            const float radius = mesh->mBoundsRadius * scale;
+            const glm::vec3 viewCentre = glm::vec3(viewMatrix * model * glm::vec4(mesh->mBoundsCentre, 1.0f));
+            const float distance = std::max(glm::length(viewCentre), camera->mNearPlane);
+            const float screenSize = radius / (distance * tanHalfFovY);
+
+            // LOD n is used below mLODs[n - 1].mScreenSize. Switch only once past the margin, in either direction.
+            int lod = std::min(obj->mLOD, numLODs);
+            while (lod > 0 && screenSize > mesh->mLODs[lod - 1].mScreenSize * (1.0f + hysteresis))
+                lod--;
+            while (lod < numLODs && screenSize < mesh->mLODs[lod].mScreenSize * (1.0f - hysteresis))
+                lod++;
+            obj->mLOD = lod;
+        }
+    }
+
+    void SceneRenderer::CollectObjects(RenderPipelineParams& params)
+    {
+        SelectLODs(params);
+
+        const glm::mat4& viewMatrix = params.mCamera->mCameraMatrix;
+
+        Frustum frustum;
+        frustum.SetFromViewProjection(params.mCamera->GetProjectionMatrix(GetAspectRatio()) * viewMatrix);
+        CullObjects(frustum, viewMatrix, params.mNodes);
+
+        RequestTextureMips(params);
+    }
+
+    void SceneRenderer::RequestTextureMips(RenderPipelineParams& params)
+    {
+        TextureStreamer* textureStreamer = GGameEngine->GetTextureStreamer();
+        const Camera* camera = params.mCamera;
+        const float tanHalfFovY = std::tan(glm::radians(camera->mFieldOfView) * 0.5f);
+        const float screenHeight = (float)GGameEngine->GetMainWindow()->GetHeight();
+
+        for (RenderPipelineNode* node : params.mNodes)
+        {
+            // Projected bounding sphere diameter, in pixels. Objects without bounds are treated as screen sized.
+            float screenPixels = screenHeight;
+            if (node->mBoundsRadius >= 0.0f)
+                screenPixels = node->mBoundsRadius / (std::max(node->mViewDepth, camera->mNearPlane) * tanHalfFovY) * screenHeight;
+            textureStreamer->RequestMaterialMips(node->mMaterial, screenPixels);
         }
     }
 
     void SceneRenderer::SortObjects(RenderPipelineParams& params)
     {
-        RenderNodeSorter sorter;
-        std::sort(params.mNodes.begin(), params.mNodes.end(), sorter);
+        if (params.mSortMode == ERenderNodeSortMode::FrontToBack)
+        {
+            RenderNodeFrontToBackSorter sorter;
+            std::sort(params.mNodes.begin(), params.mNodes.end(), sorter);
+        }
+        else
+        {
+            RenderNodeSorter sorter;
+            std::sort(params.mNodes.begin(), params.mNodes.end(), sorter);
+        }
     }
 }
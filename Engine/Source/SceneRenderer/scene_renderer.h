@@ -5,10 +5,14 @@
 #include "camera.h"
 #include <list>
 #include "render_pipeline.h"
+#include "light_cluster_grid.h"
+#include "frustum.h"
 
 namespace Ming3D
 {
     class ConstantBuffer;
+    class TextureBuffer;
+    class RenderTarget;
 
     class SceneRenderer
     {
@@ -18,7 +22,29 @@ namespace Ming3D
         RenderPipeline* mRenderPipeline;
         ConstantBuffer* mGlobalCBuffer;
 
+        // Clustered lighting
+        LightClusterGrid mLightClusterGrid;
+        ConstantBuffer* mLightClusterCBuffer;
+        TextureBuffer* mLightDataBuffer = nullptr;
+        TextureBuffer* mLightGridBuffer = nullptr;
+        TextureBuffer* mLightIndexBuffer = nullptr;
+        size_t mLightDataCapacity = 0;
+        size_t mLightIndexCapacity = 0;
+
+        // Cascaded shadow maps (main light)
+        glm::vec3 mMainLightDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+        RenderTarget* mShadowMapTarget = nullptr;
+        unsigned int mShadowMapResolution = 0;
+        int mShadowMapLayers = 0;
+        ConstantBuffer* mShadowCBuffer;
+        TextureBuffer* mShadowMatrixBuffer = nullptr;
+        std::vector<glm::vec4> mShadowMatrixData;
+
         void UpdateUniforms(MaterialBuffer* inMat);
+        void UpdateLightClusters(Camera* inCamera);
+        void UpdateShadowCascades(RenderPipelineParams& params);
+        void UploadTexelBuffer(TextureBuffer*& ioBuffer, size_t& ioCapacity, const std::vector<glm::vec4>& inData);
+        float GetAspectRatio();
 
     public:
         SceneRenderer();
@@ -28,10 +54,23 @@ namespace Ming3D
 
         void AddCamera(Camera* inCamera);
         void RemoveCamera(Camera* inCamera);
+        const std::list<Camera*>& GetCameras() const { return mCameras; }
         void AddSceneObject(RenderSceneObject* inObject);
+        void AddSceneLight(RenderSceneLight* inLight);
+        void RemoveSceneLight(RenderSceneLight* inLight);
         void RegisterMaterial(MaterialBuffer* inMat);
+        /** Binds the renderer-owned textures (light clusters, shadow maps) to the texture slots the material's shader declares for them. */
+        void BindSceneTextures(MaterialBuffer* inMat);
+        void SetMainLightDirection(const glm::vec3& inDirection);
+        RenderTarget* GetShadowMapTarget() { return mShadowMapTarget; }
 
         void Render();
+        /** Adds the scene objects that intersect inFrustum to outNodes. View depth is measured along -Z of inViewMatrix. */
+        void CullObjects(const Frustum& inFrustum, const glm::mat4& inViewMatrix, RenderPipelineNodeCollection& outNodes);
+        /** Selects the level of detail of each scene object, from its projected size (with hysteresis). */
+        void SelectLODs(RenderPipelineParams& params);
+        /** Reports the on-screen size of the collected objects' materials to the texture streamer. */
+        void RequestTextureMips(RenderPipelineParams& params);
         void CollectObjects(RenderPipelineParams& params);
         void SortObjects(RenderPipelineParams& params);
         void RenderCameras();
@@ -0,0 +1,66 @@
+#ifndef MING3D_FRAMETIMINGS_H
+#define MING3D_FRAMETIMINGS_H
+
+#include <chrono>
+
+namespace Ming3D
+{
+    /** Phases of GameEngine::Update that are timed every frame. */
+    enum class EFramePhase
+    {
+        Tick,       // actor and component ticks
+        Physics,
+        Network,
+        Assets,     // asset loading callbacks and texture streaming
+        Cull,       // LOD selection, frustum culling and texture mip requests
+        Sort,
+        Submit,     // constant buffer/light updates and render pipeline (draw calls)
+        NumPhases
+    };
+
+    inline const char* GetFramePhaseName(EFramePhase inPhase)
+    {
+        static const char* phaseNames[] = { "tick", "physics", "network", "assets", "cull", "sort", "submit" };
+        static_assert(sizeof(phaseNames) / sizeof(phaseNames[0]) == (size_t)EFramePhase::NumPhases, "Missing phase names");
+        return phaseNames[(size_t)inPhase];
+    }
+
+    /** Time spent in each phase of the last frame (see GameEngine::GetFrameTimings). */
+    class FrameTimings
+    {
+    private:
+        double mPhaseSeconds[(size_t)EFramePhase::NumPhases] = {};
+
+    public:
+        void Reset()
+        {
+            for (double& seconds : mPhaseSeconds)
+                seconds = 0.0;
+        }
+
+        void AddTime(EFramePhase inPhase, double inSeconds) { mPhaseSeconds[(size_t)inPhase] += inSeconds; }
+        double GetTime(EFramePhase inPhase) const { return mPhaseSeconds[(size_t)inPhase]; }
+    };
+
+    /** Adds the time from construction to destruction to a phase of a FrameTimings. */
+    class ScopedFramePhaseTimer
+    {
+    private:
+        FrameTimings& mTimings;
+        EFramePhase mPhase;
+        std::chrono::steady_clock::time_point mStartTime;
+
+    public:
+        ScopedFramePhaseTimer(FrameTimings& inTimings, EFramePhase inPhase)
+            : mTimings(inTimings), mPhase(inPhase), mStartTime(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~ScopedFramePhaseTimer()
+        {
+            mTimings.AddTime(mPhase, std::chrono::duration<double>(std::chrono::steady_clock::now() - mStartTime).count());
+        }
+    };
+}
+
+#endif
@@ -1,179 +1,166 @@
 #ifndef MING3D_CONSTANTBUFFERDATA_H
 #define MING3D_CONSTANTBUFFERDATA_H
 
-#include <vector>
-#include <string>
-#include <cstdio>
-#include <glm/glm.hpp>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
 #include <type_traits>
+#include <utility>
+#include <glm/glm.hpp>
 
 namespace Ming3D
 {
-    class ConstantBufferDataBase
+    /** Size and base alignment of a constant buffer element type. */
+    template <typename T>
+    struct ConstantBufferElementInfo;
+
+    template <>
+    struct ConstantBufferElementInfo<float>
     {
-public:
-        virtual ~ConstantBufferDataBase() {}
+        static constexpr size_t Size = sizeof(float);
+        static constexpr size_t Std140Alignment = 4;
+    };
 
-        void* mDataPtr;
-        size_t mSize;
+    template <>
+    struct ConstantBufferElementInfo<glm::vec2>
+    {
+        static constexpr size_t Size = sizeof(glm::vec2);
+        static constexpr size_t Std140Alignment = 8;
     };
 
-    template <typename... Types>
-    class ConstantBufferDataGL : public ConstantBufferDataBase
+    template <>
+    struct ConstantBufferElementInfo<glm::vec3>
     {
-    private:
-        size_t mPos = 0;
+        static constexpr size_t Size = sizeof(glm::vec3);
+        static constexpr size_t Std140Alignment = 16;
+    };
 
-    public:
-        std::vector<char> mData; // TODO: calculate size at compile time, and use array of fixed size
+    template <>
+    struct ConstantBufferElementInfo<glm::vec4>
+    {
+        static constexpr size_t Size = sizeof(glm::vec4);
+        static constexpr size_t Std140Alignment = 16;
+    };
 
-        ConstantBufferDataGL() {}
-        virtual ~ConstantBufferDataGL() {}
+    template <>
+    struct ConstantBufferElementInfo<glm::mat4>
+    {
+        static constexpr size_t Size = sizeof(glm::mat4);
+        static constexpr size_t Std140Alignment = 16;
+    };
 
-    private:
-        template <typename T, std::enable_if_t<std::is_same<T, float>::value, int> = 0>
-        void SetElement(T elem)
-        {
-            const size_t size = sizeof(float);
-            mData.resize(mPos + size);
-            memcpy(&mData[mPos], &elem, size);
-            mPos += size;
-        }
+    constexpr size_t AlignConstantBufferOffset(size_t inOffset, size_t inAlignment)
+    {
+        return (inOffset + inAlignment - 1) / inAlignment * inAlignment;
+    }
 
-        template <typename T, std::enable_if_t<std::is_same<T, glm::vec2>::value, int> = 0>
-        void SetElement(T elem)
+    /** GLSL uniform block packing (layout(std140)). */
+    struct ConstantBufferPackingStd140
+    {
+        template <typename T>
+        static constexpr size_t GetElementOffset(size_t inOffset)
         {
-            const size_t size = sizeof(glm::vec2);
-            mPos += (8 - (mPos % 8)) % 8;
-            mData.resize(mPos + size);
-            memcpy(&mData[mPos], &elem, size);
-            mPos += size;
+            return AlignConstantBufferOffset(inOffset, ConstantBufferElementInfo<T>::Std140Alignment);
         }
+    };
 
-        template <typename T, std::enable_if_t<std::is_same<T, glm::vec3>::value, int> = 0>
-        void SetElement(T elem)
+    /** HLSL cbuffer packing: elements are 4 byte aligned, and may not cross a 16 byte register (matrices start a new register). */
+    struct ConstantBufferPackingHLSL
+    {
+        template <typename T>
+        static constexpr size_t GetElementOffset(size_t inOffset)
         {
-            const size_t size = sizeof(glm::vec3);
-            mPos += (16 - (mPos % 16)) % 16;
-            mData.resize(mPos + size);
-            memcpy(&mData[mPos], &elem, size);
-            mPos += size;
+            return (ConstantBufferElementInfo<T>::Size > 16 || AlignConstantBufferOffset(inOffset, 4) % 16 + ConstantBufferElementInfo<T>::Size > 16)
+                ? AlignConstantBufferOffset(inOffset, 16) : AlignConstantBufferOffset(inOffset, 4);
         }
+    };
 
-        template <typename T, std::enable_if_t<std::is_same<T, glm::vec4>::value, int> = 0>
-        void SetElement(T elem)
-        {
-            const size_t size = sizeof(glm::vec4);
-            mPos += (16 - (mPos % 16)) % 16;
-            mData.resize(mPos + size);
-            memcpy(&mData[mPos], &elem, size);
-            mPos += size;
-        }
+    /** Offsets and size of the elements of a constant buffer, computed at compile time. The size is padded to 16 bytes. */
+    template <typename Packing, size_t Offset, typename... Types>
+    struct ConstantBufferLayout
+    {
+        static constexpr size_t EndOffset = Offset;
+        static constexpr size_t Size = AlignConstantBufferOffset(Offset, 16);
 
-        template <typename T, std::enable_if_t<std::is_same<T, glm::mat4>::value, int> = 0>
-        void SetElement(T elem)
+        static constexpr size_t GetOffset(size_t)
         {
-            const size_t size = sizeof(glm::mat4);
-            mPos += (16 - (mPos % 16) % 16);
-            mData.resize(mPos + size);
-            memcpy(&mData[mPos], &elem, size);
-            mPos += size;
+            return Offset;
         }
+    };
 
-    public:
-        void SetData(Types... elements)
+    template <typename Packing, size_t Offset, typename T, typename... Types>
+    struct ConstantBufferLayout<Packing, Offset, T, Types...>
+    {
+        static constexpr size_t ElementOffset = Packing::template GetElementOffset<T>(Offset);
+        using NextElements = ConstantBufferLayout<Packing, ElementOffset + ConstantBufferElementInfo<T>::Size, Types...>;
+
+        static constexpr size_t EndOffset = NextElements::EndOffset;
+        static constexpr size_t Size = NextElements::Size;
+
+        /** Offset of the element at index inIndex. */
+        static constexpr size_t GetOffset(size_t inIndex)
         {
-            mPos = 0;
-#if __cplusplus >= 201703L
-            (SetElement(elements), ...);
-#else
-            std::initializer_list<int>{((void)SetElement(std::forward<Types>(elements)), 0)...};
-#endif
-            mDataPtr = &mData[0];
-            mSize = mPos;
+            return inIndex == 0 ? ElementOffset : NextElements::GetOffset(inIndex - 1);
         }
     };
 
-    template <typename... Types>
-    class ConstantBufferDataD3D11 : public ConstantBufferDataBase
+    class ConstantBufferDataBase
     {
-    private:
-        size_t mPos = 0;
+public:
+        virtual ~ConstantBufferDataBase() {}
+
+        void* mDataPtr;
+        size_t mSize;
+    };
 
+    template <typename Packing, typename... Types>
+    class ConstantBufferDataPacked : public ConstantBufferDataBase
+    {
     public:
-        std::vector<char> mData; // TODO: calculate size at compile time, and use array of fixed size
+        using Layout = ConstantBufferLayout<Packing, 0, Types...>;
 
-        ConstantBufferDataD3D11() {}
-        virtual ~ConstantBufferDataD3D11() {}
+        std::array<char, Layout::Size> mData = {};
 
-    private:
-        template <typename T, std::enable_if_t<std::is_same<T, float>::value, int> = 0>
-        void SetElement(T elem)
+        ConstantBufferDataPacked()
         {
-            const size_t size = sizeof(float);
-            mData.resize(mPos + size);
-            memcpy(&mData[mPos], &elem, size);
-            mPos += size;
+            mDataPtr = mData.data();
+            mSize = Layout::Size;
         }
 
-        template <typename T, std::enable_if_t<std::is_same<T, glm::vec2>::value, int> = 0>
-        void SetElement(T elem)
+        ConstantBufferDataPacked(const ConstantBufferDataPacked& inOther) : mData(inOther.mData)
         {
-            const size_t size = sizeof(glm::vec2);
-            mPos += (16 - (mPos % 16)) % 16;
-            mData.resize(mPos + size);
-            memcpy(&mData[mPos], &elem, size);
-            mPos += size;
+            mDataPtr = mData.data();
+            mSize = Layout::Size;
         }
 
-        template <typename T, std::enable_if_t<std::is_same<T, glm::vec3>::value, int> = 0>
-        void SetElement(T elem)
+        ConstantBufferDataPacked& operator=(const ConstantBufferDataPacked& inOther)
         {
-            const size_t size = sizeof(glm::vec3);
-            mPos += (16 - (mPos % 16)) % 16;
-            mData.resize(mPos + size);
-            memcpy(&mData[mPos], &elem, size);
-            mPos += size;
+            mData = inOther.mData;
+            return *this;
         }
 
-        template <typename T, std::enable_if_t<std::is_same<T, glm::vec4>::value, int> = 0>
-        void SetElement(T elem)
-        {
-            const size_t size = sizeof(glm::vec4);
-            mPos += (16 - (mPos % 16)) % 16;
-            mData.resize(mPos + size);
-            memcpy(&mData[mPos], &elem, size);
-            mPos += size;
-        }
+        virtual ~ConstantBufferDataPacked() {}
 
-        template <typename T, std::enable_if_t<std::is_same<T, glm::mat4>::value, int> = 0>
-        void SetElement(T elem)
+    private:
+        template <size_t... Indices>
+        void SetElements(std::index_sequence<Indices...>, const Types&... elements)
         {
-            const size_t size = sizeof(glm::mat4);
-            mPos += (16 - (mPos % 16) % 16);
-            mData.resize(mPos + size);
-            memcpy(&mData[mPos], &elem, size);
-            mPos += size;
+            std::initializer_list<int>{ ((void)memcpy(&mData[std::integral_constant<size_t, Layout::GetOffset(Indices)>::value], &elements, ConstantBufferElementInfo<Types>::Size), 0)... };
         }
 
     public:
-        void SetData(Types... elements)
+        void SetData(const Types&... elements)
         {
-            mPos = 0;
-#if __cplusplus >= 201703L
-            (SetElement(elements), ...);
-#else
-            std::initializer_list<int>{((void)SetElement(std::forward<Types>(elements)), 0)...};
-#endif
+            SetElements(std::index_sequence_for<Types...>(), elements...);
+        }
+    };
 
-            // Add final padding (must be multiple of 16)
-            mPos += (16 - (mPos % 16) % 16);
-            mData.resize(mPos);
+    template <typename... Types>
+    using ConstantBufferDataGL = ConstantBufferDataPacked<ConstantBufferPackingStd140, Types...>;
 
-            mDataPtr = &mData[0];
-            mSize = mPos;
-        }
-};
+    template <typename... Types>
+    using ConstantBufferDataD3D11 = ConstantBufferDataPacked<ConstantBufferPackingHLSL, Types...>;
 
     template <typename... Types>
     class ConstantBufferData
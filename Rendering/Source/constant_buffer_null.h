@@ -0,0 +1,16 @@
+#ifndef MING3D_CONSTANT_BUFFER_NULL_H
+#define MING3D_CONSTANT_BUFFER_NULL_H
+
+#include "constant_buffer.h"
+#include <cstddef>
+
+namespace Ming3D
+{
+    class ConstantBufferNull : public ConstantBuffer
+    {
+    public:
+        size_t mSize = 0;
+    };
+}
+
+#endif
@@ -11,11 +11,14 @@ namespace Ming3D
     struct DepthStencilStateDesc
     {
         bool mDepthEnabled = true;
+        bool mDepthWriteEnabled = true;
         DepthStencilDepthFunc mDepthFunc = DepthStencilDepthFunc::LEqual;
     };
 
     class DepthStencilState
     {
+    public:
+        virtual ~DepthStencilState() = default;
     };
 }
 
@@ -11,8 +11,15 @@ namespace Ming3D
     {
         friend class RenderDeviceD3D11;
     private:
-        ID3D11DepthStencilState* mDepthStencilState;
+        ID3D11DepthStencilState* mDepthStencilState = nullptr;
         D3D11_DEPTH_STENCIL_DESC mDepthStencilStateDesc;
+
+    public:
+        virtual ~DepthStencilStateD3D11()
+        {
+            if (mDepthStencilState != nullptr)
+                mDepthStencilState->Release();
+        }
     };
 }
 
@@ -10,6 +10,8 @@ namespace Ming3D
     {
     public:
         GLenum mDepthFunc = GL_LESS;
+        bool mDepthEnabled = true;
+        GLboolean mDepthWriteEnabled = GL_TRUE;
     };
 }
 
@@ -6,7 +6,8 @@ namespace Ming3D
     DepthStencilViewD3D11::~DepthStencilViewD3D11()
     {
         delete(mDepthStencilTexture);
-        mDepthStencilView->Release();
+        if (mDepthStencilView != nullptr)
+            mDepthStencilView->Release();
     }
 }
 #endif
@@ -11,8 +11,8 @@ namespace Ming3D
     public:
         ~DepthStencilViewD3D11();
 
-        TextureBufferD3D11* mDepthStencilTexture;
-        ID3D11DepthStencilView* mDepthStencilView;
+        TextureBufferD3D11* mDepthStencilTexture = nullptr;
+        ID3D11DepthStencilView* mDepthStencilView = nullptr;
     };
 }
 
@@ -1,8 +1,36 @@
 #include "graphics_data.h"
+#include "glm/gtc/packing.hpp"
+#include "glm/gtc/matrix_transform.hpp"
 #include <cstring>
+#include <cstdint>
 
 namespace Ming3D
 {
+    size_t VertexLayout::GetVertexSize() const
+    {
+        size_t vertexSize = 0;
+        for (size_t iComp = 0; iComp < VertexComponents.size(); iComp++)
+            vertexSize += VertexData::GetVertexComponentSize(VertexComponents[iComp], GetComponentFormat(iComp));
+        return vertexSize;
+    }
+
+    size_t VertexLayout::GetComponentOffset(EVertexComponent inComponent) const
+    {
+        size_t offset = 0;
+        for (size_t iComp = 0; iComp < VertexComponents.size(); iComp++)
+        {
+            if (VertexComponents[iComp] == inComponent)
+                return offset;
+            offset += VertexData::GetVertexComponentSize(VertexComponents[iComp], GetComponentFormat(iComp));
+        }
+        return -1;
+    }
+
+    glm::mat4 VertexLayout::GetPositionDequantisationMatrix() const
+    {
+        return glm::translate(glm::mat4(1.0f), PositionOffset) * glm::scale(glm::mat4(1.0f), glm::vec3(PositionScale));
+    }
+
     VertexData::VertexData()
     {
 
@@ -11,17 +39,15 @@ namespace Ming3D
     VertexData::VertexData(std::vector<EVertexComponent> inComponents, size_t inNumVertices)
     {
         mVertexLayout.VertexComponents = inComponents;
-        mVertexSize = 0;
-        for (const EVertexComponent& comp : mVertexLayout.VertexComponents)
-        {
-            mVertexSize += GetVertexComponentSize(comp);
-        }
+        mVertexSize = mVertexLayout.GetVertexSize();
         mData.resize(inNumVertices * mVertexSize);
     }
 
     VertexData::VertexData(VertexLayout inLayout, size_t inNumVertices)
-        : VertexData(inLayout.VertexComponents, inNumVertices)
     {
+        mVertexLayout = inLayout;
+        mVertexSize = mVertexLayout.GetVertexSize();
+        mData.resize(inNumVertices * mVertexSize);
     }
 
     VertexData::VertexData(const VertexData& other)
@@ -34,29 +60,20 @@ namespace Ming3D
 
     size_t VertexData::GetComponentOffset(EVertexComponent inComponent)
     {
-        size_t offset = 0;
-        for (const EVertexComponent& comp : mVertexLayout.VertexComponents)
-        {
-            if (comp == inComponent)
-            {
-                return offset;
-            }
-            else
-                offset += GetVertexComponentSize(comp);
-        }
-        return -1;
+        return mVertexLayout.GetComponentOffset(inComponent);
     }
 
     void VertexData::GetComponentOffsets(EVertexComponent inComponent, std::vector<size_t>& outOffsets)
     {
         size_t offset = 0;
-        for (const EVertexComponent& comp : mVertexLayout.VertexComponents)
+        for (size_t iComp = 0; iComp < mVertexLayout.VertexComponents.size(); iComp++)
         {
+            const EVertexComponent comp = mVertexLayout.VertexComponents[iComp];
             if (comp == inComponent)
             {
                 outOffsets.push_back(offset);
             }
-            offset += GetVertexComponentSize(comp);
+            offset += GetVertexComponentSize(comp, mVertexLayout.GetComponentFormat(iComp));
         }
     }
 
@@ -70,24 +87,132 @@ namespace Ming3D
         return mVertexSize;
     }
 
-    size_t VertexData::GetVertexComponentSize(EVertexComponent inComp)
+    glm::vec4 VertexData::GetComponentValue(size_t inVertex, EVertexComponent inComp)
     {
+        glm::vec4 value(0.0f, 0.0f, 0.0f, 1.0f);
+
+        size_t offset = 0;
+        size_t iComp = 0;
+        for (; iComp < mVertexLayout.VertexComponents.size() && mVertexLayout.VertexComponents[iComp] != inComp; iComp++)
+            offset += GetVertexComponentSize(mVertexLayout.VertexComponents[iComp], mVertexLayout.GetComponentFormat(iComp));
+        if (iComp == mVertexLayout.VertexComponents.size())
+            return value;
+
+        const EVertexComponentFormat format = mVertexLayout.GetComponentFormat(iComp);
+        const size_t numElements = GetVertexComponentElementCount(inComp, format);
+        const char* compData = mData.data() + inVertex * mVertexSize + offset;
+        for (size_t iElem = 0; iElem < numElements; iElem++)
+        {
+            switch (format)
+            {
+            case EVertexComponentFormat::Float:
+                memcpy(&value[iElem], compData + iElem * sizeof(float), sizeof(float));
+                break;
+            case EVertexComponentFormat::Half:
+            {
+                uint16_t half;
+                memcpy(&half, compData + iElem * sizeof(uint16_t), sizeof(uint16_t));
+                value[iElem] = glm::unpackHalf1x16(half);
+                break;
+            }
+            case EVertexComponentFormat::SNorm16:
+            {
+                uint16_t snorm;
+                memcpy(&snorm, compData + iElem * sizeof(uint16_t), sizeof(uint16_t));
+                value[iElem] = glm::unpackSnorm1x16(snorm);
+                break;
+            }
+            case EVertexComponentFormat::SNorm8:
+                value[iElem] = glm::unpackSnorm1x8((uint8_t)compData[iElem]);
+                break;
+            }
+        }
+
+        if (inComp == EVertexComponent::Position)
+            value = glm::vec4(glm::vec3(value) * mVertexLayout.PositionScale + mVertexLayout.PositionOffset, 1.0f);
+        return value;
+    }
+
+    void VertexData::SetComponentValue(size_t inVertex, EVertexComponent inComp, const glm::vec4& inValue)
+    {
+        size_t offset = 0;
+        size_t iComp = 0;
+        for (; iComp < mVertexLayout.VertexComponents.size() && mVertexLayout.VertexComponents[iComp] != inComp; iComp++)
+            offset += GetVertexComponentSize(mVertexLayout.VertexComponents[iComp], mVertexLayout.GetComponentFormat(iComp));
+        if (iComp == mVertexLayout.VertexComponents.size())
+            return;
+
+        glm::vec4 value = inValue;
+        if (inComp == EVertexComponent::Position)
+            value = glm::vec4((glm::vec3(inValue) - mVertexLayout.PositionOffset) / mVertexLayout.PositionScale, 1.0f);
+
+        const EVertexComponentFormat format = mVertexLayout.GetComponentFormat(iComp);
+        const size_t numElements = GetVertexComponentElementCount(inComp, format);
+        char* compData = mData.data() + inVertex * mVertexSize + offset;
+        for (size_t iElem = 0; iElem < numElements; iElem++)
+        {
+            switch (format)
+            {
+            case EVertexComponentFormat::Float:
+                memcpy(compData + iElem * sizeof(float), &value[iElem], sizeof(float));
+                break;
+            case EVertexComponentFormat::Half:
+            {
+                const uint16_t half = glm::packHalf1x16(value[iElem]);
+                memcpy(compData + iElem * sizeof(uint16_t), &half, sizeof(uint16_t));
+                break;
+            }
+            case EVertexComponentFormat::SNorm16:
+            {
+                const uint16_t snorm = glm::packSnorm1x16(value[iElem]);
+                memcpy(compData + iElem * sizeof(uint16_t), &snorm, sizeof(uint16_t));
+                break;
+            }
+            case EVertexComponentFormat::SNorm8:
+                compData[iElem] = (char)glm::packSnorm1x8(value[iElem]);
+                break;
+            }
+        }
+    }
+
+    size_t VertexData::GetVertexComponentSize(EVertexComponent inComp, EVertexComponentFormat inFormat)
+    {
+        const size_t numElements = GetVertexComponentElementCount(inComp, inFormat);
+        switch (inFormat)
+        {
+        case EVertexComponentFormat::Float:
+            return sizeof(float) * numElements;
+        case EVertexComponentFormat::Half:
+        case EVertexComponentFormat::SNorm16:
+            return sizeof(uint16_t) * numElements;
+        case EVertexComponentFormat::SNorm8:
+            return sizeof(uint8_t) * numElements;
+        }
+        return 0;
+    }
+
+    size_t VertexData::GetVertexComponentElementCount(EVertexComponent inComp, EVertexComponentFormat inFormat)
+    {
+        size_t numElements = 0;
         switch (inComp)
         {
         case EVertexComponent::Position:
-            return sizeof(float) * 3;
+            numElements = 3;
             break;
         case EVertexComponent::Normal:
-            return sizeof(float) * 3;
+            numElements = 3;
             break;
         case EVertexComponent::TexCoord:
-            return sizeof(float) * 2;
+            numElements = 2;
             break;
         case EVertexComponent::Colour:
-            return sizeof(float) * 4;
+            numElements = 4;
             break;
         }
-        return 0;
+        // There are no 3 element formats for 8/16 bit data
+        if (inFormat != EVertexComponentFormat::Float && numElements == 3)
+            numElements = 4;
+        return numElements;
     }
 
 
@@ -100,4 +225,21 @@ namespace Ming3D
     {
         return mData.size();
     }
+
+    bool IndexData::UseShortIndices()
+    {
+        for (unsigned int index : mData)
+        {
+            if (index > 0xFFFF)
+                return false;
+        }
+        return true;
+    }
+
+    void IndexData::GetShortIndices(std::vector<unsigned short>& outIndices)
+    {
+        outIndices.resize(mData.size());
+        for (size_t iIndex = 0; iIndex < mData.size(); iIndex++)
+            outIndices[iIndex] = (unsigned short)mData[iIndex];
+    }
 }
@@ -11,4 +11,14 @@ namespace Ming3D
     {
         return mNumIndices;
     }
+
+    void IndexBuffer::SetShortIndices(bool inShortIndices)
+    {
+        mShortIndices = inShortIndices;
+    }
+
+    bool IndexBuffer::HasShortIndices()
+    {
+        return mShortIndices;
+    }
 }
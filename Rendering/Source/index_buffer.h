@@ -11,12 +11,15 @@ namespace Ming3D
     class IndexBuffer
     {
     private:
-        unsigned int mNumIndices;
+        unsigned int mNumIndices = 0;
+        bool mShortIndices = false; // 16 bit indices
 
     public:
         virtual ~IndexBuffer() = default;
         void SetNumIndices(unsigned int inNumIndices);
         unsigned int GetNumIndices();
+        void SetShortIndices(bool inShortIndices);
+        bool HasShortIndices();
     };
 }
 
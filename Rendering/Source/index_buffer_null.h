@@ -0,0 +1,18 @@
+#ifndef MING3D_INDEX_BUFFER_NULL_H
+#define MING3D_INDEX_BUFFER_NULL_H
+
+#include "index_buffer.h"
+#include "render_device_null_stats.h"
+
+namespace Ming3D
+{
+    class IndexBufferNull : public IndexBuffer
+    {
+    public:
+        NullResourceMemory mMemory;
+
+        IndexBufferNull(RenderDeviceNullStats* inStats, size_t inSize) : mMemory(&inStats->mBufferMemory, inSize) {}
+    };
+}
+
+#endif
@@ -0,0 +1,163 @@
+#include "pixel_conversion.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MING3D_PIXELCONVERSION_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(MING3D_PIXELCONVERSION_SSE2) && (defined(__SSSE3__) || defined(__AVX__))
+#define MING3D_PIXELCONVERSION_SSSE3
+#include <tmmintrin.h>
+#endif
+
+namespace Ming3D
+{
+    namespace
+    {
+        /** x * a / 255, rounded. Exact for all 8 bit inputs. */
+        inline uint8_t MultiplyAlpha(unsigned int inValue, unsigned int inAlpha)
+        {
+            const unsigned int t = inValue * inAlpha + 128;
+            return (uint8_t)((t + (t >> 8)) >> 8);
+        }
+
+        void ConvertPixelsScalar(const uint8_t* inSrc, unsigned int inSrcBytesPerPixel, uint8_t* outDst, size_t inNumPixels, int inFlags)
+        {
+            const unsigned int r = (inFlags & PIXELCONVERSION_SWAP_RED_BLUE) ? 2 : 0;
+            const unsigned int b = 2 - r;
+            const bool opaque = inSrcBytesPerPixel == 3 || (inFlags & PIXELCONVERSION_FORCE_OPAQUE);
+            const bool premultiply = !opaque && (inFlags & PIXELCONVERSION_PREMULTIPLY_ALPHA);
+            for (size_t iPixel = 0; iPixel < inNumPixels; iPixel++)
+            {
+                const uint8_t* src = inSrc + iPixel * inSrcBytesPerPixel;
+                uint8_t* dst = outDst + iPixel * 4;
+                const uint8_t alpha = opaque ? 255 : src[3];
+                if (premultiply)
+                {
+                    dst[0] = MultiplyAlpha(src[r], alpha);
+                    dst[1] = MultiplyAlpha(src[1], alpha);
+                    dst[2] = MultiplyAlpha(src[b], alpha);
+                }
+                else
+                {
+                    dst[0] = src[r];
+                    dst[1] = src[1];
+                    dst[2] = src[b];
+                }
+                dst[3] = alpha;
+            }
+        }
+
+#ifdef MING3D_PIXELCONVERSION_SSE2
+        /** Swaps byte 0 and 2 of each 32 bit pixel. */
+        inline __m128i SwapRedBlue(__m128i inPixels)
+        {
+            const __m128i greenAlphaMask = _mm_set1_epi32((int)0xFF00FF00);
+            const __m128i lowMask = _mm_set1_epi32(0xFF);
+            const __m128i greenAlpha = _mm_and_si128(inPixels, greenAlphaMask);
+            const __m128i red = _mm_slli_epi32(_mm_and_si128(inPixels, lowMask), 16);
+            const __m128i blue = _mm_and_si128(_mm_srli_epi32(inPixels, 16), lowMask);
+            return _mm_or_si128(greenAlpha, _mm_or_si128(red, blue));
+        }
+
+        /** Multiplies the colour of 4 RGBA pixels by their alpha. */
+        inline __m128i PremultiplyAlpha(__m128i inPixels)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i alphaLanes = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0); // keep alpha itself (a * 255 / 255)
+            const __m128i round = _mm_set1_epi16(128);
+
+            __m128i pixels[2] = { _mm_unpacklo_epi8(inPixels, zero), _mm_unpackhi_epi8(inPixels, zero) };
+            for (__m128i& pixel : pixels)
+            {
+                __m128i alpha = _mm_shufflelo_epi16(pixel, _MM_SHUFFLE(3, 3, 3, 3));
+                alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+                alpha = _mm_or_si128(alpha, alphaLanes);
+                const __m128i t = _mm_add_epi16(_mm_mullo_epi16(pixel, alpha), round);
+                pixel = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+            }
+            return _mm_packus_epi16(pixels[0], pixels[1]);
+        }
+
+        /** Converts 4 pixels, after they have been expanded to 32 bits. */
+        inline __m128i ConvertPixels(__m128i inPixels, int inFlags, bool inOpaque)
+        {
+            if (inFlags & PIXELCONVERSION_SWAP_RED_BLUE)
+                inPixels = SwapRedBlue(inPixels);
+            if (inOpaque)
+                inPixels = _mm_or_si128(inPixels, _mm_set1_epi32((int)0xFF000000));
+            else if (inFlags & PIXELCONVERSION_PREMULTIPLY_ALPHA)
+                inPixels = PremultiplyAlpha(inPixels);
+            return inPixels;
+        }
+#endif
+    }
+
+    void PixelConversion::ConvertRowToRGBA(const uint8_t* inSrc, unsigned int inSrcBytesPerPixel, uint8_t* outDst, size_t inNumPixels, int inFlags)
+    {
+        size_t iPixel = 0;
+
+        if (inSrcBytesPerPixel == 4 && inFlags == 0)
+        {
+            memcpy(outDst, inSrc, inNumPixels * 4);
+            return;
+        }
+
+#ifdef MING3D_PIXELCONVERSION_SSE2
+        if (inSrcBytesPerPixel == 4)
+        {
+            const bool opaque = (inFlags & PIXELCONVERSION_FORCE_OPAQUE) != 0;
+            for (; iPixel + 4 <= inNumPixels; iPixel += 4)
+            {
+                const __m128i pixels = _mm_loadu_si128((const __m128i*)(inSrc + iPixel * 4));
+                _mm_storeu_si128((__m128i*)(outDst + iPixel * 4), ConvertPixels(pixels, inFlags, opaque));
+            }
+        }
+#ifdef MING3D_PIXELCONVERSION_SSSE3
+        else if (inSrcBytesPerPixel == 3)
+        {
+            // Expands 4 packed RGB pixels (12 bytes) to RGBX. Red/blue are swapped in the same shuffle.
+            const __m128i expandMask = (inFlags & PIXELCONVERSION_SWAP_RED_BLUE)
+                ? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+                : _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+            const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+            // 16 pixels (48 bytes) per iteration
+            for (; iPixel + 16 <= inNumPixels; iPixel += 16)
+            {
+                const uint8_t* src = inSrc + iPixel * 3;
+                uint8_t* dst = outDst + iPixel * 4;
+                const __m128i src0 = _mm_loadu_si128((const __m128i*)src);
+                const __m128i src1 = _mm_loadu_si128((const __m128i*)(src + 16));
+                const __m128i src2 = _mm_loadu_si128((const __m128i*)(src + 32));
+                const __m128i pixels0 = src0;                          // bytes 0-11
+                const __m128i pixels1 = _mm_alignr_epi8(src1, src0, 12); // bytes 12-23
+                const __m128i pixels2 = _mm_alignr_epi8(src2, src1, 8);  // bytes 24-35
+                const __m128i pixels3 = _mm_srli_si128(src2, 4);         // bytes 36-47
+                _mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_shuffle_epi8(pixels0, expandMask), alpha));
+                _mm_storeu_si128((__m128i*)(dst + 16), _mm_or_si128(_mm_shuffle_epi8(pixels1, expandMask), alpha));
+                _mm_storeu_si128((__m128i*)(dst + 32), _mm_or_si128(_mm_shuffle_epi8(pixels2, expandMask), alpha));
+                _mm_storeu_si128((__m128i*)(dst + 48), _mm_or_si128(_mm_shuffle_epi8(pixels3, expandMask), alpha));
+            }
+        }
+#endif
+#endif
+
+        ConvertPixelsScalar(inSrc + iPixel * inSrcBytesPerPixel, inSrcBytesPerPixel, outDst + iPixel * 4, inNumPixels - iPixel, inFlags);
+    }
+
+    void PixelConversion::ConvertToRGBA(const uint8_t* inSrc, ptrdiff_t inSrcPitch, unsigned int inSrcBytesPerPixel, uint8_t* outDst, ptrdiff_t inDstPitch,
+        unsigned int inWidth, unsigned int inHeight, int inFlags)
+    {
+        const ptrdiff_t packedPitch = (ptrdiff_t)inWidth * inSrcBytesPerPixel;
+        if (inSrcPitch == packedPitch && inDstPitch == (ptrdiff_t)inWidth * 4)
+        {
+            // Rows are contiguous in both images: convert in one go
+            ConvertRowToRGBA(inSrc, inSrcBytesPerPixel, outDst, (size_t)inWidth * inHeight, inFlags);
+            return;
+        }
+
+        for (unsigned int y = 0; y < inHeight; y++)
+            ConvertRowToRGBA(inSrc + inSrcPitch * y, inSrcBytesPerPixel, outDst + inDstPitch * y, inWidth, inFlags);
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef MING3D_PIXELCONVERSION_H
+#define MING3D_PIXELCONVERSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define PIXELCONVERSION_SWAP_RED_BLUE 1 // source is BGR(A)
+#define PIXELCONVERSION_FORCE_OPAQUE 2 // source alpha is unused padding: write 255
+#define PIXELCONVERSION_PREMULTIPLY_ALPHA 4 // multiply the colour by alpha
+
+namespace Ming3D
+{
+    /**
+    * Converts 8 bit RGB/RGBA/BGR/BGRA images to RGBA in a single pass (SSSE3/SSE2 when available, scalar otherwise).
+    * Used to copy decoded images (e.g. SDL surfaces) straight into texture storage.
+    */
+    class PixelConversion
+    {
+    public:
+        /**
+        * Converts an image with 3 or 4 bytes per source pixel to RGBA.
+        * Pitches are in bytes. To flip the image vertically, pass the last destination row and a negative destination pitch.
+        */
+        static void ConvertToRGBA(const uint8_t* inSrc, ptrdiff_t inSrcPitch, unsigned int inSrcBytesPerPixel, uint8_t* outDst, ptrdiff_t inDstPitch,
+            unsigned int inWidth, unsigned int inHeight, int inFlags);
+
+        /** Converts one row of pixels. */
+        static void ConvertRowToRGBA(const uint8_t* inSrc, unsigned int inSrcBytesPerPixel, uint8_t* outDst, size_t inNumPixels, int inFlags);
+    };
+}
+
+#endif
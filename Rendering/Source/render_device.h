@@ -33,24 +33,44 @@ namespace Ming3D
 
         virtual RenderTarget* CreateRenderTarget(RenderWindow* inWindow) = 0;
         virtual RenderTarget* CreateRenderTarget(TextureInfo inTextureInfo, int numTextures) = 0;
+        /** Creates a depth-only render target with inNumLayers layers (a 2D texture array), for shadow maps. Its depth texture is read with SampleShadowMap. */
+        virtual RenderTarget* CreateDepthRenderTarget(TextureInfo inTextureInfo, int inNumLayers) = 0;
         virtual VertexBuffer* CreateVertexBuffer(VertexData* inVertexData) = 0;
         virtual IndexBuffer* CreateIndexBuffer(IndexData* inIndexData) = 0;
         virtual ShaderProgram* CreateShaderProgram(ParsedShaderProgram* inShaderProgramPath) = 0;
+        /** Creates a program that only outputs vertex positions (used for depth pre-pass). */
+        virtual ShaderProgram* CreateDepthOnlyShaderProgram(ParsedShaderProgram* inShaderProgramPath) = 0;
         virtual TextureBuffer* CreateTextureBuffer(TextureInfo inTextureInfo, void* inTextureData) = 0;
+        /** Replaces the content of a texture buffer. The size, format and number of mip levels may change (used by texture streaming). */
+        virtual void UpdateTextureBuffer(TextureBuffer* inTextureBuffer, TextureInfo inTextureInfo, void* inTextureData) = 0;
+        /** Creates a shader-readable buffer of inNumElements vec4 (float) texels. Bound with SetTexture. */
+        virtual TextureBuffer* CreateTexelBuffer(size_t inNumElements) = 0;
+        /**
+        * Creates a 2D texture array of inNumLayers layers, each with the size, format and mip levels of inTextureInfo (content undefined).
+        * Read with ReadTextureArray. Materials whose textures share an array can be drawn without rebinding textures (see TextureArrayPool).
+        */
+        virtual TextureBuffer* CreateTextureArrayBuffer(TextureInfo inTextureInfo, unsigned int inNumLayers) = 0;
+        /** Uploads all mip levels of one layer of a texture array. inTextureInfo must match the info the array was created with. */
+        virtual void UpdateTextureArrayLayer(TextureBuffer* inTextureArray, unsigned int inLayer, TextureInfo inTextureInfo, void* inTextureData) = 0;
         virtual RenderWindow* CreateRenderWindow(WindowBase* inWindow) = 0;
         virtual RasteriserState* CreateRasteriserState(RasteriserStateCullMode inCullMode, bool inDepthClipEnabled) = 0;
         virtual DepthStencilState* CreateDepthStencilState(DepthStencilStateDesc inDesc) = 0;
         virtual ConstantBuffer* CreateConstantBuffer(size_t inSize) = 0;
 
         virtual void SetTexture(const TextureBuffer* inTexture, int inSlot) = 0;
+        virtual void UpdateTexelBuffer(TextureBuffer* inBuffer, const void* inData, size_t inNumElements) = 0;
         virtual void SetActiveShaderProgram(ShaderProgram* inProgram) = 0;
         virtual void BeginRenderWindow(RenderWindow* inWindow) = 0;
         virtual void EndRenderWindow(RenderWindow* inWindow) = 0;
         virtual void BeginRenderTarget(RenderTarget* inTarget) = 0;
+        /** Begins rendering to (and clears) one layer of a depth render target. End with EndRenderTarget. */
+        virtual void BeginDepthRenderTarget(RenderTarget* inTarget, int inLayer) = 0;
         virtual void EndRenderTarget(RenderTarget* inTarget) = 0;
         virtual void RenderPrimitive(VertexBuffer* inVertexBuffer, IndexBuffer* inIndexBuffer) = 0;
         virtual void SetRasteriserState(RasteriserState* inState) = 0;
+        /** Sets the active depth stencil state. Passing nullptr restores the default state. */
         virtual void SetDepthStencilState(DepthStencilState* inState) = 0;
+        virtual void SetColourWriteEnabled(bool inEnabled) = 0;
         virtual void SetConstantBufferData(ConstantBuffer* inConstantBuffer, void* inData, size_t inSize) = 0;
         virtual void BindConstantBuffer(ConstantBuffer* inConstantBuffer, const char* inName, ShaderProgram* inProgram) = 0;
 
@@ -60,6 +80,11 @@ namespace Ming3D
         virtual void SetShaderUniformVec2(const std::string& inName, const glm::vec2 inVec) = 0;
         virtual void SetShaderUniformVec3(const std::string& inName, const glm::vec3 inVec) = 0;
         virtual void SetShaderUniformVec4(const std::string& inName, const glm::vec4 inVec) = 0;
+        /**
+        * Uploads the bytes [inOffset, inOffset + inSize) of a uniform block to the active shader program.
+        * inBlockData is the whole block, laid out by the program's ShaderUniformBlockLayout.
+        */
+        virtual void SetShaderUniformBlock(const void* inBlockData, size_t inOffset, size_t inSize) = 0;
     };
 }
 #endif
@@ -6,10 +6,14 @@
 #include "vertex_buffer_d3d11.h"
 #include "index_buffer_d3d11.h"
 #include "texture_buffer_d3d11.h"
-#include "shader_writer_hlsl.h"
+#include "shader_converter.h"
+#include "shader_disk_cache.h"
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 #include "shader_constant_d3d11.h"
 #include "Debug/debug_stats.h"
 #include "shader_info_hlsl.h"
@@ -72,6 +76,22 @@ namespace Ming3D
             return;
         }
 
+        D3D11_SAMPLER_DESC shadowSampDesc;
+        ZeroMemory(&shadowSampDesc, sizeof(shadowSampDesc));
+        shadowSampDesc.Filter = D3D11_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+        shadowSampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+        shadowSampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+        shadowSampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+        shadowSampDesc.ComparisonFunc = D3D11_COMPARISON_LESS_EQUAL;
+        shadowSampDesc.MinLOD = 0;
+        shadowSampDesc.MaxLOD = D3D11_FLOAT32_MAX;
+        hrCreateSampler = GetDevice()->CreateSamplerState(&shadowSampDesc, &mShadowSamplerState);
+        if (!SUCCEEDED(hrCreateSampler))
+        {
+            LOG_ERROR() << "Failed to create shadow sampler";
+            return;
+        }
+
         mDefaultRasteriserState = (RasteriserStateD3D11*)CreateRasteriserState(RasteriserStateCullMode::Front, true);
         SetRasteriserState(mDefaultRasteriserState);
 
@@ -85,47 +105,12 @@ namespace Ming3D
     RenderDeviceD3D11::~RenderDeviceD3D11()
     {
         if (mDefaultDepthStencilState != nullptr)
-        {
-            DepthStencilStateD3D11* d3dDepthStencilState = (DepthStencilStateD3D11*)mDefaultDepthStencilState;
-            d3dDepthStencilState->mDepthStencilState->Release();
             delete mDefaultDepthStencilState;
-        }
 
         mDevice->Release();
         mDeviceContext->Release();
     }
 
-    void RenderDeviceD3D11::ApplyConstantPacking(const ShaderUniformInfo& inShaderUniform, size_t& outSize)
-    {
-        switch (inShaderUniform.mType.mDatatype)
-        {
-        case EShaderDatatype::Float:
-            outSize += sizeof(float);
-            break;
-        case EShaderDatatype::Int:
-            outSize +=  sizeof(int); // TODO
-            break;
-        case EShaderDatatype::Vec2:
-            outSize += (16 - (outSize % 16)) % 16;
-            outSize += sizeof(DirectX::XMFLOAT2);
-            break;
-        case EShaderDatatype::Vec3:
-            outSize += (16 - (outSize % 16)) % 16;
-            outSize += sizeof(DirectX::XMFLOAT3);
-            break;
-        case EShaderDatatype::Vec4:
-            outSize += (16 - (outSize % 16)) % 16;
-            outSize += sizeof(DirectX::XMFLOAT4);
-            break;
-        case EShaderDatatype::Mat4x4:
-            outSize += (16 - (outSize % 16)) % 16;
-            outSize += sizeof(DirectX::XMFLOAT4X4);
-            break;
-        default:
-            __AssertComment(false, "Unhandled shader uniform type");
-        }
-    }
-
     RenderTarget* RenderDeviceD3D11::CreateRenderTarget(RenderWindow* inWindow)
     {
         //__Assert(inWindow->GetOSWindowHandle());
@@ -174,6 +159,8 @@ namespace Ming3D
 
         DepthStencilViewD3D11* depthStencilView = CreateDepthStencilView(inWindow->GetWindow()->GetWidth(), inWindow->GetWindow()->GetHeight());
         renderTarget->mDepthStencilView = depthStencilView;
+        renderTarget->mWidth = inWindow->GetWindow()->GetWidth();
+        renderTarget->mHeight = inWindow->GetWindow()->GetHeight();
 
         return renderTarget;
     }
@@ -233,6 +220,77 @@ namespace Ming3D
 
         DepthStencilViewD3D11* depthStencilView = CreateDepthStencilView(inTextureInfo.mWidth, inTextureInfo.mHeight);
         renderTarget->mDepthStencilView = depthStencilView;
+        renderTarget->mWidth = inTextureInfo.mWidth;
+        renderTarget->mHeight = inTextureInfo.mHeight;
+
+        return renderTarget;
+    }
+
+    RenderTarget* RenderDeviceD3D11::CreateDepthRenderTarget(TextureInfo inTextureInfo, int inNumLayers)
+    {
+        RenderTargetD3D11* renderTarget = new RenderTargetD3D11();
+
+        ID3D11Texture2D* texture = nullptr;
+        ID3D11ShaderResourceView* shaderResourceView = nullptr;
+
+        D3D11_TEXTURE2D_DESC descDepth;
+        ZeroMemory(&descDepth, sizeof(descDepth));
+        descDepth.Width = inTextureInfo.mWidth;
+        descDepth.Height = inTextureInfo.mHeight;
+        descDepth.MipLevels = 1;
+        descDepth.ArraySize = inNumLayers;
+        descDepth.Format = DXGI_FORMAT_R32_TYPELESS;
+        descDepth.SampleDesc.Count = 1;
+        descDepth.SampleDesc.Quality = 0;
+        descDepth.Usage = D3D11_USAGE_DEFAULT;
+        descDepth.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+        HRESULT result = mDevice->CreateTexture2D(&descDepth, nullptr, &texture);
+        if (FAILED(result))
+        {
+            LOG_ERROR() << "Failed to create depth texture array";
+            delete renderTarget;
+            return nullptr;
+        }
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC depthSRVDesc;
+        ZeroMemory(&depthSRVDesc, sizeof(depthSRVDesc));
+        depthSRVDesc.Format = DXGI_FORMAT_R32_FLOAT;
+        depthSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        depthSRVDesc.Texture2DArray.MostDetailedMip = 0;
+        depthSRVDesc.Texture2DArray.MipLevels = 1;
+        depthSRVDesc.Texture2DArray.FirstArraySlice = 0;
+        depthSRVDesc.Texture2DArray.ArraySize = inNumLayers;
+        mDevice->CreateShaderResourceView(texture, &depthSRVDesc, &shaderResourceView);
+
+        for (int iLayer = 0; iLayer < inNumLayers; iLayer++)
+        {
+            D3D11_DEPTH_STENCIL_VIEW_DESC descDSV;
+            ZeroMemory(&descDSV, sizeof(descDSV));
+            descDSV.Format = DXGI_FORMAT_D32_FLOAT;
+            descDSV.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+            descDSV.Texture2DArray.MipSlice = 0;
+            descDSV.Texture2DArray.FirstArraySlice = iLayer;
+            descDSV.Texture2DArray.ArraySize = 1;
+
+            ID3D11DepthStencilView* layerView = nullptr;
+            result = mDevice->CreateDepthStencilView(texture, &descDSV, &layerView);
+            if (FAILED(result))
+            {
+                LOG_ERROR() << "Failed to create depth stencil view for layer " << iLayer;
+                continue;
+            }
+            renderTarget->mDepthLayerViews.push_back(layerView);
+        }
+
+        DepthStencilViewD3D11* depthStencilView = new DepthStencilViewD3D11();
+        depthStencilView->mDepthStencilTexture = new TextureBufferD3D11();
+        depthStencilView->mDepthStencilTexture->mTexture = texture;
+        depthStencilView->mDepthStencilTexture->mTextureResourceView = shaderResourceView;
+        depthStencilView->mDepthStencilTexture->mDepthCompare = true;
+
+        renderTarget->mDepthStencilView = depthStencilView;
+        renderTarget->mWidth = inTextureInfo.mWidth;
+        renderTarget->mHeight = inTextureInfo.mHeight;
 
         return renderTarget;
     }
@@ -267,10 +325,16 @@ namespace Ming3D
         IndexBufferD3D11* indexBuffer = new IndexBufferD3D11();
         ID3D11Buffer* iBuffer;
 
+        // 16 bit indices, when possible
+        const bool shortIndices = inIndexData->UseShortIndices();
+        std::vector<unsigned short> shortIndexData;
+        if (shortIndices)
+            inIndexData->GetShortIndices(shortIndexData);
+
         D3D11_BUFFER_DESC indexBufferDesc;
         
         indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-        indexBufferDesc.ByteWidth = sizeof(unsigned long) * inIndexData->GetNumIndices();
+        indexBufferDesc.ByteWidth = (shortIndices ? sizeof(unsigned short) : sizeof(unsigned int)) * inIndexData->GetNumIndices();
         indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
         indexBufferDesc.CPUAccessFlags = 0;
         indexBufferDesc.MiscFlags = 0;
@@ -278,7 +342,7 @@ namespace Ming3D
 
         D3D11_SUBRESOURCE_DATA indexData;
         
-        indexData.pSysMem = inIndexData->GetData();
+        indexData.pSysMem = shortIndices ? (const void*)shortIndexData.data() : (const void*)inIndexData->GetData();
         indexData.SysMemPitch = 0;
         indexData.SysMemSlicePitch = 0;
 
@@ -290,56 +354,72 @@ namespace Ming3D
         }
         indexBuffer->SetD3DBuffer(iBuffer);
         indexBuffer->SetNumIndices(inIndexData->GetNumIndices());
+        indexBuffer->SetShortIndices(shortIndices);
         return indexBuffer;
     }
 
-    ShaderProgram* RenderDeviceD3D11::CreateShaderProgram(ParsedShaderProgram* parsedProgram)
+    bool RenderDeviceD3D11::ConvertShaderProgram(ParsedShaderProgram* parsedProgram)
     {
-        ShaderProgramDataHLSL convertedShaderData;
-        // Get the converted shaders (if already converted)
-        ConvertedShaderProgramHLSL* convertedProgram = static_cast<ConvertedShaderProgramHLSL*>(parsedProgram->mConvertedProgram);
-        // Convert shaders to HLSL (if not already converted)
-        if (parsedProgram->mConvertedProgram == nullptr)
-        {
-            ShaderWriterHLSL shaderWriter;
-            shaderWriter.WriteShader(parsedProgram, convertedShaderData);
-
-            std::string vertexShaderCode = convertedShaderData.mVertexShader;
-            std::string pixelShaderCode = convertedShaderData.mFragmentShader;
+        if (parsedProgram->mConvertedProgram != nullptr && parsedProgram->mConvertedDepthOnlyProgram != nullptr)
+            return true;
 
-            ID3D10Blob* vsBlob;
-            ID3D10Blob* psBlob;
-
-            ID3DBlob* errorBlobVS;
-            ID3DBlob* errorBlobPS;
-            D3DCompile(vertexShaderCode.data(), vertexShaderCode.size(), "", NULL, NULL, "main", "vs_4_0", 0, NULL, &vsBlob, &errorBlobVS);
-            D3DCompile(pixelShaderCode.data(), pixelShaderCode.size(), "", NULL, NULL, "main", "ps_4_0", 0, NULL, &psBlob, &errorBlobPS);
+        // Compiled vertex and pixel shader, followed by the depth-only vertex and pixel shader.
+        // Both variants are compiled together, so the disk cache gets complete entries.
+        std::vector<std::string> shaderBlobs = parsedProgram->mCachedShaders;
+        if (shaderBlobs.empty())
+        {
+            const bool compiled = ShaderConverter::ConvertProgram(parsedProgram, shaderBlobs);
+            // TODO: use placeholder material if compilation fails
+            __AssertComment(compiled, "Failed compiling shader - see log for error.");
+            if (!compiled)
+                return false;
+            ShaderDiskCache::SaveProgram(parsedProgram, shaderBlobs);
+        }
+        else if (shaderBlobs.size() != 4)
+        {
+            LOG_ERROR() << "Invalid cached shader program: " << parsedProgram->mProgramPath;
+            return false;
+        }
 
-            if (errorBlobVS)
-            {
-                LPVOID err = errorBlobVS->GetBufferPointer();
-                LOG_ERROR() << "Error when compiling Vertex Shader: " << parsedProgram->mProgramPath << "\n   " << (char*)err;
-                errorBlobVS->Release();
-            }
-            if (errorBlobPS)
+        ConvertedShaderProgramHLSL* convertedPrograms[2] = {};
+        for (int iProgram = 0; iProgram < 2; iProgram++)
+        {
+            convertedPrograms[iProgram] = new ConvertedShaderProgramHLSL();
+            for (int iShader = 0; iShader < 2; iShader++)
             {
-                LPVOID err = errorBlobPS->GetBufferPointer();
-                LOG_ERROR() << "Error when compiling Pixel Shader:" << parsedProgram->mProgramPath << "\n   " << (char*)err;
-                errorBlobPS->Release();
+                const std::string& shaderBlob = shaderBlobs[iProgram * 2 + iShader];
+                ID3D10Blob*& blob = iShader == 0 ? convertedPrograms[iProgram]->vsBlob : convertedPrograms[iProgram]->psBlob;
+                if (SUCCEEDED(D3DCreateBlob(shaderBlob.size(), &blob)))
+                    memcpy(blob->GetBufferPointer(), shaderBlob.data(), shaderBlob.size());
             }
+        }
 
-            // TODO: use placeholder material if null-program is returned
-            __AssertComment(vsBlob != nullptr && psBlob != nullptr, "Failed compiling shader - see log for error.");
+        delete parsedProgram->mConvertedProgram;
+        delete parsedProgram->mConvertedDepthOnlyProgram;
+        parsedProgram->mConvertedProgram = convertedPrograms[0];
+        parsedProgram->mConvertedDepthOnlyProgram = convertedPrograms[1];
+        parsedProgram->mCachedShaders.clear();
+        return true;
+    }
 
-            if (vsBlob == nullptr || psBlob == nullptr)
-                return nullptr;
+    ShaderProgram* RenderDeviceD3D11::CreateShaderProgram(ParsedShaderProgram* parsedProgram)
+    {
+        if (!ConvertShaderProgram(parsedProgram))
+            return nullptr;
 
-            convertedProgram = new ConvertedShaderProgramHLSL();
-            convertedProgram->vsBlob = vsBlob;
-            convertedProgram->psBlob = psBlob;
-            parsedProgram->mConvertedProgram = convertedProgram;
-        }
+        return CreateShaderProgramFromBlobs(parsedProgram, static_cast<ConvertedShaderProgramHLSL*>(parsedProgram->mConvertedProgram));
+    }
+
+    ShaderProgram* RenderDeviceD3D11::CreateDepthOnlyShaderProgram(ParsedShaderProgram* parsedProgram)
+    {
+        if (!ConvertShaderProgram(parsedProgram))
+            return nullptr;
 
+        return CreateShaderProgramFromBlobs(parsedProgram, static_cast<ConvertedShaderProgramHLSL*>(parsedProgram->mConvertedDepthOnlyProgram));
+    }
+
+    ShaderProgram* RenderDeviceD3D11::CreateShaderProgramFromBlobs(ParsedShaderProgram* parsedProgram, ConvertedShaderProgramHLSL* convertedProgram)
+    {
         ID3D10Blob* vsBlob = convertedProgram->vsBlob;
         ID3D10Blob* psBlob = convertedProgram->psBlob;
         ID3D11VertexShader* pVS;
@@ -351,8 +431,13 @@ namespace Ming3D
         mDeviceContext->VSSetShader(pVS, 0, 0);
         mDeviceContext->PSSetShader(pPS, 0, 0);
 
-        // Gather Vertex Components
-        std::vector<EVertexComponent> vertexComponents;
+        ShaderProgramD3D11* shaderProgram = new ShaderProgramD3D11();
+        shaderProgram->mVS = pVS;
+        shaderProgram->mPS = pPS;
+        shaderProgram->mVSBlob = vsBlob;
+
+        // Gather Vertex Components (input layouts are created when drawing, since they depend on the vertex buffer's component formats)
+        std::vector<EVertexComponent>& vertexComponents = shaderProgram->mVertexComponents;
         const std::unordered_map<std::string, EVertexComponent> vertexComponentSemanticMap = { { "POSITION", EVertexComponent::Position },{ "NORMAL", EVertexComponent::Normal },{ "TEXCOORD", EVertexComponent::TexCoord },{ "COLOR", EVertexComponent::Colour } };
         for (const ShaderStructMember inputVar : parsedProgram->mVertexShader->mInput.mMemberVariables)
         {
@@ -367,27 +452,6 @@ namespace Ming3D
             }
         }
 
-        // Create input element descriptions (for input layout)
-        const char* vertCompNames[] = { "POSITION", "NORMAL", "TEXCOORD", "COLOR" }; // TEMP - TODO
-        const DXGI_FORMAT vertFormats[] = { DXGI_FORMAT_R32G32B32_FLOAT , DXGI_FORMAT_R32G32B32_FLOAT , DXGI_FORMAT_R32G32_FLOAT , DXGI_FORMAT_R32G32B32A32_FLOAT }; // TODO
-        UINT byteOffset = 0;
-        std::vector<D3D11_INPUT_ELEMENT_DESC> inputElements;
-        for (const EVertexComponent& vertexComp : vertexComponents)
-        {
-            D3D11_INPUT_ELEMENT_DESC desc = { vertCompNames[vertexComp], 0, vertFormats[vertexComp], 0, byteOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 };
-            inputElements.push_back(desc);
-            byteOffset += VertexData::GetVertexComponentSize(vertexComp);
-        }
-
-        // Create input layout
-        ID3D11InputLayout* inputLayout;
-        mDevice->CreateInputLayout(inputElements.data(), inputElements.size(), vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &inputLayout);
-        
-        ShaderProgramD3D11* shaderProgram = new ShaderProgramD3D11();
-        shaderProgram->mInputLayout = inputLayout;
-        shaderProgram->mVS = pVS;
-        shaderProgram->mPS = pPS;
-
         // Set up array of bound constant buffers
         const size_t numcbuffers = parsedProgram->mConstantBufferInfos.size() + (parsedProgram->mUniforms.size() > 0 ? 1 : 0);
         shaderProgram->mBoundConstantBuffers.resize(numcbuffers);
@@ -397,22 +461,22 @@ namespace Ming3D
             shaderProgram->mConstantBufferLocations.emplace(parsedProgram->mConstantBufferInfos[iCB].mName, iCB);
         }
 
+        shaderProgram->mStrippedUniforms.insert(parsedProgram->mStrippedUniforms.begin(), parsedProgram->mStrippedUniforms.end());
+
         // Crate a constant buffer for all uniforms
         if (parsedProgram->mUniforms.size() > 0)
         {
-            size_t cBufferSize = 0;
-            for (const ShaderVariableInfo& uniformInfo : parsedProgram->mUniforms)
+            const ShaderUniformBlockLayout& uniformBlockLayout = parsedProgram->mUniformBlockLayout;
+            for (size_t iUniform = 0; iUniform < parsedProgram->mUniforms.size(); iUniform++)
             {
-                size_t offset = cBufferSize;
-                ShaderDatatypeInfo varType = uniformInfo.mDatatypeInfo;
-                ShaderUniformInfo uniformInfo(varType, uniformInfo.mName);
-                ApplyConstantPacking(uniformInfo, cBufferSize);
-                ShaderConstantD3D11 scInfo(uniformInfo, offset, cBufferSize - offset);
+                const ShaderVariableInfo& uniformInfo = parsedProgram->mUniforms[iUniform];
+                const ShaderUniformBlockMember& blockMember = uniformBlockLayout.mMembers[iUniform];
+                ShaderConstantD3D11 scInfo(ShaderUniformInfo(uniformInfo.mDatatypeInfo, uniformInfo.mName), blockMember.mOffset, blockMember.mSize);
                 shaderProgram->mUniforms.emplace(uniformInfo.mName, scInfo);
             }
-            // Add final padding (size must be a multiple of 16)
-            cBufferSize += (16 - (cBufferSize % 16) % 16);
+            shaderProgram->mUniformBlockLayout = uniformBlockLayout;
 
+            const size_t cBufferSize = uniformBlockLayout.mSize;
             shaderProgram->mUniformsSize = cBufferSize;
 
             ConstantBufferD3D11* cBuffer = static_cast<ConstantBufferD3D11*>(CreateConstantBuffer(cBufferSize));
@@ -424,21 +488,8 @@ namespace Ming3D
         return shaderProgram;
     }
 
-    TextureBuffer* RenderDeviceD3D11::CreateTextureBuffer(TextureInfo inTextureInfo, void* inTextureData)
+    DXGI_FORMAT RenderDeviceD3D11::GetDXGIFormat(const TextureInfo& inTextureInfo)
     {
-        ADD_DEBUG_STAT_INT("CreateTextureBuffer", 1);
-        
-        TextureBufferD3D11* textureBuffer = new TextureBufferD3D11();
-
-        __AssertComment(inTextureInfo.mBytesPerPixel % 2 == 0, "Bytes per pixel must be a power of 2");
-
-        const unsigned int w = inTextureInfo.mWidth;
-        const unsigned int h = inTextureInfo.mHeight;
-
-        char* buffer = new char[inTextureInfo.mWidth * inTextureInfo.mHeight * inTextureInfo.mBytesPerPixel];
-        memcpy(buffer, inTextureData, inTextureInfo.mWidth * inTextureInfo.mHeight * inTextureInfo.mBytesPerPixel);
-        textureBuffer->mData = buffer;
-
         DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
         switch (inTextureInfo.mPixelFormat)
         {
@@ -488,25 +539,152 @@ namespace Ming3D
             }
             break;
         }
+        case PixelFormat::BC1:
+        {
+            dxgiFormat = DXGI_FORMAT_BC1_UNORM;
+            break;
+        }
+        case PixelFormat::BC3:
+        {
+            dxgiFormat = DXGI_FORMAT_BC3_UNORM;
+            break;
+        }
         }
+        return dxgiFormat;
+    }
+
+    void RenderDeviceD3D11::CreateTexture(TextureBufferD3D11* textureBuffer, const TextureInfo& inTextureInfo, void* inTextureData)
+    {
+        __AssertComment(inTextureInfo.mBytesPerPixel % 2 == 0, "Bytes per pixel must be a power of 2");
+
+        const unsigned int w = inTextureInfo.mWidth;
+        const unsigned int h = inTextureInfo.mHeight;
+
+        char* buffer = new char[inTextureInfo.GetDataSize()];
+        memcpy(buffer, inTextureData, inTextureInfo.GetDataSize());
+        textureBuffer->mData = buffer;
 
-        D3D11_SUBRESOURCE_DATA initData;
-        initData.pSysMem = buffer;
-        initData.SysMemPitch = w * 4 * sizeof(uint8_t);
-        initData.SysMemSlicePitch = w * h * 4 * sizeof(uint8_t);
+        const DXGI_FORMAT dxgiFormat = GetDXGIFormat(inTextureInfo);
+
+        std::vector<D3D11_SUBRESOURCE_DATA> initData(inTextureInfo.mMipLevels);
+        for (unsigned int iLevel = 0; iLevel < inTextureInfo.mMipLevels; iLevel++)
+        {
+            initData[iLevel].pSysMem = buffer + inTextureInfo.GetMipLevelOffset(iLevel);
+            initData[iLevel].SysMemPitch = (UINT)inTextureInfo.GetMipRowPitch(iLevel);
+            initData[iLevel].SysMemSlicePitch = (UINT)inTextureInfo.GetMipLevelSize(iLevel);
+        }
 
         D3D11_TEXTURE2D_DESC desc = {};
         desc.Width = w;
         desc.Height = h;
-        desc.MipLevels = 1;
+        desc.MipLevels = inTextureInfo.mMipLevels;
         desc.ArraySize = 1;
         desc.Format = dxgiFormat;
         desc.SampleDesc.Count = 1;
         desc.Usage = D3D11_USAGE_IMMUTABLE;
         desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 
-        GRenderDeviceD3D11->GetDevice()->CreateTexture2D(&desc, &initData, &textureBuffer->mTexture);
+        GRenderDeviceD3D11->GetDevice()->CreateTexture2D(&desc, initData.data(), &textureBuffer->mTexture);
         GRenderDeviceD3D11->GetDevice()->CreateShaderResourceView(textureBuffer->mTexture, NULL, &textureBuffer->mTextureResourceView);
+    }
+
+    TextureBuffer* RenderDeviceD3D11::CreateTextureBuffer(TextureInfo inTextureInfo, void* inTextureData)
+    {
+        ADD_DEBUG_STAT_INT("CreateTextureBuffer", 1);
+
+        TextureBufferD3D11* textureBuffer = new TextureBufferD3D11();
+        CreateTexture(textureBuffer, inTextureInfo, inTextureData);
+        return textureBuffer;
+    }
+
+    void RenderDeviceD3D11::UpdateTextureBuffer(TextureBuffer* inTextureBuffer, TextureInfo inTextureInfo, void* inTextureData)
+    {
+        ADD_DEBUG_STAT_INT("UpdateTextureBuffer", 1);
+
+        TextureBufferD3D11* textureBuffer = static_cast<TextureBufferD3D11*>(inTextureBuffer);
+        if (textureBuffer->mTextureResourceView != nullptr)
+        {
+            textureBuffer->mTextureResourceView->Release();
+            textureBuffer->mTextureResourceView = nullptr;
+        }
+        if (textureBuffer->mTexture != nullptr)
+        {
+            textureBuffer->mTexture->Release();
+            textureBuffer->mTexture = nullptr;
+        }
+        delete[] textureBuffer->mData;
+        textureBuffer->mData = nullptr;
+
+        CreateTexture(textureBuffer, inTextureInfo, inTextureData);
+    }
+
+    TextureBuffer* RenderDeviceD3D11::CreateTextureArrayBuffer(TextureInfo inTextureInfo, unsigned int inNumLayers)
+    {
+        ADD_DEBUG_STAT_INT("CreateTextureBuffer", 1);
+
+        TextureBufferD3D11* textureBuffer = new TextureBufferD3D11();
+
+        D3D11_TEXTURE2D_DESC desc = {};
+        desc.Width = inTextureInfo.mWidth;
+        desc.Height = inTextureInfo.mHeight;
+        desc.MipLevels = inTextureInfo.mMipLevels;
+        desc.ArraySize = inNumLayers;
+        desc.Format = GetDXGIFormat(inTextureInfo);
+        desc.SampleDesc.Count = 1;
+        desc.Usage = D3D11_USAGE_DEFAULT; // layers are uploaded later, by UpdateTextureArrayLayer
+        desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        mDevice->CreateTexture2D(&desc, nullptr, &textureBuffer->mTexture);
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format = desc.Format;
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        srvDesc.Texture2DArray.MostDetailedMip = 0;
+        srvDesc.Texture2DArray.MipLevels = desc.MipLevels;
+        srvDesc.Texture2DArray.FirstArraySlice = 0;
+        srvDesc.Texture2DArray.ArraySize = inNumLayers;
+        mDevice->CreateShaderResourceView(textureBuffer->mTexture, &srvDesc, &textureBuffer->mTextureResourceView);
+
+        return textureBuffer;
+    }
+
+    void RenderDeviceD3D11::UpdateTextureArrayLayer(TextureBuffer* inTextureArray, unsigned int inLayer, TextureInfo inTextureInfo, void* inTextureData)
+    {
+        ADD_DEBUG_STAT_INT("UpdateTextureBuffer", 1);
+
+        TextureBufferD3D11* textureBuffer = static_cast<TextureBufferD3D11*>(inTextureArray);
+        for (unsigned int iLevel = 0; iLevel < inTextureInfo.mMipLevels; iLevel++)
+        {
+            const UINT subresource = D3D11CalcSubresource(iLevel, inLayer, inTextureInfo.mMipLevels);
+            mDeviceContext->UpdateSubresource(textureBuffer->mTexture, subresource, nullptr, (const char*)inTextureData + inTextureInfo.GetMipLevelOffset(iLevel),
+                (UINT)inTextureInfo.GetMipRowPitch(iLevel), (UINT)inTextureInfo.GetMipLevelSize(iLevel));
+        }
+    }
+
+    TextureBuffer* RenderDeviceD3D11::CreateTexelBuffer(size_t inNumElements)
+    {
+        TextureBufferD3D11* textureBuffer = new TextureBufferD3D11();
+
+        D3D11_BUFFER_DESC bufferDesc;
+        ZeroMemory(&bufferDesc, sizeof(bufferDesc));
+        bufferDesc.ByteWidth = inNumElements * sizeof(float) * 4;
+        bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+        bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        HRESULT hr = mDevice->CreateBuffer(&bufferDesc, nullptr, &textureBuffer->mBuffer);
+        if (FAILED(hr))
+        {
+            LOG_ERROR() << "Failed to create texel buffer";
+            delete textureBuffer;
+            return nullptr;
+        }
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+        ZeroMemory(&srvDesc, sizeof(srvDesc));
+        srvDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+        srvDesc.Buffer.FirstElement = 0;
+        srvDesc.Buffer.NumElements = inNumElements;
+        mDevice->CreateShaderResourceView(textureBuffer->mBuffer, &srvDesc, &textureBuffer->mTextureResourceView);
 
         return textureBuffer;
     }
@@ -610,7 +788,7 @@ namespace Ming3D
         D3D11_DEPTH_STENCIL_DESC depthStencilDesc;
         ZeroMemory(&depthStencilDesc, sizeof(depthStencilDesc));
         depthStencilDesc.DepthEnable = inDesc.mDepthEnabled;
-        depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+        depthStencilDesc.DepthWriteMask = inDesc.mDepthWriteEnabled ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
         depthStencilDesc.DepthFunc = depthFuncMap[inDesc.mDepthFunc];
         depthStencilDesc.StencilEnable = true;
         depthStencilDesc.StencilReadMask = 0xFF;
@@ -693,13 +871,39 @@ namespace Ming3D
         return d3dDepthStencilView;
     }
 
+    void RenderDeviceD3D11::ResetTextureBindings()
+    {
+        std::fill(std::begin(mBoundTextures), std::end(mBoundTextures), nullptr);
+    }
+
     void RenderDeviceD3D11::SetTexture(const TextureBuffer* inTexture, int inSlot)
     {
         ADD_FRAME_STAT_INT("SetTexture", 1);
 
         TextureBufferD3D11* d3dTexture = (TextureBufferD3D11*)inTexture;
-        GetDeviceContext()->PSSetSamplers(inSlot, 1, &mDefaultSamplerState);
-        GetDeviceContext()->PSSetShaderResources(0, 1, &d3dTexture->mTextureResourceView);
+        if (d3dTexture->mTextureResourceView != nullptr && mBoundTextures[inSlot] == d3dTexture->mTextureResourceView)
+        {
+            ADD_FRAME_STAT_INT("SetTexture.Skipped", 1);
+            return;
+        }
+        mBoundTextures[inSlot] = d3dTexture->mTextureResourceView;
+
+        if (d3dTexture->mDepthCompare)
+            GetDeviceContext()->PSSetSamplers(ShadowSamplerSlot, 1, &mShadowSamplerState);
+        else
+            GetDeviceContext()->PSSetSamplers(inSlot, 1, &mDefaultSamplerState);
+        GetDeviceContext()->PSSetShaderResources(inSlot, 1, &d3dTexture->mTextureResourceView);
+    }
+
+    void RenderDeviceD3D11::UpdateTexelBuffer(TextureBuffer* inBuffer, const void* inData, size_t inNumElements)
+    {
+        TextureBufferD3D11* d3dTexture = (TextureBufferD3D11*)inBuffer;
+        __Assert(d3dTexture->mBuffer != nullptr);
+
+        D3D11_MAPPED_SUBRESOURCE mappedResource;
+        mDeviceContext->Map(d3dTexture->mBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+        memcpy(mappedResource.pData, inData, inNumElements * sizeof(float) * 4);
+        mDeviceContext->Unmap(d3dTexture->mBuffer, 0);
     }
 
     void RenderDeviceD3D11::SetActiveShaderProgram(ShaderProgram* inProgram)
@@ -740,12 +944,46 @@ namespace Ming3D
 
         mRenderTarget->BeginRendering();
 
+        // Binding the target unbinds its textures from the pixel shader
         GRenderDeviceD3D11->GetDeviceContext()->OMSetRenderTargets(1, &mRenderTarget->mBackBuffer, mRenderTarget->mDepthStencilView->mDepthStencilView);
+        ResetTextureBindings();
 
         const float clearCol[4] = { 0.0f, 0.2f, 0.4f, 1.0f };
         mDeviceContext->ClearRenderTargetView(mRenderTarget->GetBackBuffer(), clearCol);
         mDeviceContext->ClearDepthStencilView(mRenderTarget->mDepthStencilView->mDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
+        SetViewport(mRenderTarget->mWidth, mRenderTarget->mHeight);
+    }
+
+    void RenderDeviceD3D11::BeginDepthRenderTarget(RenderTarget* inTarget, int inLayer)
+    {
+        mRenderTarget = (RenderTargetD3D11*)inTarget;
+
+        mRenderTarget->BeginRendering();
+
+        // Unbind shader resources, in case the depth texture is still bound from the previous frame
+        ID3D11ShaderResourceView* nullResources[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {};
+        mDeviceContext->PSSetShaderResources(0, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, nullResources);
+        ResetTextureBindings();
+
+        ID3D11DepthStencilView* layerView = mRenderTarget->mDepthLayerViews[inLayer];
+        mDeviceContext->OMSetRenderTargets(0, nullptr, layerView);
+        mDeviceContext->ClearDepthStencilView(layerView, D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+        SetViewport(mRenderTarget->mWidth, mRenderTarget->mHeight);
+    }
+
+    void RenderDeviceD3D11::SetViewport(int inWidth, int inHeight)
+    {
+        D3D11_VIEWPORT viewport;
+        ZeroMemory(&viewport, sizeof(D3D11_VIEWPORT));
+        viewport.TopLeftX = 0;
+        viewport.TopLeftY = 0;
+        viewport.MinDepth = 0;
+        viewport.MaxDepth = 1;
+        viewport.Width = (float)inWidth;
+        viewport.Height = (float)inHeight;
+        mDeviceContext->RSSetViewports(1, &viewport);
     }
 
     void RenderDeviceD3D11::EndRenderTarget(RenderTarget* inTarget)
@@ -757,6 +995,68 @@ namespace Ming3D
         mRenderTarget = nullptr;
     }
 
+    ID3D11InputLayout* RenderDeviceD3D11::GetInputLayout(ShaderProgramD3D11* inProgram, const VertexLayout& inVertexLayout)
+    {
+        uint64_t layoutKey = 0;
+        for (size_t iComp = 0; iComp < inVertexLayout.VertexComponents.size(); iComp++)
+            layoutKey = (layoutKey << 6) | ((uint64_t)inVertexLayout.VertexComponents[iComp] << 3) | (uint64_t)inVertexLayout.GetComponentFormat(iComp);
+
+        auto layoutIter = inProgram->mInputLayouts.find(layoutKey);
+        if (layoutIter != inProgram->mInputLayouts.end())
+            return layoutIter->second;
+
+        // Indexed by EVertexComponent and element count
+        const char* vertCompNames[] = { "POSITION", "NORMAL", "TEXCOORD", "COLOR" };
+        const DXGI_FORMAT floatFormats[] = { DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT };
+        const DXGI_FORMAT halfFormats[] = { DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R16_FLOAT, DXGI_FORMAT_R16G16_FLOAT, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R16G16B16A16_FLOAT };
+        const DXGI_FORMAT snorm16Formats[] = { DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R16_SNORM, DXGI_FORMAT_R16G16_SNORM, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R16G16B16A16_SNORM };
+        const DXGI_FORMAT snorm8Formats[] = { DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R8_SNORM, DXGI_FORMAT_R8G8_SNORM, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R8G8B8A8_SNORM };
+
+        std::vector<D3D11_INPUT_ELEMENT_DESC> inputElements;
+        for (const EVertexComponent& vertexComp : inProgram->mVertexComponents)
+        {
+            size_t byteOffset = 0;
+            size_t iComp = 0;
+            for (; iComp < inVertexLayout.VertexComponents.size() && inVertexLayout.VertexComponents[iComp] != vertexComp; iComp++)
+                byteOffset += VertexData::GetVertexComponentSize(inVertexLayout.VertexComponents[iComp], inVertexLayout.GetComponentFormat(iComp));
+            if (iComp == inVertexLayout.VertexComponents.size())
+            {
+                LOG_ERROR() << "Vertex buffer is missing a vertex component used by the shader: " << vertCompNames[vertexComp];
+                continue;
+            }
+
+            const EVertexComponentFormat compFormat = inVertexLayout.GetComponentFormat(iComp);
+            const size_t numElements = VertexData::GetVertexComponentElementCount(vertexComp, compFormat);
+            DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+            switch (compFormat)
+            {
+            case EVertexComponentFormat::Float:
+                format = floatFormats[numElements];
+                break;
+            case EVertexComponentFormat::Half:
+                format = halfFormats[numElements];
+                break;
+            case EVertexComponentFormat::SNorm16:
+                format = snorm16Formats[numElements];
+                break;
+            case EVertexComponentFormat::SNorm8:
+                format = snorm8Formats[numElements];
+                break;
+            }
+
+            D3D11_INPUT_ELEMENT_DESC desc = { vertCompNames[vertexComp], 0, format, 0, (UINT)byteOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+            inputElements.push_back(desc);
+        }
+
+        ID3D11InputLayout* inputLayout = nullptr;
+        HRESULT result = mDevice->CreateInputLayout(inputElements.data(), inputElements.size(), inProgram->mVSBlob->GetBufferPointer(), inProgram->mVSBlob->GetBufferSize(), &inputLayout);
+        if (FAILED(result))
+            LOG_ERROR() << "Failed to create input layout";
+
+        inProgram->mInputLayouts.emplace(layoutKey, inputLayout);
+        return inputLayout;
+    }
+
     void RenderDeviceD3D11::RenderPrimitive(VertexBuffer* inVertexBuffer, IndexBuffer* inIndexBuffer)
     {
         ADD_FRAME_STAT_INT("RenderPrimitive", 1);
@@ -766,12 +1066,12 @@ namespace Ming3D
 
         ID3D11Buffer* vb = vertexBufferDX->GetD3DBuffer();
 
-        mDeviceContext->IASetInputLayout(mActiveShaderProgram->mInputLayout);
+        mDeviceContext->IASetInputLayout(GetInputLayout(mActiveShaderProgram, inVertexBuffer->GetVertexLayout()));
 
         UINT stride = inVertexBuffer->GetVertexSize();
         UINT offset = 0;
         mDeviceContext->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
-        mDeviceContext->IASetIndexBuffer(indexBufferDX->GetD3DBuffer(), DXGI_FORMAT_R32_UINT, 0);
+        mDeviceContext->IASetIndexBuffer(indexBufferDX->GetD3DBuffer(), inIndexBuffer->HasShortIndices() ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
         
         mDeviceContext->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
         
@@ -789,10 +1089,19 @@ namespace Ming3D
 
     void RenderDeviceD3D11::SetDepthStencilState(DepthStencilState* inState)
     {
-        DepthStencilStateD3D11* depthStencilState = (DepthStencilStateD3D11*)inState;
+        DepthStencilStateD3D11* depthStencilState = inState != nullptr ? (DepthStencilStateD3D11*)inState : mDefaultDepthStencilState;
         GetDeviceContext()->OMSetDepthStencilState(depthStencilState->mDepthStencilState, 1);
     }
 
+    void RenderDeviceD3D11::SetColourWriteEnabled(bool inEnabled)
+    {
+        __Assert(mRenderTarget != nullptr);
+
+        // Unbinding the render target view disables colour output while keeping the depth buffer bound
+        ID3D11RenderTargetView* renderTargetView = inEnabled ? mRenderTarget->mBackBuffer : nullptr;
+        mDeviceContext->OMSetRenderTargets(1, &renderTargetView, mRenderTarget->mDepthStencilView->mDepthStencilView);
+    }
+
     void RenderDeviceD3D11::SetConstantBufferData(ConstantBuffer* inConstantBuffer, void* inData, size_t inSize)
     {
         ConstantBufferD3D11* cbuffer = static_cast<ConstantBufferD3D11*>(inConstantBuffer);
@@ -852,12 +1161,44 @@ namespace Ming3D
 
             mDeviceContext->Unmap(cBuffer->mConstantBuffer, 0);
         }
-        else
+        else if (mActiveShaderProgram->mStrippedUniforms.find(inName) == mActiveShaderProgram->mStrippedUniforms.end())
         {
             LOG_ERROR() << "Could not find shader constant: " << inName;
         }
     }
 
+    void RenderDeviceD3D11::SetShaderUniformBlock(const void* inBlockData, size_t inOffset, size_t inSize)
+    {
+        __Assert(mActiveShaderProgram != nullptr);
+
+        const ConstantBufferD3D11* cBuffer = mActiveShaderProgram->mUniformCBuffer;
+        if (cBuffer == nullptr || inSize == 0)
+            return;
+
+        ADD_FRAME_STAT_INT("SetConstantBufferData", 1);
+
+        __Assert(inOffset + inSize <= cBuffer->mSize);
+        char* shaderConstData = (char*)cBuffer->mConstantData;
+        memcpy(shaderConstData + inOffset, (const char*)inBlockData + inOffset, inSize);
+
+        // Matrices are transposed, like in SetShaderUniformMat4x4
+        for (const ShaderUniformBlockMember& blockMember : mActiveShaderProgram->mUniformBlockLayout.mMembers)
+        {
+            if (blockMember.mDatatype == EShaderDatatype::Mat4x4 && blockMember.mOffset < inOffset + inSize && blockMember.mOffset + blockMember.mSize > inOffset)
+            {
+                glm::mat4 mat;
+                memcpy(&mat, (const char*)inBlockData + blockMember.mOffset, sizeof(mat));
+                mat = glm::transpose(mat);
+                memcpy(shaderConstData + blockMember.mOffset, &mat, sizeof(mat));
+            }
+        }
+
+        D3D11_MAPPED_SUBRESOURCE mappedResource;
+        mDeviceContext->Map(cBuffer->mConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+        memcpy(mappedResource.pData, shaderConstData, cBuffer->mSize);
+        mDeviceContext->Unmap(cBuffer->mConstantBuffer, 0);
+    }
+
     void RenderDeviceD3D11::SetShaderUniformFloat(const std::string& inName, float inVal)
     {
         SetUniformCBufferData(inName, &inVal, sizeof(inVal));
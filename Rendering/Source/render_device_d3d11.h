@@ -8,6 +8,7 @@
 #include "rasteriser_state_d3d11.h"
 #include "depth_stencil_state_d3d11.h"
 #include "shader_info.h"
+#include "shader_info_hlsl.h"
 
 #include <Windows.h>
 #include <windowsx.h>
@@ -16,6 +17,8 @@
 
 namespace Ming3D
 {
+    class TextureBufferD3D11;
+
     class RenderDeviceD3D11 : public RenderDevice
     {
     private:
@@ -25,41 +28,67 @@ namespace Ming3D
         RenderTargetD3D11* mRenderTarget = nullptr;
         RenderWindowD3D11* mRenderWindow = nullptr;
         ShaderProgramD3D11* mActiveShaderProgram = nullptr;
+        /** Shader resource views bound by SetTexture, per slot, to skip redundant binds. The context holds a reference to bound views, so they can't be reused while cached. */
+        ID3D11ShaderResourceView* mBoundTextures[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {};
 
         ID3D11SamplerState* mDefaultSamplerState;
+        ID3D11SamplerState* mShadowSamplerState;
         RasteriserStateD3D11* mDefaultRasteriserState;
         DepthStencilStateD3D11* mDefaultDepthStencilState;
 
-        void ApplyConstantPacking(const ShaderUniformInfo& inShaderUniform, size_t& outSize);
 
         void SetUniformCBufferData(const std::string& inName, const void* inData, size_t inSize);
 
         DepthStencilViewD3D11* CreateDepthStencilView(int inWidth, int inHeight);
+        void SetViewport(int inWidth, int inHeight);
+        /** Returns the input layout for drawing vertices of the given layout with the shader program (created on first use). */
+        ID3D11InputLayout* GetInputLayout(ShaderProgramD3D11* inProgram, const VertexLayout& inVertexLayout);
+
+        /** Compiles the regular and depth-only shaders of a program (or takes them from the disk cache). */
+        bool ConvertShaderProgram(ParsedShaderProgram* parsedProgram);
+        ShaderProgram* CreateShaderProgramFromBlobs(ParsedShaderProgram* parsedProgram, ConvertedShaderProgramHLSL* convertedProgram);
+        /** Creates the texture (with all mip levels) and shader resource view of a texture buffer. */
+        void CreateTexture(TextureBufferD3D11* textureBuffer, const TextureInfo& inTextureInfo, void* inTextureData);
+        static DXGI_FORMAT GetDXGIFormat(const TextureInfo& inTextureInfo);
+        /** Forgets the texture binding cache. Call when the runtime may have unbound shader resources (e.g. when binding render targets). */
+        void ResetTextureBindings();
 
     public:
+        /** Sampler slot of the comparison sampler used for shadow maps (declared as "shadowSampler" by ShaderWriterHLSL). */
+        static constexpr UINT ShadowSamplerSlot = 15;
+
         RenderDeviceD3D11();
         virtual ~RenderDeviceD3D11();
 
         virtual RenderTarget* CreateRenderTarget(RenderWindow* inWindow) override;
         virtual RenderTarget* CreateRenderTarget(TextureInfo inTextureInfo, int numTextures) override;
+        virtual RenderTarget* CreateDepthRenderTarget(TextureInfo inTextureInfo, int inNumLayers) override;
         virtual VertexBuffer* CreateVertexBuffer(VertexData* inVertexData) override;
         virtual IndexBuffer* CreateIndexBuffer(IndexData* inIndexData) override;
         virtual ShaderProgram* CreateShaderProgram(ParsedShaderProgram* parsedProgram) override;
+        virtual ShaderProgram* CreateDepthOnlyShaderProgram(ParsedShaderProgram* parsedProgram) override;
         virtual TextureBuffer* CreateTextureBuffer(TextureInfo inTextureInfo, void* inTextureData) override;
+        virtual void UpdateTextureBuffer(TextureBuffer* inTextureBuffer, TextureInfo inTextureInfo, void* inTextureData) override;
+        virtual TextureBuffer* CreateTexelBuffer(size_t inNumElements) override;
+        virtual TextureBuffer* CreateTextureArrayBuffer(TextureInfo inTextureInfo, unsigned int inNumLayers) override;
+        virtual void UpdateTextureArrayLayer(TextureBuffer* inTextureArray, unsigned int inLayer, TextureInfo inTextureInfo, void* inTextureData) override;
         virtual RenderWindow* CreateRenderWindow(WindowBase* inWindow) override;
         virtual RasteriserState* CreateRasteriserState(RasteriserStateCullMode inCullMode, bool inDepthClipEnabled) override;
         virtual DepthStencilState* CreateDepthStencilState(DepthStencilStateDesc inDesc) override;
         virtual ConstantBuffer* CreateConstantBuffer(size_t inSize) override;
 
         virtual void SetTexture(const TextureBuffer* inTexture, int inSlot) override;
+        virtual void UpdateTexelBuffer(TextureBuffer* inBuffer, const void* inData, size_t inNumElements) override;
         virtual void SetActiveShaderProgram(ShaderProgram* inProgram) override;
         virtual void BeginRenderWindow(RenderWindow* inWindow) override;
         virtual void EndRenderWindow(RenderWindow* inWindow) override;
         virtual void BeginRenderTarget(RenderTarget* inTarget) override;
+        virtual void BeginDepthRenderTarget(RenderTarget* inTarget, int inLayer) override;
         virtual void EndRenderTarget(RenderTarget* inTarget) override;
         virtual void RenderPrimitive(VertexBuffer* inVertexBuffer, IndexBuffer* inIndexBuffer) override;
         virtual void SetRasteriserState(RasteriserState* inState) override;
         virtual void SetDepthStencilState(DepthStencilState* inState) override;
+        virtual void SetColourWriteEnabled(bool inEnabled) override;
         virtual void SetConstantBufferData(ConstantBuffer* inConstantBuffer, void* inData, size_t inSize) override;
         virtual void BindConstantBuffer(ConstantBuffer* inConstantBuffer, const char* inName, ShaderProgram* inProgram) override;
 
@@ -69,6 +98,7 @@ namespace Ming3D
         virtual void SetShaderUniformVec2(const std::string& inName, const glm::vec2 inVec) override;
         virtual void SetShaderUniformVec3(const std::string& inName, const glm::vec3 inVec) override;
         virtual void SetShaderUniformVec4(const std::string& inName, const glm::vec4 inVec) override;
+        virtual void SetShaderUniformBlock(const void* inBlockData, size_t inOffset, size_t inSize) override;
 
         ID3D11Device* GetDevice() { return mDevice; }
         ID3D11DeviceContext* GetDeviceContext() { return mDeviceContext; }
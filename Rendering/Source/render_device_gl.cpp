@@ -6,13 +6,18 @@
 #include "render_target_gl.h"
 #include "shader_program_gl.h"
 #include "texture_buffer_gl.h"
+#include "texture_processor.h"
 #include "constant_buffer_gl.h"
 
 #include "Debug/debug.h"
 #include "Debug/st_assert.h"
-#include "shader_writer_glsl.h"
+#include "shader_converter.h"
+#include "shader_disk_cache.h"
 #include "Debug/debug_stats.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace Ming3D
 {
     RenderDeviceGL::RenderDeviceGL()
@@ -27,6 +32,18 @@ namespace Ming3D
             LOG_ERROR() << "Failed to initialise GLEW";
         }
 
+        // Program binaries are only reused with the same driver
+        const GLubyte* version = glGetString(GL_VERSION);
+        for (const GLubyte* driverString : { vendor, renderer, version })
+        {
+            if (driverString != nullptr)
+                mDriverHash = ShaderDiskCache::HashData(driverString, strlen((const char*)driverString), mDriverHash);
+        }
+        GLint numProgramBinaryFormats = 0;
+        if (GLEW_ARB_get_program_binary)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numProgramBinaryFormats);
+        mProgramBinarySupported = numProgramBinaryFormats > 0;
+
         mDefaultRasteriserState = (RasteriserStateGL*)CreateRasteriserState(RasteriserStateCullMode::Back, true);
         
         DepthStencilStateDesc dssDesc;
@@ -83,8 +100,11 @@ namespace Ming3D
             colourBuffer->SetGLTexture(renderTexture);
             renderTarget->mColourBuffers.push_back(colourBuffer);
         }
+        ResetTextureBindings();
 
         renderTarget->mFrameBufferID = FramebufferName;
+        renderTarget->mWidth = inTextureInfo.mWidth;
+        renderTarget->mHeight = inTextureInfo.mHeight;
 
         GLuint depthrenderbuffer;
         glGenRenderbuffers(1, &depthrenderbuffer);
@@ -99,6 +119,47 @@ namespace Ming3D
         return renderTarget;
     }
 
+    RenderTarget* RenderDeviceGL::CreateDepthRenderTarget(TextureInfo inTextureInfo, int inNumLayers)
+    {
+        RenderTargetGL* renderTarget = new RenderTargetGL();
+
+        GLuint frameBuffer = 0;
+        glGenFramebuffers(1, &frameBuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+
+        GLuint depthTexture;
+        glGenTextures(1, &depthTexture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT32F, inTextureInfo.mWidth, inTextureInfo.mHeight, inNumLayers);
+
+        // Hardware depth comparison, with bilinear filtering of the results
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+
+        TextureBufferGL* depthBuffer = new TextureBufferGL();
+        depthBuffer->SetGLTexture(depthTexture);
+        depthBuffer->SetGLTarget(GL_TEXTURE_2D_ARRAY);
+
+        renderTarget->mFrameBufferID = frameBuffer;
+        renderTarget->mDepthRenderBuffer = depthBuffer;
+        renderTarget->mWidth = inTextureInfo.mWidth;
+        renderTarget->mHeight = inTextureInfo.mHeight;
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        ResetTextureBindings();
+
+        return renderTarget;
+    }
+
     VertexBuffer* RenderDeviceGL::CreateVertexBuffer(VertexData* inVertexData)
     {
         VertexBufferGL* vertexBuffer = new VertexBufferGL();
@@ -117,29 +178,106 @@ namespace Ming3D
         GLuint ibo;
         glGenBuffers(1, &ibo);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, inIndexData->GetNumIndices() * sizeof(unsigned int), inIndexData->GetData(), GL_STATIC_DRAW);
+        if (inIndexData->UseShortIndices())
+        {
+            std::vector<unsigned short> shortIndices;
+            inIndexData->GetShortIndices(shortIndices);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(unsigned short), shortIndices.data(), GL_STATIC_DRAW);
+            indexBuffer->SetShortIndices(true);
+        }
+        else
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, inIndexData->GetNumIndices() * sizeof(unsigned int), inIndexData->GetData(), GL_STATIC_DRAW);
         indexBuffer->SetGLBuffer(ibo);
         indexBuffer->SetNumIndices(inIndexData->GetNumIndices());
         return indexBuffer;
     }
 
+    bool RenderDeviceGL::ConvertShaderProgram(ParsedShaderProgram* parsedProgram)
+    {
+        if (parsedProgram->mConvertedProgram != nullptr && parsedProgram->mConvertedDepthOnlyProgram != nullptr)
+            return true;
+
+        // Vertex and fragment shader, followed by the depth-only vertex and fragment shader.
+        // Both variants are converted together, so the disk cache gets complete entries.
+        std::vector<std::string> shaderSources = parsedProgram->mCachedShaders;
+        if (shaderSources.empty())
+        {
+            if (!ShaderConverter::ConvertProgram(parsedProgram, shaderSources))
+                return false;
+            ShaderDiskCache::SaveProgram(parsedProgram, shaderSources);
+        }
+        else if (shaderSources.size() != 4)
+        {
+            LOG_ERROR() << "Invalid cached shader program: " << parsedProgram->mProgramPath;
+            return false;
+        }
+
+        ConvertedShaderProgramGLSL* convertedProgram = new ConvertedShaderProgramGLSL();
+        convertedProgram->mShaderProgramData.mVertexShader.mSource = shaderSources[0];
+        convertedProgram->mShaderProgramData.mFragmentShader.mSource = shaderSources[1];
+        ConvertedShaderProgramGLSL* convertedDepthOnlyProgram = new ConvertedShaderProgramGLSL();
+        convertedDepthOnlyProgram->mShaderProgramData.mVertexShader.mSource = shaderSources[2];
+        convertedDepthOnlyProgram->mShaderProgramData.mFragmentShader.mSource = shaderSources[3];
+
+        delete parsedProgram->mConvertedProgram;
+        delete parsedProgram->mConvertedDepthOnlyProgram;
+        parsedProgram->mConvertedProgram = convertedProgram;
+        parsedProgram->mConvertedDepthOnlyProgram = convertedDepthOnlyProgram;
+        parsedProgram->mCachedShaders.clear();
+        return true;
+    }
+
     ShaderProgram* RenderDeviceGL::CreateShaderProgram(ParsedShaderProgram* parsedProgram)
     {
-        ShaderWriterGLSL shaderWriter;
+        if (!ConvertShaderProgram(parsedProgram))
+            return nullptr;
 
         ConvertedShaderProgramGLSL* convertedProgram = static_cast<ConvertedShaderProgramGLSL*>(parsedProgram->mConvertedProgram);
-        if (convertedProgram == nullptr)
+        const std::string binaryPath = parsedProgram->mDiskCachePath.empty() ? "" : parsedProgram->mDiskCachePath + ".cglbin";
+        ShaderProgramGL* shaderProgram = CreateShaderProgramFromSource(convertedProgram->mShaderProgramData, binaryPath);
+        shaderProgram->SetUniformBlockLayout(parsedProgram);
+        shaderProgram->SetConstantBufferSlots(parsedProgram);
+        return shaderProgram;
+    }
+
+    ShaderProgram* RenderDeviceGL::CreateDepthOnlyShaderProgram(ParsedShaderProgram* parsedProgram)
+    {
+        if (!ConvertShaderProgram(parsedProgram))
+            return nullptr;
+
+        ConvertedShaderProgramGLSL* convertedProgram = static_cast<ConvertedShaderProgramGLSL*>(parsedProgram->mConvertedDepthOnlyProgram);
+        const std::string binaryPath = parsedProgram->mDiskCachePath.empty() ? "" : parsedProgram->mDiskCachePath + ".depth.cglbin";
+        ShaderProgramGL* shaderProgram = CreateShaderProgramFromSource(convertedProgram->mShaderProgramData, binaryPath);
+        shaderProgram->SetUniformBlockLayout(parsedProgram);
+        shaderProgram->SetConstantBufferSlots(parsedProgram);
+        return shaderProgram;
+    }
+
+    ShaderProgramGL* RenderDeviceGL::CreateShaderProgramFromSource(const ShaderProgramDataGLSL& convertedShaderData, const std::string& inBinaryPath)
+    {
+        // Program binaries are keyed by the shader source and the driver, and are rejected by the driver if they are no longer compatible
+        const std::string& vertexSource = convertedShaderData.mVertexShader.mSource;
+        const std::string& fragmentSource = convertedShaderData.mFragmentShader.mSource;
+        const bool useProgramBinary = mProgramBinarySupported && !inBinaryPath.empty() && ShaderDiskCache::IsEnabled();
+        const uint64_t binaryKey = ShaderDiskCache::HashData(fragmentSource.data(), fragmentSource.size(), ShaderDiskCache::HashData(vertexSource.data(), vertexSource.size(), mDriverHash));
+        std::string programBinary;
+        if (useProgramBinary && ShaderDiskCache::LoadBinary(inBinaryPath, binaryKey, programBinary) && programBinary.size() > sizeof(GLenum))
         {
-            ShaderProgramDataGLSL convertedShaderData;
-            if (!shaderWriter.WriteShader(parsedProgram, convertedShaderData))
-                return nullptr;
-            convertedProgram = new ConvertedShaderProgramGLSL();
-            convertedProgram->mShaderProgramData = convertedShaderData;
-            parsedProgram->mConvertedProgram = convertedProgram;
+            GLenum binaryFormat;
+            memcpy(&binaryFormat, programBinary.data(), sizeof(binaryFormat));
+            GLuint program = glCreateProgram();
+            glProgramBinary(program, binaryFormat, programBinary.data() + sizeof(binaryFormat), (GLsizei)(programBinary.size() - sizeof(binaryFormat)));
+            GLint linkStatus = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+            if (linkStatus == GL_TRUE)
+            {
+                ShaderProgramGL* shaderProgram = new ShaderProgramGL();
+                shaderProgram->SetGLProgram(program);
+                return shaderProgram;
+            }
+            glDeleteProgram(program);
         }
 
-        ShaderProgramDataGLSL convertedShaderData = convertedProgram->mShaderProgramData;
-
         GLuint program = glCreateProgram();
         GLuint vs = glCreateShader(GL_VERTEX_SHADER);
         GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
@@ -154,6 +292,8 @@ namespace Ming3D
         glCompileShader(fs);
         glAttachShader(program, vs);
         glAttachShader(program, fs);
+        if (useProgramBinary)
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
         glLinkProgram(program);
 
         int vstatus, fstatus, lstatus;
@@ -182,6 +322,20 @@ namespace Ming3D
             glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
             LOG_ERROR() << "Error linking shader program: " << std::string(infoLog);
         }
+        else if (useProgramBinary)
+        {
+            GLint binaryLength = 0;
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+            if (binaryLength > 0)
+            {
+                // Binary format, followed by the binary
+                programBinary.resize(sizeof(GLenum) + binaryLength);
+                GLenum binaryFormat;
+                glGetProgramBinary(program, binaryLength, nullptr, &binaryFormat, &programBinary[sizeof(GLenum)]);
+                memcpy(&programBinary[0], &binaryFormat, sizeof(binaryFormat));
+                ShaderDiskCache::SaveBinary(inBinaryPath, binaryKey, programBinary.data(), programBinary.size());
+            }
+        }
 
         ShaderProgramGL* shaderProgram = new ShaderProgramGL();
         shaderProgram->SetGLProgram(program);
@@ -191,47 +345,147 @@ namespace Ming3D
         return shaderProgram;
     }
 
-    TextureBuffer* RenderDeviceGL::CreateTextureBuffer(TextureInfo inTextureInfo, void* inTextureData)
+    void RenderDeviceGL::GetGLTextureFormat(const TextureInfo& inTextureInfo, GLint& outInternalFormat, GLenum& outPixelFormat)
     {
-        ADD_DEBUG_STAT_INT("CreateTextureBuffer", 1);
+        if (inTextureInfo.mPixelFormat == PixelFormat::RGB)
+            outPixelFormat = GL_RGB;
+        else if (inTextureInfo.mPixelFormat == PixelFormat::BGRA)
+            outPixelFormat = GL_BGRA;
+        else
+            outPixelFormat = GL_RGBA;
 
-        TextureBufferGL* textureBuffer = new TextureBufferGL();
+        if (inTextureInfo.mPixelFormat == PixelFormat::BC1)
+            outInternalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        else if (inTextureInfo.mPixelFormat == PixelFormat::BC3)
+            outInternalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        else
+            outInternalFormat = (inTextureInfo.mPixelFormat == PixelFormat::RGB) ? GL_RGB : GL_RGBA;
+    }
 
+    GLuint RenderDeviceGL::CreateGLTexture(const TextureInfo& inTextureInfo, void* inTextureData)
+    {
         __Assert(inTextureData); // TODO: Clear if null
-        
-        char* buffer = new char[inTextureInfo.mWidth * inTextureInfo.mHeight * inTextureInfo.mBytesPerPixel];
-        // Flip the texture
-        for (size_t i = 0; i < inTextureInfo.mHeight; i++)
-        {
-            const size_t rowSize = inTextureInfo.mWidth * inTextureInfo.mBytesPerPixel;
-            memcpy(buffer + (rowSize * (inTextureInfo.mHeight - 1)) - (rowSize * i), (char*)inTextureData + rowSize * i, rowSize);
-        }
 
         GLuint glTexture;
         glGenTextures(1, &glTexture);
         glBindTexture(GL_TEXTURE_2D, glTexture);
+        ResetTextureBindings();
 
-        GLint pixelFormat;
-        if (inTextureInfo.mPixelFormat == PixelFormat::RGB)
-            pixelFormat = GL_RGB;
-        else if (inTextureInfo.mPixelFormat == PixelFormat::BGRA)
-            pixelFormat = GL_BGRA;
-        else
-            pixelFormat = GL_RGBA;
-        GLint internalFormat = (inTextureInfo.mPixelFormat == PixelFormat::RGB) ? GL_RGB : GL_RGBA;
+        GLint internalFormat;
+        GLenum pixelFormat;
+        GetGLTextureFormat(inTextureInfo, internalFormat, pixelFormat);
 
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, inTextureInfo.mWidth, inTextureInfo.mHeight, 0, pixelFormat, GL_UNSIGNED_BYTE, buffer);
+        char* buffer = new char[inTextureInfo.GetMipLevelSize(0)];
+        for (unsigned int iLevel = 0; iLevel < inTextureInfo.mMipLevels; iLevel++)
+        {
+            // Flip the texture
+            TextureProcessor::FlipMipLevel(inTextureInfo, iLevel, (char*)inTextureData + inTextureInfo.GetMipLevelOffset(iLevel), buffer);
+
+            const GLsizei width = inTextureInfo.GetMipWidth(iLevel);
+            const GLsizei height = inTextureInfo.GetMipHeight(iLevel);
+            if (inTextureInfo.IsCompressed())
+                glCompressedTexImage2D(GL_TEXTURE_2D, iLevel, internalFormat, width, height, 0, (GLsizei)inTextureInfo.GetMipLevelSize(iLevel), buffer);
+            else
+                glTexImage2D(GL_TEXTURE_2D, iLevel, internalFormat, width, height, 0, pixelFormat, GL_UNSIGNED_BYTE, buffer);
+        }
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, inTextureInfo.mMipLevels - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, inTextureInfo.mMipLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+        delete[] buffer;
+
+        return glTexture;
+    }
+
+    TextureBuffer* RenderDeviceGL::CreateTextureBuffer(TextureInfo inTextureInfo, void* inTextureData)
+    {
+        ADD_DEBUG_STAT_INT("CreateTextureBuffer", 1);
+
+        TextureBufferGL* textureBuffer = new TextureBufferGL();
+        textureBuffer->SetGLTexture(CreateGLTexture(inTextureInfo, inTextureData));
+        return textureBuffer;
+    }
+
+    void RenderDeviceGL::UpdateTextureBuffer(TextureBuffer* inTextureBuffer, TextureInfo inTextureInfo, void* inTextureData)
+    {
+        ADD_DEBUG_STAT_INT("UpdateTextureBuffer", 1);
+
+        TextureBufferGL* textureBuffer = static_cast<TextureBufferGL*>(inTextureBuffer);
+        GLuint oldTexture = textureBuffer->GetGLTexture();
+        glDeleteTextures(1, &oldTexture);
+        textureBuffer->SetGLTexture(CreateGLTexture(inTextureInfo, inTextureData));
+    }
+
+    TextureBuffer* RenderDeviceGL::CreateTextureArrayBuffer(TextureInfo inTextureInfo, unsigned int inNumLayers)
+    {
+        ADD_DEBUG_STAT_INT("CreateTextureBuffer", 1);
+
+        GLint internalFormat;
+        GLenum pixelFormat;
+        GetGLTextureFormat(inTextureInfo, internalFormat, pixelFormat);
+
+        GLuint glTexture;
+        glGenTextures(1, &glTexture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, glTexture);
+        ResetTextureBindings();
+
+        // Allocate all layers (uploaded later, by UpdateTextureArrayLayer)
+        for (unsigned int iLevel = 0; iLevel < inTextureInfo.mMipLevels; iLevel++)
+        {
+            const GLsizei width = inTextureInfo.GetMipWidth(iLevel);
+            const GLsizei height = inTextureInfo.GetMipHeight(iLevel);
+            if (inTextureInfo.IsCompressed())
+                glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, iLevel, internalFormat, width, height, inNumLayers, 0, (GLsizei)(inTextureInfo.GetMipLevelSize(iLevel) * inNumLayers), nullptr);
+            else
+                glTexImage3D(GL_TEXTURE_2D_ARRAY, iLevel, internalFormat, width, height, inNumLayers, 0, pixelFormat, GL_UNSIGNED_BYTE, nullptr);
+        }
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, inTextureInfo.mMipLevels - 1);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, inTextureInfo.mMipLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        TextureBufferGL* textureBuffer = new TextureBufferGL();
         textureBuffer->SetGLTexture(glTexture);
+        textureBuffer->SetGLTarget(GL_TEXTURE_2D_ARRAY);
+        return textureBuffer;
+    }
+
+    void RenderDeviceGL::UpdateTextureArrayLayer(TextureBuffer* inTextureArray, unsigned int inLayer, TextureInfo inTextureInfo, void* inTextureData)
+    {
+        ADD_DEBUG_STAT_INT("UpdateTextureBuffer", 1);
 
+        TextureBufferGL* textureBuffer = static_cast<TextureBufferGL*>(inTextureArray);
+        __Assert(textureBuffer->GetGLTarget() == GL_TEXTURE_2D_ARRAY);
+
+        GLint internalFormat;
+        GLenum pixelFormat;
+        GetGLTextureFormat(inTextureInfo, internalFormat, pixelFormat);
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, textureBuffer->GetGLTexture());
+        ResetTextureBindings();
+
+        char* buffer = new char[inTextureInfo.GetMipLevelSize(0)];
+        for (unsigned int iLevel = 0; iLevel < inTextureInfo.mMipLevels; iLevel++)
+        {
+            // Flipped, like the textures created by CreateGLTexture
+            TextureProcessor::FlipMipLevel(inTextureInfo, iLevel, (char*)inTextureData + inTextureInfo.GetMipLevelOffset(iLevel), buffer);
+
+            const GLsizei width = inTextureInfo.GetMipWidth(iLevel);
+            const GLsizei height = inTextureInfo.GetMipHeight(iLevel);
+            if (inTextureInfo.IsCompressed())
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, iLevel, 0, 0, inLayer, width, height, 1, internalFormat, (GLsizei)inTextureInfo.GetMipLevelSize(iLevel), buffer);
+            else
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, iLevel, 0, 0, inLayer, width, height, 1, pixelFormat, GL_UNSIGNED_BYTE, buffer);
+        }
         delete[] buffer;
 
-        return textureBuffer;
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
     }
 
     RenderWindow* RenderDeviceGL::CreateRenderWindow(WindowBase* inWindow)
@@ -270,10 +524,35 @@ namespace Ming3D
             depthStencilState->mDepthFunc = GL_GREATER;
             break;
         }
-        // TODO: enable/disable depth?
+        depthStencilState->mDepthEnabled = inDesc.mDepthEnabled;
+        depthStencilState->mDepthWriteEnabled = inDesc.mDepthWriteEnabled ? GL_TRUE : GL_FALSE;
         return depthStencilState;
     }
 
+    TextureBuffer* RenderDeviceGL::CreateTexelBuffer(size_t inNumElements)
+    {
+        TextureBufferGL* textureBuffer = new TextureBufferGL();
+
+        GLuint glBuffer;
+        glGenBuffers(1, &glBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, glBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, inNumElements * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+
+        GLuint glTexture;
+        glGenTextures(1, &glTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, glTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, glBuffer);
+
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        ResetTextureBindings();
+
+        textureBuffer->SetGLTexture(glTexture);
+        textureBuffer->SetGLTarget(GL_TEXTURE_BUFFER);
+        textureBuffer->SetGLBuffer(glBuffer);
+        return textureBuffer;
+    }
+
     ConstantBuffer* RenderDeviceGL::CreateConstantBuffer(size_t inSize)
     {
         ConstantBufferGL* cb = new ConstantBufferGL();
@@ -290,14 +569,44 @@ namespace Ming3D
         return cb;
     }
 
+    void RenderDeviceGL::ResetTextureBindings()
+    {
+        std::fill(mBoundTextures.begin(), mBoundTextures.end(), 0);
+        mActiveTextureUnit = -1;
+    }
+
     void RenderDeviceGL::SetTexture(const TextureBuffer* inTexture, int inSlot)
     {
         ADD_FRAME_STAT_INT("SetTexture", 1);
 
-        glEnable(GL_TEXTURE_2D); // TODO
         TextureBufferGL* glTexture = (TextureBufferGL*)inTexture;
-        glActiveTexture(GL_TEXTURE0 + inSlot);
-        glBindTexture(GL_TEXTURE_2D, glTexture->GetGLTexture());
+        const GLuint textureName = glTexture->GetGLTexture();
+        if (inSlot >= (int)mBoundTextures.size())
+            mBoundTextures.resize(inSlot + 1, 0);
+        else if (textureName != 0 && mBoundTextures[inSlot] == textureName)
+        {
+            ADD_FRAME_STAT_INT("SetTexture.Skipped", 1);
+            return;
+        }
+
+        glEnable(GL_TEXTURE_2D); // TODO
+        if (mActiveTextureUnit != inSlot)
+        {
+            glActiveTexture(GL_TEXTURE0 + inSlot);
+            mActiveTextureUnit = inSlot;
+        }
+        glBindTexture(glTexture->GetGLTarget(), textureName);
+        mBoundTextures[inSlot] = textureName;
+    }
+
+    void RenderDeviceGL::UpdateTexelBuffer(TextureBuffer* inBuffer, const void* inData, size_t inNumElements)
+    {
+        TextureBufferGL* glTexture = (TextureBufferGL*)inBuffer;
+        __Assert(glTexture->GetGLTarget() == GL_TEXTURE_BUFFER);
+
+        glBindBuffer(GL_TEXTURE_BUFFER, glTexture->GetGLBuffer());
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, inNumElements * sizeof(glm::vec4), inData);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
     }
 
     void RenderDeviceGL::SetActiveShaderProgram(ShaderProgram* inProgram)
@@ -308,6 +617,13 @@ namespace Ming3D
         if (mActiveShaderProgram != nullptr)
         {
             glUseProgram(mActiveShaderProgram->GetGLProgram());
+
+            const std::vector<GLuint>& constantBuffers = mActiveShaderProgram->GetBoundConstantBuffers();
+            for (GLuint iSlot = 0; iSlot < (GLuint)constantBuffers.size(); iSlot++)
+            {
+                if (constantBuffers[iSlot] != 0)
+                    glBindBufferBase(GL_UNIFORM_BUFFER, iSlot, constantBuffers[iSlot]);
+            }
         }
     }
 
@@ -332,6 +648,7 @@ namespace Ming3D
 
         glBindFramebuffer(GL_FRAMEBUFFER, mRenderTarget->mFrameBufferID);
         glDrawBuffers(1, mRenderTarget->mAttachments.data());
+        glViewport(0, 0, mRenderTarget->mWidth, mRenderTarget->mHeight);
 
         glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
@@ -343,6 +660,17 @@ namespace Ming3D
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
 
+    void RenderDeviceGL::BeginDepthRenderTarget(RenderTarget* inTarget, int inLayer)
+    {
+        mRenderTarget = (RenderTargetGL*)inTarget;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, mRenderTarget->mFrameBufferID);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mRenderTarget->mDepthRenderBuffer->GetGLTexture(), 0, inLayer);
+        glViewport(0, 0, mRenderTarget->mWidth, mRenderTarget->mHeight);
+
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
     void RenderDeviceGL::EndRenderTarget(RenderTarget* inTarget)
     {
         __Assert(mRenderTarget == inTarget);
@@ -377,20 +705,36 @@ namespace Ming3D
         VertexBufferGL* vertexBufferGL = (VertexBufferGL*)inVertexBuffer;
         IndexBufferGL* indexBufferGL = (IndexBufferGL*)inIndexBuffer;
         
-        size_t vertexComponentIndex = 0;
+        const VertexLayout& vertexLayout = inVertexBuffer->GetVertexLayout();
         size_t vertexComponentOffset = 0;
-        for (EVertexComponent vertexComponent : inVertexBuffer->GetVertexLayout().VertexComponents)
+        for (size_t vertexComponentIndex = 0; vertexComponentIndex < vertexLayout.VertexComponents.size(); vertexComponentIndex++)
         {
-            const size_t vertexComponentSize = VertexData::GetVertexComponentSize(vertexComponent);
+            const EVertexComponent vertexComponent = vertexLayout.VertexComponents[vertexComponentIndex];
+            const EVertexComponentFormat vertexComponentFormat = vertexLayout.GetComponentFormat(vertexComponentIndex);
+            const GLint numElements = (GLint)VertexData::GetVertexComponentElementCount(vertexComponent, vertexComponentFormat);
+            const size_t vertexComponentSize = VertexData::GetVertexComponentSize(vertexComponent, vertexComponentFormat);
             glEnableVertexAttribArray(vertexComponentIndex);
             glBindBuffer(GL_ARRAY_BUFFER, vertexBufferGL->GetGLBuffer());
-            glVertexAttribPointer(vertexComponentIndex, VertexData::GetVertexComponentSize(vertexComponent) / sizeof(float), GL_FLOAT, GL_FALSE, vertexBufferGL->GetVertexSize(), (void*)vertexComponentOffset);
-            vertexComponentIndex++;
+            switch (vertexComponentFormat)
+            {
+            case EVertexComponentFormat::Float:
+                glVertexAttribPointer(vertexComponentIndex, numElements, GL_FLOAT, GL_FALSE, vertexBufferGL->GetVertexSize(), (void*)vertexComponentOffset);
+                break;
+            case EVertexComponentFormat::Half:
+                glVertexAttribPointer(vertexComponentIndex, numElements, GL_HALF_FLOAT, GL_FALSE, vertexBufferGL->GetVertexSize(), (void*)vertexComponentOffset);
+                break;
+            case EVertexComponentFormat::SNorm16:
+                glVertexAttribPointer(vertexComponentIndex, numElements, GL_SHORT, GL_TRUE, vertexBufferGL->GetVertexSize(), (void*)vertexComponentOffset);
+                break;
+            case EVertexComponentFormat::SNorm8:
+                glVertexAttribPointer(vertexComponentIndex, numElements, GL_BYTE, GL_TRUE, vertexBufferGL->GetVertexSize(), (void*)vertexComponentOffset);
+                break;
+            }
             vertexComponentOffset += vertexComponentSize;
         }
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferGL->GetGLBuffer());
-        glDrawElements(GL_TRIANGLES, indexBufferGL->GetNumIndices(), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, indexBufferGL->GetNumIndices(), indexBufferGL->HasShortIndices() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, 0);
     }
 
     void RenderDeviceGL::SetRasteriserState(RasteriserState* inState)
@@ -414,11 +758,20 @@ namespace Ming3D
 
     void RenderDeviceGL::SetDepthStencilState(DepthStencilState* inState)
     {
-        DepthStencilStateGL* glStencilState = (DepthStencilStateGL*)inState;
-        mDefaultDepthStencilState = glStencilState;
+        DepthStencilStateGL* glStencilState = inState != nullptr ? (DepthStencilStateGL*)inState : mDefaultDepthStencilState;
 
-        glEnable(GL_DEPTH_TEST);
+        if (glStencilState->mDepthEnabled)
+            glEnable(GL_DEPTH_TEST);
+        else
+            glDisable(GL_DEPTH_TEST);
         glDepthFunc(glStencilState->mDepthFunc);
+        glDepthMask(glStencilState->mDepthWriteEnabled);
+    }
+
+    void RenderDeviceGL::SetColourWriteEnabled(bool inEnabled)
+    {
+        const GLboolean mask = inEnabled ? GL_TRUE : GL_FALSE;
+        glColorMask(mask, mask, mask, mask);
     }
 
     void RenderDeviceGL::SetConstantBufferData(ConstantBuffer* inConstantBuffer, void* inData, size_t inSize)
@@ -436,10 +789,16 @@ namespace Ming3D
         ConstantBufferGL* cb = static_cast<ConstantBufferGL*>(inConstantBuffer);
         ShaderProgramGL* prog = static_cast<ShaderProgramGL*>(inProgram);
 
-        // get index
-        unsigned int block_index = glGetUniformBlockIndex(prog->GetGLProgram(), inName);
-        // bind UBO to shader program
-        glBindBufferBase(GL_UNIFORM_BUFFER, block_index, cb->mGLBuffer);
+        // Binding points are per program (see ShaderProgramGL::SetConstantBufferSlots), so the buffers are bound when the program is activated
+        GLuint slot;
+        if (!prog->GetConstantBufferSlot(inName, slot))
+        {
+            LOG_ERROR() << "Constant buffer does not exist: " << inName;
+            return;
+        }
+        prog->SetBoundConstantBuffer(slot, cb->mGLBuffer);
+        if (mActiveShaderProgram == prog)
+            glBindBufferBase(GL_UNIFORM_BUFFER, slot, cb->mGLBuffer);
     }
 
     void RenderDeviceGL::SetShaderUniformFloat(const std::string& inName, float inVal)
@@ -489,5 +848,48 @@ namespace Ming3D
         GLuint loc = mActiveShaderProgram->GetUniformLocation(inName);
         glUniform4fv(loc, 1, (float*)&inVec[0]);
     }
+
+    void RenderDeviceGL::SetShaderUniformBlock(const void* inBlockData, size_t inOffset, size_t inSize)
+    {
+        ADD_FRAME_STAT_INT("SetConstantBufferData", 1);
+
+        // The uniforms aren't in a uniform buffer, so set the ones in the range
+        for (const ShaderUniformGL& uniform : mActiveShaderProgram->GetUniformBlock())
+        {
+            const ShaderUniformBlockMember& blockMember = uniform.mBlockMember;
+            if (uniform.mLocation == -1 || blockMember.mOffset >= inOffset + inSize || blockMember.mOffset + blockMember.mSize <= inOffset)
+                continue;
+
+            const void* data = (const char*)inBlockData + blockMember.mOffset;
+            switch (blockMember.mDatatype)
+            {
+            case EShaderDatatype::Float:
+                glUniform1fv(uniform.mLocation, 1, (const GLfloat*)data);
+                break;
+            case EShaderDatatype::Int:
+                glUniform1iv(uniform.mLocation, 1, (const GLint*)data);
+                break;
+            case EShaderDatatype::Bool:
+                glUniform1i(uniform.mLocation, *(const bool*)data ? 1 : 0); // stored as a C++ bool (see ShaderDatatypeInfo::GetDataSize)
+                break;
+            case EShaderDatatype::Vec2:
+                glUniform2fv(uniform.mLocation, 1, (const GLfloat*)data);
+                break;
+            case EShaderDatatype::Vec3:
+                glUniform3fv(uniform.mLocation, 1, (const GLfloat*)data);
+                break;
+            case EShaderDatatype::Vec4:
+                glUniform4fv(uniform.mLocation, 1, (const GLfloat*)data);
+                break;
+            case EShaderDatatype::Mat4x4:
+                glUniformMatrix4fv(uniform.mLocation, 1, GL_FALSE, (const GLfloat*)data);
+                break;
+            default:
+                // Struct uniforms have no location of their own, and other types can't be in the block
+                __AssertComment(false, "Unsupported uniform type in uniform block");
+                break;
+            }
+        }
+    }
 }
 #endif
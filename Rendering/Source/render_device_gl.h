@@ -9,6 +9,9 @@
 #include "render_window_gl.h"
 #include "rasteriser_state_gl.h"
 #include "depth_stencil_state_gl.h"
+#include "shader_info_glsl.h"
+
+#include <vector>
 
 namespace Ming3D
 {
@@ -20,7 +23,24 @@ namespace Ming3D
 
         ShaderProgramGL* mActiveShaderProgram = nullptr;
 
+        /** Textures bound by SetTexture, per texture unit (0 = unknown), to skip redundant binds when consecutive materials share textures. */
+        std::vector<GLuint> mBoundTextures;
+        GLint mActiveTextureUnit = -1; // -1 = unknown
+
+        bool mProgramBinarySupported = false;
+        uint64_t mDriverHash = 0; // hash of the GL vendor, renderer and version
+
         void BlitRenderTarget(RenderTargetGL* inSourceTarget, RenderWindow* inTargetWindow);
+        /** Converts the regular and depth-only shaders of a program (or takes them from the disk cache). */
+        bool ConvertShaderProgram(ParsedShaderProgram* parsedProgram);
+        /** Compiles and links a program, or loads it from the program binary at inBinaryPath (if supported, and not empty). */
+        ShaderProgramGL* CreateShaderProgramFromSource(const ShaderProgramDataGLSL& convertedShaderData, const std::string& inBinaryPath);
+        /** Creates a GL texture with all the mip levels of the texture data. */
+        GLuint CreateGLTexture(const TextureInfo& inTextureInfo, void* inTextureData);
+        /** Internal format, and pixel format of the uploaded data (unused for compressed formats). */
+        static void GetGLTextureFormat(const TextureInfo& inTextureInfo, GLint& outInternalFormat, GLenum& outPixelFormat);
+        /** Forgets the texture binding cache. Call after binding textures outside SetTexture (texture names may also have been reused). */
+        void ResetTextureBindings();
 
         RasteriserStateGL* mDefaultRasteriserState;
         DepthStencilStateGL* mDefaultDepthStencilState;
@@ -31,24 +51,33 @@ namespace Ming3D
 
         virtual RenderTarget* CreateRenderTarget(RenderWindow* inWindow) override;
         virtual RenderTarget* CreateRenderTarget(TextureInfo inTextureInfo, int numTextures) override;
+        virtual RenderTarget* CreateDepthRenderTarget(TextureInfo inTextureInfo, int inNumLayers) override;
         virtual VertexBuffer* CreateVertexBuffer(VertexData* inVertexData) override;
         virtual IndexBuffer* CreateIndexBuffer(IndexData* inIndexData) override;
         virtual ShaderProgram* CreateShaderProgram(ParsedShaderProgram* parsedProgram) override;
+        virtual ShaderProgram* CreateDepthOnlyShaderProgram(ParsedShaderProgram* parsedProgram) override;
         virtual TextureBuffer* CreateTextureBuffer(TextureInfo inTextureInfo, void* inTextureData) override;
+        virtual void UpdateTextureBuffer(TextureBuffer* inTextureBuffer, TextureInfo inTextureInfo, void* inTextureData) override;
+        virtual TextureBuffer* CreateTexelBuffer(size_t inNumElements) override;
+        virtual TextureBuffer* CreateTextureArrayBuffer(TextureInfo inTextureInfo, unsigned int inNumLayers) override;
+        virtual void UpdateTextureArrayLayer(TextureBuffer* inTextureArray, unsigned int inLayer, TextureInfo inTextureInfo, void* inTextureData) override;
         virtual RenderWindow* CreateRenderWindow(WindowBase* inWindow) override;
         virtual RasteriserState* CreateRasteriserState(RasteriserStateCullMode inCullMode, bool inDepthClipEnabled) override;
         virtual DepthStencilState* CreateDepthStencilState(DepthStencilStateDesc inDesc) override;
         virtual ConstantBuffer* CreateConstantBuffer(size_t inSize) override;
 
         virtual void SetTexture(const TextureBuffer* inTexture, int inSlot) override;
+        virtual void UpdateTexelBuffer(TextureBuffer* inBuffer, const void* inData, size_t inNumElements) override;
         virtual void SetActiveShaderProgram(ShaderProgram* inProgram) override;
         virtual void BeginRenderWindow(RenderWindow* inWindow) override;
         virtual void EndRenderWindow(RenderWindow* inWindow) override;
         virtual void BeginRenderTarget(RenderTarget* inTarget) override;
+        virtual void BeginDepthRenderTarget(RenderTarget* inTarget, int inLayer) override;
         virtual void EndRenderTarget(RenderTarget* inTarget) override;
         virtual void RenderPrimitive(VertexBuffer* inVertexBuffer, IndexBuffer* inIndexBuffer) override;
         virtual void SetRasteriserState(RasteriserState* inState) override;
         virtual void SetDepthStencilState(DepthStencilState* inState) override;
+        virtual void SetColourWriteEnabled(bool inEnabled) override;
         virtual void SetConstantBufferData(ConstantBuffer* inConstantBuffer, void* inData, size_t inSize) override;
         virtual void BindConstantBuffer(ConstantBuffer* inConstantBuffer, const char* inName, ShaderProgram* inProgram) override;
 
@@ -58,6 +87,7 @@ namespace Ming3D
         virtual void SetShaderUniformVec2(const std::string& inName, const glm::vec2 inVec) override;
         virtual void SetShaderUniformVec3(const std::string& inName, const glm::vec3 inVec) override;
         virtual void SetShaderUniformVec4(const std::string& inName, const glm::vec4 inVec) override;
+        virtual void SetShaderUniformBlock(const void* inBlockData, size_t inOffset, size_t inSize) override;
 
     };
 }
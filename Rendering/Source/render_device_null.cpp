@@ -0,0 +1,235 @@
+#include "render_device_null.h"
+
+#include "vertex_buffer_null.h"
+#include "index_buffer_null.h"
+#include "texture_buffer_null.h"
+#include "constant_buffer_null.h"
+#include "render_target_null.h"
+
+namespace Ming3D
+{
+    void RenderDeviceNull::ResetCallStats()
+    {
+        const size_t bufferMemory = mStats.mBufferMemory;
+        const size_t textureMemory = mStats.mTextureMemory;
+        mStats = RenderDeviceNullStats();
+        mStats.mBufferMemory = bufferMemory;
+        mStats.mTextureMemory = textureMemory;
+    }
+
+    RenderTarget* RenderDeviceNull::CreateRenderTarget(RenderWindow* inWindow)
+    {
+        mStats.mNumResourcesCreated++;
+        WindowBase* window = inWindow->GetWindow();
+        const size_t size = (size_t)window->GetWidth() * window->GetHeight() * 4;
+        RenderTargetNull* renderTarget = new RenderTargetNull();
+        renderTarget->mColourTextureBuffers.push_back(new TextureBufferNull(&mStats.mTextureMemory, size));
+        renderTarget->mDepthTextureBuffer = new TextureBufferNull(&mStats.mTextureMemory, size);
+        return renderTarget;
+    }
+
+    RenderTarget* RenderDeviceNull::CreateRenderTarget(TextureInfo inTextureInfo, int numTextures)
+    {
+        mStats.mNumResourcesCreated++;
+        RenderTargetNull* renderTarget = new RenderTargetNull();
+        for (int iTexture = 0; iTexture < numTextures; iTexture++)
+            renderTarget->mColourTextureBuffers.push_back(new TextureBufferNull(&mStats.mTextureMemory, inTextureInfo.GetDataSize()));
+        renderTarget->mDepthTextureBuffer = new TextureBufferNull(&mStats.mTextureMemory, (size_t)inTextureInfo.mWidth * inTextureInfo.mHeight * 4);
+        return renderTarget;
+    }
+
+    RenderTarget* RenderDeviceNull::CreateDepthRenderTarget(TextureInfo inTextureInfo, int inNumLayers)
+    {
+        mStats.mNumResourcesCreated++;
+        RenderTargetNull* renderTarget = new RenderTargetNull();
+        renderTarget->mDepthTextureBuffer = new TextureBufferNull(&mStats.mTextureMemory, (size_t)inTextureInfo.mWidth * inTextureInfo.mHeight * 4 * inNumLayers);
+        return renderTarget;
+    }
+
+    VertexBuffer* RenderDeviceNull::CreateVertexBuffer(VertexData* inVertexData)
+    {
+        mStats.mNumResourcesCreated++;
+        VertexBufferNull* vertexBuffer = new VertexBufferNull(&mStats, inVertexData->GetNumVertices() * inVertexData->GetVertexSize());
+        vertexBuffer->SetVertexLayout(inVertexData->GetVertexLayout());
+        return vertexBuffer;
+    }
+
+    IndexBuffer* RenderDeviceNull::CreateIndexBuffer(IndexData* inIndexData)
+    {
+        mStats.mNumResourcesCreated++;
+        IndexBufferNull* indexBuffer = new IndexBufferNull(&mStats, inIndexData->GetNumIndices() * sizeof(unsigned int));
+        indexBuffer->SetNumIndices(inIndexData->GetNumIndices());
+        return indexBuffer;
+    }
+
+    ShaderProgram* RenderDeviceNull::CreateShaderProgram(ParsedShaderProgram* parsedProgram)
+    {
+        mStats.mNumResourcesCreated++;
+        return new ShaderProgram();
+    }
+
+    ShaderProgram* RenderDeviceNull::CreateDepthOnlyShaderProgram(ParsedShaderProgram* parsedProgram)
+    {
+        mStats.mNumResourcesCreated++;
+        return new ShaderProgram();
+    }
+
+    TextureBuffer* RenderDeviceNull::CreateTextureBuffer(TextureInfo inTextureInfo, void* inTextureData)
+    {
+        mStats.mNumResourcesCreated++;
+        return new TextureBufferNull(&mStats.mTextureMemory, inTextureInfo.GetDataSize());
+    }
+
+    void RenderDeviceNull::UpdateTextureBuffer(TextureBuffer* inTextureBuffer, TextureInfo inTextureInfo, void* inTextureData)
+    {
+        mStats.mNumConstantBufferUpdates++;
+        static_cast<TextureBufferNull*>(inTextureBuffer)->mMemory.SetSize(inTextureInfo.GetDataSize());
+    }
+
+    TextureBuffer* RenderDeviceNull::CreateTexelBuffer(size_t inNumElements)
+    {
+        mStats.mNumResourcesCreated++;
+        return new TextureBufferNull(&mStats.mBufferMemory, inNumElements * sizeof(glm::vec4));
+    }
+
+    TextureBuffer* RenderDeviceNull::CreateTextureArrayBuffer(TextureInfo inTextureInfo, unsigned int inNumLayers)
+    {
+        mStats.mNumResourcesCreated++;
+        return new TextureBufferNull(&mStats.mTextureMemory, inTextureInfo.GetDataSize() * inNumLayers);
+    }
+
+    void RenderDeviceNull::UpdateTextureArrayLayer(TextureBuffer* inTextureArray, unsigned int inLayer, TextureInfo inTextureInfo, void* inTextureData)
+    {
+        mStats.mNumConstantBufferUpdates++;
+    }
+
+    RenderWindow* RenderDeviceNull::CreateRenderWindow(WindowBase* inWindow)
+    {
+        return new RenderWindow(inWindow);
+    }
+
+    RasteriserState* RenderDeviceNull::CreateRasteriserState(RasteriserStateCullMode inCullMode, bool inDepthClipEnabled)
+    {
+        mStats.mNumResourcesCreated++;
+        return new RasteriserState();
+    }
+
+    DepthStencilState* RenderDeviceNull::CreateDepthStencilState(DepthStencilStateDesc inDesc)
+    {
+        mStats.mNumResourcesCreated++;
+        return new DepthStencilState();
+    }
+
+    ConstantBuffer* RenderDeviceNull::CreateConstantBuffer(size_t inSize)
+    {
+        mStats.mNumResourcesCreated++;
+        // Constant buffers have no virtual destructor, and live as long as the device
+        mStats.mBufferMemory += inSize;
+        ConstantBufferNull* constantBuffer = new ConstantBufferNull();
+        constantBuffer->mSize = inSize;
+        return constantBuffer;
+    }
+
+    void RenderDeviceNull::SetTexture(const TextureBuffer* inTexture, int inSlot)
+    {
+        mStats.mNumTextureBinds++;
+    }
+
+    void RenderDeviceNull::UpdateTexelBuffer(TextureBuffer* inBuffer, const void* inData, size_t inNumElements)
+    {
+        mStats.mNumConstantBufferUpdates++;
+    }
+
+    void RenderDeviceNull::SetActiveShaderProgram(ShaderProgram* inProgram)
+    {
+        mStats.mNumShaderProgramChanges++;
+    }
+
+    void RenderDeviceNull::BeginRenderWindow(RenderWindow* inWindow)
+    {
+        mStats.mNumRenderTargets++;
+    }
+
+    void RenderDeviceNull::EndRenderWindow(RenderWindow* inWindow)
+    {
+    }
+
+    void RenderDeviceNull::BeginRenderTarget(RenderTarget* inTarget)
+    {
+        mStats.mNumRenderTargets++;
+    }
+
+    void RenderDeviceNull::BeginDepthRenderTarget(RenderTarget* inTarget, int inLayer)
+    {
+        mStats.mNumRenderTargets++;
+    }
+
+    void RenderDeviceNull::EndRenderTarget(RenderTarget* inTarget)
+    {
+    }
+
+    void RenderDeviceNull::RenderPrimitive(VertexBuffer* inVertexBuffer, IndexBuffer* inIndexBuffer)
+    {
+        mStats.mNumDrawCalls++;
+        mStats.mNumIndices += inIndexBuffer->GetNumIndices();
+    }
+
+    void RenderDeviceNull::SetRasteriserState(RasteriserState* inState)
+    {
+        mStats.mNumStateChanges++;
+    }
+
+    void RenderDeviceNull::SetDepthStencilState(DepthStencilState* inState)
+    {
+        mStats.mNumStateChanges++;
+    }
+
+    void RenderDeviceNull::SetColourWriteEnabled(bool inEnabled)
+    {
+        mStats.mNumStateChanges++;
+    }
+
+    void RenderDeviceNull::SetConstantBufferData(ConstantBuffer* inConstantBuffer, void* inData, size_t inSize)
+    {
+        mStats.mNumConstantBufferUpdates++;
+    }
+
+    void RenderDeviceNull::BindConstantBuffer(ConstantBuffer* inConstantBuffer, const char* inName, ShaderProgram* inProgram)
+    {
+    }
+
+    void RenderDeviceNull::SetShaderUniformFloat(const std::string& inName, float inVal)
+    {
+        mStats.mNumUniformUpdates++;
+    }
+
+    void RenderDeviceNull::SetShaderUniformInt(const std::string& inName, int inVal)
+    {
+        mStats.mNumUniformUpdates++;
+    }
+
+    void RenderDeviceNull::SetShaderUniformMat4x4(const std::string& inName, const glm::mat4 inMat)
+    {
+        mStats.mNumUniformUpdates++;
+    }
+
+    void RenderDeviceNull::SetShaderUniformVec2(const std::string& inName, const glm::vec2 inVec)
+    {
+        mStats.mNumUniformUpdates++;
+    }
+
+    void RenderDeviceNull::SetShaderUniformVec3(const std::string& inName, const glm::vec3 inVec)
+    {
+        mStats.mNumUniformUpdates++;
+    }
+
+    void RenderDeviceNull::SetShaderUniformVec4(const std::string& inName, const glm::vec4 inVec)
+    {
+        mStats.mNumUniformUpdates++;
+    }
+
+    void RenderDeviceNull::SetShaderUniformBlock(const void* inBlockData, size_t inOffset, size_t inSize)
+    {
+        mStats.mNumUniformUpdates++;
+    }
+}
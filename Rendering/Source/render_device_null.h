@@ -0,0 +1,68 @@
+#ifndef MING3D_RENDER_DEVICE_NULL_H
+#define MING3D_RENDER_DEVICE_NULL_H
+
+#include "render_device.h"
+#include "render_device_null_stats.h"
+
+namespace Ming3D
+{
+    /**
+    * Render device that does no rendering, and needs no GPU or window (used by servers and benchmarks).
+    * Records the calls made to it and the memory its resources would use (see RenderDeviceNullStats),
+    * so the CPU cost of the renderer can be measured in isolation.
+    */
+    class RenderDeviceNull : public RenderDevice
+    {
+    private:
+        RenderDeviceNullStats mStats;
+
+    public:
+        virtual ~RenderDeviceNull() {}
+
+        const RenderDeviceNullStats& GetStats() const { return mStats; }
+        /** Resets the call counts (but not the memory stats). */
+        void ResetCallStats();
+
+        virtual RenderTarget* CreateRenderTarget(RenderWindow* inWindow) override;
+        virtual RenderTarget* CreateRenderTarget(TextureInfo inTextureInfo, int numTextures) override;
+        virtual RenderTarget* CreateDepthRenderTarget(TextureInfo inTextureInfo, int inNumLayers) override;
+        virtual VertexBuffer* CreateVertexBuffer(VertexData* inVertexData) override;
+        virtual IndexBuffer* CreateIndexBuffer(IndexData* inIndexData) override;
+        virtual ShaderProgram* CreateShaderProgram(ParsedShaderProgram* parsedProgram) override;
+        virtual ShaderProgram* CreateDepthOnlyShaderProgram(ParsedShaderProgram* parsedProgram) override;
+        virtual TextureBuffer* CreateTextureBuffer(TextureInfo inTextureInfo, void* inTextureData) override;
+        virtual void UpdateTextureBuffer(TextureBuffer* inTextureBuffer, TextureInfo inTextureInfo, void* inTextureData) override;
+        virtual TextureBuffer* CreateTexelBuffer(size_t inNumElements) override;
+        virtual TextureBuffer* CreateTextureArrayBuffer(TextureInfo inTextureInfo, unsigned int inNumLayers) override;
+        virtual void UpdateTextureArrayLayer(TextureBuffer* inTextureArray, unsigned int inLayer, TextureInfo inTextureInfo, void* inTextureData) override;
+        virtual RenderWindow* CreateRenderWindow(WindowBase* inWindow) override;
+        virtual RasteriserState* CreateRasteriserState(RasteriserStateCullMode inCullMode, bool inDepthClipEnabled) override;
+        virtual DepthStencilState* CreateDepthStencilState(DepthStencilStateDesc inDesc) override;
+        virtual ConstantBuffer* CreateConstantBuffer(size_t inSize) override;
+
+        virtual void SetTexture(const TextureBuffer* inTexture, int inSlot) override;
+        virtual void UpdateTexelBuffer(TextureBuffer* inBuffer, const void* inData, size_t inNumElements) override;
+        virtual void SetActiveShaderProgram(ShaderProgram* inProgram) override;
+        virtual void BeginRenderWindow(RenderWindow* inWindow) override;
+        virtual void EndRenderWindow(RenderWindow* inWindow) override;
+        virtual void BeginRenderTarget(RenderTarget* inTarget) override;
+        virtual void BeginDepthRenderTarget(RenderTarget* inTarget, int inLayer) override;
+        virtual void EndRenderTarget(RenderTarget* inTarget) override;
+        virtual void RenderPrimitive(VertexBuffer* inVertexBuffer, IndexBuffer* inIndexBuffer) override;
+        virtual void SetRasteriserState(RasteriserState* inState) override;
+        virtual void SetDepthStencilState(DepthStencilState* inState) override;
+        virtual void SetColourWriteEnabled(bool inEnabled) override;
+        virtual void SetConstantBufferData(ConstantBuffer* inConstantBuffer, void* inData, size_t inSize) override;
+        virtual void BindConstantBuffer(ConstantBuffer* inConstantBuffer, const char* inName, ShaderProgram* inProgram) override;
+
+        virtual void SetShaderUniformFloat(const std::string& inName, float inVal) override;
+        virtual void SetShaderUniformInt(const std::string& inName, int inVal) override;
+        virtual void SetShaderUniformMat4x4(const std::string& inName, const glm::mat4 inMat) override;
+        virtual void SetShaderUniformVec2(const std::string& inName, const glm::vec2 inVec) override;
+        virtual void SetShaderUniformVec3(const std::string& inName, const glm::vec3 inVec) override;
+        virtual void SetShaderUniformVec4(const std::string& inName, const glm::vec4 inVec) override;
+        virtual void SetShaderUniformBlock(const void* inBlockData, size_t inOffset, size_t inSize) override;
+    };
+}
+
+#endif
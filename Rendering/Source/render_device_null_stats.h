@@ -0,0 +1,50 @@
+#ifndef MING3D_RENDER_DEVICE_NULL_STATS_H
+#define MING3D_RENDER_DEVICE_NULL_STATS_H
+
+#include <cstddef>
+
+namespace Ming3D
+{
+    /** Calls made to a RenderDeviceNull, and the memory its live resources would use on the GPU. */
+    class RenderDeviceNullStats
+    {
+    public:
+        // Calls (since the last RenderDeviceNull::ResetCallStats)
+        size_t mNumDrawCalls = 0;
+        size_t mNumIndices = 0;
+        size_t mNumShaderProgramChanges = 0;
+        size_t mNumTextureBinds = 0;
+        size_t mNumConstantBufferUpdates = 0; // constant buffers, texel buffers and textures
+        size_t mNumUniformUpdates = 0;
+        size_t mNumRenderTargets = 0; // render windows and render targets (and depth render target layers) begun
+        size_t mNumStateChanges = 0; // rasteriser state, depth stencil state and colour write changes
+        size_t mNumResourcesCreated = 0;
+
+        // Memory of live resources, in bytes
+        size_t mBufferMemory = 0; // vertex, index, constant and texel buffers
+        size_t mTextureMemory = 0; // textures and render targets
+    };
+
+    /** Adds the size of a null device resource to a memory stat, while the resource is alive. */
+    class NullResourceMemory
+    {
+    private:
+        size_t* mMemoryStat;
+        size_t mSize;
+
+    public:
+        NullResourceMemory(size_t* inMemoryStat, size_t inSize) : mMemoryStat(inMemoryStat), mSize(inSize) { *mMemoryStat += mSize; }
+        ~NullResourceMemory() { *mMemoryStat -= mSize; }
+        NullResourceMemory(const NullResourceMemory&) = delete;
+        NullResourceMemory& operator=(const NullResourceMemory&) = delete;
+
+        void SetSize(size_t inSize)
+        {
+            *mMemoryStat = *mMemoryStat - mSize + inSize;
+            mSize = inSize;
+        }
+        size_t GetSize() const { return mSize; }
+    };
+}
+
+#endif
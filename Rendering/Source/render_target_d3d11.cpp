@@ -17,6 +17,14 @@ namespace Ming3D
         {
             mBackBuffer->Release();
         }
+        for (ID3D11DepthStencilView* layerView : mDepthLayerViews)
+        {
+            layerView->Release();
+        }
+        if (mDepthStencilView != nullptr)
+        {
+            delete mDepthStencilView;
+        }
     }
 
     void RenderTargetD3D11::BeginRendering()
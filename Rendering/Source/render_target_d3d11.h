@@ -18,9 +18,12 @@ namespace Ming3D
         friend class RenderDeviceD3D11; // TODO
 
     private:
-        ID3D11RenderTargetView* mBackBuffer;
+        ID3D11RenderTargetView* mBackBuffer = nullptr;
         std::vector<TextureBuffer*> mColourBuffers;
-        DepthStencilViewD3D11* mDepthStencilView;
+        DepthStencilViewD3D11* mDepthStencilView = nullptr;
+        std::vector<ID3D11DepthStencilView*> mDepthLayerViews; // one per layer, for depth array targets
+        int mWidth = 0;
+        int mHeight = 0;
 
     public:
         RenderTargetD3D11();
@@ -15,6 +15,8 @@ namespace Ming3D
             delete colBuffer;
         }
         delete mDepthRenderBuffer;
+        if (mFrameBufferID != 0)
+            glDeleteFramebuffers(1, &mFrameBufferID);
     }
 
     void RenderTargetGL::BeginRendering()
@@ -17,8 +17,10 @@ namespace Ming3D
         GLuint mFrameBufferID = 0;
         std::vector<TextureBufferGL*> mColourBuffers;
         std::vector<GLenum> mAttachments;
-        TextureBufferGL* mDepthRenderBuffer;
+        TextureBufferGL* mDepthRenderBuffer = nullptr;
         bool mWindowTarget = false;
+        int mWidth = 0;
+        int mHeight = 0;
 
     public:
         RenderTargetGL();
@@ -0,0 +1,31 @@
+#ifndef MING3D_RENDER_TARGET_NULL_H
+#define MING3D_RENDER_TARGET_NULL_H
+
+#include "render_target.h"
+#include "texture_buffer_null.h"
+#include <vector>
+
+namespace Ming3D
+{
+    class RenderTargetNull : public RenderTarget
+    {
+    public:
+        std::vector<TextureBufferNull*> mColourTextureBuffers;
+        TextureBufferNull* mDepthTextureBuffer = nullptr;
+
+        virtual ~RenderTargetNull()
+        {
+            for (TextureBufferNull* textureBuffer : mColourTextureBuffers)
+                delete textureBuffer;
+            delete mDepthTextureBuffer;
+        }
+
+        virtual void BeginRendering() override {}
+        virtual void EndRendering() override {}
+
+        virtual TextureBuffer* GetColourTextureBuffer(int inSlot) override { return mColourTextureBuffers[inSlot]; }
+        virtual TextureBuffer* GetDepthTextureBuffer() override { return mDepthTextureBuffer; }
+    };
+}
+
+#endif
@@ -0,0 +1,32 @@
+#include "shader_arena.h"
+
+#include <cstdint>
+
+namespace Ming3D
+{
+    ShaderArena::~ShaderArena()
+    {
+        for (Destructor* destructor = mDestructors; destructor != nullptr; destructor = destructor->mNext)
+            destructor->mDestroy(destructor->mObject);
+        for (char* block : mBlocks)
+            delete[] block;
+    }
+
+    void* ShaderArena::Allocate(size_t inSize, size_t inAlignment)
+    {
+        uintptr_t pos = ((uintptr_t)mCurrentPos + inAlignment - 1) & ~(uintptr_t)(inAlignment - 1);
+        if (mCurrentPos == nullptr || pos + inSize > (uintptr_t)mCurrentEnd)
+        {
+            // Large allocations get a block of their own
+            const size_t blockSize = inSize + inAlignment > BlockSize ? inSize + inAlignment : BlockSize;
+            char* block = new char[blockSize];
+            mBlocks.push_back(block);
+            mCurrentPos = block;
+            mCurrentEnd = block + blockSize;
+            pos = ((uintptr_t)mCurrentPos + inAlignment - 1) & ~(uintptr_t)(inAlignment - 1);
+        }
+        mCurrentPos = (char*)(pos + inSize);
+        mAllocatedSize += inSize;
+        return (void*)pos;
+    }
+}
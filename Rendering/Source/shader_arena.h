@@ -0,0 +1,73 @@
+#ifndef MING3D_SHADERARENA_H
+#define MING3D_SHADERARENA_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Ming3D
+{
+    /**
+    * Bump allocator for shader syntax trees.
+    * Each ParsedShaderProgram owns an arena, and all nodes of its syntax tree are allocated from it, so the tree is freed in one go.
+    * Objects that need destruction (those with containers) are destroyed in reverse order of allocation, when the arena is freed.
+    * Not thread safe: a program is parsed by one thread.
+    */
+    class ShaderArena
+    {
+    private:
+        class Destructor
+        {
+        public:
+            void(*mDestroy)(void*);
+            void* mObject;
+            Destructor* mNext;
+        };
+
+        static const size_t BlockSize = 16 * 1024;
+
+        std::vector<char*> mBlocks;
+        char* mCurrentPos = nullptr;
+        char* mCurrentEnd = nullptr;
+        Destructor* mDestructors = nullptr;
+        size_t mAllocatedSize = 0;
+
+        template <typename T>
+        static void Destroy(void* inObject)
+        {
+            static_cast<T*>(inObject)->~T();
+        }
+
+    public:
+        ShaderArena() = default;
+        ShaderArena(const ShaderArena&) = delete;
+        ShaderArena& operator=(const ShaderArena&) = delete;
+        ~ShaderArena();
+
+        /** Allocates uninitialised memory, which is freed with the arena. */
+        void* Allocate(size_t inSize, size_t inAlignment);
+
+        /** Creates an object in the arena. Don't delete it: it's destroyed with the arena. */
+        template <typename T, typename... Args>
+        T* New(Args&&... inArgs)
+        {
+            T* object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(inArgs)...);
+            if (!std::is_trivially_destructible<T>::value)
+            {
+                Destructor* destructor = new (Allocate(sizeof(Destructor), alignof(Destructor))) Destructor();
+                destructor->mDestroy = &Destroy<T>;
+                destructor->mObject = object;
+                destructor->mNext = mDestructors;
+                mDestructors = destructor;
+            }
+            return object;
+        }
+
+        /** Bytes allocated from the arena (excluding unused space at the end of blocks). */
+        size_t GetAllocatedSize() const { return mAllocatedSize; }
+    };
+}
+
+#endif
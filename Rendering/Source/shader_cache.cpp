@@ -1,9 +1,14 @@
 #include "shader_cache.h"
+#include "Debug/debug.h"
+#include "Debug/st_assert.h"
+#include <fstream>
 #include <sstream>
 
 namespace Ming3D
 {
+    std::unordered_map<std::string, ShaderCache::CachedProgram> ShaderCache::mCachedPrograms;
     std::unordered_map<std::string, ParsedShaderProgram*> ShaderCache::mCachedProgramInfos;
+    std::mutex ShaderCache::mMutex;
 
     std::string ShaderCache::ParamsToString(const ShaderParserParams& inParams)
     {
@@ -16,16 +21,76 @@ namespace Ming3D
         return ss.str();
     }
 
+    ShaderCache::CachedProgram& ShaderCache::GetCachedProgram(const std::string& inProgramPath)
+    {
+        auto programIter = mCachedPrograms.find(inProgramPath);
+        if (programIter != mCachedPrograms.end())
+            return programIter->second;
+
+        CachedProgram& program = mCachedPrograms[inProgramPath];
+
+        // Read the keyword declarations ("#pragma keywords a b c")
+        std::ifstream shaderFile(inProgramPath);
+        std::string line;
+        while (std::getline(shaderFile, line))
+        {
+            std::istringstream lineStream(line);
+            std::string directive, pragma, keyword;
+            if (!(lineStream >> directive >> pragma) || directive != "#pragma" || pragma != "keywords")
+                continue;
+            while (lineStream >> keyword)
+            {
+                if (program.mKeywords.size() == sizeof(ShaderKeywordMask) * 8)
+                {
+                    LOG_ERROR() << "Too many shader keywords in " << inProgramPath << ": " << keyword;
+                    break;
+                }
+                program.mKeywordBits.emplace(keyword, 1u << program.mKeywords.size());
+                program.mKeywords.push_back(keyword);
+            }
+        }
+        return program;
+    }
+
+    bool ShaderCache::GetKeywordMask(const CachedProgram& inProgram, const ShaderParserParams& inParams, ShaderKeywordMask& outMask)
+    {
+        outMask = 0;
+        for (const auto& definition : inParams.mPreprocessorDefinitions)
+        {
+            auto keywordIter = inProgram.mKeywordBits.find(definition.first);
+            if (keywordIter == inProgram.mKeywordBits.end() || !definition.second.empty())
+                return false;
+            outMask |= keywordIter->second;
+        }
+        return true;
+    }
+
     void ShaderCache::CacheProgramInfo(const ShaderParserParams& inParams, ParsedShaderProgram* inProgram)
     {
-        std::string strParams = ParamsToString(inParams);
-        mCachedProgramInfos.emplace(strParams, inProgram); // TODO: copy???
+        std::lock_guard<std::mutex> lock(mMutex);
+        CachedProgram& program = GetCachedProgram(inParams.mShaderProgramPath);
+        ShaderKeywordMask keywordMask;
+        if (GetKeywordMask(program, inParams, keywordMask))
+            program.mPermutations.emplace(keywordMask, inProgram); // TODO: copy???
+        else
+            mCachedProgramInfos.emplace(ParamsToString(inParams), inProgram); // TODO: copy???
     }
 
     bool ShaderCache::GetCachedProgramInfo(const ShaderParserParams& inParams, ParsedShaderProgram*& outProgram)
     {
-        std::string strParams = ParamsToString(inParams);
-        auto itPrg = mCachedProgramInfos.find(strParams);
+        std::lock_guard<std::mutex> lock(mMutex);
+        const CachedProgram& program = GetCachedProgram(inParams.mShaderProgramPath);
+        ShaderKeywordMask keywordMask;
+        if (GetKeywordMask(program, inParams, keywordMask))
+        {
+            auto permutationIter = program.mPermutations.find(keywordMask);
+            if (permutationIter == program.mPermutations.end())
+                return false;
+            outProgram = permutationIter->second;
+            return true;
+        }
+
+        auto itPrg = mCachedProgramInfos.find(ParamsToString(inParams));
         if (itPrg != mCachedProgramInfos.end())
         {
             outProgram = itPrg->second;
@@ -34,4 +99,30 @@ namespace Ming3D
         else
             return false;
     }
+
+    std::vector<std::string> ShaderCache::GetKeywords(const std::string& inProgramPath)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return GetCachedProgram(inProgramPath).mKeywords;
+    }
+
+    std::vector<ShaderParserParams> ShaderCache::GetPermutations(const std::string& inProgramPath)
+    {
+        const std::vector<std::string> keywords = GetKeywords(inProgramPath);
+        const ShaderKeywordMask numPermutations = keywords.size() < 32 ? (1u << keywords.size()) : 0;
+        __AssertComment(numPermutations > 0, "Too many keywords to list all permutations");
+
+        std::vector<ShaderParserParams> permutations(numPermutations);
+        for (ShaderKeywordMask keywordMask = 0; keywordMask < numPermutations; keywordMask++)
+        {
+            ShaderParserParams& params = permutations[keywordMask];
+            params.mShaderProgramPath = inProgramPath;
+            for (size_t iKeyword = 0; iKeyword < keywords.size(); iKeyword++)
+            {
+                if (keywordMask & (1u << iKeyword))
+                    params.mPreprocessorDefinitions.emplace(keywords[iKeyword], "");
+            }
+        }
+        return permutations;
+    }
 }
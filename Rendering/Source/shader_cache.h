@@ -3,21 +3,58 @@
 
 #include <unordered_map>
 #include <string>
+#include <mutex>
+#include <cstdint>
+#include <vector>
 #include "shader_info.h"
 
 namespace Ming3D
 {
+    /** Set of shader keywords. Bit i is the i-th keyword declared by the program. */
+    typedef uint32_t ShaderKeywordMask;
+
+    /**
+    * Cache of parsed shader programs.
+    * Thread safe, so shaders can be parsed by asset loading threads.
+    * Programs that aren't in memory yet may be loaded from the ShaderDiskCache instead of being parsed.
+    *
+    * Programs can declare keywords in the program file: "#pragma keywords use_mat_colour unlit_mode".
+    * Keywords are preprocessor definitions without a value, and each combination of keywords is a permutation of the program.
+    * Permutations are looked up by keyword mask, and can be listed (GetPermutations) to precompile them.
+    * Definitions that aren't declared keywords (or that have a value) are looked up by their names and values instead.
+    */
     class ShaderCache
     {
     private:
+        class CachedProgram
+        {
+        public:
+            std::vector<std::string> mKeywords;
+            std::unordered_map<std::string, ShaderKeywordMask> mKeywordBits;
+            std::unordered_map<ShaderKeywordMask, ParsedShaderProgram*> mPermutations;
+        };
+
+        static std::unordered_map<std::string, CachedProgram> mCachedPrograms;
         static std::unordered_map<std::string, ParsedShaderProgram*> mCachedProgramInfos;
+        static std::mutex mMutex;
 
         static std::string ParamsToString(const ShaderParserParams& inParams);
 
+        /** Gets the cache entry of a program, and reads its keywords the first time. Must be called with mMutex locked. */
+        static CachedProgram& GetCachedProgram(const std::string& inProgramPath);
+        /** Returns false if any of the definitions isn't a keyword of the program. */
+        static bool GetKeywordMask(const CachedProgram& inProgram, const ShaderParserParams& inParams, ShaderKeywordMask& outMask);
+
     public:
         static void CacheProgramInfo(const ShaderParserParams& inParams, ParsedShaderProgram* inProgram); // !!! TODO: Cache a copy of the program !!!
 
         static bool GetCachedProgramInfo(const ShaderParserParams& inParams, ParsedShaderProgram*& outProgram);
+
+        /** Keywords declared by a program, in bit order. */
+        static std::vector<std::string> GetKeywords(const std::string& inProgramPath);
+
+        /** Parser params of all permutations of a program (2^keywords), indexed by keyword mask. */
+        static std::vector<ShaderParserParams> GetPermutations(const std::string& inProgramPath);
     };
 }
 
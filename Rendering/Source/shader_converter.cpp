@@ -0,0 +1,65 @@
+#include "shader_converter.h"
+
+#include "Debug/debug.h"
+#ifdef MING3D_D3D11
+#include "shader_writer_hlsl.h"
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#else
+#include "shader_writer_glsl.h"
+#endif
+
+namespace Ming3D
+{
+#ifdef MING3D_D3D11
+    namespace
+    {
+        bool CompileShader(const std::string& inSource, const char* inTarget, const std::string& inProgramPath, std::string& outBytecode)
+        {
+            ID3D10Blob* blob = nullptr;
+            ID3DBlob* errorBlob = nullptr;
+            D3DCompile(inSource.data(), inSource.size(), "", NULL, NULL, "main", inTarget, 0, NULL, &blob, &errorBlob);
+            if (errorBlob != nullptr)
+            {
+                LOG_ERROR() << "Error when compiling shader (" << inTarget << "): " << inProgramPath << "\n   " << (char*)errorBlob->GetBufferPointer();
+                errorBlob->Release();
+            }
+            if (blob == nullptr)
+                return false;
+
+            outBytecode.assign((const char*)blob->GetBufferPointer(), blob->GetBufferSize());
+            blob->Release();
+            return true;
+        }
+    }
+
+    bool ShaderConverter::ConvertProgram(const ParsedShaderProgram* inProgram, std::vector<std::string>& outShaders)
+    {
+        outShaders.resize(4);
+        for (int iProgram = 0; iProgram < 2; iProgram++)
+        {
+            ShaderProgramDataHLSL convertedShaderData;
+            if (!ShaderWriterHLSL().WriteShader(inProgram, convertedShaderData, iProgram == 1))
+                return false;
+            // Compile both, to log errors of both
+            const bool compiledVS = CompileShader(convertedShaderData.mVertexShader, "vs_4_0", inProgram->mProgramPath, outShaders[iProgram * 2]);
+            const bool compiledPS = CompileShader(convertedShaderData.mFragmentShader, "ps_4_0", inProgram->mProgramPath, outShaders[iProgram * 2 + 1]);
+            if (!compiledVS || !compiledPS)
+                return false;
+        }
+        return true;
+    }
+#else
+    bool ShaderConverter::ConvertProgram(const ParsedShaderProgram* inProgram, std::vector<std::string>& outShaders)
+    {
+        ShaderProgramDataGLSL convertedShaderData;
+        ShaderProgramDataGLSL convertedDepthOnlyShaderData;
+        if (!ShaderWriterGLSL().WriteShader(inProgram, convertedShaderData) || !ShaderWriterGLSL().WriteShader(inProgram, convertedDepthOnlyShaderData, true))
+            return false;
+
+        outShaders = { convertedShaderData.mVertexShader.mSource, convertedShaderData.mFragmentShader.mSource,
+            convertedDepthOnlyShaderData.mVertexShader.mSource, convertedDepthOnlyShaderData.mFragmentShader.mSource };
+        return true;
+    }
+#endif
+}
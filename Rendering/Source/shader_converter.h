@@ -0,0 +1,23 @@
+#ifndef MING3D_SHADERCONVERTER_H
+#define MING3D_SHADERCONVERTER_H
+
+#include <string>
+#include <vector>
+#include "shader_info.h"
+
+namespace Ming3D
+{
+    /**
+    * Converts parsed shader programs for the rendering API: GLSL sources (OpenGL), or compiled shader bytecode (D3D11).
+    * Doesn't need a render device, so programs can also be converted offline (see the ShaderCompiler tool) and stored in the ShaderDiskCache.
+    * Thread safe.
+    */
+    class ShaderConverter
+    {
+    public:
+        /** Converts the vertex and fragment shader, followed by the depth-only vertex and fragment shader (the layout of ShaderDiskCache entries). */
+        static bool ConvertProgram(const ParsedShaderProgram* inProgram, std::vector<std::string>& outShaders);
+    };
+}
+
+#endif
@@ -0,0 +1,342 @@
+#include "shader_disk_cache.h"
+
+#include "Debug/debug.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace Ming3D
+{
+    namespace
+    {
+        const uint32_t ShaderCacheMagic = 0x5344334D; // "M3DS"
+        const uint32_t ShaderCacheVersion = 3; // bump when the parser or the shader writers change their output
+        const uint32_t ShaderBinaryMagic = 0x4244334D; // "M3DB"
+
+#ifdef MING3D_D3D11
+        const char* ShaderCacheExtension = ".chlsl";
+#else
+        const char* ShaderCacheExtension = ".cglsl";
+#endif
+
+        /** Preprocessor definitions as a string, sorted by name. */
+        std::string GetDefinitionsString(const ShaderParserParams& inParams)
+        {
+            std::vector<std::pair<std::string, std::string>> definitions(inParams.mPreprocessorDefinitions.begin(), inParams.mPreprocessorDefinitions.end());
+            std::sort(definitions.begin(), definitions.end());
+            std::stringstream ss;
+            for (const auto& definition : definitions)
+                ss << definition.first << "=" << definition.second << "|";
+            return ss.str();
+        }
+
+        /** Shader sources are read in text mode, like the parser reads them, so their hashes match. */
+        bool ReadFile(const std::string& inPath, std::string& outData, bool inBinary = true)
+        {
+            std::ifstream file(inPath, inBinary ? std::ios::in | std::ios::binary : std::ios::in);
+            if (!file.is_open())
+                return false;
+            outData.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            return true;
+        }
+
+        class CacheWriter
+        {
+        public:
+            std::string mData;
+
+            void WriteUInt32(uint32_t inValue) { mData.append((const char*)&inValue, sizeof(inValue)); }
+            void WriteUInt64(uint64_t inValue) { mData.append((const char*)&inValue, sizeof(inValue)); }
+            void WriteString(const std::string& inString)
+            {
+                WriteUInt32((uint32_t)inString.size());
+                mData.append(inString);
+            }
+
+            void WriteDatatype(const ShaderDatatypeInfo& inDatatype)
+            {
+                WriteUInt32((uint32_t)inDatatype.mDatatype);
+                WriteString(inDatatype.mName);
+                WriteString(inDatatype.mParentType);
+                WriteUInt32((uint32_t)inDatatype.mMemberVariables.size());
+                for (const ShaderStructMember& member : inDatatype.mMemberVariables)
+                {
+                    WriteDatatype(member.mDatatype);
+                    WriteString(member.mName);
+                    WriteString(member.mSemantic);
+                }
+            }
+
+            void WriteVariables(const std::vector<ShaderVariableInfo>& inVariables)
+            {
+                WriteUInt32((uint32_t)inVariables.size());
+                for (const ShaderVariableInfo& variable : inVariables)
+                {
+                    WriteString(variable.mName);
+                    WriteDatatype(variable.mDatatypeInfo);
+                }
+            }
+        };
+
+        /** Reads cache data. Stops (and fails) at the end of the data, so truncated files are rejected. */
+        class CacheReader
+        {
+        public:
+            const std::string& mData;
+            size_t mOffset = 0;
+            bool mFailed = false;
+
+            CacheReader(const std::string& inData) : mData(inData) {}
+
+            bool Read(void* outData, size_t inSize)
+            {
+                if (mFailed || mData.size() - mOffset < inSize)
+                {
+                    mFailed = true;
+                    return false;
+                }
+                memcpy(outData, mData.data() + mOffset, inSize);
+                mOffset += inSize;
+                return true;
+            }
+
+            uint32_t ReadUInt32()
+            {
+                uint32_t value = 0;
+                Read(&value, sizeof(value));
+                return value;
+            }
+
+            uint64_t ReadUInt64()
+            {
+                uint64_t value = 0;
+                Read(&value, sizeof(value));
+                return value;
+            }
+
+            std::string ReadString()
+            {
+                const uint32_t size = ReadUInt32();
+                if (mFailed || mData.size() - mOffset < size)
+                {
+                    mFailed = true;
+                    return "";
+                }
+                std::string str = mData.substr(mOffset, size);
+                mOffset += size;
+                return str;
+            }
+
+            /** Number of elements in an array. Each element is at least 4 bytes, which bounds the count for corrupt files. */
+            uint32_t ReadCount()
+            {
+                const uint32_t count = ReadUInt32();
+                if (count > (mData.size() - mOffset) / 4)
+                {
+                    mFailed = true;
+                    return 0;
+                }
+                return count;
+            }
+
+            void ReadDatatype(ShaderDatatypeInfo& outDatatype)
+            {
+                outDatatype.mDatatype = (EShaderDatatype)ReadUInt32();
+                outDatatype.mName = ReadString();
+                outDatatype.mParentType = ReadString();
+                const uint32_t numMembers = ReadCount();
+                outDatatype.mMemberVariables.resize(numMembers);
+                for (ShaderStructMember& member : outDatatype.mMemberVariables)
+                {
+                    ReadDatatype(member.mDatatype);
+                    member.mName = ReadString();
+                    member.mSemantic = ReadString();
+                }
+            }
+
+            void ReadVariables(std::vector<ShaderVariableInfo>& outVariables)
+            {
+                const uint32_t numVariables = ReadCount();
+                outVariables.resize(numVariables);
+                for (ShaderVariableInfo& variable : outVariables)
+                {
+                    variable.mName = ReadString();
+                    ReadDatatype(variable.mDatatypeInfo);
+                }
+            }
+        };
+    }
+
+    bool ShaderDiskCache::mEnabled = true;
+
+    uint64_t ShaderDiskCache::HashData(const void* inData, size_t inSize, uint64_t inSeed)
+    {
+        const uint8_t* data = (const uint8_t*)inData;
+        uint64_t hash = inSeed;
+        for (size_t i = 0; i < inSize; i++)
+        {
+            hash ^= data[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    std::string ShaderDiskCache::GetCachePath(const ShaderParserParams& inParams)
+    {
+        const std::string definitions = GetDefinitionsString(inParams);
+        std::stringstream ss;
+        ss << inParams.mShaderProgramPath << "." << std::hex << HashData(definitions.data(), definitions.size());
+        return ss.str();
+    }
+
+    ParsedShaderProgram* ShaderDiskCache::LoadProgram(const ShaderParserParams& inParams)
+    {
+        if (!mEnabled)
+            return nullptr;
+
+        const std::string cachePath = GetCachePath(inParams);
+        std::string data;
+        if (!ReadFile(cachePath + ShaderCacheExtension, data))
+            return nullptr;
+
+        CacheReader reader(data);
+        if (reader.ReadUInt32() != ShaderCacheMagic || reader.ReadUInt32() != ShaderCacheVersion)
+            return nullptr;
+        if (reader.ReadString() != inParams.mShaderProgramPath)
+            return nullptr;
+
+        ParsedShaderProgram* program = new ParsedShaderProgram();
+        program->mProgramPath = inParams.mShaderProgramPath;
+        program->mDiskCachePath = cachePath;
+
+        // Check that the program and its includes haven't changed
+        bool valid = true;
+        const uint32_t numSourceFiles = reader.ReadCount();
+        program->mSourceFiles.resize(numSourceFiles);
+        for (ShaderSourceFile& sourceFile : program->mSourceFiles)
+        {
+            sourceFile.mPath = reader.ReadString();
+            sourceFile.mHash = reader.ReadUInt64();
+            std::string source;
+            valid = valid && !reader.mFailed && ReadFile(sourceFile.mPath, source, false) && HashData(source.data(), source.size()) == sourceFile.mHash;
+        }
+
+        if (valid)
+        {
+            const uint32_t numConstantBuffers = reader.ReadCount();
+            program->mConstantBufferInfos.resize(numConstantBuffers);
+            for (ConstantBufferInfo& constantBuffer : program->mConstantBufferInfos)
+            {
+                constantBuffer.mName = reader.ReadString();
+                reader.ReadVariables(constantBuffer.mShaderUniforms);
+            }
+            reader.ReadVariables(program->mUniforms);
+            program->mUniformBlockLayout = ShaderUniformBlockLayout(program->mUniforms);
+            const uint32_t numStrippedUniforms = reader.ReadCount();
+            for (uint32_t iUniform = 0; iUniform < numStrippedUniforms; iUniform++)
+                program->mStrippedUniforms.push_back(reader.ReadString());
+            const uint32_t numTextures = reader.ReadCount();
+            program->mShaderTextures.resize(numTextures);
+            for (ShaderTextureInfo& texture : program->mShaderTextures)
+            {
+                texture.mTextureType = reader.ReadString();
+                texture.mTextureName = reader.ReadString();
+            }
+            program->mVertexShader = program->mArena.New<ParsedShader>();
+            reader.ReadDatatype(program->mVertexShader->mInput);
+            const uint32_t numShaders = reader.ReadCount();
+            for (uint32_t iShader = 0; iShader < numShaders; iShader++)
+                program->mCachedShaders.push_back(reader.ReadString());
+
+            valid = !reader.mFailed;
+            if (!valid)
+                LOG_ERROR() << "Corrupt shader cache file: " << cachePath << ShaderCacheExtension;
+        }
+
+        if (!valid)
+        {
+            delete program;
+            return nullptr;
+        }
+        return program;
+    }
+
+    bool ShaderDiskCache::SaveProgram(const ParsedShaderProgram* inProgram, const std::vector<std::string>& inConvertedShaders)
+    {
+        if (!mEnabled || inProgram->mDiskCachePath.empty() || inProgram->mSourceFiles.empty())
+            return false;
+
+        CacheWriter writer;
+        writer.WriteUInt32(ShaderCacheMagic);
+        writer.WriteUInt32(ShaderCacheVersion);
+        writer.WriteString(inProgram->mProgramPath);
+        writer.WriteUInt32((uint32_t)inProgram->mSourceFiles.size());
+        for (const ShaderSourceFile& sourceFile : inProgram->mSourceFiles)
+        {
+            writer.WriteString(sourceFile.mPath);
+            writer.WriteUInt64(sourceFile.mHash);
+        }
+        writer.WriteUInt32((uint32_t)inProgram->mConstantBufferInfos.size());
+        for (const ConstantBufferInfo& constantBuffer : inProgram->mConstantBufferInfos)
+        {
+            writer.WriteString(constantBuffer.mName);
+            writer.WriteVariables(constantBuffer.mShaderUniforms);
+        }
+        writer.WriteVariables(inProgram->mUniforms);
+        writer.WriteUInt32((uint32_t)inProgram->mStrippedUniforms.size());
+        for (const std::string& uniformName : inProgram->mStrippedUniforms)
+            writer.WriteString(uniformName);
+        writer.WriteUInt32((uint32_t)inProgram->mShaderTextures.size());
+        for (const ShaderTextureInfo& texture : inProgram->mShaderTextures)
+        {
+            writer.WriteString(texture.mTextureType);
+            writer.WriteString(texture.mTextureName);
+        }
+        writer.WriteDatatype(inProgram->mVertexShader != nullptr ? inProgram->mVertexShader->mInput : ShaderDatatypeInfo());
+        writer.WriteUInt32((uint32_t)inConvertedShaders.size());
+        for (const std::string& shader : inConvertedShaders)
+            writer.WriteString(shader);
+
+        const std::string cacheFilePath = inProgram->mDiskCachePath + ShaderCacheExtension;
+        std::ofstream cacheFile(cacheFilePath, std::ios::binary | std::ios::trunc);
+        if (!cacheFile.is_open())
+        {
+            LOG_ERROR() << "Failed to write shader cache file: " << cacheFilePath;
+            return false;
+        }
+        cacheFile.write(writer.mData.data(), writer.mData.size());
+        return cacheFile.good();
+    }
+
+    bool ShaderDiskCache::LoadBinary(const std::string& inPath, uint64_t inKey, std::string& outData)
+    {
+        if (!mEnabled || !ReadFile(inPath, outData))
+            return false;
+
+        CacheReader reader(outData);
+        if (reader.ReadUInt32() != ShaderBinaryMagic || reader.ReadUInt64() != inKey || reader.mFailed)
+            return false;
+        outData.erase(0, reader.mOffset);
+        return true;
+    }
+
+    bool ShaderDiskCache::SaveBinary(const std::string& inPath, uint64_t inKey, const void* inData, size_t inSize)
+    {
+        if (!mEnabled)
+            return false;
+
+        std::ofstream binaryFile(inPath, std::ios::binary | std::ios::trunc);
+        if (!binaryFile.is_open())
+        {
+            LOG_ERROR() << "Failed to write shader binary: " << inPath;
+            return false;
+        }
+        binaryFile.write((const char*)&ShaderBinaryMagic, sizeof(ShaderBinaryMagic));
+        binaryFile.write((const char*)&inKey, sizeof(inKey));
+        binaryFile.write((const char*)inData, inSize);
+        return binaryFile.good();
+    }
+}
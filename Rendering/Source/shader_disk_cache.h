@@ -0,0 +1,49 @@
+#ifndef MING3D_SHADERDISKCACHE_H
+#define MING3D_SHADERDISKCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "shader_info.h"
+
+namespace Ming3D
+{
+    /**
+    * Disk cache of converted shader programs, so shaders are only tokenised, parsed and converted the first time a program is used.
+    * Entries are stored next to the program ("<program>.<definitions hash>.cglsl" or ".chlsl"), and contain the reflection data
+    *  (constant buffers, uniforms, textures, vertex inputs) and the converted shaders of the render device (regular and depth-only).
+    * Entries record a content hash of the program and of every included file, and are ignored (then rewritten) when any of them changes.
+    * Render devices may also store compiled program binaries (see LoadBinary/SaveBinary).
+    * Thread safe (entries are only written by the render device, on the main thread).
+    */
+    class ShaderDiskCache
+    {
+    private:
+        static bool mEnabled;
+
+    public:
+        static void SetEnabled(bool inEnabled) { mEnabled = inEnabled; }
+        static bool IsEnabled() { return mEnabled; }
+
+        /** 64 bit FNV-1a hash. Pass the previous hash as seed, to hash several pieces of data. */
+        static uint64_t HashData(const void* inData, size_t inSize, uint64_t inSeed = 14695981039346656037ULL);
+
+        /** Path of the cache entries of a program (without extension), based on the program path and the preprocessor definitions. */
+        static std::string GetCachePath(const ShaderParserParams& inParams);
+
+        /**
+        * Loads a program from the cache. The program has no syntax tree: its converted shaders are in mCachedShaders.
+        * Returns nullptr if the program isn't cached, or if its source has changed.
+        */
+        static ParsedShaderProgram* LoadProgram(const ShaderParserParams& inParams);
+
+        /** Stores a (freshly parsed) program and its converted shaders. Both the regular and the depth-only shaders are required. */
+        static bool SaveProgram(const ParsedShaderProgram* inProgram, const std::vector<std::string>& inConvertedShaders);
+
+        /** Loads a binary that was stored with the same key (e.g. a hash of the shader source and the driver version). */
+        static bool LoadBinary(const std::string& inPath, uint64_t inKey, std::string& outData);
+        static bool SaveBinary(const std::string& inPath, uint64_t inKey, const void* inData, size_t inSize);
+    };
+}
+
+#endif
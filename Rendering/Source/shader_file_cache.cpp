@@ -0,0 +1,79 @@
+#include "shader_file_cache.h"
+#include "shader_disk_cache.h"
+
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace Ming3D
+{
+    std::unordered_map<std::string, std::shared_ptr<const TokenisedShaderFile>> ShaderFileCache::mFiles;
+    std::mutex ShaderFileCache::mMutex;
+
+    std::string ShaderFileCache::FindIncludeGuard(const std::vector<Token>& inTokens)
+    {
+        // Skip line breaks. Comments aren't tokens.
+        std::vector<const Token*> tokens;
+        for (const Token& token : inTokens)
+        {
+            if (token.mTokenType != ETokenType::NewLine)
+                tokens.push_back(&token);
+        }
+        if (tokens.size() < 5 || tokens[0]->mTokenString != "#ifndef" || tokens[2]->mTokenString != "#define" || tokens[1]->mTokenString != tokens[3]->mTokenString)
+            return "";
+
+        // The #endif of the guard must be the last token, and the guard can't have an #else (or #elif) branch
+        int depth = 0;
+        for (size_t i = 0; i < tokens.size(); i++)
+        {
+            const TokenString& tokenString = tokens[i]->mTokenString;
+            if (tokenString == "#ifdef" || tokenString == "#ifndef")
+                depth++;
+            else if ((tokenString == "#else" || tokenString == "#elif") && depth == 1)
+                return "";
+            else if (tokenString == "#endif" && --depth == 0)
+                return i == tokens.size() - 1 ? tokens[1]->mTokenString.GetString() : "";
+        }
+        return "";
+    }
+
+    std::shared_ptr<const TokenisedShaderFile> ShaderFileCache::GetFile(const std::string& inPath)
+    {
+        struct stat fileStat;
+        if (stat(inPath.c_str(), &fileStat) != 0)
+            return nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto fileIter = mFiles.find(inPath);
+            if (fileIter != mFiles.end() && fileIter->second->mModifiedTime == (int64_t)fileStat.st_mtime && fileIter->second->mSize == (size_t)fileStat.st_size)
+                return fileIter->second;
+        }
+
+        // Read and tokenise without holding the lock. Two threads may read the same file: the last one is cached.
+        std::ifstream file(inPath);
+        if (!file.is_open())
+            return nullptr;
+        const std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        std::shared_ptr<TokenisedShaderFile> tokenisedFile = std::make_shared<TokenisedShaderFile>();
+        tokenisedFile->mPath = inPath;
+        tokenisedFile->mHash = ShaderDiskCache::HashData(source.data(), source.size());
+        tokenisedFile->mSize = (size_t)fileStat.st_size; // on disk (the source may be shorter, in text mode)
+        tokenisedFile->mModifiedTime = (int64_t)fileStat.st_mtime;
+        tokenisedFile->mTokens.reserve(source.size() / 4);
+        Tokeniser(source.c_str()).Tokenise(tokenisedFile->mTokens);
+        tokenisedFile->mIncludeGuard = FindIncludeGuard(tokenisedFile->mTokens);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFiles[inPath] = tokenisedFile;
+        return tokenisedFile;
+    }
+
+    void ShaderFileCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFiles.clear();
+    }
+}
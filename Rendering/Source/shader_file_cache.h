@@ -0,0 +1,48 @@
+#ifndef MING3D_SHADERFILECACHE_H
+#define MING3D_SHADERFILECACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "shader_tokeniser.h"
+
+namespace Ming3D
+{
+    /** A tokenised shader source file (program or include). Immutable once cached, so it can be shared by parsing threads. */
+    class TokenisedShaderFile
+    {
+    public:
+        std::string mPath;
+        uint64_t mHash = 0; // content hash (see ShaderDiskCache::HashData)
+        size_t mSize = 0;
+        int64_t mModifiedTime = 0;
+        std::vector<Token> mTokens;
+        std::string mIncludeGuard; // macro of an include guard around the whole file ("#ifndef X", "#define X" ... "#endif"), if any
+    };
+
+    /**
+    * Process wide cache of tokenised shader files, so each file is read and tokenised once, and not once per program and permutation.
+    * Files are re-read when their modification time or size changes.
+    * Thread safe.
+    */
+    class ShaderFileCache
+    {
+    private:
+        static std::unordered_map<std::string, std::shared_ptr<const TokenisedShaderFile>> mFiles;
+        static std::mutex mMutex;
+
+    public:
+        /** Returns the macro of the include guard around the whole file, or an empty string if the file isn't include guarded. */
+        static std::string FindIncludeGuard(const std::vector<Token>& inTokens);
+
+        /** Returns the tokenised file, or nullptr if it can't be read. */
+        static std::shared_ptr<const TokenisedShaderFile> GetFile(const std::string& inPath);
+
+        static void Clear();
+    };
+}
+
+#endif
@@ -42,4 +42,21 @@ namespace Ming3D
         }
         return 0;
     }
+
+    ShaderUniformBlockLayout::ShaderUniformBlockLayout(const std::vector<ShaderVariableInfo>& inUniforms)
+    {
+        for (const ShaderVariableInfo& uniform : inUniforms)
+        {
+            ShaderUniformBlockMember member;
+            member.mDatatype = uniform.mDatatypeInfo.mDatatype;
+            member.mSize = uniform.mDatatypeInfo.GetDataSize();
+            // 4 byte aligned, but may not cross a 16 byte register (matrices start a new register)
+            member.mOffset = (mSize + 3) / 4 * 4;
+            if (member.mSize > 16 || member.mOffset % 16 + member.mSize > 16)
+                member.mOffset = (mSize + 15) / 16 * 16;
+            mSize = member.mOffset + member.mSize;
+            mMembers.push_back(member);
+        }
+        mSize = (mSize + 15) / 16 * 16;
+    }
 }
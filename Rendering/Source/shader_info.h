@@ -4,14 +4,17 @@
 #include <string>
 #include <vector>
 #include "shader_tokeniser.h"
+#include "shader_arena.h"
 #include "glm/glm.hpp"
 #include <map>
+#include <unordered_map>
+#include <cstdint>
 
 namespace Ming3D
 {
     enum class EShaderDatatype
     {
-        None = 0, Struct = 1, Float = 2, Int = 3, Bool = 4, Void = 5, Vec2 = 6, Vec3 = 7, Vec4 = 8, Mat4x4 = 9, Texture2D = 10
+        None = 0, Struct = 1, Float = 2, Int = 3, Bool = 4, Void = 5, Vec2 = 6, Vec3 = 7, Vec4 = 8, Mat4x4 = 9, Texture2D = 10, TexelBuffer = 11, ShadowMapArray = 12, Texture2DArray = 13
     };
 
     class ShaderStructMember; // fwd.decl.
@@ -74,17 +77,22 @@ namespace Ming3D
         BinaryOperation, UnaryOperation, Literal, VariableAccess, FunctionCall
     };
 
+    /*
+    * Syntax tree nodes are allocated from the ShaderArena of their ParsedShaderProgram, and must not be deleted.
+    * Strings are interned TokenStrings, so most nodes need no destruction.
+    */
+
     class ShaderExpression
     {
     public:
-        std::string mValueType; // TODO
+        TokenString mValueType; // TODO
         virtual EExpressionType GetExpressionType() const = 0;
     };
 
     class BinaryOperationExpression : public ShaderExpression
     {
     public:
-        std::string mOperator;
+        TokenString mOperator;
         ShaderExpression* mLeftOperand;
         ShaderExpression* mRightOperand;
         virtual EExpressionType GetExpressionType() const override { return EExpressionType::BinaryOperation; }
@@ -93,7 +101,7 @@ namespace Ming3D
     class UnaryOperationExpression : public ShaderExpression
     {
     public:
-        std::string mOperator;
+        TokenString mOperator;
         ShaderExpression* mOperand;
         virtual EExpressionType GetExpressionType() const override { return EExpressionType::UnaryOperation; }
     };
@@ -135,8 +143,8 @@ namespace Ming3D
     class VariableDefinitionStatement : public ShaderStatement
     {
     public:
-        std::string mVariableType;
-        std::string mVariableName;
+        TokenString mVariableType;
+        TokenString mVariableName;
         ShaderExpression* mAssignmentExpression = nullptr;
         virtual EStatementType GetStatementType() const override { return EStatementType::VariableDefinition; };
     };
@@ -164,7 +172,7 @@ namespace Ming3D
     class ControlStatement : public ShaderStatement
     {
     public:
-        std::string mIdentifier;
+        TokenString mIdentifier;
         ShaderStatementBlock* mExpressionStatements = nullptr;
         ShaderStatementBlock* mStatementBlock = nullptr;
         virtual EStatementType GetStatementType() const override { return EStatementType::ControlStatement; };
@@ -174,7 +182,7 @@ namespace Ming3D
     {
     public:
         ShaderFunctionInfo mFunctionInfo;
-        ShaderStatementBlock* mStatementBlock;
+        ShaderStatementBlock* mStatementBlock = nullptr;
     };
 
     class ConstantBufferInfo
@@ -184,6 +192,30 @@ namespace Ming3D
         std::vector<ShaderVariableInfo> mShaderUniforms;
     };
 
+    /** Location of a uniform in a uniform block. */
+    class ShaderUniformBlockMember
+    {
+    public:
+        EShaderDatatype mDatatype = EShaderDatatype::None;
+        size_t mOffset = 0;
+        size_t mSize = 0;
+    };
+
+    /**
+    * Layout of a program's uniforms (not in a cbuffer) in one contiguous block, in the order of ParsedShaderProgram::mUniforms.
+    * Uses HLSL cbuffer packing, so on D3D11 the block has the layout of the program's uniform constant buffer.
+    * Values are stored like on the CPU (column major matrices), and converted by the render device when uploaded.
+    */
+    class ShaderUniformBlockLayout
+    {
+    public:
+        std::vector<ShaderUniformBlockMember> mMembers;
+        size_t mSize = 0; // padded to 16 bytes
+
+        ShaderUniformBlockLayout() {}
+        ShaderUniformBlockLayout(const std::vector<ShaderVariableInfo>& inUniforms);
+    };
+
     /**
     * Base class for converted (and possibly compiled) shader data.
     */
@@ -201,18 +233,24 @@ namespace Ming3D
         ShaderFunctionDefinition* mMainFunction = nullptr;
         ShaderDatatypeInfo mInput;
         ShaderDatatypeInfo mOutput;
+    };
 
-        ~ParsedShader()
-        {
-            if(mMainFunction != nullptr)
-                delete mMainFunction;
-        }
+    /** A source file of a shader program (the program itself, or an included file), and a hash of its content. */
+    class ShaderSourceFile
+    {
+    public:
+        std::string mPath;
+        uint64_t mHash = 0;
     };
 
     class ParsedShaderProgram
     {
     public:
+        ShaderArena mArena; // owns the syntax tree (shaders, functions, statements and expressions). Declared first, so it's freed last.
         std::string mProgramPath;
+        std::vector<ShaderSourceFile> mSourceFiles; // the program, followed by the files it includes
+        std::string mDiskCachePath; // see ShaderDiskCache (empty if not cached on disk)
+        std::vector<std::string> mCachedShaders; // converted shaders, loaded from the disk cache (programs loaded from the disk cache have no syntax tree)
 
         ParsedShader* mVertexShader = nullptr;
         ParsedShader* mFragmentShader = nullptr;
@@ -221,19 +259,18 @@ namespace Ming3D
         std::vector<ShaderFunctionDefinition*> mFunctionDefinitions;
         std::vector<ConstantBufferInfo> mConstantBufferInfos;
         std::vector<ShaderVariableInfo> mUniforms;
+        ShaderUniformBlockLayout mUniformBlockLayout; // layout of mUniforms
+        std::vector<std::string> mStrippedUniforms; // declared, but unused by this permutation (see ShaderOptimiser). Setting them does nothing.
         std::vector<ShaderTextureInfo> mShaderTextures;
         ConvertedShaderProgram* mConvertedProgram = nullptr;
+        ConvertedShaderProgram* mConvertedDepthOnlyProgram = nullptr;
 
         ~ParsedShaderProgram()
         {
-            for (ShaderFunctionDefinition* def : mFunctionDefinitions)
-                delete def; 
-            if (mVertexShader != nullptr)
-                delete mVertexShader;
-            if (mFragmentShader != nullptr)
-                delete mFragmentShader;
             if (mConvertedProgram != nullptr)
                 delete mConvertedProgram;
+            if (mConvertedDepthOnlyProgram != nullptr)
+                delete mConvertedDepthOnlyProgram;
         }
     };
 
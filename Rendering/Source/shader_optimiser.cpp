@@ -0,0 +1,789 @@
+#include "shader_optimiser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <set>
+#include <sstream>
+
+namespace Ming3D
+{
+    namespace
+    {
+        enum class EConstantType
+        {
+            Bool, Int, Float
+        };
+
+        class ConstantValue
+        {
+        public:
+            EConstantType mType = EConstantType::Int;
+            bool mBool = false;
+            long long mInt = 0;
+            float mFloat = 0.0f;
+
+            float GetFloat() const { return mType == EConstantType::Int ? (float)mInt : mFloat; }
+        };
+
+        bool IsAssignmentOperator(const TokenString& inOperator)
+        {
+            return inOperator == "=" || inOperator == "+=" || inOperator == "-=";
+        }
+
+        /** Value of a literal. The value is read from the token string, since the tokeniser drops the sign of negative literals. */
+        bool GetConstant(const ShaderExpression* inExpression, ConstantValue& outValue)
+        {
+            if (inExpression == nullptr || inExpression->GetExpressionType() != EExpressionType::Literal)
+                return false;
+
+            const Token& token = ((const LiteralExpression*)inExpression)->mToken;
+            const bool isParenthesised = token.mTokenString[0] == '('; // folded negative value (see CreateLiteral)
+            const char* str = token.mTokenString.c_str() + (isParenthesised ? 1 : 0);
+            const char* suffix = isParenthesised ? ")" : "";
+            char* end = nullptr;
+            switch (token.mTokenType)
+            {
+            case ETokenType::BooleanLiteral:
+                outValue.mType = EConstantType::Bool;
+                outValue.mBool = token.mTokenString == "true";
+                return true;
+            case ETokenType::IntegerLiteral:
+                outValue.mType = EConstantType::Int;
+                outValue.mInt = strtoll(str, &end, 0);
+                return end != str && strcmp(end, suffix) == 0;
+            case ETokenType::FloatLiteral:
+                outValue.mType = EConstantType::Float;
+                outValue.mFloat = strtof(str, &end);
+                if (*end == 'f')
+                    end++;
+                return end != str && strcmp(end, suffix) == 0;
+            default:
+                return false;
+            }
+        }
+
+        bool EvaluateUnaryOperation(const TokenString& inOperator, const ConstantValue& inOperand, ConstantValue& outValue)
+        {
+            outValue = inOperand;
+            if (inOperator == "!")
+            {
+                outValue.mBool = !inOperand.mBool;
+                return inOperand.mType == EConstantType::Bool;
+            }
+            if (inOperand.mType == EConstantType::Bool)
+                return false;
+            if (inOperator == "+")
+                return true;
+            if (inOperator == "-")
+            {
+                outValue.mInt = -inOperand.mInt;
+                outValue.mFloat = -inOperand.mFloat;
+                return true;
+            }
+            return false; // ++ and -- modify their operand
+        }
+
+        bool EvaluateBinaryOperation(const TokenString& inOperator, const ConstantValue& inLeft, const ConstantValue& inRight, ConstantValue& outValue)
+        {
+            const std::string& op = inOperator;
+            const bool isLeftBool = inLeft.mType == EConstantType::Bool;
+            const bool isRightBool = inRight.mType == EConstantType::Bool;
+            if (isLeftBool || isRightBool)
+            {
+                if (!isLeftBool || !isRightBool)
+                    return false;
+                outValue.mType = EConstantType::Bool;
+                if (op == "&&")
+                    outValue.mBool = inLeft.mBool && inRight.mBool;
+                else if (op == "||")
+                    outValue.mBool = inLeft.mBool || inRight.mBool;
+                else if (op == "^^" || op == "!=")
+                    outValue.mBool = inLeft.mBool != inRight.mBool;
+                else if (op == "==")
+                    outValue.mBool = inLeft.mBool == inRight.mBool;
+                else
+                    return false;
+                return true;
+            }
+
+            if (op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=")
+            {
+                outValue.mType = EConstantType::Bool;
+                const float left = inLeft.GetFloat();
+                const float right = inRight.GetFloat();
+                const bool isInt = inLeft.mType == EConstantType::Int && inRight.mType == EConstantType::Int;
+                if (op == "<")
+                    outValue.mBool = isInt ? inLeft.mInt < inRight.mInt : left < right;
+                else if (op == ">")
+                    outValue.mBool = isInt ? inLeft.mInt > inRight.mInt : left > right;
+                else if (op == "<=")
+                    outValue.mBool = isInt ? inLeft.mInt <= inRight.mInt : left <= right;
+                else if (op == ">=")
+                    outValue.mBool = isInt ? inLeft.mInt >= inRight.mInt : left >= right;
+                else if (op == "==")
+                    outValue.mBool = isInt ? inLeft.mInt == inRight.mInt : left == right;
+                else
+                    outValue.mBool = isInt ? inLeft.mInt != inRight.mInt : left != right;
+                return true;
+            }
+
+            if (inLeft.mType == EConstantType::Int && inRight.mType == EConstantType::Int)
+            {
+                outValue.mType = EConstantType::Int;
+                if (op == "+")
+                    outValue.mInt = inLeft.mInt + inRight.mInt;
+                else if (op == "-")
+                    outValue.mInt = inLeft.mInt - inRight.mInt;
+                else if (op == "*")
+                    outValue.mInt = inLeft.mInt * inRight.mInt;
+                else if (op == "/" && inRight.mInt != 0)
+                    outValue.mInt = inLeft.mInt / inRight.mInt;
+                else
+                    return false;
+                return outValue.mInt >= std::numeric_limits<int>::min() && outValue.mInt <= std::numeric_limits<int>::max();
+            }
+
+            // Ints are implicitly converted to float when mixed with floats
+            outValue.mType = EConstantType::Float;
+            if (op == "+")
+                outValue.mFloat = inLeft.GetFloat() + inRight.GetFloat();
+            else if (op == "-")
+                outValue.mFloat = inLeft.GetFloat() - inRight.GetFloat();
+            else if (op == "*")
+                outValue.mFloat = inLeft.GetFloat() * inRight.GetFloat();
+            else if (op == "/")
+                outValue.mFloat = inLeft.GetFloat() / inRight.GetFloat();
+            else
+                return false;
+            return std::isfinite(outValue.mFloat);
+        }
+
+        /**
+        * Creates a literal for a folded value.
+        * Negative values are written in parentheses, so they can't merge with a preceding operator ("a - -1.0" would be written as "(a--1.0)").
+        */
+        LiteralExpression* CreateLiteral(ShaderArena& inArena, const ConstantValue& inValue)
+        {
+            std::ostringstream ss;
+            Token token;
+            switch (inValue.mType)
+            {
+            case EConstantType::Bool:
+                token.mTokenType = ETokenType::BooleanLiteral;
+                ss << (inValue.mBool ? "true" : "false");
+                break;
+            case EConstantType::Int:
+                token.mTokenType = ETokenType::IntegerLiteral;
+                token.mIntValue = (int)inValue.mInt;
+                ss << inValue.mInt;
+                break;
+            case EConstantType::Float:
+            {
+                token.mTokenType = ETokenType::FloatLiteral;
+                token.mFloatValue = inValue.mFloat;
+                ss << std::setprecision(9) << inValue.mFloat; // enough digits to read back the same float
+                if (ss.str().find_first_of(".e") == std::string::npos)
+                    ss << ".0";
+                break;
+            }
+            }
+
+            LiteralExpression* literal = inArena.New<LiteralExpression>();
+            const std::string str = ss.str();
+            token.mTokenString = str[0] == '-' ? "(" + str + ")" : str;
+            literal->mToken = token;
+            return literal;
+        }
+
+        template <typename Func>
+        void ForEachExpression(const ShaderStatementBlock* inStatementBlock, Func&& inFunc);
+
+        /** Calls inFunc on each expression of a statement (but not on their subexpressions), including nested blocks. */
+        template <typename Func>
+        void ForEachExpression(const ShaderStatement* inStatement, Func&& inFunc)
+        {
+            switch (inStatement->GetStatementType())
+            {
+            case EStatementType::VariableDefinition:
+                if (((const VariableDefinitionStatement*)inStatement)->mAssignmentExpression != nullptr)
+                    inFunc(((const VariableDefinitionStatement*)inStatement)->mAssignmentExpression);
+                break;
+            case EStatementType::Expression:
+                inFunc(((const ExpressionStatement*)inStatement)->mExpression);
+                break;
+            case EStatementType::ReturnStatement:
+                if (((const ReturnStatement*)inStatement)->mReturnValueExpression != nullptr)
+                    inFunc(((const ReturnStatement*)inStatement)->mReturnValueExpression);
+                break;
+            case EStatementType::ControlStatement:
+                ForEachExpression(((const ControlStatement*)inStatement)->mExpressionStatements, inFunc);
+                ForEachExpression(((const ControlStatement*)inStatement)->mStatementBlock, inFunc);
+                break;
+            }
+        }
+
+        template <typename Func>
+        void ForEachExpression(const ShaderStatementBlock* inStatementBlock, Func&& inFunc)
+        {
+            if (inStatementBlock == nullptr)
+                return;
+            for (const ShaderStatement* statement : inStatementBlock->mStatements)
+                ForEachExpression(statement, inFunc);
+        }
+
+        /** Calls inFunc on an expression and all its subexpressions. */
+        template <typename Func>
+        void ForEachSubexpression(const ShaderExpression* inExpression, Func&& inFunc)
+        {
+            if (inExpression == nullptr)
+                return;
+            inFunc(inExpression);
+            switch (inExpression->GetExpressionType())
+            {
+            case EExpressionType::BinaryOperation:
+                ForEachSubexpression(((const BinaryOperationExpression*)inExpression)->mLeftOperand, inFunc);
+                ForEachSubexpression(((const BinaryOperationExpression*)inExpression)->mRightOperand, inFunc);
+                break;
+            case EExpressionType::UnaryOperation:
+                ForEachSubexpression(((const UnaryOperationExpression*)inExpression)->mOperand, inFunc);
+                break;
+            case EExpressionType::VariableAccess:
+                ForEachSubexpression(((const VariableAccessExpression*)inExpression)->mOuterExpression, inFunc);
+                break;
+            case EExpressionType::FunctionCall:
+                for (const ShaderExpression* paramExpression : ((const FunctionCallExpression*)inExpression)->mParameterExpressions)
+                    ForEachSubexpression(paramExpression, inFunc);
+                break;
+            default:
+                break;
+            }
+        }
+
+        /** Assignments, increments and fragment output. Other functions can't have side effects (there are no out parameters or globals). */
+        bool HasSideEffects(const ShaderExpression* inExpression)
+        {
+            bool sideEffects = false;
+            ForEachSubexpression(inExpression, [&sideEffects](const ShaderExpression* inSubexpression)
+            {
+                switch (inSubexpression->GetExpressionType())
+                {
+                case EExpressionType::BinaryOperation:
+                    sideEffects |= IsAssignmentOperator(((const BinaryOperationExpression*)inSubexpression)->mOperator);
+                    break;
+                case EExpressionType::UnaryOperation:
+                {
+                    const TokenString& op = ((const UnaryOperationExpression*)inSubexpression)->mOperator;
+                    sideEffects |= op == "++" || op == "--";
+                    break;
+                }
+                case EExpressionType::FunctionCall:
+                    sideEffects |= ((const FunctionCallExpression*)inSubexpression)->mIdentifier.mTokenString == "SetFragmentColour";
+                    break;
+                default:
+                    break;
+                }
+            });
+            return sideEffects;
+        }
+
+        /** Returns the member name if the expression is "inVariableName.member". */
+        const VariableAccessExpression* GetMemberAccess(const ShaderExpression* inExpression, const std::string& inVariableName)
+        {
+            if (inExpression->GetExpressionType() != EExpressionType::VariableAccess)
+                return nullptr;
+            const VariableAccessExpression* memberAccess = (const VariableAccessExpression*)inExpression;
+            const ShaderExpression* outerExpression = memberAccess->mOuterExpression;
+            if (outerExpression == nullptr || outerExpression->GetExpressionType() != EExpressionType::VariableAccess)
+                return nullptr;
+            const VariableAccessExpression* variableAccess = (const VariableAccessExpression*)outerExpression;
+            if (variableAccess->mOuterExpression != nullptr || variableAccess->mIdentifier.mTokenString != inVariableName)
+                return nullptr;
+            return memberAccess;
+        }
+
+        /**
+        * Collects the members of a struct variable that are accessed by an expression.
+        * Sets outWholeAccess if the variable is used as a whole (e.g. passed to a function), since then any member may be read.
+        */
+        void CollectMemberAccesses(const ShaderExpression* inExpression, const std::string& inVariableName, std::set<std::string>& outMembers, bool& outWholeAccess)
+        {
+            switch (inExpression->GetExpressionType())
+            {
+            case EExpressionType::BinaryOperation:
+                CollectMemberAccesses(((const BinaryOperationExpression*)inExpression)->mLeftOperand, inVariableName, outMembers, outWholeAccess);
+                CollectMemberAccesses(((const BinaryOperationExpression*)inExpression)->mRightOperand, inVariableName, outMembers, outWholeAccess);
+                break;
+            case EExpressionType::UnaryOperation:
+                CollectMemberAccesses(((const UnaryOperationExpression*)inExpression)->mOperand, inVariableName, outMembers, outWholeAccess);
+                break;
+            case EExpressionType::FunctionCall:
+                for (const ShaderExpression* paramExpression : ((const FunctionCallExpression*)inExpression)->mParameterExpressions)
+                    CollectMemberAccesses(paramExpression, inVariableName, outMembers, outWholeAccess);
+                break;
+            case EExpressionType::VariableAccess:
+            {
+                const VariableAccessExpression* variableAccess = (const VariableAccessExpression*)inExpression;
+                if (const VariableAccessExpression* memberAccess = GetMemberAccess(inExpression, inVariableName))
+                    outMembers.insert(memberAccess->mIdentifier.mTokenString);
+                else if (variableAccess->mOuterExpression != nullptr)
+                    CollectMemberAccesses(variableAccess->mOuterExpression, inVariableName, outMembers, outWholeAccess);
+                else if (variableAccess->mIdentifier.mTokenString == inVariableName)
+                    outWholeAccess = true;
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        /** True if a variable of the given type is defined in the statement block (or in nested blocks). */
+        bool DefinesVariableOfType(const ShaderStatementBlock* inStatementBlock, const std::string& inTypeName, bool inNested = true)
+        {
+            if (inStatementBlock == nullptr)
+                return false;
+            for (const ShaderStatement* statement : inStatementBlock->mStatements)
+            {
+                if (statement->GetStatementType() == EStatementType::VariableDefinition)
+                {
+                    if (inTypeName.empty() || ((const VariableDefinitionStatement*)statement)->mVariableType == inTypeName)
+                        return true;
+                }
+                else if (inNested && statement->GetStatementType() == EStatementType::ControlStatement)
+                {
+                    const ControlStatement* controlStatement = (const ControlStatement*)statement;
+                    if (DefinesVariableOfType(controlStatement->mExpressionStatements, inTypeName) || DefinesVariableOfType(controlStatement->mStatementBlock, inTypeName))
+                        return true;
+                }
+            }
+            return false;
+        }
+
+        /** Value of a control statement's condition, if it's a constant. */
+        bool GetConstantCondition(const ControlStatement* inStatement, bool& outValue)
+        {
+            const ShaderStatementBlock* condition = inStatement->mExpressionStatements;
+            if (condition == nullptr || condition->mStatements.size() != 1 || condition->mStatements[0]->GetStatementType() != EStatementType::Expression)
+                return false;
+            ConstantValue value;
+            if (!GetConstant(((const ExpressionStatement*)condition->mStatements[0])->mExpression, value) || value.mType != EConstantType::Bool)
+                return false;
+            outValue = value.mBool;
+            return true;
+        }
+
+        void RemoveStructMembers(ShaderDatatypeInfo& inOutDatatype, const std::set<std::string>& inMembers)
+        {
+            std::vector<ShaderStructMember>& members = inOutDatatype.mMemberVariables;
+            members.erase(std::remove_if(members.begin(), members.end(), [&inMembers](const ShaderStructMember& inMember) { return inMembers.count(inMember.mName) > 0; }), members.end());
+        }
+    }
+
+    ShaderExpression* ShaderOptimiser::FoldExpression(ShaderExpression* inExpression)
+    {
+        if (inExpression == nullptr)
+            return nullptr;
+
+        switch (inExpression->GetExpressionType())
+        {
+        case EExpressionType::BinaryOperation:
+        {
+            BinaryOperationExpression* binaryExpr = (BinaryOperationExpression*)inExpression;
+            binaryExpr->mLeftOperand = FoldExpression(binaryExpr->mLeftOperand);
+            binaryExpr->mRightOperand = FoldExpression(binaryExpr->mRightOperand);
+            if (IsAssignmentOperator(binaryExpr->mOperator))
+                return binaryExpr;
+
+            ConstantValue left, right, result;
+            const bool isLeftConstant = GetConstant(binaryExpr->mLeftOperand, left);
+            const bool isRightConstant = GetConstant(binaryExpr->mRightOperand, right);
+            if (isLeftConstant && isRightConstant)
+            {
+                if (EvaluateBinaryOperation(binaryExpr->mOperator, left, right, result))
+                    return CreateLiteral(mProgram->mArena, result);
+            }
+            else if (isLeftConstant && left.mType == EConstantType::Bool && (binaryExpr->mOperator == "&&" || binaryExpr->mOperator == "||"))
+            {
+                // true && x => x, false || x => x, and the other side is skipped if the result is known
+                const bool isResultKnown = left.mBool == (binaryExpr->mOperator == "||");
+                return isResultKnown ? binaryExpr->mLeftOperand : binaryExpr->mRightOperand;
+            }
+            else if (isRightConstant && right.mType == EConstantType::Bool && (binaryExpr->mOperator == "&&" || binaryExpr->mOperator == "||"))
+            {
+                const bool isResultKnown = right.mBool == (binaryExpr->mOperator == "||");
+                if (!isResultKnown)
+                    return binaryExpr->mLeftOperand;
+                else if (!HasSideEffects(binaryExpr->mLeftOperand))
+                    return binaryExpr->mRightOperand;
+            }
+            return binaryExpr;
+        }
+        case EExpressionType::UnaryOperation:
+        {
+            UnaryOperationExpression* unaryExpr = (UnaryOperationExpression*)inExpression;
+            unaryExpr->mOperand = FoldExpression(unaryExpr->mOperand);
+            ConstantValue operand, result;
+            if (GetConstant(unaryExpr->mOperand, operand) && EvaluateUnaryOperation(unaryExpr->mOperator, operand, result))
+                return CreateLiteral(mProgram->mArena, result);
+            return unaryExpr;
+        }
+        case EExpressionType::VariableAccess:
+        {
+            VariableAccessExpression* varAccessExpr = (VariableAccessExpression*)inExpression;
+            varAccessExpr->mOuterExpression = FoldExpression(varAccessExpr->mOuterExpression);
+            return varAccessExpr;
+        }
+        case EExpressionType::FunctionCall:
+        {
+            FunctionCallExpression* funcCallExpr = (FunctionCallExpression*)inExpression;
+            for (ShaderExpression*& paramExpression : funcCallExpr->mParameterExpressions)
+                paramExpression = FoldExpression(paramExpression);
+            return funcCallExpr;
+        }
+        default:
+            return inExpression;
+        }
+    }
+
+    void ShaderOptimiser::OptimiseStatement(ShaderStatement* inStatement)
+    {
+        switch (inStatement->GetStatementType())
+        {
+        case EStatementType::VariableDefinition:
+        {
+            VariableDefinitionStatement* varDefStatement = (VariableDefinitionStatement*)inStatement;
+            varDefStatement->mAssignmentExpression = FoldExpression(varDefStatement->mAssignmentExpression);
+            break;
+        }
+        case EStatementType::Expression:
+        {
+            ExpressionStatement* expressionStatement = (ExpressionStatement*)inStatement;
+            expressionStatement->mExpression = FoldExpression(expressionStatement->mExpression);
+            break;
+        }
+        case EStatementType::ReturnStatement:
+        {
+            ReturnStatement* returnStatement = (ReturnStatement*)inStatement;
+            returnStatement->mReturnValueExpression = FoldExpression(returnStatement->mReturnValueExpression);
+            break;
+        }
+        case EStatementType::ControlStatement:
+        {
+            // The condition is a statement block, so the for loop's init statement is a statement too
+            ControlStatement* controlStatement = (ControlStatement*)inStatement;
+            if (controlStatement->mExpressionStatements != nullptr)
+            {
+                for (ShaderStatement* statement : controlStatement->mExpressionStatements->mStatements)
+                    OptimiseStatement(statement);
+            }
+            if (controlStatement->mStatementBlock != nullptr)
+                OptimiseStatementBlock(controlStatement->mStatementBlock);
+            break;
+        }
+        }
+    }
+
+    void ShaderOptimiser::AppendBranches(const std::vector<ControlStatement*>& inChain, std::vector<ShaderStatement*>& outStatements)
+    {
+        // Branches that can be taken. The last one is always taken if isLastUnconditional is set.
+        std::vector<ControlStatement*> branches;
+        bool isLastUnconditional = false;
+        for (ControlStatement* branch : inChain)
+        {
+            bool condition = false;
+            const bool isConstant = GetConstantCondition(branch, condition);
+            if (isConstant && !condition)
+                continue;
+            branches.push_back(branch);
+            if (branch->mIdentifier == "else" || isConstant)
+            {
+                isLastUnconditional = true;
+                break;
+            }
+        }
+
+        if (branches.empty())
+            return;
+
+        if (branches.size() == 1 && isLastUnconditional)
+        {
+            // Only one branch is taken. Its statements are moved out of the branch, unless they define variables (which would leak into the outer scope).
+            ControlStatement* branch = branches[0];
+            if (!DefinesVariableOfType(branch->mStatementBlock, "", false))
+            {
+                outStatements.insert(outStatements.end(), branch->mStatementBlock->mStatements.begin(), branch->mStatementBlock->mStatements.end());
+                return;
+            }
+            if (branch->mIdentifier == "else")
+            {
+                ConstantValue trueValue;
+                trueValue.mType = EConstantType::Bool;
+                trueValue.mBool = true;
+                ExpressionStatement* condition = mProgram->mArena.New<ExpressionStatement>();
+                condition->mExpression = CreateLiteral(mProgram->mArena, trueValue);
+                branch->mExpressionStatements = mProgram->mArena.New<ShaderStatementBlock>();
+                branch->mExpressionStatements->mStatements.push_back(condition);
+            }
+        }
+
+        // The first remaining branch starts the chain (it may have been an "else if")
+        branches[0]->mIdentifier = "if";
+        outStatements.insert(outStatements.end(), branches.begin(), branches.end());
+    }
+
+    void ShaderOptimiser::OptimiseStatementBlock(ShaderStatementBlock* inStatementBlock)
+    {
+        for (ShaderStatement* statement : inStatementBlock->mStatements)
+            OptimiseStatement(statement);
+
+        // Remove dead branches, and statements after return
+        std::vector<ShaderStatement*> statements;
+        statements.reserve(inStatementBlock->mStatements.size());
+        const std::vector<ShaderStatement*>& oldStatements = inStatementBlock->mStatements;
+        for (size_t iStatement = 0; iStatement < oldStatements.size(); iStatement++)
+        {
+            ShaderStatement* statement = oldStatements[iStatement];
+            if (statement->GetStatementType() == EStatementType::ControlStatement)
+            {
+                ControlStatement* controlStatement = (ControlStatement*)statement;
+                bool condition = false;
+                if (controlStatement->mIdentifier == "if")
+                {
+                    std::vector<ControlStatement*> chain = { controlStatement };
+                    while (iStatement + 1 < oldStatements.size() && oldStatements[iStatement + 1]->GetStatementType() == EStatementType::ControlStatement
+                        && chain.back()->mIdentifier != "else")
+                    {
+                        ControlStatement* nextStatement = (ControlStatement*)oldStatements[iStatement + 1];
+                        if (nextStatement->mIdentifier != "else if" && nextStatement->mIdentifier != "else")
+                            break;
+                        chain.push_back(nextStatement);
+                        iStatement++;
+                    }
+                    AppendBranches(chain, statements);
+                    continue;
+                }
+                else if (controlStatement->mIdentifier == "while" && GetConstantCondition(controlStatement, condition) && !condition)
+                {
+                    continue;
+                }
+            }
+
+            statements.push_back(statement);
+            if (statement->GetStatementType() == EStatementType::ReturnStatement)
+                break;
+        }
+
+        // Statements moved out of a branch may contain a return
+        auto returnIter = std::find_if(statements.begin(), statements.end(), [](const ShaderStatement* inStatement) { return inStatement->GetStatementType() == EStatementType::ReturnStatement; });
+        if (returnIter != statements.end())
+            statements.erase(returnIter + 1, statements.end());
+
+        inStatementBlock->mStatements = std::move(statements);
+    }
+
+    std::vector<ShaderFunctionDefinition*> ShaderOptimiser::GetShaderFunctions(const ParsedShader* inShader) const
+    {
+        std::vector<ShaderFunctionDefinition*> functions = inShader->mFunctionDefinitions;
+        functions.insert(functions.end(), mProgram->mFunctionDefinitions.begin(), mProgram->mFunctionDefinitions.end());
+        if (inShader->mMainFunction != nullptr)
+            functions.push_back(inShader->mMainFunction);
+        return functions;
+    }
+
+    void ShaderOptimiser::RemoveUnusedVaryings()
+    {
+        ParsedShader* vertexShader = mProgram->mVertexShader;
+        ParsedShader* fragmentShader = mProgram->mFragmentShader;
+        ShaderFunctionDefinition* vertexMain = vertexShader->mMainFunction;
+        ShaderFunctionDefinition* fragmentMain = fragmentShader->mMainFunction;
+        const std::string& structName = fragmentShader->mInput.mName;
+        const std::string& outputName = vertexMain->mFunctionInfo.mParameters[1].mName;
+        const std::string& inputName = fragmentMain->mFunctionInfo.mParameters[0].mName;
+
+        // The struct must only be used to pass data from the vertex shader to the fragment shader
+        if (vertexShader->mInput.mName == structName)
+            return;
+        for (const ParsedShader* shader : { vertexShader, fragmentShader })
+        {
+            for (const ShaderFunctionDefinition* function : GetShaderFunctions(shader))
+            {
+                if (DefinesVariableOfType(function->mStatementBlock, structName))
+                    return;
+                if (function == shader->mMainFunction)
+                    continue;
+                for (const ShaderVariableInfo& param : function->mFunctionInfo.mParameters)
+                {
+                    if (param.mDatatypeInfo.mName == structName)
+                        return;
+                }
+            }
+        }
+
+        // Members read by the fragment shader
+        std::set<std::string> usedMembers;
+        bool isWholeStructUsed = false;
+        ForEachExpression(fragmentMain->mStatementBlock, [&](const ShaderExpression* inExpression)
+        {
+            CollectMemberAccesses(inExpression, inputName, usedMembers, isWholeStructUsed);
+        });
+
+        // Members read by the vertex shader. Writes are removed along with the members ("output.member = expression;" in main's outer scope).
+        std::vector<ShaderStatement*>& vertexStatements = vertexMain->mStatementBlock->mStatements;
+        std::vector<const VariableAccessExpression*> memberWrites(vertexStatements.size(), nullptr);
+        for (size_t iStatement = 0; iStatement < vertexStatements.size(); iStatement++)
+        {
+            const ShaderStatement* statement = vertexStatements[iStatement];
+            if (statement->GetStatementType() == EStatementType::Expression)
+            {
+                const ShaderExpression* expression = ((const ExpressionStatement*)statement)->mExpression;
+                if (expression->GetExpressionType() == EExpressionType::BinaryOperation && ((const BinaryOperationExpression*)expression)->mOperator == "=")
+                {
+                    const BinaryOperationExpression* assignment = (const BinaryOperationExpression*)expression;
+                    memberWrites[iStatement] = GetMemberAccess(assignment->mLeftOperand, outputName);
+                    if (memberWrites[iStatement] != nullptr && !HasSideEffects(assignment->mRightOperand))
+                    {
+                        CollectMemberAccesses(assignment->mRightOperand, outputName, usedMembers, isWholeStructUsed);
+                        continue;
+                    }
+                    memberWrites[iStatement] = nullptr;
+                }
+            }
+            ForEachExpression(statement, [&](const ShaderExpression* inExpression)
+            {
+                CollectMemberAccesses(inExpression, outputName, usedMembers, isWholeStructUsed);
+            });
+        }
+        if (isWholeStructUsed)
+            return;
+
+        // The vertex position is required by the rasteriser
+        std::set<std::string> unusedMembers;
+        for (const ShaderStructMember& member : fragmentShader->mInput.mMemberVariables)
+        {
+            if (usedMembers.count(member.mName) == 0 && member.mSemantic != "SV_POSITION")
+                unusedMembers.insert(member.mName);
+        }
+        if (unusedMembers.empty())
+            return;
+
+        std::vector<ShaderStatement*> statements;
+        for (size_t iStatement = 0; iStatement < vertexStatements.size(); iStatement++)
+        {
+            if (memberWrites[iStatement] == nullptr || unusedMembers.count(memberWrites[iStatement]->mIdentifier.mTokenString) == 0)
+                statements.push_back(vertexStatements[iStatement]);
+        }
+        vertexStatements = std::move(statements);
+
+        RemoveStructMembers(vertexShader->mOutput, unusedMembers);
+        RemoveStructMembers(vertexMain->mFunctionInfo.mParameters[1].mDatatypeInfo, unusedMembers);
+        RemoveStructMembers(fragmentShader->mInput, unusedMembers);
+        RemoveStructMembers(fragmentMain->mFunctionInfo.mParameters[0].mDatatypeInfo, unusedMembers);
+        for (std::vector<ShaderDatatypeInfo>* structDefinitions : { &mProgram->mStructDefinitions, &vertexShader->mStructDefinitions, &fragmentShader->mStructDefinitions })
+        {
+            for (ShaderDatatypeInfo& structDefinition : *structDefinitions)
+            {
+                if (structDefinition.mName == structName)
+                    RemoveStructMembers(structDefinition, unusedMembers);
+            }
+        }
+    }
+
+    void ShaderOptimiser::RemoveUnusedFunctions()
+    {
+        // Functions are called by name, so all overloads of a called function are kept
+        std::set<std::string> usedProgramFunctions;
+        for (ParsedShader* shader : { mProgram->mVertexShader, mProgram->mFragmentShader })
+        {
+            const std::vector<ShaderFunctionDefinition*> functions = GetShaderFunctions(shader);
+            std::set<std::string> calledFunctions;
+            std::vector<const ShaderFunctionDefinition*> pendingFunctions = { shader->mMainFunction };
+            while (!pendingFunctions.empty())
+            {
+                const ShaderFunctionDefinition* function = pendingFunctions.back();
+                pendingFunctions.pop_back();
+                ForEachExpression(function->mStatementBlock, [&](const ShaderExpression* inExpression)
+                {
+                    ForEachSubexpression(inExpression, [&](const ShaderExpression* inSubexpression)
+                    {
+                        if (inSubexpression->GetExpressionType() != EExpressionType::FunctionCall)
+                            return;
+                        const std::string& functionName = ((const FunctionCallExpression*)inSubexpression)->mIdentifier.mTokenString;
+                        if (!calledFunctions.insert(functionName).second)
+                            return;
+                        for (const ShaderFunctionDefinition* calledFunction : functions)
+                        {
+                            if (calledFunction->mFunctionInfo.mFunctionName == functionName)
+                                pendingFunctions.push_back(calledFunction);
+                        }
+                    });
+                });
+            }
+
+            std::vector<ShaderFunctionDefinition*>& shaderFunctions = shader->mFunctionDefinitions;
+            shaderFunctions.erase(std::remove_if(shaderFunctions.begin(), shaderFunctions.end(), [&calledFunctions](const ShaderFunctionDefinition* inFunction)
+            {
+                return calledFunctions.count(inFunction->mFunctionInfo.mFunctionName) == 0;
+            }), shaderFunctions.end());
+            usedProgramFunctions.insert(calledFunctions.begin(), calledFunctions.end());
+        }
+
+        std::vector<ShaderFunctionDefinition*>& programFunctions = mProgram->mFunctionDefinitions;
+        programFunctions.erase(std::remove_if(programFunctions.begin(), programFunctions.end(), [&usedProgramFunctions](const ShaderFunctionDefinition* inFunction)
+        {
+            return usedProgramFunctions.count(inFunction->mFunctionInfo.mFunctionName) == 0;
+        }), programFunctions.end());
+    }
+
+    void ShaderOptimiser::RemoveUnusedUniforms()
+    {
+        // Local variables may hide uniforms of the same name, which keeps the uniform (harmless)
+        std::set<std::string> referencedVariables;
+        for (const ParsedShader* shader : { mProgram->mVertexShader, mProgram->mFragmentShader })
+        {
+            for (const ShaderFunctionDefinition* function : GetShaderFunctions(shader))
+            {
+                ForEachExpression(function->mStatementBlock, [&referencedVariables](const ShaderExpression* inExpression)
+                {
+                    ForEachSubexpression(inExpression, [&referencedVariables](const ShaderExpression* inSubexpression)
+                    {
+                        if (inSubexpression->GetExpressionType() == EExpressionType::VariableAccess && ((const VariableAccessExpression*)inSubexpression)->mOuterExpression == nullptr)
+                            referencedVariables.insert(((const VariableAccessExpression*)inSubexpression)->mIdentifier.mTokenString);
+                    });
+                });
+            }
+        }
+
+        std::vector<ShaderVariableInfo> uniforms;
+        for (ShaderVariableInfo& uniform : mProgram->mUniforms)
+        {
+            if (referencedVariables.count(uniform.mName) > 0)
+                uniforms.push_back(uniform);
+            else
+                mProgram->mStrippedUniforms.push_back(uniform.mName);
+        }
+        mProgram->mUniforms = std::move(uniforms);
+    }
+
+    void ShaderOptimiser::OptimiseProgram()
+    {
+        if (mProgram->mVertexShader == nullptr || mProgram->mFragmentShader == nullptr)
+            return;
+
+        for (const ParsedShader* shader : { mProgram->mVertexShader, mProgram->mFragmentShader })
+        {
+            for (ShaderFunctionDefinition* function : shader->mFunctionDefinitions)
+                OptimiseStatementBlock(function->mStatementBlock);
+            OptimiseStatementBlock(shader->mMainFunction->mStatementBlock);
+        }
+        for (ShaderFunctionDefinition* function : mProgram->mFunctionDefinitions)
+            OptimiseStatementBlock(function->mStatementBlock);
+
+        // Removing varyings may leave functions and uniforms unused, so they go last
+        RemoveUnusedVaryings();
+        RemoveUnusedFunctions();
+        RemoveUnusedUniforms();
+    }
+}
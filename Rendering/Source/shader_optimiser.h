@@ -0,0 +1,44 @@
+#ifndef MING3D_SHADEROPTIMISER_H
+#define MING3D_SHADEROPTIMISER_H
+
+#include <string>
+#include <vector>
+#include "shader_info.h"
+
+namespace Ming3D
+{
+    /**
+    * Optimises the syntax tree of a parsed shader program, before it's converted by the shader writers.
+    * Runs after the preprocessor, so the permutation's definitions have already been applied.
+    *  - Folds expressions of literals, and removes branches with constant conditions.
+    *  - Removes fragment shader inputs (varyings) that are never read, and the vertex shader code that writes them.
+    *  - Removes functions that can't be reached from main.
+    *  - Removes uniforms that are no longer referenced (see ParsedShaderProgram::mStrippedUniforms).
+    * Textures and cbuffer members are kept, since their binding slots and layouts are shared with the engine.
+    * New nodes are allocated from the program's arena.
+    */
+    class ShaderOptimiser
+    {
+    private:
+        ParsedShaderProgram* mProgram;
+
+        ShaderExpression* FoldExpression(ShaderExpression* inExpression);
+        void OptimiseStatement(ShaderStatement* inStatement);
+        void OptimiseStatementBlock(ShaderStatementBlock* inStatementBlock);
+        /** Removes the constant branches of an if/else if chain, and appends the remaining statements. */
+        void AppendBranches(const std::vector<ControlStatement*>& inChain, std::vector<ShaderStatement*>& outStatements);
+
+        void RemoveUnusedVaryings();
+        void RemoveUnusedFunctions();
+        void RemoveUnusedUniforms();
+
+        std::vector<ShaderFunctionDefinition*> GetShaderFunctions(const ParsedShader* inShader) const;
+
+    public:
+        ShaderOptimiser(ParsedShaderProgram* inProgram) : mProgram(inProgram) {}
+
+        void OptimiseProgram();
+    };
+}
+
+#endif
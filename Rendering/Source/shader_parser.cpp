@@ -1,12 +1,14 @@
 #include "shader_parser.h"
 
-#include <fstream>
 #include <string>
 #include <numeric>
 #include "Debug/debug.h"
 #include "Debug/st_assert.h"
 #include "shader_tokeniser.h"
 #include "shader_preprocessor.h"
+#include "shader_disk_cache.h"
+#include "shader_file_cache.h"
+#include "shader_optimiser.h"
 #include "Debug/st_assert.h"
 
 #define MING3D_BreakOnShaderParserError
@@ -20,6 +22,9 @@ namespace Ming3D
         mBuiltinDatatypes.emplace("bool", ShaderDatatypeInfo(EShaderDatatype::Bool, "bool"));
         mBuiltinDatatypes.emplace("void", ShaderDatatypeInfo(EShaderDatatype::Void, "void"));
         mBuiltinDatatypes.emplace("Texture2D", ShaderDatatypeInfo(EShaderDatatype::Texture2D, "Texture2D"));
+        mBuiltinDatatypes.emplace("TexelBuffer", ShaderDatatypeInfo(EShaderDatatype::TexelBuffer, "TexelBuffer"));
+        mBuiltinDatatypes.emplace("ShadowMapArray", ShaderDatatypeInfo(EShaderDatatype::ShadowMapArray, "ShadowMapArray"));
+        mBuiltinDatatypes.emplace("Texture2DArray", ShaderDatatypeInfo(EShaderDatatype::Texture2DArray, "Texture2DArray"));
 
         mBuiltinDatatypes.emplace("vec2", ShaderDatatypeInfo(EShaderDatatype::Vec2, "vec2", { ShaderStructMember(mBuiltinDatatypes["float"], "x"), ShaderStructMember(mBuiltinDatatypes["float"], "y"), ShaderStructMember(mBuiltinDatatypes["float"], "r"), ShaderStructMember(mBuiltinDatatypes["float"], "g") }));
         mBuiltinDatatypes.emplace("vec3", ShaderDatatypeInfo(EShaderDatatype::Vec3, "vec3", { ShaderStructMember(mBuiltinDatatypes["float"], "x"), ShaderStructMember(mBuiltinDatatypes["float"], "y"), ShaderStructMember(mBuiltinDatatypes["float"], "z"), ShaderStructMember(mBuiltinDatatypes["float"], "r"), ShaderStructMember(mBuiltinDatatypes["float"], "g"), ShaderStructMember(mBuiltinDatatypes["float"], "b") }));
@@ -158,7 +163,7 @@ namespace Ming3D
         if (strToken == "(")
         {
             // Function call
-            FunctionCallExpression* funcExpression = new FunctionCallExpression();
+            FunctionCallExpression* funcExpression = mArena->New<FunctionCallExpression>();
             funcExpression->mIdentifier = identifierToken;
 
             inTokenParser.Advance();
@@ -193,7 +198,7 @@ namespace Ming3D
         }
         else
         {
-            ShaderExpression* identifierExpression = new VariableAccessExpression();
+            ShaderExpression* identifierExpression = mArena->New<VariableAccessExpression>();
             ((VariableAccessExpression*)identifierExpression)->mIdentifier = identifierToken;
             // TODO: Check that the variable is defined
             while (true)
@@ -205,7 +210,7 @@ namespace Ming3D
                     inTokenParser.Advance();
 
                     Token memberToken = inTokenParser.GetCurrentToken();
-                    VariableAccessExpression* memberExpr = new VariableAccessExpression();
+                    VariableAccessExpression* memberExpr = mArena->New<VariableAccessExpression>();
                     memberExpr->mIdentifier = memberToken;
                     memberExpr->mOuterExpression = identifierExpression;
                     identifierExpression = memberExpr;
@@ -257,7 +262,7 @@ namespace Ming3D
         case ETokenType::FloatLiteral:
         case ETokenType::IntegerLiteral:
         {
-            atomExpression = new LiteralExpression();
+            atomExpression = mArena->New<LiteralExpression>();
             ((LiteralExpression*)atomExpression)->mToken = currToken;
             inTokenParser.Advance();
             break;
@@ -299,7 +304,7 @@ namespace Ming3D
 
         if (hasPrefixOperator)
         {
-            UnaryOperationExpression* unaryExpr = new UnaryOperationExpression();
+            UnaryOperationExpression* unaryExpr = mArena->New<UnaryOperationExpression>();
             unaryExpr->mOperator = prefixOperator.mOperator;
             unaryExpr->mOperand = atomExpression;
             *outExpression = unaryExpr;
@@ -333,7 +338,7 @@ namespace Ming3D
                     EParseResult subExprParseResult = ParseExpression(inTokenParser, operatorInfo, &rightExpr);
                     if (subExprParseResult == EParseResult::Parsed)
                     {
-                        BinaryOperationExpression* opExpr = new BinaryOperationExpression();
+                        BinaryOperationExpression* opExpr = mArena->New<BinaryOperationExpression>();
                         opExpr->mOperator = operatorInfo.mOperator;
                         opExpr->mLeftOperand = *outExpression;
                         opExpr->mRightOperand = rightExpr;
@@ -473,7 +478,7 @@ namespace Ming3D
             return EParseResult::Error;
         }
         inTokenParser.Advance();
-        ShaderFunctionDefinition* funcDefinition = new ShaderFunctionDefinition();
+        ShaderFunctionDefinition* funcDefinition = mArena->New<ShaderFunctionDefinition>();
         funcDefinition->mFunctionInfo = funcInfo;
         EParseResult statementParseRes = ParseStatementBlock(inTokenParser, TerminatorType::CurlyBrackets, &funcDefinition->mStatementBlock);
 
@@ -508,7 +513,6 @@ namespace Ming3D
                 return exprParseResult;
             if (inTokenParser.GetCurrentToken().mTokenString != ")")
             {
-                delete exprStatements;
                 OnParseError(inTokenParser, "Expected ( after control statement identifier");
                 return EParseResult::Error;
             }
@@ -526,10 +530,9 @@ namespace Ming3D
             }
             if (statementParseResult == EParseResult::Error)
             {
-                delete exprStatements;
                 return statementParseResult;
             }
-            ControlStatement* controlStatement = new ControlStatement();
+            ControlStatement* controlStatement = mArena->New<ControlStatement>();
             controlStatement->mIdentifier = controlStatementIdentifier;
             controlStatement->mExpressionStatements = exprStatements;
             controlStatement->mStatementBlock = statementBlock;
@@ -538,7 +541,7 @@ namespace Ming3D
         }
         else if (IsTypeIdentifier(tokenString.c_str()))
         {
-            VariableDefinitionStatement* varDefStatement = new VariableDefinitionStatement();
+            VariableDefinitionStatement* varDefStatement = mArena->New<VariableDefinitionStatement>();
 
             varDefStatement->mVariableType = inTokenParser.GetCurrentToken().mTokenString;
 
@@ -556,7 +559,6 @@ namespace Ming3D
                 if (exprParseResult != EParseResult::Parsed)
                 {
                     OnParseError(inTokenParser, "Invalid assignment expression in variable definition expression");
-                    delete varDefStatement;
                     return EParseResult::Error;
                 }
             }
@@ -564,7 +566,6 @@ namespace Ming3D
             if (inTokenParser.GetCurrentToken().mTokenString != ";")
             {
                 OnParseError(inTokenParser, "Missing semicolon");
-                delete varDefStatement;
                 return EParseResult::Error;
             }
 
@@ -572,7 +573,7 @@ namespace Ming3D
         }
         else if (tokenString == "return")
         {
-            ReturnStatement* retStatement = new ReturnStatement();
+            ReturnStatement* retStatement = mArena->New<ReturnStatement>();
 
             inTokenParser.Advance();
 
@@ -585,19 +586,17 @@ namespace Ming3D
             if (exprParseResult == EParseResult::Error || inTokenParser.GetCurrentToken().mTokenString != ";")
             {
                 OnParseError(inTokenParser, "Invalid return statement");
-                delete retStatement;
                 return EParseResult::Error;
             }
             *outStatement = retStatement;
         }
         else
         {
-            ExpressionStatement* exprStatement = new ExpressionStatement();
+            ExpressionStatement* exprStatement = mArena->New<ExpressionStatement>();
             EParseResult exprParseResult = ParseExpression(inTokenParser, mDefaultOuterOperatorInfo, &exprStatement->mExpression);
             if (exprParseResult != EParseResult::Parsed)
             {
                 OnParseError(inTokenParser, "Invalid statement expression");
-                delete exprStatement;
                 return EParseResult::Error;
             }
             *outStatement = exprStatement;
@@ -607,7 +606,7 @@ namespace Ming3D
 
     EParseResult ShaderParser::ParseStatementBlock(TokenParser& inTokenParser, TerminatorType inTerminator, ShaderStatementBlock** outStatementBlock)
     {
-        *outStatementBlock = new ShaderStatementBlock();
+        *outStatementBlock = mArena->New<ShaderStatementBlock>();
 
         char terminatorChar = inTerminator == TerminatorType::LineBreak ? '\n' : (inTerminator == TerminatorType::CurlyBrackets ? '}' : ')');
 
@@ -634,11 +633,11 @@ namespace Ming3D
         mParams = inParams;
 
         ParsedShaderProgram* parsedShaderProgram = new ParsedShaderProgram();
+        mArena = &parsedShaderProgram->mArena;
         parsedShaderProgram->mProgramPath = inParams.mShaderProgramPath;
-        std::ifstream shaderFile(inParams.mShaderProgramPath);
-        std::string shaderString((std::istreambuf_iterator<char>(shaderFile)), std::istreambuf_iterator<char>());
+        std::shared_ptr<const TokenisedShaderFile> shaderFile = ShaderFileCache::GetFile(inParams.mShaderProgramPath);
 
-        if (shaderString == "")
+        if (shaderFile == nullptr || shaderFile->mSize == 0)
         {
             LOG_ERROR() << "Failed to read shader: " << inParams.mShaderProgramPath;
             __AssertComment(false, "Faield to read shader");
@@ -646,13 +645,21 @@ namespace Ming3D
             return nullptr;
         }
 
-        TokenParser tokenParser(shaderString.c_str());
+        TokenParser tokenParser(shaderFile->mTokens);
 
         ShaderPreprocessor preprocessor(tokenParser);
         for (auto preprocdef : mParams.mPreprocessorDefinitions)
             preprocessor.AddDefinition(preprocdef.first, preprocdef.second);
         preprocessor.PreprocessShader();
 
+        ShaderSourceFile programFile;
+        programFile.mPath = inParams.mShaderProgramPath;
+        programFile.mHash = shaderFile->mHash;
+        parsedShaderProgram->mSourceFiles.push_back(programFile);
+        const std::vector<ShaderSourceFile>& includedFiles = preprocessor.GetIncludedFiles();
+        parsedShaderProgram->mSourceFiles.insert(parsedShaderProgram->mSourceFiles.end(), includedFiles.begin(), includedFiles.end());
+        parsedShaderProgram->mDiskCachePath = ShaderDiskCache::GetCachePath(inParams);
+
         std::vector<ParsedShader*> parsedShaders;
         ParsedShader* currentParsingShader = nullptr;
 
@@ -768,7 +775,7 @@ namespace Ming3D
                     if (currToken.mTokenString == "shader")
                     {
                         tokenParser.Advance();
-                        currentParsingShader = new ParsedShader();
+                        currentParsingShader = mArena->New<ParsedShader>();
                         if (tokenParser.GetCurrentToken().mTokenString == "VertexShader")
                         {
                             parsedShaderProgram->mVertexShader = currentParsingShader;
@@ -781,6 +788,12 @@ namespace Ming3D
                         tokenParser.Advance(); // TODO: look for "{"
                         PushScopeStack();
                     }
+                    else
+                    {
+                        OnParseError(tokenParser, "Expected shader definition");
+                        failed = true;
+                        break;
+                    }
                 }
                 // Parse shader
                 else
@@ -875,6 +888,10 @@ namespace Ming3D
             parsedShaderProgram->mStructDefinitions.push_back(structDef.second);
         mCurrentProgramStructDefs.clear();
 
+        ShaderOptimiser optimiser(parsedShaderProgram);
+        optimiser.OptimiseProgram();
+        parsedShaderProgram->mUniformBlockLayout = ShaderUniformBlockLayout(parsedShaderProgram->mUniforms);
+
         // TODO: Print any errors from here + PRINT THE LINE THAT HAS THE ERROR!
 
         LOG_INFO() << "Successfully parsed shader program: " << inParams.mShaderProgramPath;
@@ -57,6 +57,7 @@ namespace Ming3D
     {
     private:
         ShaderParserParams mParams;
+        ShaderArena* mArena = nullptr; // arena of the program being parsed
 
         std::set<std::string> mControlStatementIdentifiers = { "for", "while", "if", "else" };
 
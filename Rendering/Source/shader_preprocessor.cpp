@@ -1,6 +1,7 @@
 #include "shader_preprocessor.h"
+#include "Debug/debug.h"
+#include <algorithm>
 #include <ctype.h>
-#include <fstream>
 
 namespace Ming3D
 {
@@ -41,10 +42,22 @@ namespace Ming3D
         {
             return PreprocessorDirective::Include;
         }
+        else if (inToken == "#pragma")
+        {
+            return PreprocessorDirective::Pragma;
+        }
         else
             return PreprocessorDirective::Invalid;
     }
 
+    const Token* ShaderPreprocessor::ReadToken()
+    {
+        ShaderPreprocessorSource& source = mSources.back();
+        if (source.mCurrentTokenIndex >= source.mTokens->size())
+            return nullptr;
+        return &(*source.mTokens)[source.mCurrentTokenIndex++];
+    }
+
     void ShaderPreprocessor::ProcessToken(Token inToken)
     {
         // handle preprocessor directives
@@ -58,21 +71,24 @@ namespace Ming3D
             {
                 if (!IsCurrentScopeIgnored())
                 {
-                    mTokenParser.Advance();
-                    const Token defNameToken = mTokenParser.GetCurrentToken();
-                    mTokenParser.Advance();
-                    const Token defValToken = mTokenParser.GetCurrentToken();
-                    std::string defName = defNameToken.mTokenString;
-                    std::string defVal = defValToken.mTokenType == ETokenType::NewLine ? "" : defValToken.mTokenString;
-                    AddDefinition(defName, defVal);
+                    const Token* defNameToken = ReadToken();
+                    const Token* defValToken = defNameToken != nullptr ? ReadToken() : nullptr;
+                    if (defNameToken != nullptr)
+                    {
+                        Token defVal;
+                        defVal.mTokenType = ETokenType::Identifier;
+                        if (defValToken != nullptr && defValToken->mTokenType != ETokenType::NewLine)
+                            defVal = *defValToken;
+                        AddDefinition(defNameToken->mTokenString, defVal);
+                    }
                 }
                 break;
             }
             case PreprocessorDirective::Ifdef:
             case PreprocessorDirective::Ifndef:
             {
-                mTokenParser.Advance();
-                std::string def = mTokenParser.GetCurrentToken().mTokenString;
+                const Token* defToken = ReadToken();
+                const std::string def = defToken != nullptr ? defToken->mTokenString.GetString() : "";
                 ShaderPreprocessorScope scope;
                 scope.mScopeType = ShaderPreprocessorScopeType::IfBody;
                 scope.mIgnoreContent = IsCurrentScopeIgnored() || (mDefinitions.find(def) == mDefinitions.end()) == (directive == PreprocessorDirective::Ifdef);
@@ -95,34 +111,22 @@ namespace Ming3D
             }
             case PreprocessorDirective::Include:
             {
-                mTokenParser.Advance();
-                // Read included file
-                std::string includePath = mTokenParser.GetCurrentToken().mTokenString;
-                includePath = includePath.substr(1, includePath.size() - 2);
-                std::ifstream shaderFile(includePath);
-                std::string shaderString((std::istreambuf_iterator<char>(shaderFile)), std::istreambuf_iterator<char>());
-
-                // Parse included file
-                std::vector<Token> newTokens;
-                Tokeniser tokeniser(shaderString.c_str());
-                while (true)
+                const Token* pathToken = ReadToken();
+                if (pathToken != nullptr && !IsCurrentScopeIgnored())
                 {
-                    Token token = tokeniser.ParseToken();
-                    if (token.mTokenString != "")
-                    {
-                        newTokens.push_back(token);
-                    }
-                    else if (token.mTokenType == ETokenType::EndOfFile)
-                    {
-                        break;
-                    }
+                    const std::string& quotedPath = pathToken->mTokenString;
+                    IncludeFile(quotedPath.substr(1, quotedPath.size() - 2));
                 }
-
-                // Copy new tokens
-                std::vector<Token>& tokens = mTokenParser.GetTokens();
-                size_t numTokens = tokens.size();
-                size_t nextTokenIndex = mTokenParser.GetCurrentTokenIndex() + 1;
-                tokens.insert(tokens.begin() + nextTokenIndex, newTokens.begin(), newTokens.end());
+                break;
+            }
+            case PreprocessorDirective::Pragma:
+            {
+                // "#pragma keywords" is read before parsing (see ShaderCache). Skip the rest of the line.
+                const Token* token = ReadToken();
+                if (token != nullptr && token->mTokenString == "once" && mSources.back().mFile != nullptr)
+                    mPragmaOnceFiles.insert(mSources.back().mFile->mPath);
+                while (token != nullptr && token->mTokenType != ETokenType::NewLine)
+                    token = ReadToken();
                 break;
             }
             }
@@ -135,7 +139,9 @@ namespace Ming3D
                 auto defIter = mDefinitions.find(inToken.mTokenString);
                 if (defIter != mDefinitions.end())
                 {
-                    inToken.mTokenString = defIter->second;
+                    const int lineNumber = inToken.mLineNumber;
+                    inToken = defIter->second;
+                    inToken.mLineNumber = lineNumber;
                 }
             }
             // push preprocessed token
@@ -144,22 +150,79 @@ namespace Ming3D
         }
     }
 
+    void ShaderPreprocessor::IncludeFile(const std::string& inPath)
+    {
+        if (mPragmaOnceFiles.count(inPath) > 0)
+            return;
+
+        std::shared_ptr<const TokenisedShaderFile> file = ShaderFileCache::GetFile(inPath);
+        if (file == nullptr)
+        {
+            LOG_ERROR() << "Failed to read included shader file: " << inPath;
+            return;
+        }
+
+        // Already included, and guarded
+        if (!file->mIncludeGuard.empty() && mDefinitions.find(file->mIncludeGuard) != mDefinitions.end())
+            return;
+
+        auto includedIter = std::find_if(mIncludedFiles.begin(), mIncludedFiles.end(), [&inPath](const ShaderSourceFile& inFile) { return inFile.mPath == inPath; });
+        if (includedIter == mIncludedFiles.end())
+        {
+            ShaderSourceFile includedFile;
+            includedFile.mPath = inPath;
+            includedFile.mHash = file->mHash;
+            mIncludedFiles.push_back(includedFile);
+        }
+
+        ShaderPreprocessorSource source;
+        source.mFile = file;
+        source.mTokens = &file->mTokens;
+        mSources.push_back(source);
+    }
+
     void ShaderPreprocessor::AddDefinition(const std::string name, const std::string value)
     {
-        mDefinitions.emplace(name, value);
+        Token valueToken;
+        valueToken.mTokenType = ETokenType::Identifier;
+        if (!value.empty())
+        {
+            Tokeniser tokeniser(value.c_str());
+            valueToken = tokeniser.ParseToken();
+            if (tokeniser.ParseToken().mTokenType != ETokenType::EndOfFile)
+            {
+                LOG_ERROR() << "Preprocessor definition values must be a single token: " << name << "=" << value;
+                return;
+            }
+        }
+        AddDefinition(name, valueToken);
+    }
+
+    void ShaderPreprocessor::AddDefinition(const std::string& inName, const Token& inValue)
+    {
+        mDefinitions.emplace(inName, inValue);
     }
 
     void ShaderPreprocessor::PreprocessShader()
     {
-        while (mTokenParser.HasMoreTokens())
-        {
-            Token token = mTokenParser.GetCurrentToken();
+        std::vector<Token> programTokens;
+        programTokens.swap(mTokenParser.GetTokens());
+        mPreprocessedTokens.reserve(programTokens.size());
 
-            ProcessToken(token);
+        ShaderPreprocessorSource programSource;
+        programSource.mTokens = &programTokens;
+        mSources.push_back(programSource);
 
-            mTokenParser.Advance();
+        while (!mSources.empty())
+        {
+            const Token* token = ReadToken();
+            if (token != nullptr)
+                ProcessToken(*token);
+            else
+                mSources.pop_back(); // end of an included file (or the program)
         }
-        mTokenParser.SetTokens(mPreprocessedTokens);
+
+        mTokenParser.GetTokens().swap(mPreprocessedTokens);
         mTokenParser.ResetPosition();
     }
 }
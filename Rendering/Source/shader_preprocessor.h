@@ -4,8 +4,12 @@
 #include <string>
 #include <sstream>
 #include <stack>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include "shader_tokeniser.h"
+#include "shader_file_cache.h"
+#include "shader_info.h"
 
 namespace Ming3D
 {
@@ -29,26 +33,51 @@ namespace Ming3D
         Else,
         Endif,
         Include,
+        Pragma,
         Invalid
     };
 
+    /** A file that is being preprocessed: the program, or an included file. */
+    struct ShaderPreprocessorSource
+    {
+        std::shared_ptr<const TokenisedShaderFile> mFile; // null for the program
+        const std::vector<Token>* mTokens;
+        size_t mCurrentTokenIndex = 0;
+    };
+
+    /**
+    * Shader preprocessor.
+    * Reads tokens from a stack of sources: included files are pushed when included, and read until their end, so each token is visited once.
+    * Included files are tokenised once per process (see ShaderFileCache). Files with "#pragma once" or an include guard are only included once.
+    */
     class ShaderPreprocessor
     {
     private:
         TokenParser& mTokenParser;
         std::stack<ShaderPreprocessorScope> mScopeStack;
-        std::unordered_map<std::string, std::string> mDefinitions;
+        std::unordered_map<std::string, Token> mDefinitions; // definition values are tokens, so literals stay literals when substituted
         std::vector<Token> mPreprocessedTokens;
+        std::vector<ShaderSourceFile> mIncludedFiles;
+        std::vector<ShaderPreprocessorSource> mSources;
+        std::unordered_set<std::string> mPragmaOnceFiles;
 
         PreprocessorDirective GetPreprocessorDirective(const std::string& inToken);
+        /** Next token of the current source, or nullptr at its end. Directives can't span files. */
+        const Token* ReadToken();
         void ProcessToken(Token inToken);
+        void IncludeFile(const std::string& inPath);
         bool IsCurrentScopeIgnored();
+        void AddDefinition(const std::string& inName, const Token& inValue);
 
     public:
         ShaderPreprocessor(TokenParser& inTokenParser);
         
+        /** Defines a macro. Like #define in shaders, the value must be a single token (or empty). */
         void AddDefinition(const std::string name, const std::string value);
         void PreprocessShader();
+
+        /** Files included by the shader (recursively), in the order they were included. */
+        const std::vector<ShaderSourceFile>& GetIncludedFiles() const { return mIncludedFiles; }
     };
 }
 
@@ -16,11 +16,8 @@ namespace Ming3D
             delete mPS;
         }
 
-        if (mInputLayout != nullptr)
-        {
-            mInputLayout->Release();
-            delete mInputLayout;
-        }
+        for (auto& inputLayout : mInputLayouts)
+            inputLayout.second->Release();
         
         delete mUniformCBuffer;
     }
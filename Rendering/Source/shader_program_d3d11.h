@@ -5,9 +5,12 @@
 
 #include <d3d11.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "shader_constant_d3d11.h"
 #include "constant_buffer_d3d11.h"
+#include "graphics_data.h"
+#include <cstdint>
 
 namespace Ming3D
 {
@@ -16,12 +19,16 @@ namespace Ming3D
     public: // TODO: should be private
         ID3D11VertexShader* mVS;
         ID3D11PixelShader* mPS;
-        ID3D11InputLayout* mInputLayout; // TODO: Do not create one per shader program
+        std::vector<EVertexComponent> mVertexComponents; // vertex shader inputs
+        ID3D10Blob* mVSBlob = nullptr; // owned by the converted shader program
+        std::unordered_map<uint64_t, ID3D11InputLayout*> mInputLayouts; // one per vertex layout (see RenderDeviceD3D11::GetInputLayout)
         
         // Constant buffer for all uniforms (non-cbuffer uniforms)
-        ConstantBufferD3D11* mUniformCBuffer;
+        ConstantBufferD3D11* mUniformCBuffer = nullptr; // null if the program has no uniforms
         std::unordered_map<std::string, ShaderConstantD3D11> mUniforms;
-        size_t mUniformsSize;
+        std::unordered_set<std::string> mStrippedUniforms; // see ParsedShaderProgram::mStrippedUniforms
+        ShaderUniformBlockLayout mUniformBlockLayout; // layout of the uniform constant buffer
+        size_t mUniformsSize = 0;
         std::unordered_map<std::string, int> mConstantBufferLocations;
 
 
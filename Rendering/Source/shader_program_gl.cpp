@@ -47,5 +47,39 @@ namespace Ming3D
             return loc;
         }
     }
+
+    void ShaderProgramGL::SetUniformBlockLayout(const ParsedShaderProgram* inParsedProgram)
+    {
+        mUniformBlock.resize(inParsedProgram->mUniforms.size());
+        for (size_t iUniform = 0; iUniform < mUniformBlock.size(); iUniform++)
+        {
+            mUniformBlock[iUniform].mBlockMember = inParsedProgram->mUniformBlockLayout.mMembers[iUniform];
+            mUniformBlock[iUniform].mLocation = glGetUniformLocation(mGLProgram, inParsedProgram->mUniforms[iUniform].mName.c_str());
+        }
+    }
+
+    void ShaderProgramGL::SetConstantBufferSlots(const ParsedShaderProgram* inParsedProgram)
+    {
+        const std::vector<ConstantBufferInfo>& cbufferInfos = inParsedProgram->mConstantBufferInfos;
+        mBoundConstantBuffers.assign(cbufferInfos.size(), 0);
+        for (GLuint iSlot = 0; iSlot < (GLuint)cbufferInfos.size(); iSlot++)
+        {
+            mConstantBufferSlots[cbufferInfos[iSlot].mName] = iSlot;
+
+            // The GLSL declares the same binding, but program binaries from an older shader writer may not
+            const GLuint blockIndex = glGetUniformBlockIndex(mGLProgram, cbufferInfos[iSlot].mName.c_str());
+            if (blockIndex != GL_INVALID_INDEX)
+                glUniformBlockBinding(mGLProgram, blockIndex, iSlot);
+        }
+    }
+
+    bool ShaderProgramGL::GetConstantBufferSlot(const std::string& inName, GLuint& outSlot) const
+    {
+        auto slotIter = mConstantBufferSlots.find(inName);
+        if (slotIter == mConstantBufferSlots.end())
+            return false;
+        outSlot = slotIter->second;
+        return true;
+    }
 }
 #endif
@@ -5,9 +5,18 @@
 #include <GL/glew.h>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace Ming3D
 {
+    /** A uniform of the program's uniform block (see ShaderUniformBlockLayout), and its location. */
+    class ShaderUniformGL
+    {
+    public:
+        ShaderUniformBlockMember mBlockMember;
+        GLint mLocation = -1; // -1 if the program doesn't use it
+    };
+
     class ShaderProgramGL : public ShaderProgram
     {
     private:
@@ -15,6 +24,9 @@ namespace Ming3D
         GLuint mGLVertexShader = -1;
         GLuint mGLFragmentShader = -1;
         std::unordered_map<std::string, GLuint> mCachedUniformLocations;
+        std::vector<ShaderUniformGL> mUniformBlock;
+        std::unordered_map<std::string, GLuint> mConstantBufferSlots; // uniform block binding points, by block name
+        std::vector<GLuint> mBoundConstantBuffers; // buffer bound to each slot (see RenderDeviceGL::BindConstantBuffer)
 
     public:
         virtual ~ShaderProgramGL();
@@ -29,6 +41,17 @@ namespace Ming3D
 
         GLuint GetUniformLocation(const std::string& inName);
 
+        /** Looks up the locations of the uniform block's uniforms. Call after linking. */
+        void SetUniformBlockLayout(const ParsedShaderProgram* inParsedProgram);
+        const std::vector<ShaderUniformGL>& GetUniformBlock() const { return mUniformBlock; }
+
+        /** Assigns each constant buffer (uniform block) the binding point matching its declaration order. Call after linking. */
+        void SetConstantBufferSlots(const ParsedShaderProgram* inParsedProgram);
+        /** Binding point of a constant buffer, or false if the program has no constant buffer named inName. */
+        bool GetConstantBufferSlot(const std::string& inName, GLuint& outSlot) const;
+        void SetBoundConstantBuffer(GLuint inSlot, GLuint inBuffer) { mBoundConstantBuffers[inSlot] = inBuffer; }
+        const std::vector<GLuint>& GetBoundConstantBuffers() const { return mBoundConstantBuffers; }
+
     };
 }
 
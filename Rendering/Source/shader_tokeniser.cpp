@@ -1,121 +1,192 @@
 #include "shader_tokeniser.h"
 
-#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
 #include <string>
-#include <numeric>
+#include <unordered_map>
 #include "Debug/debug.h"
 #include "Debug/st_assert.h"
 
 namespace Ming3D
 {
+    namespace
+    {
+        enum ECharClass : uint8_t
+        {
+            CharClassSpace = 1,         // skipped between tokens
+            CharClassDigit = 2,
+            CharClassPunctuator = 4,    // [ ] ( ) { } , . ; : < > = ! + - * / & | ?
+            CharClassSeparator = 8,     // ends identifiers and numbers: punctuators, whitespace, line breaks and the end of the source
+            CharClassCompound = 16      // may be followed by '=' ("==", ">=", "+=", etc.)
+        };
+
+        class CharClassTable
+        {
+        public:
+            uint8_t mClasses[256] = {};
+
+            CharClassTable()
+            {
+                for (char c = '0'; c <= '9'; c++)
+                    mClasses[(uint8_t)c] |= CharClassDigit;
+                for (const char* c = "[](){},.;:<>=!+-*/&|?"; *c != 0; c++)
+                    mClasses[(uint8_t)*c] |= CharClassPunctuator | CharClassSeparator;
+                for (const char* c = "=<>!+*/&|"; *c != 0; c++)
+                    mClasses[(uint8_t)*c] |= CharClassCompound;
+                mClasses[(uint8_t)' '] |= CharClassSpace | CharClassSeparator;
+                mClasses[(uint8_t)'\t'] |= CharClassSpace | CharClassSeparator;
+                mClasses[(uint8_t)'\n'] |= CharClassSeparator;
+                mClasses[0] |= CharClassSeparator;
+            }
+        };
+
+        const CharClassTable CharClasses;
+
+        inline uint8_t GetCharClass(char inChar)
+        {
+            return CharClasses.mClasses[(uint8_t)inChar];
+        }
+
+        /** Two character operators: "==", ">=", "<=", "!=", "&&", "||", "+=", "*=", "/=", "&=", "|=" */
+        inline bool IsDoublePunctuator(char inFirst, char inSecond)
+        {
+            return (inSecond == '=' && (GetCharClass(inFirst) & CharClassCompound)) || ((inFirst == '&' || inFirst == '|') && inSecond == inFirst);
+        }
+
+        inline size_t HashTokenString(const char* inString, size_t inLength)
+        {
+            size_t hash = 2166136261u;
+            for (size_t i = 0; i < inLength; i++)
+                hash = (hash ^ (uint8_t)inString[i]) * 16777619u;
+            return hash;
+        }
+
+        /** A string that isn't owned by the key, so existing strings can be looked up without allocating a std::string. */
+        class TokenStringKey
+        {
+        public:
+            const char* mData;
+            size_t mLength;
+
+            bool operator==(const TokenStringKey& inOther) const { return mLength == inOther.mLength && memcmp(mData, inOther.mData, mLength) == 0; }
+        };
+
+        class TokenStringKeyHash
+        {
+        public:
+            size_t operator()(const TokenStringKey& inKey) const { return HashTokenString(inKey.mData, inKey.mLength); }
+        };
+
+        class TokenStringPool
+        {
+        public:
+            std::mutex mMutex;
+            std::deque<std::string> mStrings; // elements are never moved, so the strings can be referenced
+            std::unordered_map<TokenStringKey, const std::string*, TokenStringKeyHash> mStringIndex; // keys point to the strings in mStrings
+        };
+
+        TokenStringPool& GetTokenStringPool()
+        {
+            static TokenStringPool pool;
+            return pool;
+        }
+    }
+
+    const std::string* TokenString::GetEmptyString()
+    {
+        static const std::string emptyString;
+        return &emptyString;
+    }
+
+    TokenString::TokenString(const char* inString, size_t inLength)
+        : mString(Intern(inString, inLength))
+    {
+    }
+
+    const std::string* TokenString::Intern(const char* inString, size_t inLength)
+    {
+        if (inLength == 0)
+            return GetEmptyString();
+
+        TokenStringPool& pool = GetTokenStringPool();
+        std::lock_guard<std::mutex> lock(pool.mMutex);
+        auto stringIter = pool.mStringIndex.find(TokenStringKey{ inString, inLength });
+        if (stringIter != pool.mStringIndex.end())
+            return stringIter->second;
+
+        pool.mStrings.emplace_back(inString, inLength);
+        const std::string* internedString = &pool.mStrings.back();
+        pool.mStringIndex.emplace(TokenStringKey{ internedString->data(), internedString->size() }, internedString);
+        return internedString;
+    }
+
     Tokeniser::Tokeniser(const char* inSourceText)
     {
-        mSourceText = inSourceText;
-        mSourceStringPos = mSourceText.c_str();
+        mSourceStringPos = inSourceText;
     }
 
-    bool Tokeniser::isOperator(const char* inToken)
+    TokenString Tokeniser::InternTokenString(const char* inString, size_t inLength)
     {
-        return (mPunctuators.find(*inToken) != mPunctuators.end() || mDoublePunctuators.find(inToken) != mDoublePunctuators.end());
+        const std::string*& recentString = mRecentStrings[HashTokenString(inString, inLength) & 255];
+        if (recentString == nullptr || recentString->size() != inLength || memcmp(recentString->data(), inString, inLength) != 0)
+            recentString = TokenString::Intern(inString, inLength);
+        return TokenString::FromInterned(recentString);
     }
 
     Token Tokeniser::ParseToken()
     {
         Token outToken;
+        const char* pos = mSourceStringPos;
 
         // Remove whitespaces and tabs from beginning
-        while (*mSourceStringPos == ' ' || *mSourceStringPos == '\t')
-            mSourceStringPos++;
+        while (GetCharClass(*pos) & CharClassSpace)
+            pos++;
 
-        if (*mSourceStringPos == '\n')
+        if (*pos == '\n')
         {
-            mSourceStringPos++;
+            mSourceStringPos = pos + 1;
             mLineNumber++; // count linebreaks
             outToken.mTokenType = ETokenType::NewLine;
-            outToken.mTokenString = "\n";
+            outToken.mTokenString = InternTokenString("\n", 1);
+            outToken.mLineNumber = mLineNumber;
             return outToken;
         }
 
         // End of file
-        if (*mSourceStringPos == 0)
+        if (*pos == 0)
         {
+            mSourceStringPos = pos;
             outToken.mTokenType = ETokenType::EndOfFile;
             return outToken;
         }
-        
-        const char* tokenStart = mSourceStringPos;
-
-        bool isStringLiteral = false;
-        bool isNumericLiteral = false;
-        bool isFloatLiteral = false;
-        bool isPunctuator = false;
-        bool isComment = false;
-        const char* commentStartPos;
-        int sign = 1;
-
-        // Evaluate the first character
-        if (*mSourceStringPos == '"')
-        {
-            isStringLiteral = true;
-            mSourceStringPos++;
-        }
-        else if (isdigit(*mSourceStringPos))
-        {
-            isNumericLiteral = true;
-        }
-        else if(*mSourceStringPos == '+' || *mSourceStringPos == '-')
-        {
-            isNumericLiteral = true;
-            sign = *mSourceStringPos == '+' ? 1 : -1;
-        }
-        else if (*mSourceStringPos == '/' && *(mSourceStringPos + 1) == '/')
-        {
-            isComment = true;
-            commentStartPos = mSourceStringPos;
-            mSourceStringPos++;
-        }
-        else if (mPunctuators.find(*mSourceStringPos) != mPunctuators.end())
-        {
-            isPunctuator = true;
-        }
-        mSourceStringPos++;
 
-        // Evaluate the rest of the characters
-        while (*mSourceStringPos != 0)
+        const char* tokenStart = pos;
+        const char firstChar = *pos;
+        const uint8_t firstCharClass = GetCharClass(firstChar);
+
+        if (firstChar == '"')
         {
-            const char& currChar = *mSourceStringPos;
-            if (isComment)
+            // String literal (including the quotes). The first character after the opening quote is always part of the string.
+            pos += pos[1] != 0 ? 2 : 1;
+            while (*pos != 0)
             {
-                if (currChar == '\n')
-                {
-                    mSourceStringPos++;
-                    mLineNumber++;
+                if (*pos++ == '"')
                     break;
-                }
             }
-            else if (isStringLiteral)
+            outToken.mTokenType = ETokenType::StringLiteral;
+        }
+        else if ((firstCharClass & CharClassDigit) || firstChar == '+' || firstChar == '-')
+        {
+            const int sign = firstChar == '-' ? -1 : 1;
+            bool isFloatLiteral = false;
+            pos++;
+            while (true)
             {
-                if (*mSourceStringPos == '"')
-                {
-                    mSourceStringPos++;
+                const char currChar = *pos;
+                if ((GetCharClass(currChar) & CharClassSeparator) && currChar != '.')
                     break;
-                }
-            }
-            else if (isPunctuator)
-            {
-                // Double punctuator? (>=, ==, !=, etc..)
-                if (mDoublePunctuators.find(std::string { *(mSourceStringPos -1), *mSourceStringPos }) != mDoublePunctuators.end())
-                {
-                    mSourceStringPos++;
-                }
-                break;
-            }
-            else if (currChar == ';' || currChar == ' ' || currChar == '\n' || currChar == '\t' || ((!isNumericLiteral || currChar != '.') && mPunctuators.find(currChar) != mPunctuators.end()))
-            {
-                break;
-            }
-            else if (isNumericLiteral)
-            {
                 if (currChar == '.')
                 {
                     isFloatLiteral = true;
@@ -124,7 +195,7 @@ namespace Ming3D
                 {
                     if (isFloatLiteral)
                     {
-                        mSourceStringPos++;
+                        pos++;
                         break;
                     }
                     else
@@ -132,78 +203,102 @@ namespace Ming3D
                         LOG_ERROR() << "Invalid character 'f' in numeric literal: " << tokenStart;
                     }
                 }
-                else if (!isdigit(currChar))
+                else if (!(GetCharClass(currChar) & CharClassDigit))
                 {
                     LOG_ERROR() << "Invalid character in numerical literal: " << tokenStart;
                 }
+                pos++;
             }
-            mSourceStringPos++;
-        }
 
-        const char* tokenEnd = isComment ? commentStartPos : mSourceStringPos;
-
-        outToken.mTokenString = std::string(tokenStart, tokenEnd - tokenStart);
-
-        if (isStringLiteral)
-        {
-            outToken.mTokenType = ETokenType::StringLiteral;
-        }
-        else if (isNumericLiteral && isFloatLiteral)
-        {
-            outToken.mTokenType = ETokenType::FloatLiteral;
-            outToken.mFloatValue = sign * strtof(outToken.mTokenString.c_str(), nullptr);
-        }
-        else if (isNumericLiteral)
-        {
-            outToken.mTokenType = ETokenType::IntegerLiteral;
-            outToken.mIntValue = sign * strtol(outToken.mTokenString.c_str(), nullptr, 10);
-        }
-        else if (outToken.mTokenString == "true")
-        {
-            outToken.mTokenType = ETokenType::BooleanLiteral;
-            outToken.mIntValue = 1;
+            outToken.mTokenString = InternTokenString(tokenStart, pos - tokenStart);
+            if (isFloatLiteral)
+            {
+                outToken.mTokenType = ETokenType::FloatLiteral;
+                outToken.mFloatValue = sign * strtof(outToken.mTokenString.c_str(), nullptr);
+            }
+            else
+            {
+                outToken.mTokenType = ETokenType::IntegerLiteral;
+                outToken.mIntValue = sign * strtol(outToken.mTokenString.c_str(), nullptr, 10);
+            }
+            mSourceStringPos = pos;
+            outToken.mLineNumber = mLineNumber;
+            return outToken;
         }
-        else if (outToken.mTokenString == "false")
+        else if (firstChar == '/' && pos[1] == '/')
         {
-            outToken.mTokenType = ETokenType::BooleanLiteral;
-            outToken.mIntValue = 0;
+            // Comment, until the end of the line (including the line break). Returns an empty token.
+            pos += 2;
+            while (*pos != 0)
+            {
+                if (*pos++ == '\n')
+                {
+                    mLineNumber++;
+                    break;
+                }
+            }
+            mSourceStringPos = pos;
+            outToken.mTokenType = ETokenType::Identifier;
+            outToken.mLineNumber = mLineNumber;
+            return outToken;
         }
-        else if (isPunctuator)
+        else if (firstCharClass & CharClassPunctuator)
         {
+            pos++;
+            // Double punctuator? (>=, ==, !=, etc..)
+            if (IsDoublePunctuator(firstChar, *pos))
+                pos++;
             outToken.mTokenType = ETokenType::Operator;
         }
-        else if (outToken.mTokenString[0] == '#')
+        else
         {
-            outToken.mTokenType = ETokenType::PreprocessorDirective;
+            // Identifiers, keywords and preprocessor directives
+            pos++;
+            while (!(GetCharClass(*pos) & CharClassSeparator))
+                pos++;
+            outToken.mTokenType = firstChar == '#' ? ETokenType::PreprocessorDirective : ETokenType::Identifier;
         }
-        else
+
+        outToken.mTokenString = InternTokenString(tokenStart, pos - tokenStart);
+
+        if (outToken.mTokenType == ETokenType::Identifier)
         {
-            outToken.mTokenType = ETokenType::Identifier;
+            if (outToken.mTokenString == "true")
+            {
+                outToken.mTokenType = ETokenType::BooleanLiteral;
+                outToken.mIntValue = 1;
+            }
+            else if (outToken.mTokenString == "false")
+            {
+                outToken.mTokenType = ETokenType::BooleanLiteral;
+                outToken.mIntValue = 0;
+            }
         }
 
+        mSourceStringPos = pos;
         outToken.mLineNumber = mLineNumber;
 
         return outToken;
     }
 
-    TokenParser::TokenParser(const char* inShaderCode)
-        : mTokeniser(inShaderCode)
+    void Tokeniser::Tokenise(std::vector<Token>& outTokens)
     {
-        const char* shaderStringPos = inShaderCode;
-        while (*shaderStringPos != 0)
+        while (true)
         {
-            Token token = mTokeniser.ParseToken();
-            if (token.mTokenString != "")
-            {
-                mTokens.push_back(token);
-            }
+            Token token = ParseToken();
+            if (!token.mTokenString.empty())
+                outTokens.push_back(token);
             else if (token.mTokenType == ETokenType::EndOfFile)
-            {
                 break;
-            }
         }
     }
 
+    TokenParser::TokenParser(const char* inShaderCode)
+    {
+        mTokens.reserve(strlen(inShaderCode) / 4); // roughly one token per 4-5 characters
+        Tokeniser(inShaderCode).Tokenise(mTokens);
+    }
+
     void TokenParser::ResetPosition()
     {
         mCurrentTokenIndex = 0;
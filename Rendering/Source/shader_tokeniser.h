@@ -1,10 +1,11 @@
 #ifndef MING3D_SHADERTOKENISER_H
 #define MING3D_SHADERTOKENISER_H
 
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
 #include <vector>
-#include <set>
-#include <unordered_map>
-#include <stack>
 
 namespace Ming3D
 {
@@ -21,37 +22,84 @@ namespace Ming3D
         Identifier
     };
 
+    /**
+    * Interned token string.
+    * Equal strings share the same storage, so tokens are cheap to copy and compare, and stay valid after the source text is freed.
+    * Interned strings are never freed (shaders have a small vocabulary).
+    */
+    class TokenString
+    {
+    private:
+        const std::string* mString;
+
+        static const std::string* GetEmptyString();
+
+    public:
+        TokenString() : mString(GetEmptyString()) {}
+        TokenString(const char* inString, size_t inLength);
+        TokenString(const std::string& inString) : TokenString(inString.data(), inString.size()) {}
+        TokenString(const char* inString) : TokenString(std::string(inString)) {}
+
+        /** Finds or adds an interned string. Thread safe. */
+        static const std::string* Intern(const char* inString, size_t inLength);
+
+        /** Wraps a string returned by Intern. */
+        static TokenString FromInterned(const std::string* inString) { TokenString str; str.mString = inString; return str; }
+
+        const std::string& GetString() const { return *mString; }
+        operator const std::string&() const { return *mString; }
+        const char* c_str() const { return mString->c_str(); }
+        size_t size() const { return mString->size(); }
+        bool empty() const { return mString->empty(); }
+        char operator[](size_t inIndex) const { return (*mString)[inIndex]; }
+
+        bool operator==(const TokenString& inOther) const { return mString == inOther.mString; }
+        bool operator!=(const TokenString& inOther) const { return mString != inOther.mString; }
+        bool operator==(const std::string& inOther) const { return *mString == inOther; }
+        bool operator!=(const std::string& inOther) const { return *mString != inOther; }
+        bool operator==(const char* inOther) const { return *mString == inOther; }
+        bool operator!=(const char* inOther) const { return *mString != inOther; }
+    };
+
+    inline bool operator==(const std::string& inLeft, const TokenString& inRight) { return inRight == inLeft; }
+    inline bool operator!=(const std::string& inLeft, const TokenString& inRight) { return inRight != inLeft; }
+    inline std::ostream& operator<<(std::ostream& inStream, const TokenString& inString) { return inStream << inString.GetString(); }
+
     class Token
     {
     public:
-        ETokenType mTokenType;
-        std::string mTokenString;
-        float mFloatValue;
-        int mIntValue;
-        int mLineNumber;
+        ETokenType mTokenType = ETokenType::EndOfFile;
+        TokenString mTokenString;
+        float mFloatValue = 0.0f;
+        int mIntValue = 0;
+        int mLineNumber = 0;
     };
 
     /**
     * Shader tokeniser.
     * Divides shader code into a set of tokens.
+    * Characters are classified by a lookup table, and token strings are interned (see TokenString).
+    * The source text is not copied: it must outlive the tokeniser (but not the tokens).
     * Used by the TokenParser.
     */
     class Tokeniser
     {
     private:
-        const std::set<char> mPunctuators = { '[', ']', '(' , ')' , '{' , '}' , ',' , '.' , ';' , ':' , '<', '>', '=', '!', '+', '-', '*', '/', '&', '|', '?' };
-        const std::set<std::string> mDoublePunctuators = { "==", ">=", "<=", "!=", "&&", "||", "+=", "*=", "/=", "&=", "|=" };
+        /** Recently interned strings, by hash. Avoids locking the string pool for most tokens. */
+        const std::string* mRecentStrings[256] = {};
 
-        std::string mSourceText;
         const char* mSourceStringPos;
         int mLineNumber = 1;
 
-        bool isOperator(const char* inToken);
+        TokenString InternTokenString(const char* inString, size_t inLength);
 
     public:
         Tokeniser(const char* inSourceText);
 
         Token ParseToken();
+
+        /** Parses all remaining tokens. Empty tokens (comments) are skipped. */
+        void Tokenise(std::vector<Token>& outTokens);
     };
     
     /**
@@ -61,12 +109,12 @@ namespace Ming3D
     class TokenParser
     {
     private:
-        Tokeniser mTokeniser;
         std::vector<Token> mTokens;
         size_t mCurrentTokenIndex = 0;
 
     public:
         TokenParser(const char* inShaderCode);
+        TokenParser(const std::vector<Token>& inTokens) : mTokens(inTokens) {}
         void ResetPosition();
         void Advance();
         const Token& GetCurrentToken();
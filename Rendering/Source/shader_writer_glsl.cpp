@@ -1,7 +1,6 @@
 #include "shader_writer_glsl.h"
 
 #include <sstream>
-#include <fstream>
 #include "Debug/debug.h"
 
 namespace Ming3D
@@ -22,6 +21,12 @@ namespace Ming3D
     {
         if (inString == "Texture2D")
             return "sampler2D";
+        else if (inString == "TexelBuffer")
+            return "samplerBuffer";
+        else if (inString == "ShadowMapArray")
+            return "sampler2DArrayShadow";
+        else if (inString == "Texture2DArray")
+            return "sampler2DArray";
 
         return inString;
     }
@@ -83,7 +88,8 @@ namespace Ming3D
             for (size_t iMember = 0; iMember < mCurrentShader->mOutput.mMemberVariables.size(); iMember++)
             {
                 const ShaderStructMember& member = mCurrentShader->mOutput.mMemberVariables[iMember];
-                inStream << "output_" << member.mName << "=" << GetVariableIdentifierString(inFunctionDef->mFunctionInfo.mParameters[1].mName) << "." << member.mName << ";\n";
+                if (!mDepthOnly)
+                    inStream << "output_" << member.mName << "=" << GetVariableIdentifierString(inFunctionDef->mFunctionInfo.mParameters[1].mName) << "." << member.mName << ";\n";
                 if (member.mSemantic == "SV_POSITION")
                 {
                     vertexPosOutputIndex = iMember;
@@ -165,6 +171,30 @@ namespace Ming3D
                 inStream << "FragColour = ";
                 WriteFunctionCallParameters(inStream, funcCallExpr->mParameterExpressions);
             }
+            else if (funcCallExpr->mIdentifier.mTokenString == "SampleShadowMap")
+            {
+                // SampleShadowMap(shadowMap, vec3(u, v, depth), layer) => texture(shadowMap, vec4(u, v, layer, depth))
+                inStream << "texture(";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[0]);
+                inStream << ", vec4(";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[1]);
+                inStream << ".xy, ";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[2]);
+                inStream << ", ";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[1]);
+                inStream << ".z))";
+            }
+            else if (funcCallExpr->mIdentifier.mTokenString == "ReadTextureArray")
+            {
+                // ReadTextureArray(textureArray, uv, layer) => texture(textureArray, vec3(uv, layer))
+                inStream << "texture(";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[0]);
+                inStream << ", vec3(";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[1]);
+                inStream << ", ";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[2]);
+                inStream << "))";
+            }
             else
             {
                 std::string functionName = funcCallExpr->mIdentifier.mTokenString;
@@ -172,6 +202,10 @@ namespace Ming3D
                 {
                     functionName = "texture";
                 }
+                else if (funcCallExpr->mIdentifier.mTokenString == "ReadTexelBuffer")
+                {
+                    functionName = "texelFetch";
+                }
                 inStream << functionName;
                 inStream << "(";
                 WriteFunctionCallParameters(inStream, funcCallExpr->mParameterExpressions);
@@ -269,9 +303,10 @@ namespace Ming3D
         }
     }
 
-    bool ShaderWriterGLSL::WriteShader(const ParsedShaderProgram* inParsedShaderProgram, ShaderProgramDataGLSL& outData)
+    bool ShaderWriterGLSL::WriteShader(const ParsedShaderProgram* inParsedShaderProgram, ShaderProgramDataGLSL& outData, bool inDepthOnly)
     {
         mCurrentShaderProgram = inParsedShaderProgram;
+        mDepthOnly = inDepthOnly;
 
         std::vector<ParsedShader*> shaders;
         if (inParsedShaderProgram->mVertexShader)
@@ -298,6 +333,13 @@ namespace Ming3D
 
         for (ParsedShader* currShader : shaders)
         {
+            // Depth-only programs have no colour output, so the fragment stage is left empty
+            if (mDepthOnly && currShader == inParsedShaderProgram->mFragmentShader)
+            {
+                outData.mFragmentShader.mSource = "#version 430\n\nvoid main()\n{\n}\n";
+                continue;
+            }
+
             mCurrentShader = currShader;
             mReferencedUniforms.clear();
 
@@ -345,10 +387,11 @@ namespace Ming3D
                     shaderHeaderStream << "uniform " << GetConvertedType(uniformInfo.mDatatypeInfo.mName) << " " << uniformInfo.mName << ";\n";
                 }
             }
-            // Write uniform groups
-            for (const ConstantBufferInfo& cbuffer : inParsedShaderProgram->mConstantBufferInfos)
+            // Write uniform groups (bound to the slot matching their declaration order, like the HLSL cbuffer registers)
+            for (size_t iBlock = 0; iBlock < inParsedShaderProgram->mConstantBufferInfos.size(); iBlock++)
             {
-                shaderHeaderStream << "layout (std140) uniform " << cbuffer.mName << "\n{\n";
+                const ConstantBufferInfo& cbuffer = inParsedShaderProgram->mConstantBufferInfos[iBlock];
+                shaderHeaderStream << "layout (std140, binding = " << iBlock << ") uniform " << cbuffer.mName << "\n{\n";
 
                 for (const ShaderVariableInfo& uniformInfo : cbuffer.mShaderUniforms)
                 {
@@ -359,11 +402,13 @@ namespace Ming3D
 
             shaderHeaderStream << "\n";
 
-            // Write textures
-            for (const ShaderTextureInfo textureInfo : inParsedShaderProgram->mShaderTextures)
+            // Write textures (bound to the slot matching their declaration order)
+            for (size_t iTexture = 0; iTexture < inParsedShaderProgram->mShaderTextures.size(); iTexture++)
             {
+                const ShaderTextureInfo& textureInfo = inParsedShaderProgram->mShaderTextures[iTexture];
                 if (mReferencedUniforms.find(textureInfo.mTextureName) != mReferencedUniforms.end())
                 {
+                    shaderHeaderStream << "layout (binding=" << iTexture << ") ";
                     shaderHeaderStream << "uniform " << GetConvertedType(textureInfo.mTextureType) << " " << textureInfo.mTextureName << ";\n";
                 }
             }
@@ -380,7 +425,7 @@ namespace Ming3D
             shaderHeaderStream << "\n";
 
             // Write shader output
-            for (size_t i = 0; i < currShader->mOutput.mMemberVariables.size(); i++)
+            for (size_t i = 0; i < currShader->mOutput.mMemberVariables.size() && !mDepthOnly; i++)
             {
                 const ShaderStructMember outputMember = currShader->mOutput.mMemberVariables[i];
                 shaderHeaderStream << "layout (location=" << i << ") ";
@@ -389,6 +434,12 @@ namespace Ming3D
 
             shaderHeaderStream << "\n";
 
+            // Depth pre-pass and colour pass must produce bit-identical positions for the Equal depth test
+            if (currShader == inParsedShaderProgram->mVertexShader)
+            {
+                shaderHeaderStream << "invariant gl_Position;\n";
+            }
+
             if (currShader == inParsedShaderProgram->mFragmentShader)
             {
                 shaderHeaderStream << "out vec4 FragColour;\n";
@@ -401,11 +452,6 @@ namespace Ming3D
                 outData.mVertexShader.mSource = outStream.str();
             else
                 outData.mFragmentShader.mSource = outStream.str();
-
-            std::ofstream oFile;
-            oFile.open(std::string("converted_shader_." + (currShader == inParsedShaderProgram->mVertexShader ? std::string("vs") : std::string("fs"))));
-            oFile << outStream.str().c_str();
-            oFile.close();
         }
 
         return true;
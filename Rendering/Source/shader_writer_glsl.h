@@ -19,6 +19,7 @@ namespace Ming3D
 
         const ParsedShaderProgram* mCurrentShaderProgram = nullptr;
         ParsedShader* mCurrentShader = nullptr;
+        bool mDepthOnly = false;
 
         std::string GetVariableIdentifierString(const std::string inName);
         std::string GetConvertedType(const std::string inString);
@@ -32,7 +33,7 @@ namespace Ming3D
         void WriteStatementBlock(ShaderStream& inStream, const ShaderStatementBlock* inStatementBlock);
 
     public:
-        bool WriteShader(const ParsedShaderProgram* inParsedShaderProgram, ShaderProgramDataGLSL& outData);
+        bool WriteShader(const ParsedShaderProgram* inParsedShaderProgram, ShaderProgramDataGLSL& outData, bool inDepthOnly = false);
     };
 }
 
@@ -1,7 +1,6 @@
 #include "shader_writer_hlsl.h"
 
 #include <sstream>
-#include <fstream>
 #include "Debug/debug.h"
 
 namespace Ming3D
@@ -30,6 +29,10 @@ namespace Ming3D
             return "float3x3";
         else if (inString == "mat4")
             return "float4x4";
+        else if (inString == "TexelBuffer")
+            return "Buffer<float4>";
+        else if (inString == "ShadowMapArray")
+            return "Texture2DArray";
         return inString;
     }
 
@@ -172,6 +175,39 @@ namespace Ming3D
                 inStream << ".y)";
                 inStream << ")";
             }
+            else if (funcCallExpr->mIdentifier.mTokenString == "ReadTextureArray")
+            {
+                // ReadTextureArray(textureArray, uv, layer)
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[0]);
+                inStream << ".Sample(defaultSampler, float3(";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[1]);
+                inStream << ".x, 1.0f - ";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[1]);
+                inStream << ".y, ";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[2]);
+                inStream << "))";
+            }
+            else if (funcCallExpr->mIdentifier.mTokenString == "ReadTexelBuffer")
+            {
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[0]);
+                inStream << ".Load(";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[1]);
+                inStream << ")";
+            }
+            else if (funcCallExpr->mIdentifier.mTokenString == "SampleShadowMap")
+            {
+                // SampleShadowMap(shadowMap, float3(u, v, depth), layer)
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[0]);
+                inStream << ".SampleCmpLevelZero(shadowSampler, float3(";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[1]);
+                inStream << ".x, 1.0f - ";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[1]);
+                inStream << ".y, ";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[2]);
+                inStream << "), ";
+                WriteExpression(inStream, funcCallExpr->mParameterExpressions[1]);
+                inStream << ".z)";
+            }
             else
             {
                 std::string functionName = GetConvertedType(funcCallExpr->mIdentifier.mTokenString);
@@ -285,7 +321,7 @@ namespace Ming3D
         }
     }
 
-    bool ShaderWriterHLSL::WriteShader(const ParsedShaderProgram* inParsedShaderProgram, ShaderProgramDataHLSL& outData)
+    bool ShaderWriterHLSL::WriteShader(const ParsedShaderProgram* inParsedShaderProgram, ShaderProgramDataHLSL& outData, bool inDepthOnly)
     {
         mCurrentProgram = inParsedShaderProgram;
 
@@ -315,6 +351,13 @@ namespace Ming3D
 
         for (ParsedShader* currShader : shaders)
         {
+            // Depth-only programs have no colour output, so the pixel stage is left empty
+            if (inDepthOnly && currShader == inParsedShaderProgram->mFragmentShader)
+            {
+                outData.mFragmentShader = "void main()\n{\n}\n";
+                continue;
+            }
+
             mCurrentShader = currShader;
             mReferencedUniforms.clear();
 
@@ -348,6 +391,9 @@ namespace Ming3D
                 shaderHeaderStream.AddIndent();
                 for (const ShaderStructMember member : structInfo.mMemberVariables)
                 {
+                    // Depth pre-pass and colour pass must produce bit-identical positions for the Equal depth test (like "invariant gl_Position" in GLSL)
+                    if (member.mSemantic == "SV_POSITION" && currShader == inParsedShaderProgram->mVertexShader)
+                        shaderHeaderStream << "precise ";
                     shaderHeaderStream << GetConvertedType(member.mDatatype.mName) << " " << member.mName;
                     if (member.mSemantic != "")
                     {
@@ -405,13 +451,23 @@ namespace Ming3D
             {
                 shaderHeaderStream << "SamplerState defaultSampler;\n";
             }
+            for (const ShaderTextureInfo& textureInfo : inParsedShaderProgram->mShaderTextures)
+            {
+                // Comparison sampler for shadow maps (bound by RenderDeviceD3D11::SetTexture, see ShadowSamplerSlot)
+                if (textureInfo.mTextureType == "ShadowMapArray" && mReferencedUniforms.find(textureInfo.mTextureName) != mReferencedUniforms.end())
+                {
+                    shaderHeaderStream << "SamplerComparisonState shadowSampler : register(s15);\n";
+                    break;
+                }
+            }
 
-            // Write textures
-            for (const ShaderTextureInfo textureInfo : inParsedShaderProgram->mShaderTextures)
+            // Write textures (bound to the slot matching their declaration order)
+            for (size_t iTexture = 0; iTexture < inParsedShaderProgram->mShaderTextures.size(); iTexture++)
             {
+                const ShaderTextureInfo& textureInfo = inParsedShaderProgram->mShaderTextures[iTexture];
                 if (mReferencedUniforms.find(textureInfo.mTextureName) != mReferencedUniforms.end())
                 {
-                    shaderHeaderStream << GetConvertedType(textureInfo.mTextureType) << " " << textureInfo.mTextureName << ";\n";
+                    shaderHeaderStream << GetConvertedType(textureInfo.mTextureType) << " " << textureInfo.mTextureName << " : register(t" << iTexture << ");\n";
                 }
             }
 
@@ -419,12 +475,6 @@ namespace Ming3D
             outStream << shaderHeaderStream.GetStream().str() << "\n" << shaderBodyStream.GetStream().str();
 
             currShaderText = outStream.str();
-
-            // Write converted shader text
-            std::ofstream oFile;
-            oFile.open(std::string("converted_shader_." + (currShader == inParsedShaderProgram->mVertexShader ? std::string("vs") : std::string("fs"))));
-            oFile << outStream.str().c_str();
-            oFile.close();
         }
 
         return true;
@@ -37,7 +37,7 @@ namespace Ming3D
         void WriteStatementBlock(ShaderStream& inStream, const ShaderStatementBlock* inStatementBlock);
 
     public:
-        bool WriteShader(const ParsedShaderProgram* inParsedShaderProgram, ShaderProgramDataHLSL& outData);
+        bool WriteShader(const ParsedShaderProgram* inParsedShaderProgram, ShaderProgramDataHLSL& outData, bool inDepthOnly = false);
     };
 }
 
@@ -3,14 +3,49 @@
 
 namespace Ming3D
 {
+    size_t TextureInfo::GetMipRowPitch(unsigned int inLevel) const
+    {
+        switch (mPixelFormat)
+        {
+        case PixelFormat::BC1:
+            return ((GetMipWidth(inLevel) + 3) / 4) * 8;
+        case PixelFormat::BC3:
+            return ((GetMipWidth(inLevel) + 3) / 4) * 16;
+        default:
+            return GetMipWidth(inLevel) * mBytesPerPixel;
+        }
+    }
+
+    size_t TextureInfo::GetMipLevelSize(unsigned int inLevel) const
+    {
+        const size_t numRows = IsCompressed() ? (GetMipHeight(inLevel) + 3) / 4 : GetMipHeight(inLevel);
+        return GetMipRowPitch(inLevel) * numRows;
+    }
+
+    size_t TextureInfo::GetMipLevelOffset(unsigned int inLevel) const
+    {
+        size_t offset = 0;
+        for (unsigned int iLevel = 0; iLevel < inLevel; iLevel++)
+            offset += GetMipLevelSize(iLevel);
+        return offset;
+    }
+
     void Texture::SetTextureData(const void* inData, const size_t inBytesPerPixel, PixelFormat inPixelFormat, unsigned int inWidth, unsigned int inHeight)
     {
         mTextureInfo.mWidth = inWidth;
         mTextureInfo.mHeight = inHeight;
         mTextureInfo.mBytesPerPixel = inBytesPerPixel;
         mTextureInfo.mPixelFormat = inPixelFormat;
+        mTextureInfo.mMipLevels = 1;
         const size_t size = inBytesPerPixel * inWidth * inHeight;
         mTextureData.resize(size);
         memcpy(mTextureData.data(), inData, size);
     }
+
+    void Texture::SetTextureData(const void* inData, const TextureInfo& inTextureInfo)
+    {
+        mTextureInfo = inTextureInfo;
+        mTextureData.resize(inTextureInfo.GetDataSize());
+        memcpy(mTextureData.data(), inData, mTextureData.size());
+    }
 }
@@ -8,15 +8,29 @@ namespace Ming3D
 {
     enum PixelFormat
     {
-        RGBA, BGRA, RGB
+        RGBA, BGRA, RGB,
+        BC1, // 4x4 blocks of 8 bytes (RGB, 1 bit alpha)
+        BC3  // 4x4 blocks of 16 bytes (RGBA)
     };
 
     struct TextureInfo
     {
         unsigned int mWidth = 0;
         unsigned int mHeight = 0;
-        unsigned int mBytesPerPixel;
+        unsigned int mBytesPerPixel; // 0 for block compressed formats
         PixelFormat mPixelFormat;
+        unsigned int mMipLevels = 1;
+
+        bool IsCompressed() const { return mPixelFormat == PixelFormat::BC1 || mPixelFormat == PixelFormat::BC3; }
+        unsigned int GetMipWidth(unsigned int inLevel) const { return (mWidth >> inLevel) > 0 ? (mWidth >> inLevel) : 1; }
+        unsigned int GetMipHeight(unsigned int inLevel) const { return (mHeight >> inLevel) > 0 ? (mHeight >> inLevel) : 1; }
+        /** Size of one row of pixels, or one row of blocks for compressed formats. */
+        size_t GetMipRowPitch(unsigned int inLevel) const;
+        size_t GetMipLevelSize(unsigned int inLevel) const;
+        /** Offset of a mip level in the texture data. Levels are stored consecutively, largest first. */
+        size_t GetMipLevelOffset(unsigned int inLevel) const;
+        /** Total size of all mip levels. */
+        size_t GetDataSize() const { return GetMipLevelOffset(mMipLevels); }
     };
 
     /**
@@ -33,7 +47,9 @@ namespace Ming3D
     public:
         virtual ~Texture() {}
         void SetTextureData(const void* inData, const size_t inBytesPerPixel, PixelFormat inPixelFormat, unsigned int inWidth, unsigned int inHeight); // TODO: Use a smart pointer to a stream
-        
+        /** Sets the data of all mip levels (see TextureInfo::GetMipLevelOffset). */
+        void SetTextureData(const void* inData, const TextureInfo& inTextureInfo);
+
         void* GetTextureData() { return mTextureData.data(); }
         TextureInfo GetTextureInfo() const { return mTextureInfo; }
     };
@@ -12,6 +12,10 @@ namespace Ming3D
         {
             mTexture->Release();
         }
+        if (mBuffer != nullptr)
+        {
+            mBuffer->Release();
+        }
         if (mTextureResourceView != nullptr)
         {
             mTextureResourceView->Release();
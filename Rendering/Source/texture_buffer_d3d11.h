@@ -17,7 +17,9 @@ namespace Ming3D
         virtual ~TextureBufferD3D11();
 
         ID3D11Texture2D* mTexture = nullptr;
+        ID3D11Buffer* mBuffer = nullptr; // set for texel buffers (instead of mTexture)
         ID3D11ShaderResourceView* mTextureResourceView = nullptr;
+        bool mDepthCompare = false; // sampled with the shadow (comparison) sampler
 
     };
 }
@@ -11,6 +11,10 @@ namespace Ming3D
         {
             glDeleteTextures(1, &mGLTexture);
         }
+        if (mGLBuffer != 0)
+        {
+            glDeleteBuffers(1, &mGLBuffer);
+        }
     }
 
     void TextureBufferGL::SetGLTexture(GLuint inTextureID)
@@ -22,5 +26,25 @@ namespace Ming3D
     {
         return mGLTexture;
     }
+
+    void TextureBufferGL::SetGLTarget(GLenum inTarget)
+    {
+        mGLTarget = inTarget;
+    }
+
+    GLenum TextureBufferGL::GetGLTarget()
+    {
+        return mGLTarget;
+    }
+
+    void TextureBufferGL::SetGLBuffer(GLuint inBufferID)
+    {
+        mGLBuffer = inBufferID;
+    }
+
+    GLuint TextureBufferGL::GetGLBuffer()
+    {
+        return mGLBuffer;
+    }
 }
 #endif
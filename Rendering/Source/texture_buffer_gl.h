@@ -10,11 +10,17 @@ namespace Ming3D
     {
     private:
         GLuint mGLTexture = -1;
+        GLenum mGLTarget = GL_TEXTURE_2D;
+        GLuint mGLBuffer = 0; // backing buffer, for GL_TEXTURE_BUFFER textures
 
     public:
         virtual ~TextureBufferGL();
         void SetGLTexture(GLuint inTextureID);
         GLuint GetGLTexture();
+        void SetGLTarget(GLenum inTarget);
+        GLenum GetGLTarget();
+        void SetGLBuffer(GLuint inBufferID);
+        GLuint GetGLBuffer();
     };
 }
 
@@ -0,0 +1,19 @@
+#ifndef MING3D_TEXTURE_BUFFER_NULL_H
+#define MING3D_TEXTURE_BUFFER_NULL_H
+
+#include "texture_buffer.h"
+#include "render_device_null_stats.h"
+
+namespace Ming3D
+{
+    /** Texture, texel buffer or render target attachment of a RenderDeviceNull. */
+    class TextureBufferNull : public TextureBuffer
+    {
+    public:
+        NullResourceMemory mMemory;
+
+        TextureBufferNull(size_t* inMemoryStat, size_t inSize) : mMemory(inMemoryStat, inSize) {}
+    };
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "texture_loader.h"
+#include "pixel_conversion.h"
 
 #ifdef _WIN32
 #include <SDL_image.h>
@@ -8,68 +9,50 @@
 
 namespace Ming3D
 {
-    Texture* TextureLoader::LoadTextureData(const char* inFilePath)
+    Texture* TextureLoader::LoadTextureData(const char* inFilePath, bool inPremultiplyAlpha)
     {
-        SDL_Surface * surface = IMG_Load(inFilePath);
+        return CreateTexture(IMG_Load(inFilePath), inPremultiplyAlpha);
+    }
+
+    Texture* TextureLoader::LoadTextureData(const void* inData, size_t inSize, const char* inType, bool inPremultiplyAlpha)
+    {
+        return CreateTexture(IMG_LoadTyped_RW(SDL_RWFromConstMem(inData, (int)inSize), 1, inType), inPremultiplyAlpha);
+    }
 
+    Texture* TextureLoader::CreateTexture(SDL_Surface* surface, bool inPremultiplyAlpha)
+    {
         if (surface == nullptr)
             return nullptr;
 
-        Texture* texture = new Texture();
-
-        unsigned int bytesPerPixel = surface->format->BytesPerPixel;
-        PixelFormat pixelFormat;
-        if (surface->format->BitsPerPixel == 32 && surface->format->Bshift < surface->format->Gshift)
-            pixelFormat = PixelFormat::RGBA;
-        else if (surface->format->BitsPerPixel == 32)
-            pixelFormat = PixelFormat::RGBA;
-        else
-            pixelFormat = PixelFormat::RGB;
+        if (surface->format->BytesPerPixel != 3 && surface->format->BytesPerPixel != 4)
+        {
+            // Palettised and 16 bit images: let SDL convert them
+            SDL_Surface* convertedSurface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+            SDL_FreeSurface(surface);
+            if (convertedSurface == nullptr)
+                return nullptr;
+            surface = convertedSurface;
+        }
 
-        const int texWidth = surface->w;
-        const int texHeight = surface->h;
-        const size_t textureSize = 4 * texWidth * texHeight; // Force 32 bit
-        uint8_t* textureData = new uint8_t[textureSize];
+        // Convert (RGB/BGR(A) -> RGBA) straight into the texture's storage, in one pass
+        int conversionFlags = 0;
+        if (surface->format->Rshift != 0)
+            conversionFlags |= PIXELCONVERSION_SWAP_RED_BLUE;
+        if (surface->format->BytesPerPixel == 4 && surface->format->Amask == 0)
+            conversionFlags |= PIXELCONVERSION_FORCE_OPAQUE;
+        if (inPremultiplyAlpha)
+            conversionFlags |= PIXELCONVERSION_PREMULTIPLY_ALPHA;
 
-        // correct pixel format - TODO: also handle 16 bit
-        if (pixelFormat == PixelFormat::RGB && bytesPerPixel == 3)
-        {
-            pixelFormat = PixelFormat::RGBA;
-            bytesPerPixel = 4;
+        Texture* texture = new Texture();
+        texture->mTextureInfo.mWidth = surface->w;
+        texture->mTextureInfo.mHeight = surface->h;
+        texture->mTextureInfo.mBytesPerPixel = 4;
+        texture->mTextureInfo.mPixelFormat = PixelFormat::RGBA;
+        texture->mTextureData.resize((size_t)surface->w * surface->h * 4);
 
-            size_t sourceTextureIndex = 0;
-            for (size_t i = 0; i < texWidth * texHeight * 4; i++)
-            {
-                if (i % 4 == 3)
-                {
-                    textureData[i] = 255;
-                }
-                else
-                {
-                    textureData[i] = ((uint8_t*)surface->pixels)[sourceTextureIndex];
-                    sourceTextureIndex++;
-                }
-            }
-        }
-        else
-        {
-            memcpy(&textureData[0], surface->pixels, textureSize);
-        }
+        PixelConversion::ConvertToRGBA((const uint8_t*)surface->pixels, surface->pitch, surface->format->BytesPerPixel,
+            (uint8_t*)texture->mTextureData.data(), (ptrdiff_t)surface->w * 4, surface->w, surface->h, conversionFlags);
 
-        texture->SetTextureData(textureData, bytesPerPixel, pixelFormat, surface->w, surface->h);
-        /*
-        #ifndef MING3D_OPENGL // TODO - TEMP HACK: what to do about this? OpenGL and D3D use a different origin (Upper-Left vs BottomLeft). If we try to solve it by flipping the Y-coordinate in the shader, we also have to do that when rendering to texture, which is ugly..
-        char* buffer = new char[surface->w * surface->h * bytesPerPixel];
-        memcpy(buffer, outTexture->mTextureData.data(), surface->w * surface->h * bytesPerPixel);
-        for (size_t i = 0; i < surface->h; i++)
-        {
-        const size_t rowSize = surface->w * bytesPerPixel;
-        memcpy(outTexture->mTextureData.data() + (rowSize * (surface->h - 1)) - (rowSize * i), buffer + rowSize * i, rowSize);
-        }
-        delete[] buffer;
-        #endif
-        */
-        delete[] textureData;
         SDL_FreeSurface(surface);
         return texture;
     }
@@ -3,12 +3,20 @@
 
 #include "texture.h"
 
+struct SDL_Surface;
+
 namespace Ming3D
 {
     class TextureLoader
     {
+    private:
+        /** Converts the surface to a (32 bit RGBA) texture, and frees it. */
+        static Texture* CreateTexture(SDL_Surface* surface, bool inPremultiplyAlpha);
+
     public:
-        static Texture* LoadTextureData(const char* inFilePath);
+        static Texture* LoadTextureData(const char* inFilePath, bool inPremultiplyAlpha = false);
+        /** Decodes an image file that has already been read into memory. inType is the file extension (needed for formats without a signature, such as TGA). */
+        static Texture* LoadTextureData(const void* inData, size_t inSize, const char* inType = nullptr, bool inPremultiplyAlpha = false);
         static void CreateEmptyTexture(Texture* outTexture);
     };
 }
@@ -0,0 +1,363 @@
+#include "texture_processor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MING3D_TEXTUREPROCESSOR_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Ming3D
+{
+    namespace
+    {
+        inline uint8_t Average(uint8_t inA, uint8_t inB)
+        {
+            return (uint8_t)((inA + inB + 1) >> 1); // same rounding as _mm_avg_epu8
+        }
+
+        /** Downsamples one 8 bit RGBA mip level with a 2x2 box filter. Odd edges are clamped. */
+        void DownsampleLevel(const uint8_t* inSrc, unsigned int inSrcWidth, unsigned int inSrcHeight, uint8_t* outDst, unsigned int inDstWidth, unsigned int inDstHeight)
+        {
+            for (unsigned int y = 0; y < inDstHeight; y++)
+            {
+                const uint8_t* row0 = inSrc + (size_t)std::min(y * 2, inSrcHeight - 1) * inSrcWidth * 4;
+                const uint8_t* row1 = inSrc + (size_t)std::min(y * 2 + 1, inSrcHeight - 1) * inSrcWidth * 4;
+                uint8_t* dstRow = outDst + (size_t)y * inDstWidth * 4;
+
+                unsigned int x = 0;
+#ifdef MING3D_TEXTUREPROCESSOR_SSE
+                // 8 source pixels (two rows) -> 4 destination pixels
+                for (; x + 4 <= inDstWidth; x += 4)
+                {
+                    const __m128i top0 = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+                    const __m128i top1 = _mm_loadu_si128((const __m128i*)(row0 + x * 8 + 16));
+                    const __m128i bottom0 = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+                    const __m128i bottom1 = _mm_loadu_si128((const __m128i*)(row1 + x * 8 + 16));
+                    const __m128 vertical0 = _mm_castsi128_ps(_mm_avg_epu8(top0, bottom0));
+                    const __m128 vertical1 = _mm_castsi128_ps(_mm_avg_epu8(top1, bottom1));
+                    const __m128i evenPixels = _mm_castps_si128(_mm_shuffle_ps(vertical0, vertical1, _MM_SHUFFLE(2, 0, 2, 0)));
+                    const __m128i oddPixels = _mm_castps_si128(_mm_shuffle_ps(vertical0, vertical1, _MM_SHUFFLE(3, 1, 3, 1)));
+                    _mm_storeu_si128((__m128i*)(dstRow + x * 4), _mm_avg_epu8(evenPixels, oddPixels));
+                }
+#endif
+                for (; x < inDstWidth; x++)
+                {
+                    const unsigned int x0 = std::min(x * 2, inSrcWidth - 1) * 4;
+                    const unsigned int x1 = std::min(x * 2 + 1, inSrcWidth - 1) * 4;
+                    for (unsigned int c = 0; c < 4; c++)
+                        dstRow[x * 4 + c] = Average(Average(row0[x0 + c], row1[x0 + c]), Average(row0[x1 + c], row1[x1 + c]));
+                }
+            }
+        }
+
+        inline uint16_t ToRGB565(const int* inColour)
+        {
+            return (uint16_t)(((inColour[0] >> 3) << 11) | ((inColour[1] >> 2) << 5) | (inColour[2] >> 3));
+        }
+
+        inline void FromRGB565(uint16_t inColour, int* outColour)
+        {
+            const int r = (inColour >> 11) & 31;
+            const int g = (inColour >> 5) & 63;
+            const int b = inColour & 31;
+            outColour[0] = (r << 3) | (r >> 2);
+            outColour[1] = (g << 2) | (g >> 4);
+            outColour[2] = (b << 3) | (b >> 2);
+        }
+
+        /**
+        * Encodes the colour of a 4x4 block of RGBA pixels to a BC1 block.
+        * Endpoints are picked from the (inset) bounding box of the colours, along the diagonal that matches the colour covariance.
+        */
+        void EncodeColourBlock(const uint8_t* inPixels, uint8_t* outBlock)
+        {
+            int minColour[3] = { 255, 255, 255 };
+            int maxColour[3] = { 0, 0, 0 };
+            int centre[3] = { 0, 0, 0 };
+            for (int iPixel = 0; iPixel < 16; iPixel++)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    minColour[c] = std::min(minColour[c], (int)inPixels[iPixel * 4 + c]);
+                    maxColour[c] = std::max(maxColour[c], (int)inPixels[iPixel * 4 + c]);
+                    centre[c] += inPixels[iPixel * 4 + c];
+                }
+            }
+
+            // Flip the red/blue extents if they are anti-correlated with green
+            int covRG = 0;
+            int covBG = 0;
+            for (int iPixel = 0; iPixel < 16; iPixel++)
+            {
+                const int r = inPixels[iPixel * 4] * 16 - centre[0];
+                const int g = inPixels[iPixel * 4 + 1] * 16 - centre[1];
+                const int b = inPixels[iPixel * 4 + 2] * 16 - centre[2];
+                covRG += r * g;
+                covBG += b * g;
+            }
+            if (covRG < 0)
+                std::swap(minColour[0], maxColour[0]);
+            if (covBG < 0)
+                std::swap(minColour[2], maxColour[2]);
+
+            // Inset the bounding box, to reduce the error of the interpolated colours
+            for (int c = 0; c < 3; c++)
+            {
+                const int inset = (maxColour[c] - minColour[c]) / 16;
+                minColour[c] += inset;
+                maxColour[c] -= inset;
+            }
+
+            uint16_t colour0 = ToRGB565(maxColour);
+            uint16_t colour1 = ToRGB565(minColour);
+            if (colour0 < colour1)
+                std::swap(colour0, colour1); // colour0 > colour1 selects the 4 colour mode
+
+            uint32_t indices = 0;
+            if (colour0 != colour1)
+            {
+                int palette[4][3];
+                FromRGB565(colour0, palette[0]);
+                FromRGB565(colour1, palette[1]);
+                for (int c = 0; c < 3; c++)
+                {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+
+                for (int iPixel = 0; iPixel < 16; iPixel++)
+                {
+                    int bestIndex = 0;
+                    int bestDistance = INT32_MAX;
+                    for (int iColour = 0; iColour < 4; iColour++)
+                    {
+                        int distance = 0;
+                        for (int c = 0; c < 3; c++)
+                        {
+                            const int delta = inPixels[iPixel * 4 + c] - palette[iColour][c];
+                            distance += delta * delta;
+                        }
+                        if (distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            bestIndex = iColour;
+                        }
+                    }
+                    indices |= (uint32_t)bestIndex << (iPixel * 2);
+                }
+            }
+
+            outBlock[0] = (uint8_t)(colour0 & 0xFF);
+            outBlock[1] = (uint8_t)(colour0 >> 8);
+            outBlock[2] = (uint8_t)(colour1 & 0xFF);
+            outBlock[3] = (uint8_t)(colour1 >> 8);
+            for (int i = 0; i < 4; i++)
+                outBlock[4 + i] = (uint8_t)(indices >> (i * 8));
+        }
+
+        /** Encodes the alpha of a 4x4 block of RGBA pixels to a BC3 alpha block (8 interpolated values between min and max). */
+        void EncodeAlphaBlock(const uint8_t* inPixels, uint8_t* outBlock)
+        {
+            int minAlpha = 255;
+            int maxAlpha = 0;
+            for (int iPixel = 0; iPixel < 16; iPixel++)
+            {
+                minAlpha = std::min(minAlpha, (int)inPixels[iPixel * 4 + 3]);
+                maxAlpha = std::max(maxAlpha, (int)inPixels[iPixel * 4 + 3]);
+            }
+
+            uint64_t indices = 0;
+            if (minAlpha != maxAlpha)
+            {
+                int palette[8];
+                palette[0] = maxAlpha;
+                palette[1] = minAlpha;
+                for (int i = 1; i < 7; i++)
+                    palette[i + 1] = ((7 - i) * maxAlpha + i * minAlpha) / 7;
+
+                for (int iPixel = 0; iPixel < 16; iPixel++)
+                {
+                    const int alpha = inPixels[iPixel * 4 + 3];
+                    int bestIndex = 0;
+                    int bestDistance = 256;
+                    for (int iAlpha = 0; iAlpha < 8; iAlpha++)
+                    {
+                        const int distance = std::abs(alpha - palette[iAlpha]);
+                        if (distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            bestIndex = iAlpha;
+                        }
+                    }
+                    indices |= (uint64_t)bestIndex << (iPixel * 3);
+                }
+            }
+
+            outBlock[0] = (uint8_t)maxAlpha;
+            outBlock[1] = (uint8_t)minAlpha;
+            for (int i = 0; i < 6; i++)
+                outBlock[2 + i] = (uint8_t)(indices >> (i * 8));
+        }
+
+        void CompressLevel(const uint8_t* inSrc, unsigned int inWidth, unsigned int inHeight, bool inBGRA, PixelFormat inFormat, uint8_t* outDst)
+        {
+            const size_t blockSize = inFormat == PixelFormat::BC1 ? 8 : 16;
+            uint8_t pixels[16 * 4];
+            for (unsigned int blockY = 0; blockY < inHeight; blockY += 4)
+            {
+                for (unsigned int blockX = 0; blockX < inWidth; blockX += 4)
+                {
+                    // Gather the block (clamped, for mip levels smaller than a block)
+                    for (unsigned int y = 0; y < 4; y++)
+                    {
+                        const size_t srcRow = (size_t)std::min(blockY + y, inHeight - 1) * inWidth;
+                        for (unsigned int x = 0; x < 4; x++)
+                        {
+                            const uint8_t* srcPixel = inSrc + (srcRow + std::min(blockX + x, inWidth - 1)) * 4;
+                            uint8_t* pixel = &pixels[(y * 4 + x) * 4];
+                            pixel[0] = srcPixel[inBGRA ? 2 : 0];
+                            pixel[1] = srcPixel[1];
+                            pixel[2] = srcPixel[inBGRA ? 0 : 2];
+                            pixel[3] = srcPixel[3];
+                        }
+                    }
+
+                    if (inFormat == PixelFormat::BC3)
+                    {
+                        EncodeAlphaBlock(pixels, outDst);
+                        EncodeColourBlock(pixels, outDst + 8);
+                    }
+                    else
+                    {
+                        EncodeColourBlock(pixels, outDst);
+                    }
+                    outDst += blockSize;
+                }
+            }
+        }
+
+        /** Reverses the order of the first inNumRows texel rows of a block of 2 bit (BC1) indices. */
+        void FlipColourIndices(uint8_t* ioIndices, unsigned int inNumRows)
+        {
+            std::reverse(ioIndices, ioIndices + inNumRows);
+        }
+
+        /** Reverses the order of the first inNumRows texel rows of a block of 3 bit (BC3 alpha) indices. */
+        void FlipAlphaIndices(uint8_t* ioIndices, unsigned int inNumRows)
+        {
+            uint64_t indices = 0;
+            for (int i = 0; i < 6; i++)
+                indices |= (uint64_t)ioIndices[i] << (i * 8);
+            uint64_t flippedIndices = indices;
+            for (unsigned int iRow = 0; iRow < inNumRows; iRow++)
+            {
+                const uint64_t row = (indices >> (iRow * 12)) & 0xFFF;
+                const unsigned int flippedRow = inNumRows - 1 - iRow;
+                flippedIndices &= ~(0xFFFull << (flippedRow * 12));
+                flippedIndices |= row << (flippedRow * 12);
+            }
+            for (int i = 0; i < 6; i++)
+                ioIndices[i] = (uint8_t)(flippedIndices >> (i * 8));
+        }
+    }
+
+    void TextureProcessor::GenerateMipmaps(Texture* ioTexture)
+    {
+        TextureInfo textureInfo = ioTexture->GetTextureInfo();
+        if (textureInfo.IsCompressed() || textureInfo.mBytesPerPixel != 4 || textureInfo.mMipLevels != 1)
+            return;
+
+        unsigned int numLevels = 1;
+        while ((textureInfo.mWidth >> numLevels) > 0 || (textureInfo.mHeight >> numLevels) > 0)
+            numLevels++;
+        textureInfo.mMipLevels = numLevels;
+
+        std::vector<char> mipData(textureInfo.GetDataSize());
+        memcpy(mipData.data(), ioTexture->mTextureData.data(), textureInfo.GetMipLevelSize(0));
+        for (unsigned int iLevel = 1; iLevel < numLevels; iLevel++)
+        {
+            const uint8_t* srcLevel = (const uint8_t*)mipData.data() + textureInfo.GetMipLevelOffset(iLevel - 1);
+            uint8_t* dstLevel = (uint8_t*)mipData.data() + textureInfo.GetMipLevelOffset(iLevel);
+            DownsampleLevel(srcLevel, textureInfo.GetMipWidth(iLevel - 1), textureInfo.GetMipHeight(iLevel - 1), dstLevel, textureInfo.GetMipWidth(iLevel), textureInfo.GetMipHeight(iLevel));
+        }
+
+        ioTexture->mTextureData.swap(mipData);
+        ioTexture->mTextureInfo = textureInfo;
+    }
+
+    bool TextureProcessor::CanCompress(const TextureInfo& inTextureInfo)
+    {
+        const bool powerOfTwo = (inTextureInfo.mWidth & (inTextureInfo.mWidth - 1)) == 0 && (inTextureInfo.mHeight & (inTextureInfo.mHeight - 1)) == 0;
+        return !inTextureInfo.IsCompressed() && inTextureInfo.mBytesPerPixel == 4 && inTextureInfo.mWidth > 0 && inTextureInfo.mHeight > 0 && powerOfTwo
+            && (inTextureInfo.mPixelFormat == PixelFormat::RGBA || inTextureInfo.mPixelFormat == PixelFormat::BGRA);
+    }
+
+    bool TextureProcessor::Compress(Texture* ioTexture, PixelFormat inFormat)
+    {
+        const TextureInfo srcInfo = ioTexture->GetTextureInfo();
+        if (!CanCompress(srcInfo) || (inFormat != PixelFormat::BC1 && inFormat != PixelFormat::BC3))
+            return false;
+
+        TextureInfo dstInfo = srcInfo;
+        dstInfo.mPixelFormat = inFormat;
+        dstInfo.mBytesPerPixel = 0;
+
+        std::vector<char> compressedData(dstInfo.GetDataSize());
+        for (unsigned int iLevel = 0; iLevel < srcInfo.mMipLevels; iLevel++)
+        {
+            const uint8_t* srcLevel = (const uint8_t*)ioTexture->mTextureData.data() + srcInfo.GetMipLevelOffset(iLevel);
+            uint8_t* dstLevel = (uint8_t*)compressedData.data() + dstInfo.GetMipLevelOffset(iLevel);
+            CompressLevel(srcLevel, srcInfo.GetMipWidth(iLevel), srcInfo.GetMipHeight(iLevel), srcInfo.mPixelFormat == PixelFormat::BGRA, inFormat, dstLevel);
+        }
+
+        ioTexture->mTextureData.swap(compressedData);
+        ioTexture->mTextureInfo = dstInfo;
+        return true;
+    }
+
+    bool TextureProcessor::HasAlpha(const Texture* inTexture)
+    {
+        const TextureInfo& textureInfo = inTexture->mTextureInfo;
+        if (textureInfo.IsCompressed() || textureInfo.mBytesPerPixel != 4 || textureInfo.mPixelFormat == PixelFormat::RGB)
+            return false;
+
+        const uint8_t* pixels = (const uint8_t*)inTexture->mTextureData.data();
+        const size_t numPixels = (size_t)textureInfo.mWidth * textureInfo.mHeight;
+        for (size_t iPixel = 0; iPixel < numPixels; iPixel++)
+        {
+            if (pixels[iPixel * 4 + 3] != 255)
+                return true;
+        }
+        return false;
+    }
+
+    void TextureProcessor::FlipMipLevel(const TextureInfo& inTextureInfo, unsigned int inLevel, const char* inData, char* outData)
+    {
+        const size_t rowPitch = inTextureInfo.GetMipRowPitch(inLevel);
+        const unsigned int height = inTextureInfo.GetMipHeight(inLevel);
+        const unsigned int numRows = inTextureInfo.IsCompressed() ? (height + 3) / 4 : height;
+        for (unsigned int iRow = 0; iRow < numRows; iRow++)
+            memcpy(outData + rowPitch * (numRows - 1 - iRow), inData + rowPitch * iRow, rowPitch);
+
+        if (!inTextureInfo.IsCompressed())
+            return;
+
+        // Only the first (height) texel rows of a block are used, if the level is smaller than a block
+        const unsigned int blockRows = std::min(height, 4u);
+        const size_t blockSize = inTextureInfo.mPixelFormat == PixelFormat::BC1 ? 8 : 16;
+        const size_t levelSize = inTextureInfo.GetMipLevelSize(inLevel);
+        for (size_t blockOffset = 0; blockOffset < levelSize; blockOffset += blockSize)
+        {
+            uint8_t* block = (uint8_t*)outData + blockOffset;
+            if (inTextureInfo.mPixelFormat == PixelFormat::BC3)
+            {
+                FlipAlphaIndices(block + 2, blockRows);
+                block += 8;
+            }
+            FlipColourIndices(block + 4, blockRows);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef MING3D_TEXTUREPROCESSOR_H
+#define MING3D_TEXTUREPROCESSOR_H
+
+#include "texture.h"
+
+namespace Ming3D
+{
+    /**
+    * Offline (or load time) texture processing: mip chain generation and block compression.
+    * Works on 8 bit RGBA/BGRA textures. Thread safe (no render device access).
+    */
+    class TextureProcessor
+    {
+    public:
+        /** Replaces the texture data with a full mip chain, generated with a 2x2 box filter. The texture must have a single level. */
+        static void GenerateMipmaps(Texture* ioTexture);
+
+        /**
+        * Block compresses all mip levels to BC1 or BC3.
+        * Returns false (and leaves the texture unchanged) if the texture can't be compressed (see CanCompress).
+        */
+        static bool Compress(Texture* ioTexture, PixelFormat inFormat);
+
+        /** Block compression needs power of two dimensions, so each mip level is a whole number of blocks (or a single block). */
+        static bool CanCompress(const TextureInfo& inTextureInfo);
+
+        /** True if any pixel isn't fully opaque. BC1 is used for opaque textures, BC3 for the rest. */
+        static bool HasAlpha(const Texture* inTexture);
+
+        /** Copies a mip level, flipped vertically. Compressed blocks are flipped by swapping the block rows and the texel rows inside each block. */
+        static void FlipMipLevel(const TextureInfo& inTextureInfo, unsigned int inLevel, const char* inData, char* outData);
+    };
+}
+
+#endif
@@ -14,7 +14,7 @@ namespace Ming3D
     {
     private:
         VertexLayout mVertexLayout;
-        size_t mVertexSize;
+        size_t mVertexSize = 0;
 
     public:
         virtual ~VertexBuffer() {}
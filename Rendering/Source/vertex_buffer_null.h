@@ -0,0 +1,18 @@
+#ifndef MING3D_VERTEX_BUFFER_NULL_H
+#define MING3D_VERTEX_BUFFER_NULL_H
+
+#include "vertex_buffer.h"
+#include "render_device_null_stats.h"
+
+namespace Ming3D
+{
+    class VertexBufferNull : public VertexBuffer
+    {
+    public:
+        NullResourceMemory mMemory;
+
+        VertexBufferNull(RenderDeviceNullStats* inStats, size_t inSize) : mMemory(&inStats->mBufferMemory, inSize) {}
+    };
+}
+
+#endif
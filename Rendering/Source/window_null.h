@@ -0,0 +1,26 @@
+#ifndef MING3D_WINDOW_NULL_H
+#define MING3D_WINDOW_NULL_H
+
+#include "window_base.h"
+
+namespace Ming3D
+{
+    /** Window without an OS window, for headless engines (see RenderDeviceNull). */
+    class WindowNull : public WindowBase
+    {
+    private:
+        unsigned int mWindowWidth = 800;
+        unsigned int mWindowHeight = 600;
+
+    public:
+        virtual void Initialise() override {}
+        virtual void SetSize(unsigned int inWidth, unsigned int inHeight) override { mWindowWidth = inWidth; mWindowHeight = inHeight; }
+        virtual unsigned int GetWidth() override { return mWindowWidth; }
+        virtual unsigned int GetHeight() override { return mWindowHeight; }
+        virtual void BeginRender() override {}
+        virtual void EndRender() override {}
+        virtual void* GetOSWindowHandle() override { return nullptr; }
+    };
+}
+
+#endif
@@ -13,6 +13,7 @@
 #include "Components/camera_component.h"
 #include "glm/gtx//rotate_vector.hpp"
 #include "Input/input_manager.h"
+#include "Assets/asset_manager.h"
 
 using namespace Ming3D;
 
@@ -38,7 +39,7 @@ int main()
     actor1->GetTransform().SetLocalScale(glm::vec3(2.0f, 2.0f, 2.0f));
     actor1->GetTransform().SetLocalRotation(glm::angleAxis(10.0f * 3.141592654f / 180.0f, glm::vec3(0.0f, 1.0f, 0.0f)));
     gameEngine->GetWorld()->AddActor(actor1);
-    ModelLoader::LoadModel("Resources//Mvr_PetCow_walk.dae", actor1);
+    gameEngine->GetAssetManager()->LoadModelAsync("Resources//Mvr_PetCow_walk.dae", actor1); // appears when loaded
 
     const float camSpeed = 3.0f;
     const float camRotSpeed = 1.0f;
@@ -0,0 +1,116 @@
+#include "shader_cache.h"
+#include "shader_converter.h"
+#include "shader_disk_cache.h"
+#include "shader_parser.h"
+#include "Debug/debug.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Ming3D;
+
+namespace
+{
+    enum class ECookResult
+    {
+        UpToDate,
+        Converted,
+        Failed
+    };
+
+    /** Converts one permutation of a shader program, and writes it to the shader disk cache. */
+    ECookResult CookShaderProgram(const ShaderParserParams& inParams)
+    {
+        ParsedShaderProgram* cachedProgram = ShaderDiskCache::LoadProgram(inParams);
+        if (cachedProgram != nullptr)
+        {
+            delete cachedProgram;
+            return ECookResult::UpToDate;
+        }
+
+        ShaderParser parser;
+        ParsedShaderProgram* parsedProgram = parser.ParseShaderProgram(inParams);
+        if (parsedProgram == nullptr)
+            return ECookResult::Failed;
+
+        std::vector<std::string> convertedShaders;
+        const bool converted = ShaderConverter::ConvertProgram(parsedProgram, convertedShaders) && ShaderDiskCache::SaveProgram(parsedProgram, convertedShaders);
+        delete parsedProgram;
+        return converted ? ECookResult::Converted : ECookResult::Failed;
+    }
+}
+
+// Converts all permutations of the given shader programs, and writes them to the shader disk cache.
+// The runtime loads the cooked programs (converted shaders and reflection data) without parsing them.
+// Paths must be relative to the directory that contains the Resources folder, since they're part of the cache key.
+// Usage: ShaderCompiler [--threads N] Resources/Shaders/defaultshader.cgp ...
+int main(int argc, char** argv)
+{
+    std::vector<std::string> programPaths;
+    unsigned int numThreads = std::thread::hardware_concurrency();
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        if (strcmp(argv[iArg], "--threads") == 0 && iArg + 1 < argc)
+            numThreads = (unsigned int)atoi(argv[++iArg]);
+        else
+            programPaths.push_back(argv[iArg]);
+    }
+
+    if (programPaths.empty())
+    {
+        LOG_ERROR() << "Usage: ShaderCompiler [--threads N] <shader programs>";
+        return 1;
+    }
+
+    std::vector<ShaderParserParams> jobs;
+    for (const std::string& programPath : programPaths)
+    {
+        const std::vector<ShaderParserParams> permutations = ShaderCache::GetPermutations(programPath);
+        jobs.insert(jobs.end(), permutations.begin(), permutations.end());
+    }
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::vector<ECookResult> results(jobs.size(), ECookResult::Failed);
+    std::atomic<size_t> nextJob(0);
+    auto workerFunc = [&]()
+    {
+        for (size_t iJob = nextJob++; iJob < jobs.size(); iJob = nextJob++)
+            results[iJob] = CookShaderProgram(jobs[iJob]);
+    };
+
+    std::vector<std::thread> workerThreads;
+    numThreads = std::min(std::max(numThreads, 1u), (unsigned int)jobs.size());
+    for (unsigned int iThread = 1; iThread < numThreads; iThread++)
+        workerThreads.emplace_back(workerFunc);
+    workerFunc();
+    for (std::thread& workerThread : workerThreads)
+        workerThread.join();
+
+    const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - startTime;
+
+    size_t numConverted = 0;
+    size_t numFailed = 0;
+    for (size_t iJob = 0; iJob < jobs.size(); iJob++)
+    {
+        if (results[iJob] == ECookResult::Converted)
+            numConverted++;
+        else if (results[iJob] == ECookResult::Failed)
+        {
+            numFailed++;
+            LOG_ERROR() << "Failed to convert shader program: " << ShaderDiskCache::GetCachePath(jobs[iJob]);
+        }
+    }
+
+    LOG_INFO() << "Shader programs: " << jobs.size() << " permutations of " << programPaths.size() << " programs. "
+        << numConverted << " converted, " << jobs.size() - numConverted - numFailed << " up to date, " << numFailed << " failed ("
+        << duration.count() * 1000.0 << " ms, " << numThreads << " threads)";
+
+    return numFailed > 0 ? 1 : 0;
+}
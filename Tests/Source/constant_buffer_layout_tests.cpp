@@ -0,0 +1,39 @@
+#include "constant_buffer_data.h"
+
+// Compile time checks of the constant buffer layouts (compiled with every test type).
+
+namespace Ming3D
+{
+    template <typename... Types>
+    using LayoutStd140 = ConstantBufferLayout<ConstantBufferPackingStd140, 0, Types...>;
+
+    template <typename... Types>
+    using LayoutHLSL = ConstantBufferLayout<ConstantBufferPackingHLSL, 0, Types...>;
+
+    // std140: scalars align to 4, vec2 to 8, vec3/vec4/mat4 to 16
+    static_assert(LayoutStd140<float, glm::vec2>::GetOffset(1) == 8, "std140: vec2 is 8 byte aligned");
+    static_assert(LayoutStd140<float, glm::vec3>::GetOffset(1) == 16, "std140: vec3 is 16 byte aligned");
+    static_assert(LayoutStd140<glm::vec3, float>::GetOffset(1) == 12, "std140: scalars fill the end of a vec3");
+    static_assert(LayoutStd140<glm::vec3, glm::vec2>::GetOffset(1) == 16, "std140: vec2 after vec3");
+    static_assert(LayoutStd140<float, glm::mat4>::GetOffset(1) == 16, "std140: mat4 is 16 byte aligned");
+    static_assert(LayoutStd140<float, glm::mat4>::Size == 80, "std140: mat4 size");
+    static_assert(LayoutStd140<float>::Size == 16, "std140: size is padded to 16 bytes");
+    static_assert(LayoutStd140<float, float, float, glm::vec2>::GetOffset(3) == 16, "std140: vec2 after 3 scalars");
+    static_assert(LayoutStd140<>::Size == 0, "std140: empty buffer");
+
+    // HLSL: scalars and vectors pack into 16 byte registers, but don't cross them
+    static_assert(LayoutHLSL<float, glm::vec2>::GetOffset(1) == 4, "HLSL: vec2 packs after a scalar");
+    static_assert(LayoutHLSL<float, glm::vec3>::GetOffset(1) == 4, "HLSL: vec3 packs after a scalar");
+    static_assert(LayoutHLSL<glm::vec3, glm::vec2>::GetOffset(1) == 16, "HLSL: vec2 doesn't cross a register");
+    static_assert(LayoutHLSL<float, float, float, glm::vec2>::GetOffset(3) == 16, "HLSL: vec2 doesn't cross a register");
+    static_assert(LayoutHLSL<float, glm::vec4>::GetOffset(1) == 16, "HLSL: vec4 starts a register");
+    static_assert(LayoutHLSL<float, glm::mat4>::GetOffset(1) == 16, "HLSL: mat4 starts a register");
+    static_assert(LayoutHLSL<glm::vec2, glm::vec2, float>::Size == 32, "HLSL: size is padded to 16 bytes");
+
+    // Layouts used by the SceneRenderer (_Globals, _LightClusters)
+    static_assert(LayoutStd140<glm::vec3, glm::vec4, glm::vec3, float>::GetOffset(3) == 44, "std140: _Globals");
+    static_assert(LayoutStd140<glm::vec3, glm::vec4, glm::vec3, float>::Size == 48, "std140: _Globals size");
+    static_assert(LayoutHLSL<glm::vec3, glm::vec4, glm::vec3, float>::GetOffset(3) == 44, "HLSL: _Globals");
+    static_assert(LayoutHLSL<glm::vec3, glm::vec4, glm::vec3, float>::Size == 48, "HLSL: _Globals size");
+    static_assert(LayoutStd140<glm::vec4, glm::vec4>::Size == 32 && LayoutHLSL<glm::vec4, glm::vec4>::Size == 32, "_LightClusters size");
+}
@@ -0,0 +1,198 @@
+#if MING3D_TESTTYPE == 8
+#include "shader_tokeniser.h"
+#include "shader_parser.h"
+#include "shader_writer_glsl.h"
+#include "shader_file_cache.h"
+#include "Model/material_buffer.h"
+#include "Debug/debug.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <set>
+#include <string>
+
+using namespace Ming3D;
+
+// Checks that every uniform block of the written GLSL has its own binding point (they're bound by slot, see RenderDeviceGL::BindConstantBuffer)
+bool CheckUniformBlockBindings()
+{
+    ShaderParserParams params;
+    params.mShaderProgramPath = "Resources/Shaders/defaultshader.cgp";
+    params.mPreprocessorDefinitions.emplace("clustered_lighting", "");
+    params.mPreprocessorDefinitions.emplace("cascaded_shadows", "");
+    ShaderParser parser;
+    ParsedShaderProgram* parsedProgram = parser.ParseShaderProgram(params);
+    if (parsedProgram == nullptr)
+        return false;
+
+    bool succeeded = parsedProgram->mConstantBufferInfos.size() > 1;
+    for (bool depthOnly : { false, true })
+    {
+        ShaderProgramDataGLSL shaderData;
+        if (!ShaderWriterGLSL().WriteShader(parsedProgram, shaderData, depthOnly))
+        {
+            succeeded = false;
+            continue;
+        }
+        for (const std::string* source : { &shaderData.mVertexShader.mSource, &shaderData.mFragmentShader.mSource })
+        {
+            const std::regex blockRegex("layout \\(std140, binding = (\\d+)\\) uniform (\\w+)");
+            std::set<std::string> bindings;
+            size_t numBlocks = 0;
+            for (std::sregex_iterator match(source->begin(), source->end(), blockRegex); match != std::sregex_iterator(); match++)
+            {
+                bindings.insert((*match)[1].str());
+                numBlocks++;
+            }
+            if (bindings.size() != numBlocks)
+            {
+                LOG_ERROR() << "Uniform blocks share a binding point" << (depthOnly ? " (depth only)" : "") << ":\n" << *source;
+                succeeded = false;
+            }
+        }
+    }
+
+    LOG_INFO() << "Uniform block bindings: " << (succeeded ? "OK" : "FAILED") << " (" << parsedProgram->mConstantBufferInfos.size() << " blocks)";
+    delete parsedProgram;
+    return succeeded;
+}
+
+// The texture_array permutation of the default shader samples a layer (inTextureLayer uniform) of a sampler2DArray
+bool CheckTextureArrayShader()
+{
+    ShaderParserParams params;
+    params.mShaderProgramPath = "Resources/Shaders/defaultshader.cgp";
+    params.mPreprocessorDefinitions.emplace("texture_array", "");
+    ShaderParser parser;
+    ParsedShaderProgram* parsedProgram = parser.ParseShaderProgram(params);
+    if (parsedProgram == nullptr)
+        return false;
+
+    bool succeeded = false;
+    ShaderProgramDataGLSL shaderData;
+    if (ShaderWriterGLSL().WriteShader(parsedProgram, shaderData, false))
+    {
+        const std::string& source = shaderData.mFragmentShader.mSource;
+        bool hasLayerUniform = false;
+        for (const ShaderVariableInfo& uniform : parsedProgram->mUniforms)
+            hasLayerUniform |= uniform.mName == "inTextureLayer";
+        succeeded = hasLayerUniform && source.find("uniform sampler2DArray inTexture;") != std::string::npos
+            && source.find("texture(inTexture, vec3(") != std::string::npos;
+        if (!succeeded)
+            LOG_ERROR() << "Unexpected texture array shader:\n" << source;
+    }
+
+    LOG_INFO() << "Texture array shader: " << (succeeded ? "OK" : "FAILED");
+    delete parsedProgram;
+    return succeeded;
+}
+
+// Constant folding, dead branch removal, and stripping of unused varyings and uniforms (see Tests/Resources/Shaders/optimisertest.cgp)
+bool CheckShaderOptimiser()
+{
+    ShaderParserParams params;
+    params.mShaderProgramPath = "Tests/Resources/Shaders/optimisertest.cgp";
+    ShaderParser parser;
+    ParsedShaderProgram* parsedProgram = parser.ParseShaderProgram(params);
+    if (parsedProgram == nullptr)
+        return false;
+
+    bool succeeded = false;
+    ShaderProgramDataGLSL shaderData;
+    if (ShaderWriterGLSL().WriteShader(parsedProgram, shaderData, false))
+    {
+        const std::string& vertexSource = shaderData.mVertexShader.mSource;
+        const std::string& fragmentSource = shaderData.mFragmentShader.mSource;
+        const bool isConstantFolded = fragmentSource.find("(5.0*_brightness)") != std::string::npos;
+        const bool isDeadBranchRemoved = !std::regex_search(fragmentSource, std::regex("\\bif\\b")) && fragmentSource.find("_debugColour") == std::string::npos;
+        const bool isVaryingStripped = vertexSource.find("output_Normal") == std::string::npos && fragmentSource.find("input_Normal") == std::string::npos
+            && fragmentSource.find("input_TexCoord") != std::string::npos;
+
+        bool isUniformStripped = parsedProgram->mStrippedUniforms == std::vector<std::string>{ "_debugColour" };
+        for (const ShaderVariableInfo& uniform : parsedProgram->mUniforms)
+            isUniformStripped &= uniform.mName != "_debugColour";
+
+        // Setting a stripped uniform does nothing
+        MaterialBuffer materialBuffer;
+        materialBuffer.mParsedShaderProgram = parsedProgram;
+        materialBuffer.mUniformData.resize(parsedProgram->mUniformBlockLayout.mSize);
+        materialBuffer.SetShaderUniformVec4("_debugColour", glm::vec4(1.0f));
+        const bool isStrippedUniformIgnored = materialBuffer.mDirtyUniformsBegin == materialBuffer.mDirtyUniformsEnd
+            && std::all_of(materialBuffer.mUniformData.begin(), materialBuffer.mUniformData.end(), [](char inByte) { return inByte == 0; });
+
+        succeeded = isConstantFolded && isDeadBranchRemoved && isVaryingStripped && isUniformStripped && isStrippedUniformIgnored;
+        if (!succeeded)
+        {
+            LOG_ERROR() << "Unexpected optimised shader (folded: " << isConstantFolded << ", dead branch: " << isDeadBranchRemoved << ", varyings: " << isVaryingStripped
+                << ", uniforms: " << isUniformStripped << ", stripped uniform ignored: " << isStrippedUniformIgnored << "):\n" << vertexSource << "\n" << fragmentSource;
+        }
+    }
+
+    LOG_INFO() << "Shader optimiser: " << (succeeded ? "OK" : "FAILED");
+    delete parsedProgram;
+    return succeeded;
+}
+
+// Files are only treated as include guarded (and skipped when included again) if the whole file is inside the #ifndef, without an #else branch
+bool CheckIncludeGuards()
+{
+    auto findGuard = [](const char* inSource)
+    {
+        std::vector<Token> tokens;
+        Tokeniser(inSource).Tokenise(tokens);
+        return ShaderFileCache::FindIncludeGuard(tokens);
+    };
+
+    const bool succeeded = findGuard("#ifndef GUARD_H\n#define GUARD_H\n#ifdef A\nfloat a;\n#else\nfloat b;\n#endif\n#endif\n") == "GUARD_H"
+        && findGuard("#ifndef GUARD_H\n#define GUARD_H\nfloat a;\n#else\nfloat b;\n#endif\n") == ""
+        && findGuard("#ifndef GUARD_H\n#define GUARD_H\nfloat a;\n#endif\nfloat b;\n") == "";
+
+    LOG_INFO() << "Include guards: " << (succeeded ? "OK" : "FAILED");
+    return succeeded;
+}
+
+// Shader tokeniser throughput, on the shaders in Resources/Shaders
+int main()
+{
+    const char* shaderFiles[] = { "Resources/Shaders/defaultshader.cgp", "Resources/Shaders/unlit.cgp", "Resources/Shaders/debuggraphics.cgp", "Resources/Shaders/lighting.cgh" };
+    std::string corpus;
+    for (const char* shaderFile : shaderFiles)
+    {
+        std::ifstream file(shaderFile);
+        corpus.append((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        corpus += "\n";
+    }
+    if (corpus.size() <= 4)
+    {
+        LOG_ERROR() << "Shaders not found. Run from the directory that contains the Resources folder.";
+        return 1;
+    }
+
+    if (!CheckUniformBlockBindings() || !CheckTextureArrayShader() || !CheckIncludeGuards() || !CheckShaderOptimiser())
+        return 1;
+
+    // Repeat the corpus, so the timing isn't dominated by cache effects of a tiny input
+    std::string source;
+    while (source.size() < 8 * 1024 * 1024)
+        source += corpus;
+
+    const int numIterations = 10;
+    size_t numTokens = 0;
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numIterations; i++)
+    {
+        TokenParser tokenParser(source.c_str());
+        numTokens += tokenParser.GetTokens().size();
+    }
+    const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - startTime;
+
+    const double megabytes = (double)source.size() * numIterations / (1024.0 * 1024.0);
+    LOG_INFO() << "Tokenised " << megabytes << " MB (" << numTokens << " tokens) in " << duration.count() * 1000.0 << " ms: " << megabytes / duration.count() << " MB/s";
+
+    return 0;
+}
+
+#endif
@@ -63,14 +63,12 @@ int main()
     std::vector<MeshComponent*> meshComps = modelActor->GetComponentsInChildren<MeshComponent>();
     for(MeshComponent* meshComp : meshComps)
     {
-        // TODO: Create vertex iterator class
         Mesh* mesh = meshComp->GetMesh();
         VertexData* vertData = mesh->mVertexData;
-        VertexDataIterator<glm::vec3> vertIterator(vertData, EVertexComponent::Position);
-        size_t vertCount = vertIterator.GetCount();
+        size_t vertCount = vertData->GetNumVertices();
         for (size_t iVert = 0; iVert < vertCount; iVert++)
         {
-            const glm::vec3 pos = vertIterator.GetElement(iVert);
+            const glm::vec3 pos = glm::vec3(vertData->GetComponentValue(iVert, EVertexComponent::Position));
             minPos.x = std::min(minPos.x, pos.x);
             minPos.y = std::min(minPos.y, pos.y);
             minPos.z = std::min(minPos.z, pos.z);